@@ -2,23 +2,74 @@
 
 #include "AsyncHttpClient.h"
 #include <algorithm>
+#include <cctype>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cerrno>
 #include <cstring>
 #include <memory>
+#include <string>
 #include <utility>
 #include "ConnectionPool.h"
 #include "AsyncCookieJar.h"
 #include "HttpHelpers.h"
 #include "RedirectHandler.h"
+#include "RequestBatch.h"
+#include "UrlParser.h"
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
 
 static constexpr size_t kMaxChunkSizeLineLen = 64;
 static constexpr size_t kMaxChunkTrailerLineLen = 256;
 static constexpr size_t kMaxChunkTrailerLines = 32;
 static constexpr size_t kDefaultMaxHeaderBytes = 2800; // ~2.8 KiB
 static constexpr size_t kDefaultMaxBodyBytes = 8192;   // 8 KiB
+// Free heap is polled: requests held back for it are re-checked this often (budget releases wake the queue at once).
+static constexpr uint32_t kMemoryRecheckMs = 50;
+// keepWarm() targets are topped up at most this often, and not again for kWarmRetryMs after a failed warm-up.
+static constexpr uint32_t kWarmCheckMs = 250;
+static constexpr uint32_t kWarmRetryMs = 5000;
+// How long an origin whose server broke a pipeline gets one request per connection.
+static constexpr uint32_t kPipelineRefusalMs = 60000;
+
+static size_t freeHeapBytes() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#else
+    return SIZE_MAX;
+#endif
+}
+
+// Trims optional whitespace around a field in place; returns the new start and stores the new length.
+static char* trimField(char* text, size_t* len) {
+    while (*len > 0 && isspace(static_cast<unsigned char>(*text))) {
+        ++text;
+        --*len;
+    }
+    while (*len > 0 && isspace(static_cast<unsigned char>(text[*len - 1])))
+        --*len;
+    text[*len] = '\0';
+    return text;
+}
+
+static void lowercaseInPlace(char* text) {
+    for (; *text; ++text)
+        *text = static_cast<char>(tolower(static_cast<unsigned char>(*text)));
+}
+
+// `token` is lower case.
+static bool containsIgnoreCase(const char* text, const char* token) {
+    for (; *text; ++text) {
+        size_t i = 0;
+        while (token[i] && tolower(static_cast<unsigned char>(text[i])) == token[i])
+            ++i;
+        if (!token[i])
+            return true;
+    }
+    return false;
+}
 
 AsyncHttpClient::AsyncHttpClient()
     : _defaultTimeout(10000), _defaultUserAgent(String("ESPAsyncWebClient/") + ESP_ASYNC_WEB_CLIENT_VERSION),
@@ -27,6 +78,7 @@ AsyncHttpClient::AsyncHttpClient()
     _cookieJar.reset(new AsyncCookieJar(this));
     _connectionPool.reset(new ConnectionPool(this));
     _redirectHandler.reset(new RedirectHandler(this));
+    _batcher.reset(new RequestBatcher(this));
 #if defined(ARDUINO_ARCH_ESP32) && defined(ASYNC_HTTP_ENABLE_AUTOLOOP)
     // Create recursive mutex for shared containers when auto-loop may run in background
     _reqMutex = xSemaphoreCreateRecursiveMutex();
@@ -58,6 +110,7 @@ AsyncHttpClient::~AsyncHttpClient() {
         _reqMutex = nullptr;
     }
 #endif
+    dropWarmups();
     if (_connectionPool) {
         _connectionPool->dropAll();
         _connectionPool.reset();
@@ -66,16 +119,37 @@ AsyncHttpClient::~AsyncHttpClient() {
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(ASYNC_HTTP_ENABLE_AUTOLOOP)
 void AsyncHttpClient::lock() const {
-    if (_reqMutex)
-        xSemaphoreTakeRecursive(_reqMutex, portMAX_DELAY);
+    if (_reqMutex && xSemaphoreTakeRecursive(_reqMutex, portMAX_DELAY) == pdTRUE)
+        _lockDepth++;
 }
 void AsyncHttpClient::unlock() const {
-    if (_reqMutex)
+    if (!_reqMutex)
+        return;
+    bool outermost = --_lockDepth == 0;
+    xSemaphoreGiveRecursive(_reqMutex);
+    // Submitters that found the mutex taken only queued their work: the outermost holder drains it on release,
+    // whatever it held the mutex for (a getter on another task included).
+    while (outermost && hasSubmissions() && xSemaphoreTakeRecursive(_reqMutex, 0) == pdTRUE) {
+        _lockDepth = 1;
+        const_cast<AsyncHttpClient*>(this)->drainSubmissionsLocked();
+        _lockDepth = 0;
         xSemaphoreGiveRecursive(_reqMutex);
+    }
+}
+bool AsyncHttpClient::tryLock() const {
+    if (!_reqMutex)
+        return true;
+    if (xSemaphoreTakeRecursive(_reqMutex, 0) != pdTRUE)
+        return false;
+    _lockDepth++;
+    return true;
 }
 #else
 void AsyncHttpClient::lock() const {}
 void AsyncHttpClient::unlock() const {}
+bool AsyncHttpClient::tryLock() const {
+    return true;
+}
 #endif
 
 #if !ASYNC_TCP_HAS_TIMEOUT && defined(ARDUINO_ARCH_ESP32) && defined(ASYNC_HTTP_ENABLE_AUTOLOOP)
@@ -91,22 +165,55 @@ void AsyncHttpClient::_autoLoopTaskThunk(void* param) {
 #endif
 
 uint32_t AsyncHttpClient::get(const char* url, SuccessCallback onSuccess, ErrorCallback onError) {
-    return makeRequest(HTTP_METHOD_GET, url, nullptr, onSuccess, onError);
+    return makeRequest(HTTP_METHOD_GET, url, nullptr, std::move(onSuccess), std::move(onError));
 }
 uint32_t AsyncHttpClient::post(const char* url, const char* data, SuccessCallback onSuccess, ErrorCallback onError) {
-    return makeRequest(HTTP_METHOD_POST, url, data, onSuccess, onError);
+    return makeRequest(HTTP_METHOD_POST, url, data, std::move(onSuccess), std::move(onError));
 }
 uint32_t AsyncHttpClient::put(const char* url, const char* data, SuccessCallback onSuccess, ErrorCallback onError) {
-    return makeRequest(HTTP_METHOD_PUT, url, data, onSuccess, onError);
+    return makeRequest(HTTP_METHOD_PUT, url, data, std::move(onSuccess), std::move(onError));
 }
 uint32_t AsyncHttpClient::del(const char* url, SuccessCallback onSuccess, ErrorCallback onError) {
-    return makeRequest(HTTP_METHOD_DELETE, url, nullptr, onSuccess, onError);
+    return makeRequest(HTTP_METHOD_DELETE, url, nullptr, std::move(onSuccess), std::move(onError));
 }
 uint32_t AsyncHttpClient::head(const char* url, SuccessCallback onSuccess, ErrorCallback onError) {
-    return makeRequest(HTTP_METHOD_HEAD, url, nullptr, onSuccess, onError);
+    return makeRequest(HTTP_METHOD_HEAD, url, nullptr, std::move(onSuccess), std::move(onError));
 }
 uint32_t AsyncHttpClient::patch(const char* url, const char* data, SuccessCallback onSuccess, ErrorCallback onError) {
-    return makeRequest(HTTP_METHOD_PATCH, url, data, onSuccess, onError);
+    return makeRequest(HTTP_METHOD_PATCH, url, data, std::move(onSuccess), std::move(onError));
+}
+
+AsyncHttpFuture AsyncHttpClient::getAsync(const char* url) {
+    return makeRequestAsync(HTTP_METHOD_GET, url, nullptr);
+}
+AsyncHttpFuture AsyncHttpClient::postAsync(const char* url, const char* data) {
+    return makeRequestAsync(HTTP_METHOD_POST, url, data);
+}
+AsyncHttpFuture AsyncHttpClient::putAsync(const char* url, const char* data) {
+    return makeRequestAsync(HTTP_METHOD_PUT, url, data);
+}
+AsyncHttpFuture AsyncHttpClient::delAsync(const char* url) {
+    return makeRequestAsync(HTTP_METHOD_DELETE, url, nullptr);
+}
+AsyncHttpFuture AsyncHttpClient::headAsync(const char* url) {
+    return makeRequestAsync(HTTP_METHOD_HEAD, url, nullptr);
+}
+AsyncHttpFuture AsyncHttpClient::patchAsync(const char* url, const char* data) {
+    return makeRequestAsync(HTTP_METHOD_PATCH, url, data);
+}
+
+AsyncHttpFuture AsyncHttpClient::requestAsync(std::unique_ptr<AsyncHttpRequest> request) {
+    AsyncHttpFuture::State* state = new AsyncHttpFuture::State();
+    AsyncHttpFuture future(state);
+    state->setRequestId(this->request(std::move(request), state->successCallback(), state->errorCallback()));
+    return future;
+}
+
+AsyncHttpFuture AsyncHttpClient::makeRequestAsync(HttpMethod method, const char* url, const char* data) {
+    AsyncHttpFuture::State* state = new AsyncHttpFuture::State();
+    AsyncHttpFuture future(state);
+    state->setRequestId(makeRequest(method, url, data, state->successCallback(), state->errorCallback()));
+    return future;
 }
 
 void AsyncHttpClient::setHeader(const char* name, const char* value) {
@@ -203,6 +310,75 @@ void AsyncHttpClient::setMaxParallel(uint16_t maxParallel) {
     tryDequeue();
 }
 
+void AsyncHttpClient::setRateLimit(float requestsPerSecond, uint16_t burst) {
+    lock();
+    _rateLimiter.setGlobal(requestsPerSecond, burst, millis());
+    unlock();
+    tryDequeue();
+}
+
+void AsyncHttpClient::setPerOriginRateLimit(float requestsPerSecond, uint16_t burst) {
+    lock();
+    _rateLimiter.setPerOriginDefault(requestsPerSecond, burst);
+    unlock();
+    tryDequeue();
+}
+
+void AsyncHttpClient::setOriginRateLimit(const char* origin, float requestsPerSecond, uint16_t burst) {
+    if (!origin || strlen(origin) == 0)
+        return;
+    UrlParser::ParsedUrl parsed;
+    if (!UrlParser::parse(origin, parsed))
+        return;
+    std::string key = RateLimiter::makeOriginKey(parsed.host, parsed.port, parsed.secure);
+    lock();
+    _rateLimiter.setOrigin(key, requestsPerSecond, burst, millis());
+    unlock();
+    tryDequeue();
+}
+
+void AsyncHttpClient::setRetryPolicy(const AsyncHttpRetryPolicy& policy) {
+    lock();
+    _retryPolicy = policy;
+    unlock();
+}
+
+void AsyncHttpClient::setCircuitBreaker(uint8_t failureRatePercent, uint32_t openMs, uint8_t minRequests,
+                                        uint8_t window) {
+    lock();
+    _circuitBreaker.configure(failureRatePercent, openMs, minRequests, window);
+    for (auto& active : _activeRequests)
+        active->circuitProbe = false; // configure() forgot every origin, including in-flight probes
+    unlock();
+}
+
+void AsyncHttpClient::setHedgePolicy(const AsyncHttpHedgePolicy& policy) {
+    lock();
+    _hedgePolicy = policy;
+    unlock();
+}
+
+uint32_t AsyncHttpClient::getHedgesFired() const {
+    lock();
+    uint32_t fired = _hedgesFired;
+    unlock();
+    return fired;
+}
+
+uint32_t AsyncHttpClient::getHedgesWon() const {
+    lock();
+    uint32_t won = _hedgesWon;
+    unlock();
+    return won;
+}
+
+uint32_t AsyncHttpClient::getStaleConnectionReplays() const {
+    lock();
+    uint32_t replays = _staleReplays;
+    unlock();
+    return replays;
+}
+
 void AsyncHttpClient::setDefaultTlsConfig(const AsyncHttpTLSConfig& config) {
     lock();
     _defaultTlsConfig = config;
@@ -249,7 +425,284 @@ void AsyncHttpClient::setKeepAlive(bool enable, uint16_t idleMs) {
     unlock();
     if (!enable && _connectionPool) {
         _connectionPool->dropAll();
+        dropWarmups();
+    }
+}
+
+void AsyncHttpClient::setSocketOptions(const AsyncHttpSocketOptions& options) {
+    lock();
+    _socketOptions = options;
+    unlock();
+}
+
+AsyncHttpSocketOptions AsyncHttpClient::getSocketOptions() const {
+    lock();
+    AsyncHttpSocketOptions options = _socketOptions;
+    unlock();
+    return options;
+}
+
+void AsyncHttpClient::setConnectionPoolLimits(const AsyncHttpConnectionPoolLimits& limits) {
+    if (_connectionPool)
+        _connectionPool->setLimits(limits);
+}
+
+AsyncHttpConnectionPoolStats AsyncHttpClient::getConnectionPoolStats() const {
+    return _connectionPool ? _connectionPool->stats() : AsyncHttpConnectionPoolStats();
+}
+
+void AsyncHttpClient::setPipelining(bool enable, uint8_t maxDepth) {
+    lock();
+    _pipelineDepth = enable ? std::max<uint8_t>(2, maxDepth) : 0;
+    _pipelineRefused.clear();
+    if (!enable) {
+        // Pipelines in flight finish their queued requests; nothing new is appended.
+        for (auto& entry : _pipelines)
+            entry.second->open = false;
+        _pipelines.clear();
+    }
+    unlock();
+}
+
+uint32_t AsyncHttpClient::getPipelinedRequests() const {
+    lock();
+    uint32_t pipelined = _pipelinedRequests;
+    unlock();
+    return pipelined;
+}
+
+uint32_t AsyncHttpClient::getPipelineRequeues() const {
+    lock();
+    uint32_t requeues = _pipelineRequeues;
+    unlock();
+    return requeues;
+}
+
+bool AsyncHttpClient::setEndpointGroup(const char* name, const char* endpoints) {
+    if (!name || !endpoints)
+        return false;
+    std::vector<std::string> urls;
+    const char* start = endpoints;
+    while (true) {
+        const char* end = strchr(start, ',');
+        size_t len = end ? static_cast<size_t>(end - start) : strlen(start);
+        while (len > 0 && isspace(static_cast<unsigned char>(*start))) {
+            start++;
+            len--;
+        }
+        while (len > 0 && isspace(static_cast<unsigned char>(start[len - 1])))
+            len--;
+        if (len > 0)
+            urls.emplace_back(start, len);
+        if (!end)
+            break;
+        start = end + 1;
+    }
+    lock();
+    bool ok = _endpointGroups.setGroup(name, urls);
+    unlock();
+    return ok;
+}
+
+bool AsyncHttpClient::removeEndpointGroup(const char* name) {
+    if (!name)
+        return false;
+    lock();
+    bool removed = _endpointGroups.removeGroup(name);
+    unlock();
+    return removed;
+}
+
+void AsyncHttpClient::setEndpointPolicy(const AsyncHttpEndpointPolicy& policy) {
+    lock();
+    _endpointGroups.configure(policy);
+    unlock();
+}
+
+std::vector<AsyncHttpEndpointStats> AsyncHttpClient::getEndpointStats(const char* name) const {
+    if (!name)
+        return std::vector<AsyncHttpEndpointStats>();
+    lock();
+    std::vector<AsyncHttpEndpointStats> stats = _endpointGroups.stats(name, millis());
+    unlock();
+    return stats;
+}
+
+uint32_t AsyncHttpClient::getEndpointFailovers() const {
+    lock();
+    uint32_t failovers = _endpointFailovers;
+    unlock();
+    return failovers;
+}
+
+uint16_t AsyncHttpClient::preconnect(const char* url, uint16_t count) {
+    if (!url || count == 0 || !_connectionPool)
+        return 0;
+    lock();
+    bool keepAlive = _keepAliveEnabled;
+    unlock();
+    if (!keepAlive)
+        return 0;
+    AsyncHttpRequest request(HTTP_METHOD_GET, url);
+    if (request.getHost().length() == 0)
+        return 0;
+    AsyncHttpTLSConfig tls = resolveTlsConfig(&request);
+    return startWarmups(request, tls, ConnectionPool::makeKey(&request, tls), count);
+}
+
+void AsyncHttpClient::keepWarm(const char* url, uint16_t minIdle) {
+    if (!url)
+        return;
+    lock();
+    auto it = std::find_if(_warmTargets.begin(), _warmTargets.end(),
+                           [url](const WarmTarget& target) { return target.url == url; });
+    if (minIdle == 0) {
+        if (it != _warmTargets.end())
+            _warmTargets.erase(it);
+    } else if (it != _warmTargets.end()) {
+        it->minIdle = minIdle;
+        it->retryAtMs = 0;
+    } else {
+        WarmTarget target;
+        target.url = url;
+        target.minIdle = minIdle;
+        _warmTargets.push_back(target);
+    }
+    _nextWarmCheckMs = millis(); // top up on the next loop()
+    unlock();
+}
+
+uint16_t AsyncHttpClient::startWarmups(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls,
+                                       const std::string& key, uint16_t count) {
+    lock();
+    uint32_t timeoutMs = _defaultConnectTimeout;
+    unlock();
+    if (request.isSecure())
+        timeoutMs += tls.handshakeTimeoutMs;
+    uint16_t started = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        AsyncTransport* transport = makeTransport(request, tls, key);
+        if (!transport)
+            break;
+        // The TLS transport reports "connected" once the handshake is done; the pool takes over from there.
+        transport->setConnectHandler([this](void*, AsyncTransport* t) { finishWarmup(t, true); }, nullptr);
+        transport->setDataHandler([this](void*, AsyncTransport* t, void*, size_t) { finishWarmup(t, false); },
+                                  nullptr);
+        transport->setDisconnectHandler([this](void*, AsyncTransport* t) { finishWarmup(t, false); }, nullptr);
+        transport->setErrorHandler(
+            [this](void*, AsyncTransport* t, HttpClientError, const char*) { finishWarmup(t, false); }, nullptr);
+        Warmup warmup;
+        warmup.transport = transport;
+        warmup.poolKey = key;
+        warmup.startedMs = millis();
+        warmup.timeoutMs = timeoutMs;
+        lock();
+        _warmups.push_back(warmup);
+        unlock();
+        if (!transport->connect(request.getHost().c_str(), request.getPort())) {
+            finishWarmup(transport, false);
+            break;
+        }
+        ++started;
+    }
+    return started;
+}
+
+void AsyncHttpClient::finishWarmup(AsyncTransport* transport, bool connected) {
+    std::string key;
+    bool found = false;
+    lock();
+    for (auto it = _warmups.begin(); it != _warmups.end(); ++it) {
+        if (it->transport == transport) {
+            key = std::move(it->poolKey);
+            _warmups.erase(it);
+            found = true;
+            break;
+        }
+    }
+    if (found && !connected) {
+        uint32_t retryAt = millis() + kWarmRetryMs;
+        for (auto& target : _warmTargets) {
+            if (target.poolKey == key)
+                target.retryAtMs = retryAt;
+        }
     }
+    bool pool = found && connected && _keepAliveEnabled && _connectionPool;
+    unlock();
+    if (!found)
+        return;
+    if (pool) {
+        _connectionPool->releaseConnectionToPool(transport, key);
+    } else {
+        transport->close(true);
+        delete transport;
+    }
+}
+
+void AsyncHttpClient::expireWarmups(uint32_t now) {
+    std::vector<AsyncTransport*> expired;
+    lock();
+    for (const auto& warmup : _warmups) {
+        if (now - warmup.startedMs > warmup.timeoutMs)
+            expired.push_back(warmup.transport);
+    }
+    unlock();
+    for (auto* transport : expired)
+        finishWarmup(transport, false);
+}
+
+void AsyncHttpClient::maintainWarmConnections(uint32_t now) {
+    lock();
+    bool due = !_warmTargets.empty() && _keepAliveEnabled && static_cast<int32_t>(now - _nextWarmCheckMs) >= 0;
+    std::vector<WarmTarget> targets;
+    if (due) {
+        _nextWarmCheckMs = now + kWarmCheckMs;
+        targets = _warmTargets;
+    }
+    unlock();
+    for (auto& target : targets) {
+        AsyncHttpRequest request(HTTP_METHOD_GET, target.url);
+        if (request.getHost().length() == 0)
+            continue;
+        AsyncHttpTLSConfig tls = resolveTlsConfig(&request);
+        std::string key = ConnectionPool::makeKey(&request, tls);
+        size_t have = _connectionPool->idleCount(key);
+        lock();
+        for (auto& live : _warmTargets) {
+            if (live.url == target.url)
+                live.poolKey = key;
+        }
+        for (const auto& warmup : _warmups) {
+            if (warmup.poolKey == key)
+                ++have;
+        }
+        unlock();
+        if (have < target.minIdle && (target.retryAtMs == 0 || static_cast<int32_t>(now - target.retryAtMs) >= 0))
+            startWarmups(request, tls, key, static_cast<uint16_t>(target.minIdle - have));
+    }
+}
+
+void AsyncHttpClient::dropWarmups() {
+    std::vector<Warmup> warmups;
+    lock();
+    warmups.swap(_warmups);
+    unlock();
+    for (auto& warmup : warmups) {
+        warmup.transport->close(true);
+        delete warmup.transport;
+    }
+}
+
+void AsyncHttpClient::setCallbackExecutor(std::shared_ptr<CallbackExecutor> executor) {
+    lock();
+    _callbackExecutor = std::move(executor);
+    unlock();
+}
+
+void AsyncHttpClient::setTransportFactory(TransportFactory factory) {
+    lock();
+    _transportFactory = std::move(factory);
+    unlock();
 }
 
 void AsyncHttpClient::clearCookies() {
@@ -325,7 +778,7 @@ uint32_t AsyncHttpClient::makeRequest(HttpMethod method, const char* url, const
         }
     }
     request->finalizeQueryParams(); // ensure built queries closed
-    return this->request(std::move(request), onSuccess, onError);
+    return this->request(std::move(request), std::move(onSuccess), std::move(onError));
 }
 
 uint32_t AsyncHttpClient::request(std::unique_ptr<AsyncHttpRequest> request, SuccessCallback onSuccess,
@@ -340,12 +793,120 @@ uint32_t AsyncHttpClient::request(std::unique_ptr<AsyncHttpRequest> request, Suc
             onError(CONNECTION_FAILED, "Invalid URL");
         return 0;
     }
-    auto ctx = std::make_shared<RequestContext>();
+    auto ctx = createContext(std::move(request));
+    ctx->onSuccess = std::move(onSuccess);
+    ctx->onError = std::move(onError);
+    uint32_t id = ctx->id;
+    submitContext(std::move(ctx));
+    return id;
+}
+
+uint32_t AsyncHttpClient::batch(std::vector<std::unique_ptr<AsyncHttpRequest>> requests, BatchCallback onComplete,
+                                const BatchOptions& options) {
+    return _batcher->submit(std::move(requests), std::move(onComplete), options);
+}
+
+bool AsyncHttpClient::abortBatch(uint32_t batchId) {
+    // Flush submissions first so items handed over moments ago can be aborted.
+    lock();
+    drainSubmissionsLocked();
+    unlock();
+    return _batcher->abortBatch(batchId);
+}
+
+bool AsyncHttpClient::configureObjectPools(const AsyncHttpPoolConfig& config) {
+    return HttpObjectPools::configure(config);
+}
+
+AsyncHttpPoolStats AsyncHttpClient::getObjectPoolStats() {
+    return HttpObjectPools::stats();
+}
+
+void AsyncHttpClient::configureDnsCache(const AsyncHttpDnsConfig& config) {
+    DnsCache::shared().configure(config);
+}
+
+void AsyncHttpClient::setResolver(AsyncHttpResolver* resolver) {
+    DnsCache::shared().setResolver(resolver);
+}
+
+bool AsyncHttpClient::pinHost(const char* host, const char* ipv4) {
+    uint32_t address = 0;
+    if (!host || !*host || !DnsCache::parseIPv4(ipv4, &address))
+        return false;
+    DnsCache::shared().pin(host, address);
+    return true;
+}
+
+bool AsyncHttpClient::unpinHost(const char* host) {
+    return host && DnsCache::shared().unpin(host);
+}
+
+bool AsyncHttpClient::preResolve(const char* host) {
+    return host && *host && DnsCache::shared().preResolve(host, millis());
+}
+
+void AsyncHttpClient::clearDnsCache() {
+    DnsCache::shared().clear();
+}
+
+AsyncHttpDnsStats AsyncHttpClient::getDnsStats() {
+    return DnsCache::shared().stats();
+}
+
+void AsyncHttpClient::configureTlsSessionCache(const AsyncHttpTlsSessionConfig& config) {
+    TlsSessionCache::shared().configure(config);
+}
+
+void AsyncHttpClient::clearTlsSessionCache() {
+    TlsSessionCache::shared().clear();
+}
+
+AsyncHttpTlsSessionStats AsyncHttpClient::getTlsSessionStats() {
+    return TlsSessionCache::shared().stats();
+}
+
+// Request arena slabs come from the arena pool when it is configured, the heap otherwise.
+static void* arenaSlabAlloc(size_t size) {
+    void* p = HttpObjectPools::arenas().tryAllocate(size);
+    return p ? p : HttpMemory::allocate(AsyncHttpBufferKind::kRequestArena, size);
+}
+
+static void arenaSlabFree(void* p) {
+    if (!HttpObjectPools::arenas().release(p))
+        HttpMemory::release(p);
+}
+
+static void* arenaPsramAlloc(size_t size) {
+    return HttpMemory::allocate(AsyncHttpMemoryRegion::kExternal, size); // internal RAM when there is no PSRAM
+}
+
+void AsyncHttpClient::setRequestArena(size_t bytes, bool preferPsram) {
+    lock();
+    _requestArenaSize = bytes;
+    _requestArenaPsram = preferPsram;
+    unlock();
+}
+
+std::shared_ptr<AsyncHttpClient::RequestContext> AsyncHttpClient::makeContext() const {
+    // Context and control block share one pool block; the block returns to the pool when the last reference (the
+    // client's or a transport handler's) goes away.
+    auto ctx = std::allocate_shared<RequestContext>(PoolAllocator<RequestContext>(&HttpObjectPools::contexts()));
+    RequestArena::AllocFn slabAlloc = _requestArenaPsram ? arenaPsramAlloc : arenaSlabAlloc;
+    ctx->arena.configure(_requestArenaSize, slabAlloc, arenaSlabFree);
+    return ctx;
+}
+
+std::shared_ptr<AsyncHttpResponse> AsyncHttpClient::makeResponse() {
+    return std::allocate_shared<AsyncHttpResponse>(PoolAllocator<AsyncHttpResponse>(&HttpObjectPools::responses()));
+}
+
+std::shared_ptr<AsyncHttpClient::RequestContext>
+AsyncHttpClient::createContext(std::unique_ptr<AsyncHttpRequest> request) {
+    auto ctx = makeContext();
     ctx->request = std::move(request);
-    ctx->response = std::make_shared<AsyncHttpResponse>();
-    ctx->onSuccess = onSuccess;
-    ctx->onError = onError;
-    ctx->id = _nextRequestId++;
+    ctx->response = makeResponse();
+    ctx->id = _nextRequestId.fetch_add(1, std::memory_order_relaxed);
     ctx->timing.connectTimeoutMs = _defaultConnectTimeout;
     if (_keepAliveEnabled && ctx->request) {
         String conn = ctx->request->getHeader("Connection");
@@ -356,47 +917,220 @@ uint32_t AsyncHttpClient::request(std::unique_ptr<AsyncHttpRequest> request, Suc
             ctx->request->setHeader("Keep-Alive", String("timeout=") + String(timeoutSec));
         }
     }
-    uint32_t id = ctx->id;
-    executeOrQueue(std::move(ctx));
-    return id;
+    return ctx;
+}
+
+void AsyncHttpClient::submitContext(std::shared_ptr<RequestContext> context) {
+    Submission submission;
+    submission.kind = Submission::kRequest;
+    submission.context = std::move(context);
+    pushSubmission(std::move(submission));
+    drainSubmissions();
 }
 
 // Removed per-request chunk overload
 
 bool AsyncHttpClient::abort(uint32_t requestId) {
-    // Active requests: we must be careful as triggerError() will cleanup and erase from _activeRequests
-    lock();
-    for (size_t i = 0; i < _activeRequests.size(); ++i) {
-        RequestContext* ctx = _activeRequests[i].get();
-        if (ctx && ctx->id == requestId && !ctx->cancelled.load()) {
-            unlock();
-            triggerError(ctx, ABORTED, "Aborted by user");
-            return true;
-        }
-    }
-    // Pending queue: still not executed
-    std::shared_ptr<RequestContext> pending;
-    for (auto it = _pendingQueue.begin(); it != _pendingQueue.end(); ++it) {
-        if ((*it)->id == requestId) {
-            pending = std::move(*it);
-            _pendingQueue.erase(it);
-            break;
-        }
+    uint32_t nextId = _nextRequestId.load(std::memory_order_relaxed);
+    if (requestId == 0 || static_cast<int32_t>(requestId - nextId) >= 0)
+        return false; // never issued by this client
+    if (tryLock()) {
+        // Client free: flush the ring first so a request submitted moments ago can be found.
+        drainSubmissionsLocked();
+        bool aborted = abortNow(requestId);
+        unlock();
+        return aborted;
     }
+    // Client busy: hand the abort to its owner instead of waiting. Whether the request was still running is only
+    // known once it is processed; the ABORTED error callback reports it.
+    Submission submission;
+    submission.kind = Submission::kAbort;
+    submission.requestId = requestId;
+    pushSubmission(std::move(submission));
+    return true;
+}
+
+void AsyncHttpClient::pushSubmission(Submission&& submission) {
+    // Once a submission spilled over, later ones follow it so the consumer still sees them in submission order.
+    if (_submitOverflowCount.load(std::memory_order_acquire) == 0 && _submissions.tryPush(std::move(submission)))
+        return;
+    std::lock_guard<std::mutex> guard(_submitOverflowMutex);
+    _submitOverflow.push_back(std::move(submission));
+    _submitOverflowCount.fetch_add(1, std::memory_order_release);
+}
+
+bool AsyncHttpClient::popOverflowSubmission(Submission* out) {
+    if (_submitOverflowCount.load(std::memory_order_acquire) == 0)
+        return false;
+    std::lock_guard<std::mutex> guard(_submitOverflowMutex);
+    if (_submitOverflow.empty())
+        return false;
+    *out = std::move(_submitOverflow.front());
+    _submitOverflow.pop_front();
+    _submitOverflowCount.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void AsyncHttpClient::drainSubmissions() {
+    // Producers never wait for the client mutex: if another context holds it, that context drains the ring when it
+    // releases the mutex (see unlock()). Holding it through the drain makes the lock() calls below recursive
+    // re-entries, which do not wait either.
+    if (!tryLock())
+        return;
+    drainSubmissionsLocked();
     unlock();
-    if (pending) {
-        triggerError(pending.get(), ABORTED, "Aborted by user");
-        return true;
+}
+
+bool AsyncHttpClient::hasSubmissions() const {
+    return !_submissions.empty() || _submitOverflowCount.load(std::memory_order_acquire) > 0;
+}
+
+void AsyncHttpClient::drainSubmissionsLocked() {
+    while (hasSubmissions()) {
+        if (_drainingSubmissions.exchange(true, std::memory_order_acq_rel))
+            return; // already draining further up this stack (or on another task when no mutex is compiled in)
+        // The ring holds the older submissions: the overflow only fills while the ring is full.
+        Submission submission;
+        while (_submissions.tryPop(&submission) || popOverflowSubmission(&submission)) {
+            processSubmission(submission);
+            submission = Submission();
+        }
+        _drainingSubmissions.store(false, std::memory_order_release);
+        // Loop again: a producer may have pushed after our last pop but before the guard was released.
+    }
+}
+
+void AsyncHttpClient::processSubmission(Submission& submission) {
+    switch (submission.kind) {
+    case Submission::kRequest:
+        executeOrQueue(std::move(submission.context));
+        break;
+    case Submission::kAbort:
+        abortNow(submission.requestId);
+        break;
+    default:
+        break;
+    }
+}
+
+bool AsyncHttpClient::abortNow(uint32_t requestId) {
+    lock();
+    auto found = _contextsById.find(requestId);
+    if (found == _contextsById.end() || found->second->cancelled.load() || found->second->dropped) {
+        unlock();
+        return false;
+    }
+    RequestContext* ctx = found->second;
+    std::shared_ptr<RequestContext> hedgeCopy;
+    if (ctx->queued) {
+        // Not started yet: leave a tombstone instead of erasing from the middle of the queue (O(n)); dispatch skips
+        // it and the queue sheds it once it reaches the front.
+        ctx->dropped = true;
+        _pendingDropped++;
+        if (ctx->retry.waiting) {
+            ctx->retry.waiting = false;
+            _retryWaitingCount--;
+        }
+    } else {
+        // A hedged request runs as two contexts sharing the id: abort both, report once.
+        hedgeCopy = detachHedgeSiblingLocked(ctx);
+    }
+    unlock();
+    if (hedgeCopy)
+        cleanup(hedgeCopy.get());
+    triggerError(ctx, ABORTED, "Aborted by user");
+    return true;
+}
+
+size_t AsyncHttpClient::abortGroup(uint32_t groupId) {
+    lock();
+    drainSubmissionsLocked(); // requests still in the ring belong to the group too
+    unlock();
+    return abortMatching(false, groupId);
+}
+
+size_t AsyncHttpClient::abortAll() {
+    lock();
+    drainSubmissionsLocked();
+    unlock();
+    return abortMatching(true, 0);
+}
+
+size_t AsyncHttpClient::abortMatching(bool all, uint32_t groupId) {
+    auto matches = [all, groupId](const RequestContext* ctx) {
+        return all || (ctx->request && ctx->request->getGroup() == groupId);
+    };
+    std::vector<std::shared_ptr<RequestContext>> victims;
+    std::vector<std::shared_ptr<RequestContext>> hedgeCopies;
+    lock();
+    for (auto& active : _activeRequests) {
+        RequestContext* ctx = active.get();
+        // Racing hedge copies go together with the request that carries the callbacks.
+        if (ctx->cancelled.load() || ctx->responseProcessed || ctx->hedge.copy || !matches(ctx))
+            continue;
+        victims.push_back(active);
+    }
+    for (auto& victim : victims) {
+        std::shared_ptr<RequestContext> copy = detachHedgeSiblingLocked(victim.get());
+        if (copy)
+            hedgeCopies.push_back(std::move(copy));
+    }
+    // One pass over the queue: take the matches out and shed tombstones on the way.
+    std::deque<std::shared_ptr<RequestContext>> kept;
+    for (auto& pending : _pendingQueue) {
+        if (pending->dropped)
+            continue;
+        if (!matches(pending.get())) {
+            kept.push_back(std::move(pending));
+            continue;
+        }
+        pending->queued = false;
+        if (pending->retry.waiting) {
+            pending->retry.waiting = false;
+            _retryWaitingCount--;
+        }
+        victims.push_back(std::move(pending));
+    }
+    _pendingQueue.swap(kept);
+    _pendingDropped = 0;
+    unlock();
+    for (auto& copy : hedgeCopies)
+        cleanup(copy.get());
+    for (auto& victim : victims)
+        triggerError(victim.get(), ABORTED, "Aborted by user");
+    return victims.size();
+}
+
+void AsyncHttpClient::pushPendingLocked(std::shared_ptr<RequestContext> context, bool front) {
+    context->queued = true;
+    if (front)
+        _pendingQueue.push_front(std::move(context));
+    else
+        _pendingQueue.push_back(std::move(context));
+}
+
+void AsyncHttpClient::purgeDroppedFrontLocked() {
+    while (!_pendingQueue.empty() && _pendingQueue.front()->dropped) {
+        _pendingQueue.front()->queued = false;
+        _pendingQueue.pop_front();
+        _pendingDropped--;
     }
-    return false;
 }
 
 void AsyncHttpClient::executeOrQueue(std::shared_ptr<RequestContext> context) {
     if (!context)
         return;
     lock();
+    _contextsById[context->id] = context.get();
+    if (_rateLimiter.enabled() || (_memoryPolicy.enabled() && !_memoryPolicy.failFast)) {
+        // Admission (and FIFO order per origin) is decided by tryDequeue().
+        pushPendingLocked(std::move(context), false);
+        unlock();
+        tryDequeue();
+        return;
+    }
     if (_maxParallel > 0 && _activeRequests.size() >= _maxParallel) {
-        _pendingQueue.push_back(std::move(context));
+        pushPendingLocked(std::move(context), false);
         unlock();
         return;
     }
@@ -406,88 +1140,105 @@ void AsyncHttpClient::executeOrQueue(std::shared_ptr<RequestContext> context) {
     executeRequest(ctx);
 }
 
+void AsyncHttpClient::bindTransportHandlers(RequestContext* context) {
+    // The handlers hold the context weakly and lock it for the duration of each call, so the context survives a
+    // cleanup() that runs inside its own handler.
+    std::weak_ptr<RequestContext> weak;
+    lock();
+    for (auto& sp : _activeRequests) {
+        if (sp.get() == context) {
+            weak = sp;
+            break;
+        }
+    }
+    unlock();
+
+    RequestContext::TransportHandlers& handlers = context->handlers;
+    handlers.onConnect = [this, weak](void* /*arg*/, AsyncTransport* /*t*/) {
+        std::shared_ptr<RequestContext> ctx = weak.lock();
+        if (ctx && !ctx->cancelled.load())
+            handleConnect(ctx.get());
+    };
+    handlers.onData = [this, weak](void* /*arg*/, AsyncTransport* /*t*/, void* data, size_t len) {
+        std::shared_ptr<RequestContext> ctx = weak.lock();
+        if (ctx && !ctx->cancelled.load())
+            handleData(ctx.get(), static_cast<char*>(data), len);
+    };
+    handlers.onDisconnect = [this, weak](void* /*arg*/, AsyncTransport* /*t*/) {
+        std::shared_ptr<RequestContext> ctx = weak.lock();
+        if (ctx && !ctx->cancelled.load())
+            handleDisconnect(ctx.get());
+    };
+    handlers.onError = [this, weak](void* /*arg*/, AsyncTransport* /*t*/, HttpClientError error, const char* message) {
+        std::shared_ptr<RequestContext> ctx = weak.lock();
+        if (ctx && !ctx->cancelled.load())
+            handleTransportError(ctx.get(), error, message);
+    };
+    handlers.onTimeout = [this, weak](void* /*arg*/, AsyncTransport* /*t*/, uint32_t /*elapsed*/) {
+        std::shared_ptr<RequestContext> ctx = weak.lock();
+        if (!ctx || ctx->cancelled.load())
+            return;
+        if (ctx->request && ctx->request->msUntilDeadline(millis()) == 0)
+            triggerError(ctx.get(), DEADLINE_EXCEEDED, httpClientErrorToString(DEADLINE_EXCEEDED));
+        else
+            triggerError(ctx.get(), REQUEST_TIMEOUT, "Request timeout");
+    };
+    handlers.bound = true;
+}
+
 void AsyncHttpClient::executeRequest(RequestContext* context) {
+    uint32_t now = millis();
+    routeToEndpoint(context, now);
     if (_cookieJar)
         _cookieJar->applyCookies(context->request.get());
-    context->timing.connectStartMs = millis();
-    context->timing.connectTimeoutMs = _defaultConnectTimeout;
+    // Budget left before the end-to-end deadline: nothing is worth connecting for once it is spent.
+    uint32_t budgetMs = context->request->msUntilDeadline(now);
+    if (budgetMs == 0) {
+        triggerError(context, DEADLINE_EXCEEDED, httpClientErrorToString(DEADLINE_EXCEEDED));
+        return;
+    }
+    if (!context->timing.started) {
+        context->timing.started = true;
+        context->timing.firstAttemptMs = now;
+    }
+    if (!admitThroughCircuitBreaker(context)) {
+        triggerError(context, CIRCUIT_OPEN, httpClientErrorToString(CIRCUIT_OPEN));
+        return;
+    }
+    if (!chargeAdmission(context)) {
+        triggerError(context, MEMORY_BUDGET_EXCEEDED, httpClientErrorToString(MEMORY_BUDGET_EXCEEDED));
+        return;
+    }
+    context->timing.connectStartMs = now;
+    context->timing.connectTimeoutMs = std::min(_defaultConnectTimeout, budgetMs);
     context->resolvedTlsConfig = resolveTlsConfig(context->request.get());
+    context->poolKey.clear(); // the origin may have changed (redirect)
+    context->serverBrokeConnection = false;
     String connHeader = context->request->getHeader("Connection");
     context->requestKeepAlive = _keepAliveEnabled && !equalsIgnoreCase(connHeader, "close");
     AsyncTransport* pooled = nullptr;
-    if (context->requestKeepAlive && _connectionPool)
-        pooled = _connectionPool->checkoutPooledTransport(context->request.get(), context->resolvedTlsConfig,
-                                                          _keepAliveEnabled);
+    bool freshConnection = context->hedge.copy || context->retry.freshConnection; // hedges and stale replays
+    context->retry.freshConnection = false;
+    bool pipelinable = !freshConnection && pipelineEligible(context);
+    if (pipelinable && attachToPipeline(context))
+        return; // written behind the request in flight on a pooled connection
+    if (context->requestKeepAlive && _connectionPool && !freshConnection)
+        pooled = _connectionPool->checkoutPooledTransport(poolKey(context), _keepAliveEnabled,
+                                                          &context->connectionReuses);
     context->transport = pooled ? pooled : buildTransport(context);
     context->usingPooledConnection = pooled != nullptr;
+    context->connectionReuses = pooled ? context->connectionReuses + 1 : 0;
     if (!context->transport) {
         triggerError(context, HTTPS_NOT_SUPPORTED, "HTTPS transport unavailable");
         return;
     }
     if (context->usingPooledConnection)
         context->timing.connectTimeoutMs = 0;
-
-    // Find the shared_ptr for this context to capture in transport lambdas.
-    // This keeps the RequestContext alive even after cleanup() erases it from _activeRequests.
-    std::shared_ptr<RequestContext> ctxShared;
-    lock();
-    for (auto& sp : _activeRequests) {
-        if (sp.get() == context) {
-            ctxShared = sp;
-            break;
-        }
-    }
-    unlock();
-
-    context->transport->setConnectHandler(
-        [this, ctxShared](void* /*arg*/, AsyncTransport* t) {
-            (void)t;
-            if (ctxShared->cancelled.load())
-                return;
-            handleConnect(ctxShared.get());
-        },
-        nullptr);
-    context->transport->setDataHandler(
-        [this, ctxShared](void* /*arg*/, AsyncTransport* t, void* data, size_t len) {
-            (void)t;
-            if (ctxShared->cancelled.load())
-                return;
-            handleData(ctxShared.get(), static_cast<char*>(data), len);
-        },
-        nullptr);
-    context->transport->setDisconnectHandler(
-        [this, ctxShared](void* /*arg*/, AsyncTransport* t) {
-            (void)t;
-            if (ctxShared->cancelled.load())
-                return;
-            handleDisconnect(ctxShared.get());
-        },
-        nullptr);
-    context->transport->setErrorHandler(
-        [this, ctxShared](void* /*arg*/, AsyncTransport* t, HttpClientError error, const char* message) {
-            (void)t;
-            if (ctxShared->cancelled.load())
-                return;
-            handleTransportError(ctxShared.get(), error, message);
-        },
-        nullptr);
-
-#if ASYNC_TCP_HAS_TIMEOUT
-    context->transport->setTimeout(context->request->getTimeout());
-    context->transport->setTimeoutHandler(
-        [this, ctxShared](void* /*arg*/, AsyncTransport* transport, uint32_t t) {
-            (void)transport;
-            (void)t;
-            if (ctxShared->cancelled.load())
-                return;
-            triggerError(ctxShared.get(), REQUEST_TIMEOUT, "Request timeout");
-        },
-        nullptr);
-#else
-    context->timing.timeoutTimer = millis();
-#endif
+    armTransport(context, now, budgetMs);
 
     if (context->usingPooledConnection) {
+        if (pipelinable)
+            openPipeline(context);
         handleConnect(context); // Already connected, just send request
     } else if (!context->transport->connect(context->request->getHost().c_str(), context->request->getPort())) {
         triggerError(context, CONNECTION_FAILED, "Failed to initiate connection");
@@ -495,19 +1246,56 @@ void AsyncHttpClient::executeRequest(RequestContext* context) {
     }
 }
 
+void AsyncHttpClient::armTransport(RequestContext* context, uint32_t now, uint32_t budgetMs) {
+    if (!context->handlers.bound)
+        bindTransportHandlers(context);
+    context->transport->setConnectHandler(context->handlers.onConnect, nullptr);
+    context->transport->setDataHandler(context->handlers.onData, nullptr);
+    context->transport->setDisconnectHandler(context->handlers.onDisconnect, nullptr);
+    context->transport->setErrorHandler(context->handlers.onError, nullptr);
+
+#if ASYNC_TCP_HAS_TIMEOUT
+    // Retries, redirects and hedge copies share the request's total timeout: arm the transport with what is left of
+    // it, or of the deadline when that comes first.
+    uint32_t timeout = context->request->getTimeout();
+    if (timeout > 0) {
+        uint32_t elapsed = now - context->timing.firstAttemptMs;
+        timeout = elapsed < timeout ? timeout - elapsed : 1;
+    }
+    if (budgetMs != UINT32_MAX && (timeout == 0 || budgetMs < timeout))
+        timeout = budgetMs;
+    context->transport->setTimeout(timeout);
+    context->transport->setTimeoutHandler(context->handlers.onTimeout, nullptr);
+#else
+    (void)now;
+    (void)budgetMs;
+    context->timing.timeoutTimer = context->timing.firstAttemptMs;
+#endif
+}
+
 void AsyncHttpClient::handleConnect(RequestContext* context) {
     if (!context || context->cancelled.load() || !context->transport)
         return;
-    if (context->request->hasBodyStream()) {
-        String headers = context->request->buildHeadersOnly();
-        context->transport->write(headers.c_str(), headers.length());
-        context->headersSent = true;
+    writeRequest(context, context->transport);
+}
+
+void AsyncHttpClient::writeRequest(RequestContext* context, AsyncTransport* transport) {
+    // The request is serialized into the context's arena (heap fallback when it does not fit); a streamed body
+    // follows the head.
+    bool streaming = context->request->hasBodyStream();
+    size_t length = context->request->serializedLength(!streaming);
+    char* wire = static_cast<char*>(context->arena.allocate(length + 1));
+    if (!wire) {
+        triggerError(context, CONNECTION_FAILED, "Out of memory serializing request");
+        return;
+    }
+    context->request->serialize(wire, !streaming);
+    wire[length] = '\0'; // not sent; keeps the buffer a C string for transports that log it
+    transport->write(wire, length);
+    context->headersSent = true;
+    if (streaming) {
         context->streamingBodyInProgress = true;
         sendStreamData(context);
-    } else {
-        String full = context->request->buildHttpRequest();
-        context->transport->write(full.c_str(), full.length());
-        context->headersSent = true;
     }
 }
 
@@ -533,12 +1321,16 @@ bool AsyncHttpClient::emitBodyBytes(RequestContext* context, const char* out, si
         return false;
     }
     if (storeBody) {
+        if (!chargeBody(context, outLen)) {
+            triggerError(context, MEMORY_BUDGET_EXCEEDED, "Response body exceeds the client memory budget");
+            return false;
+        }
         context->response->appendBody(out, outLen);
     }
     context->receivedBodyLength += outLen;
     auto cb = _bodyChunkCallback;
     if (cb)
-        cb(out, outLen, false);
+        dispatchBodyChunk(cb, out, outLen, false);
     return true;
 }
 
@@ -632,9 +1424,12 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
             }
         }
         if (headerEnd != -1) {
-            String headerData = context->responseBuffer.substring(0, headerEnd);
-            if (parseResponseHeaders(context, headerData)) {
+            if (parseResponseHeaders(context, context->responseBuffer.c_str(), (size_t)headerEnd)) {
                 context->headersComplete = true;
+                notePipelineFraming(context);
+                recordCircuitOutcome(context, false);
+                recordEndpointOutcome(context, false);
+                resolveHedgeRace(context);
 #if ASYNC_HTTP_ENABLE_GZIP_DECODE
                 bool gzipActive = context->gzip.gzipDecodeActive;
 #else
@@ -652,9 +1447,14 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
                 context->responseBuffer.remove(0, headerEnd + 4);
                 if (_redirectHandler && _redirectHandler->handleRedirect(context))
                     return;
+                if (maybeRetryStatus(context))
+                    return;
                 // Deliver any leftover body bytes after the headers
                 if (!context->chunk.chunked && context->responseBuffer.length() > 0) {
-                    size_t incomingLen = context->responseBuffer.length();
+                    size_t incomingLen = pipelineBodyBytes(context, context->responseBuffer.length());
+                    if (incomingLen < context->responseBuffer.length())
+                        context->pipeline->carry.concat(context->responseBuffer.c_str() + incomingLen,
+                                                        context->responseBuffer.length() - incomingLen);
                     if (!gzipActive && wouldExceedBodyLimit(context, incomingLen, enforceLimit)) {
                         triggerError(context, MAX_BODY_SIZE_EXCEEDED, "Body exceeds configured maximum");
                         return;
@@ -662,7 +1462,7 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
                     if (!deliverWireBytes(context, context->responseBuffer.c_str(), incomingLen, storeBody,
                                           enforceLimit))
                         return;
-                    context->responseBuffer = "";
+                    context->responseBuffer.clear();
                 }
                 // For chunked: responseBuffer may contain partial chunk metadata + data;
                 // fall through to the chunked processing loop below.
@@ -678,11 +1478,14 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
 #else
         bool gzipActive = false;
 #endif
-        if (!gzipActive && wouldExceedBodyLimit(context, len, enforceLimit)) {
+        size_t bodyLen = pipelineBodyBytes(context, len);
+        if (bodyLen < len)
+            context->pipeline->carry.concat(data + bodyLen, len - bodyLen);
+        if (!gzipActive && wouldExceedBodyLimit(context, bodyLen, enforceLimit)) {
             triggerError(context, MAX_BODY_SIZE_EXCEEDED, "Body exceeds configured maximum");
             return;
         }
-        if (!deliverWireBytes(context, data, len, storeBody, enforceLimit))
+        if (!deliverWireBytes(context, data, bodyLen, storeBody, enforceLimit))
             return;
         dataOffset = len;
     } else {
@@ -690,8 +1493,10 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
         // directly from the incoming data buffer when possible.
         // Only buffer metadata (chunk size lines, trailers, partial bytes).
 
-        // First, if we have currentChunkRemaining > 0, deliver directly from data
-        while (dataOffset < len && context->chunk.currentChunkRemaining > 0) {
+        // First, if we have currentChunkRemaining > 0, deliver directly from data (unless the buffer still holds
+        // the start of the chunk, kept while waiting for its CRLF: then the new bytes follow it there)
+        while (dataOffset < len && context->chunk.currentChunkRemaining > 0 &&
+               context->responseBuffer.length() == 0) {
             size_t canDeliver = std::min(len - dataOffset, context->chunk.currentChunkRemaining);
             if (!deliverWireBytes(context, data + dataOffset, canDeliver, storeBody, enforceLimit))
                 return;
@@ -699,8 +1504,8 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
             context->chunk.currentChunkRemaining -= canDeliver;
 
             if (context->chunk.currentChunkRemaining == 0) {
-                // Need to consume the trailing \r\n after chunk data
-                // Append remaining data to responseBuffer for CRLF + next chunk size parsing
+                // The trailing \r\n after the chunk data is consumed by the parsing loop below
+                context->chunk.awaitingChunkDataCrlf = true;
                 break;
             }
         }
@@ -737,26 +1542,46 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
                 triggerError(context, CHUNKED_DECODE_FAILED, "Too many chunk trailers");
                 return;
             }
-            String trailerLine = context->responseBuffer.substring(0, lineEndT);
-            int colonPos = trailerLine.indexOf(':');
-            if (colonPos == -1) {
+            // Trailer lines are bounded (length and count), so their arena copies stay small.
+            char* trailerLine = context->arena.copy(context->responseBuffer.c_str(), (size_t)lineEndT);
+            if (!trailerLine) {
+                triggerError(context, CHUNKED_DECODE_FAILED, "Out of memory parsing chunk trailer");
+                return;
+            }
+            char* colon = strchr(trailerLine, ':');
+            if (!colon) {
                 triggerError(context, CHUNKED_DECODE_FAILED, "Chunk trailer missing colon");
                 return;
             }
-            String name = trailerLine.substring(0, colonPos);
-            String value = trailerLine.substring(colonPos + 1);
-            name.trim();
-            value.trim();
-            if (name.length() == 0) {
+            size_t nameLen = static_cast<size_t>(colon - trailerLine);
+            size_t valueLen = strlen(colon + 1);
+            char* name = trimField(trailerLine, &nameLen);
+            char* value = trimField(colon + 1, &valueLen);
+            if (nameLen == 0) {
                 triggerError(context, CHUNKED_DECODE_FAILED, "Chunk trailer name empty");
                 return;
             }
-            context->response->setTrailer(name, value);
+            lowercaseInPlace(name);
+            context->response->setLowercaseTrailer(name, value);
             context->chunk.trailerLineCount++;
             context->responseBuffer.remove(0, lineEndT + 2);
             continue;
         }
 
+        if (context->chunk.awaitingChunkDataCrlf) {
+            size_t available = context->responseBuffer.length();
+            if ((available >= 1 && context->responseBuffer.charAt(0) != '\r') ||
+                (available >= 2 && context->responseBuffer.charAt(1) != '\n')) {
+                triggerError(context, CHUNKED_DECODE_FAILED, "Chunk missing terminating CRLF");
+                return;
+            }
+            if (available < 2)
+                break; // wait for the CRLF
+            context->responseBuffer.remove(0, 2);
+            context->chunk.awaitingChunkDataCrlf = false;
+            continue;
+        }
+
         if (context->chunk.currentChunkRemaining == 0) {
             // Need to parse the next chunk size line from responseBuffer
             if (context->responseBuffer.length() > kMaxChunkSizeLineLen &&
@@ -777,10 +1602,8 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
                 triggerError(context, CHUNKED_DECODE_FAILED, "Chunk size line too long");
                 return;
             }
-            String sizeLine = context->responseBuffer.substring(0, lineEnd);
-            sizeLine.trim();
             uint32_t chunkSize = 0;
-            if (!parseChunkSizeLine(sizeLine, &chunkSize)) {
+            if (!parseChunkSizeLine(context->responseBuffer.c_str(), (size_t)lineEnd, &chunkSize)) {
                 triggerError(context, CHUNKED_DECODE_FAILED, "Chunk size parse error");
                 return;
             }
@@ -837,6 +1660,11 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
         }
     }
 
+    if (context->pipeline && context->chunk.chunkedComplete && context->responseBuffer.length() > 0) {
+        context->pipeline->carry.concat(context->responseBuffer.c_str(), context->responseBuffer.length());
+        context->responseBuffer.clear();
+    }
+
     if (context->headersComplete && !context->responseProcessed) {
         bool complete = false;
         if (context->chunk.chunked && context->chunk.chunkedComplete)
@@ -844,6 +1672,9 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
         else if (!context->chunk.chunked && context->expectedContentLength > 0 &&
                  context->receivedContentLength >= context->expectedContentLength)
             complete = true;
+        else if (!context->chunk.chunked && context->pipeline && context->pipelineFramed &&
+                 context->expectedContentLength == 0)
+            complete = true; // empty body (Content-Length: 0, 204, 304): the next bytes are the next response
         if (complete) {
             if (!finalizeDecoding(context, storeBody, enforceLimit))
                 return;
@@ -853,29 +1684,45 @@ void AsyncHttpClient::handleData(RequestContext* context, char* data, size_t len
 }
 
 bool AsyncHttpClient::parseChunkSizeLine(const String& line, uint32_t* outSize) {
-    if (!outSize)
+    return parseChunkSizeLine(line.c_str(), line.length(), outSize);
+}
+
+bool AsyncHttpClient::parseChunkSizeLine(const char* line, size_t len, uint32_t* outSize) {
+    if (!outSize || !line)
         return false;
-    if (line.length() == 0)
+    // Works on the raw line (no copy): surrounding whitespace is skipped and chunk extensions after ';' ignored.
+    while (len > 0 && isspace(static_cast<unsigned char>(line[0]))) {
+        ++line;
+        --len;
+    }
+    while (len > 0 && isspace(static_cast<unsigned char>(line[len - 1])))
+        --len;
+    if (len == 0)
         return false;
-    if (line.length() > kMaxChunkSizeLineLen)
+    if (len > kMaxChunkSizeLineLen)
         return false;
-    // Spec allows chunk extensions after size separated by ';'. We ignore extensions for now.
-    int semi = line.indexOf(';');
-    String sizePart = semi == -1 ? line : line.substring(0, semi);
-    sizePart.trim();
-    const char* cstr = sizePart.c_str();
-    char* endptr = nullptr;
-    errno = 0;
-    unsigned long val = strtoul(cstr, &endptr, 16);
-    if (cstr[0] == '\0')
+    const char* semi = static_cast<const char*>(memchr(line, ';', len));
+    size_t sizeLen = semi ? static_cast<size_t>(semi - line) : len;
+    while (sizeLen > 0 && isspace(static_cast<unsigned char>(line[sizeLen - 1])))
+        --sizeLen;
+    if (sizeLen == 0)
         return false; // empty after trim
-    if (endptr == cstr)
-        return false; // no digits parsed
-    if (errno == ERANGE)
-        return false; // overflow
-    // Must have consumed all hex digits; any leftover (excluding chunk extensions already removed) is invalid
-    if (*endptr != '\0')
-        return false;
+    uint64_t val = 0;
+    for (size_t i = 0; i < sizeLen; ++i) {
+        char c = line[i];
+        int digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return false; // leftover after the hex digits (excluding chunk extensions) is invalid
+        val = (val << 4) | (uint64_t)digit;
+        if (val > 0xFFFFFFFFull)
+            return false; // overflow
+    }
     *outSize = (uint32_t)val;
     return true;
 }
@@ -883,6 +1730,7 @@ bool AsyncHttpClient::parseChunkSizeLine(const String& line, uint32_t* outSize)
 void AsyncHttpClient::handleDisconnect(RequestContext* context) {
     if (!context || context->cancelled.load() || context->responseProcessed)
         return;
+    context->serverBrokeConnection = true; // also when the close ends the body: requests behind it got no answer
     if (!context->headersComplete) {
         triggerError(context, CONNECTION_CLOSED, "Connection closed before headers received");
         return;
@@ -920,69 +1768,80 @@ void AsyncHttpClient::handleTransportError(RequestContext* context, HttpClientEr
 }
 
 bool AsyncHttpClient::parseResponseHeaders(RequestContext* context, const String& headerData) {
-    int firstLineEnd = headerData.indexOf("\r\n");
-    if (firstLineEnd == -1)
+    return parseResponseHeaders(context, headerData.c_str(), headerData.length());
+}
+
+bool AsyncHttpClient::parseResponseHeaders(RequestContext* context, const char* headerData, size_t len) {
+    // headerData excludes the terminating blank line, so the last line carries no CRLF. It is copied once into the
+    // request arena and split in place: names and values become NUL-terminated slices of that copy.
+    char* block = context->arena.copy(headerData, len);
+    if (!block)
         return false;
-    String statusLine = headerData.substring(0, firstLineEnd);
-    int firstSpace = statusLine.indexOf(' ');
-    int secondSpace = statusLine.indexOf(' ', firstSpace + 1);
-    if (firstSpace == -1 || secondSpace == -1)
+    char* end = block + len;
+    char* lineEnd = strstr(block, "\r\n");
+    if (!lineEnd)
+        lineEnd = end;
+    *lineEnd = '\0';
+    char* firstSpace = strchr(block, ' ');
+    char* secondSpace = firstSpace ? strchr(firstSpace + 1, ' ') : nullptr;
+    if (!secondSpace)
         return false;
-    int statusCode = statusLine.substring(firstSpace + 1, secondSpace).toInt();
-    String statusText = statusLine.substring(secondSpace + 1);
+    *secondSpace = '\0';
+    int statusCode = atoi(firstSpace + 1);
     context->response->setStatusCode(statusCode);
-    context->response->setStatusText(statusText);
-    int lineStart = firstLineEnd + 2;
-    while (lineStart < headerData.length()) {
-        int lineEnd = headerData.indexOf("\r\n", lineStart);
-        if (lineEnd == -1)
-            break;
-        String line = headerData.substring(lineStart, lineEnd);
-        int colonPos = line.indexOf(':');
-        if (colonPos != -1) {
-            String name = line.substring(0, colonPos);
-            String value = line.substring(colonPos + 1);
-            name.trim();
-            value.trim();
-            String lowerName = name;
-            lowerName.toLowerCase();
-            context->response->setHeader(lowerName, value);
-            if (lowerName == "content-length") {
-                const char* clStr = value.c_str();
+    context->response->setStatusText(String(secondSpace + 1));
+
+    size_t lineCount = 0;
+    for (const char* p = lineEnd + 1; p < end; ++p)
+        lineCount += (*p == '\n');
+    context->response->reserveHeaders(lineCount + 1);
+
+    char* line = lineEnd < end ? lineEnd + 2 : end;
+    while (line < end) {
+        lineEnd = strstr(line, "\r\n");
+        if (!lineEnd)
+            lineEnd = end;
+        *lineEnd = '\0';
+        char* colon = strchr(line, ':');
+        if (colon) {
+            size_t nameLen = static_cast<size_t>(colon - line);
+            size_t valueLen = static_cast<size_t>(lineEnd - colon - 1);
+            char* name = trimField(line, &nameLen);
+            char* value = trimField(colon + 1, &valueLen);
+            lowercaseInPlace(name);
+            context->response->setLowercaseHeader(name, value);
+            if (strcmp(name, "content-length") == 0) {
                 char* endptr = nullptr;
                 errno = 0;
-                unsigned long cl = strtoul(clStr, &endptr, 10);
-                if (endptr == clStr || *endptr != '\0' || errno == ERANGE) {
+                unsigned long cl = strtoul(value, &endptr, 10);
+                if (endptr == value || *endptr != '\0' || errno == ERANGE) {
                     cl = 0; // invalid Content-Length, treat as unknown
                 }
                 context->expectedContentLength = (size_t)cl;
                 context->response->setContentLength(context->expectedContentLength);
-            } else if (lowerName == "transfer-encoding") {
-                String lower = value;
-                lower.toLowerCase();
-                if (lower.indexOf("chunked") != -1)
+            } else if (strcmp(name, "transfer-encoding") == 0) {
+                if (containsIgnoreCase(value, "chunked"))
                     context->chunk.chunked = true;
-            } else if (lowerName == "content-encoding") {
+            } else if (strcmp(name, "content-encoding") == 0) {
 #if ASYNC_HTTP_ENABLE_GZIP_DECODE
-                String lower = value;
-                lower.toLowerCase();
-                if (lower.indexOf("gzip") != -1) {
+                if (containsIgnoreCase(value, "gzip")) {
                     context->gzip.gzipEncoded = true;
                     context->gzip.gzipDecodeActive = true;
                     context->gzip.gzipDecoder.begin();
                 }
 #endif
-            } else if (lowerName == "connection") {
-                String lower = value;
-                lower.toLowerCase();
-                if (lower.indexOf("close") != -1)
+            } else if (strcmp(name, "connection") == 0) {
+                if (containsIgnoreCase(value, "close"))
                     context->serverRequestedClose = true;
-            } else if (lowerName == "set-cookie") {
+            } else if (strcmp(name, "keep-alive") == 0) {
+                ConnectionPool::parseKeepAliveHeader(value, &context->serverKeepAliveTimeoutMs,
+                                                     &context->serverKeepAliveMax);
+            } else if (strcmp(name, "set-cookie") == 0) {
                 if (_cookieJar)
-                    _cookieJar->storeResponseCookie(context->request.get(), value);
+                    _cookieJar->storeResponseCookie(context->request.get(), String(value));
             }
         }
-        lineStart = lineEnd + 2;
+        line = lineEnd + 2;
     }
     return true;
 }
@@ -995,11 +1854,13 @@ void AsyncHttpClient::processResponse(RequestContext* context) {
     auto cb = _bodyChunkCallback;
     if (cb && !context->notifiedEndCallback) {
         context->notifiedEndCallback = true;
-        cb(nullptr, 0, true);
+        dispatchBodyChunk(cb, nullptr, 0, true);
     }
     context->responseProcessed = true;
     if (context->onSuccess)
-        context->onSuccess(context->response);
+        dispatchSuccess(std::move(context->onSuccess), context->response);
+    if (context->batch)
+        _batcher->onItemSucceeded(context);
     cleanup(context);
 }
 
@@ -1007,8 +1868,18 @@ void AsyncHttpClient::cleanup(RequestContext* context) {
     // Signal cancellation BEFORE erasing — transport callbacks capturing
     // the shared_ptr will see this and bail out immediately.
     context->cancelled.store(true);
+    if (context->circuitProbe && context->request) {
+        // The probe ended without a verdict (aborted, local error): let the next request probe instead.
+        std::string key = circuitKey(context);
+        lock();
+        _circuitBreaker.releaseProbe(key);
+        context->circuitProbe = false;
+        unlock();
+    }
 
     AsyncTransport* toDelete = nullptr;
+    std::shared_ptr<Pipeline> handover;
+    std::vector<RequestContext*> orphans;
     if (context->transport) {
         bool recycle = false;
         if (_connectionPool) {
@@ -1018,26 +1889,42 @@ void AsyncHttpClient::cleanup(RequestContext* context) {
                 context->chunk.chunkedComplete, context->expectedContentLength, context->receivedContentLength,
                 _keepAliveEnabled);
         }
-        if (recycle && _connectionPool) {
-            _connectionPool->releaseConnectionToPool(context->transport, context->request.get(),
-                                                     context->resolvedTlsConfig);
+        if (context->pipeline && leavePipeline(context, &recycle, &handover, &orphans)) {
+            // The next pipelined request takes the connection over (below, once this context is gone).
+        } else if (recycle && _connectionPool) {
+            _connectionPool->releaseConnectionToPool(context->transport, poolKey(context), context->connectionReuses,
+                                                     context->serverKeepAliveTimeoutMs, context->serverKeepAliveMax);
         } else {
             toDelete = context->transport;
         }
         context->transport = nullptr;
+    } else if (context->pipeline) {
+        leavePipeline(context, nullptr, nullptr, &orphans); // queued behind another request: no transport of its own
     }
     context->request.reset();
     context->response.reset();
+    context->arena.reset();
+    releaseMemory(context);
+    // Keep the context alive until its index entry is gone: the active list may hold the last reference.
+    std::shared_ptr<RequestContext> keepAlive;
     lock();
     auto it = std::find_if(_activeRequests.begin(), _activeRequests.end(),
                            [context](const std::shared_ptr<RequestContext>& ptr) { return ptr.get() == context; });
-    if (it != _activeRequests.end())
+    if (it != _activeRequests.end()) {
+        keepAlive = std::move(*it);
         _activeRequests.erase(it);
+    }
+    auto indexed = _contextsById.find(context->id);
+    if (indexed != _contextsById.end() && indexed->second == context)
+        _contextsById.erase(indexed);
     unlock();
     if (toDelete) {
         toDelete->close();
         delete toDelete;
     }
+    if (handover)
+        advancePipeline(handover);
+    requeueOrphans(orphans);
     // Guard against recursion: cleanup → tryDequeue → executeRequest → triggerError → cleanup → tryDequeue
     // The outer tryDequeue's while-loop will handle remaining pending requests.
     if (!_inTryDequeue.load(std::memory_order_acquire))
@@ -1047,20 +1934,135 @@ void AsyncHttpClient::cleanup(RequestContext* context) {
 void AsyncHttpClient::triggerError(RequestContext* context, HttpClientError errorCode, const char* errorMessage) {
     if (context->cancelled.load() || context->responseProcessed)
         return;
+    if (errorCode == HEADER_PARSE_FAILED || errorCode == CHUNKED_DECODE_FAILED)
+        context->serverBrokeConnection = true;
+    if (context->request && !context->headersComplete) {
+        switch (errorCode) {
+        case CONNECTION_FAILED:
+        case CONNECT_TIMEOUT:
+        case TLS_HANDSHAKE_FAILED:
+        case TLS_HANDSHAKE_TIMEOUT:
+        case REQUEST_TIMEOUT:
+            recordCircuitOutcome(context, true);
+            recordEndpointOutcome(context, true);
+            break;
+        case CONNECTION_CLOSED:
+            // A stale pooled connection says nothing about the origin's health.
+            if (!context->usingPooledConnection) {
+                recordCircuitOutcome(context, true);
+                recordEndpointOutcome(context, true);
+            }
+            break;
+        case CIRCUIT_OPEN:
+            recordEndpointOutcome(context, true); // keeps the endpoint out of the selection while its circuit is open
+            break;
+        default:
+            break;
+        }
+    }
+    if (handOverToHedgeSibling(context))
+        return;
+    if (maybeReplayStaleConnection(context, errorCode))
+        return;
+    if (maybeFailOverEndpoint(context, errorCode))
+        return;
+    if (maybeRetryError(context, errorCode))
+        return;
     context->responseProcessed = true;
     if (context->onError)
-        context->onError(errorCode, errorMessage);
+        dispatchError(std::move(context->onError), errorCode, errorMessage);
+    if (context->batch)
+        _batcher->onItemFailed(context, errorCode, errorMessage);
     cleanup(context);
 }
 
+std::shared_ptr<CallbackExecutor> AsyncHttpClient::currentCallbackExecutor() const {
+    lock();
+    std::shared_ptr<CallbackExecutor> executor = _callbackExecutor;
+    unlock();
+    return executor;
+}
+
+void AsyncHttpClient::dispatchSuccess(SuccessCallback callback, std::shared_ptr<AsyncHttpResponse> response) {
+    std::shared_ptr<CallbackExecutor> executor = currentCallbackExecutor();
+    if (!executor || executor->runsInline()) {
+        callback(std::move(response));
+        return;
+    }
+    CallbackExecutor::Task task = [callback = std::move(callback), response = std::move(response)]() mutable {
+        callback(std::move(response));
+    };
+    if (!executor->post(std::move(task)))
+        task();
+}
+
+void AsyncHttpClient::dispatchError(ErrorCallback callback, HttpClientError errorCode, const char* errorMessage) {
+    std::shared_ptr<CallbackExecutor> executor = currentCallbackExecutor();
+    if (!executor || executor->runsInline()) {
+        callback(errorCode, errorMessage);
+        return;
+    }
+    // The message may point into transient storage: copy it for the deferred call.
+    std::string message(errorMessage ? errorMessage : "");
+    CallbackExecutor::Task task = [callback = std::move(callback), errorCode, message = std::move(message)]() {
+        callback(errorCode, message.c_str());
+    };
+    if (!executor->post(std::move(task)))
+        task();
+}
+
+void AsyncHttpClient::dispatchTask(CallbackExecutor::Task&& task) {
+    std::shared_ptr<CallbackExecutor> executor = currentCallbackExecutor();
+    if (!executor || !executor->post(std::move(task)))
+        task();
+}
+
+void AsyncHttpClient::dispatchBodyChunk(const BodyChunkCallback& callback, const char* data, size_t len, bool final) {
+    std::shared_ptr<CallbackExecutor> executor = currentCallbackExecutor();
+    if (!executor || executor->runsInline()) {
+        callback(data, len, final);
+        return;
+    }
+    // Chunk bytes are only valid during this call; the deferred task owns a copy.
+    std::string bytes;
+    if (data && len > 0)
+        bytes.assign(data, len);
+    CallbackExecutor::Task task = [callback, bytes = std::move(bytes), final]() {
+        callback(bytes.empty() ? nullptr : bytes.data(), bytes.size(), final);
+    };
+    if (!executor->post(std::move(task)))
+        task();
+}
+
 void AsyncHttpClient::loop() {
+    lock();
+    drainSubmissionsLocked();
+    unlock();
     uint32_t now = millis();
-    if (_connectionPool)
+    lock();
+    bool dispatchDue = _dispatchWaiting && static_cast<int32_t>(now - _dispatchWakeMs) >= 0;
+    unlock();
+    if (dispatchDue)
+        tryDequeue();
+    expirePendingDeadlines(now);
+    if (_connectionPool) {
         _connectionPool->pruneIdleConnections(_keepAliveEnabled, _keepAliveIdleMs);
+        expireWarmups(now);
+        maintainWarmConnections(now);
+    }
     // Iterate safely even if callbacks remove entries: use index loop.
+    std::vector<std::shared_ptr<RequestContext>> hedgeDue;
     lock();
+    uint32_t hedgeDelayMs = _hedgePolicy.enabled() ? _hedgePolicy.effectiveDelayMs(_headerLatency) : 0;
     for (size_t i = 0; i < _activeRequests.size();) {
         RequestContext* ctx = _activeRequests[i].get();
+        if (!ctx->cancelled.load() && !ctx->responseProcessed && ctx->request &&
+            ctx->request->msUntilDeadline(now) == 0) {
+            unlock();
+            triggerError(ctx, DEADLINE_EXCEEDED, httpClientErrorToString(DEADLINE_EXCEEDED));
+            lock();
+            continue; // ctx may be freed; re-read at current index
+        }
 #if !ASYNC_TCP_HAS_TIMEOUT
         if (!ctx->cancelled.load() && !ctx->responseProcessed &&
             (now - ctx->timing.timeoutTimer) >= ctx->request->getTimeout()) {
@@ -1093,6 +2095,9 @@ void AsyncHttpClient::loop() {
             sendStreamData(ctx);
             lock();
         }
+        if (hedgeDelayMs > 0 && i < _activeRequests.size() && _activeRequests[i].get() == ctx &&
+            isHedgeCandidate(ctx, now, hedgeDelayMs))
+            hedgeDue.push_back(_activeRequests[i]);
         // If triggerError/processResponse cleaned up ctx, current index now holds a different pointer.
         if (i < _activeRequests.size() && _activeRequests[i].get() == ctx) {
             ++i; // still present, advance
@@ -1100,20 +2105,36 @@ void AsyncHttpClient::loop() {
         // else do not advance: current i now refers to next element after erase
     }
     unlock();
+    for (auto& original : hedgeDue)
+        fireHedge(original);
 }
 
 void AsyncHttpClient::tryDequeue() {
     if (_inTryDequeue.exchange(true, std::memory_order_acq_rel))
         return; // prevent recursion via executeRequest → triggerError → cleanup → tryDequeue
+    lock();
+    drainSubmissionsLocked();
+    unlock();
     while (true) {
         lock();
+        purgeDroppedFrontLocked();
         bool canStart = (_maxParallel == 0 || _activeRequests.size() < _maxParallel);
         if (!canStart || _pendingQueue.empty()) {
+            if (_pendingQueue.empty())
+                _dispatchWaiting = false;
             unlock();
             break;
         }
-        _activeRequests.push_back(std::move(_pendingQueue.front()));
-        _pendingQueue.pop_front();
+        size_t index = 0;
+        bool gated = _rateLimiter.enabled() || _retryWaitingCount > 0 ||
+                     (_memoryPolicy.enabled() && !_memoryPolicy.failFast);
+        if (gated && !nextDispatchableLocked(millis(), &index)) {
+            unlock();
+            break;
+        }
+        _pendingQueue[index]->queued = false;
+        _activeRequests.push_back(std::move(_pendingQueue[index]));
+        _pendingQueue.erase(_pendingQueue.begin() + index);
         RequestContext* ctx = _activeRequests.back().get();
         unlock();
         executeRequest(ctx);
@@ -1121,6 +2142,810 @@ void AsyncHttpClient::tryDequeue() {
     _inTryDequeue.store(false, std::memory_order_release);
 }
 
+bool AsyncHttpClient::nextDispatchableLocked(uint32_t now, size_t* outIndex) {
+    // First pending request that is past its retry backoff, fits the memory budget and whose origin (and the global
+    // bucket) has a token. Skipping over a throttled origin keeps other origins flowing; requests of the same origin
+    // stay FIFO since their bucket refuses them all alike. Memory is not skipped over: a large request is not starved
+    // by smaller ones behind it.
+    uint32_t minWait = UINT32_MAX;
+    bool rateLimited = _rateLimiter.enabled();
+    bool memoryGated = _memoryPolicy.enabled() && !_memoryPolicy.failFast;
+    for (size_t i = 0; i < _pendingQueue.size(); ++i) {
+        RequestContext* ctx = _pendingQueue[i].get();
+        if (ctx->dropped)
+            continue;
+        if (ctx->retry.waiting) {
+            int32_t remaining = static_cast<int32_t>(ctx->retry.notBeforeMs - now);
+            if (remaining > 0) {
+                if (static_cast<uint32_t>(remaining) < minWait)
+                    minWait = static_cast<uint32_t>(remaining);
+                continue;
+            }
+        }
+        if (memoryGated && !memoryAdmitsLocked(ctx)) {
+            if (kMemoryRecheckMs < minWait)
+                minWait = kMemoryRecheckMs;
+            break;
+        }
+        const AsyncHttpRequest* request = ctx->request.get();
+        if (rateLimited && request) {
+            std::string key =
+                RateLimiter::makeOriginKey(request->getHost().c_str(), request->getPort(), request->isSecure());
+            uint32_t waitMs = 0;
+            RateLimiter::Result result = _rateLimiter.tryAcquire(key, now, &waitMs);
+            if (result != RateLimiter::Result::kGranted) {
+                if (waitMs < minWait)
+                    minWait = waitMs;
+                if (result == RateLimiter::Result::kGlobalLimited)
+                    break; // nothing else can go either
+                continue;
+            }
+        }
+        if (ctx->retry.waiting) {
+            ctx->retry.waiting = false;
+            _retryWaitingCount--;
+        }
+        *outIndex = i;
+        _dispatchWaiting = false; // the caller's next pass re-evaluates the remaining requests
+        return true;
+    }
+    _dispatchWaiting = false;
+    scheduleDispatchWakeLocked(now + (minWait == UINT32_MAX || minWait == 0 ? 1 : minWait));
+    return false;
+}
+
+void AsyncHttpClient::scheduleDispatchWakeLocked(uint32_t wakeMs) {
+    if (!_dispatchWaiting || static_cast<int32_t>(wakeMs - _dispatchWakeMs) < 0)
+        _dispatchWakeMs = wakeMs;
+    _dispatchWaiting = true;
+}
+
+void AsyncHttpClient::resetResponseState(RequestContext* context) {
+    if (context->pipeline) {
+        std::vector<RequestContext*> orphans;
+        leavePipeline(context, nullptr, nullptr, &orphans);
+        requeueOrphans(orphans);
+    }
+    if (context->transport) {
+        context->transport->close();
+        delete context->transport;
+        context->transport = nullptr;
+    }
+    context->response = makeResponse();
+    context->responseBuffer.clear();
+    context->arena.reset();
+    releaseMemory(context); // charged again when the retry / redirect starts
+    context->headersComplete = false;
+    context->responseProcessed = false;
+    context->expectedContentLength = 0;
+    context->receivedContentLength = 0;
+    context->receivedBodyLength = 0;
+    context->chunk = RequestContext::ChunkParseState();
+    context->headersSent = false;
+    context->streamingBodyInProgress = false;
+    context->notifiedEndCallback = false;
+    context->requestKeepAlive = false;
+    context->serverRequestedClose = false;
+    context->serverKeepAliveTimeoutMs = 0;
+    context->serverKeepAliveMax = ConnectionPool::kNoRequestLimit;
+    context->usingPooledConnection = false;
+    context->pipelineFramed = false;
+    context->resolvedTlsConfig = AsyncHttpTLSConfig();
+    context->poolKey.clear();
+#if ASYNC_HTTP_ENABLE_GZIP_DECODE
+    context->gzip.gzipEncoded = false;
+    context->gzip.gzipDecodeActive = false;
+    context->gzip.gzipDecoder.reset();
+#endif
+}
+
+void AsyncHttpClient::expirePendingDeadlines(uint32_t now) {
+    std::vector<std::shared_ptr<RequestContext>> expired;
+    lock();
+    for (auto it = _pendingQueue.begin(); it != _pendingQueue.end();) {
+        if ((*it)->dropped) { // already reported: just shed the tombstone
+            (*it)->queued = false;
+            it = _pendingQueue.erase(it);
+            _pendingDropped--;
+            continue;
+        }
+        const AsyncHttpRequest* request = (*it)->request.get();
+        if (request && request->msUntilDeadline(now) == 0) {
+            (*it)->queued = false;
+            if ((*it)->retry.waiting) {
+                (*it)->retry.waiting = false;
+                _retryWaitingCount--;
+            }
+            expired.push_back(std::move(*it));
+            it = _pendingQueue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    unlock();
+    // Dropped before ever connecting: the caller has already given up on them.
+    for (auto& context : expired)
+        triggerError(context.get(), DEADLINE_EXCEEDED, httpClientErrorToString(DEADLINE_EXCEEDED));
+}
+
+bool AsyncHttpClient::isHedgeCandidate(const RequestContext* context, uint32_t now, uint32_t delayMs) const {
+    if (context->cancelled.load() || context->responseProcessed || context->headersComplete || !context->transport)
+        return false;
+    if (context->hedge.fired || context->hedge.copy || !context->request)
+        return false;
+    // A body stream cannot be read by two connections at once.
+    if (!context->request->isIdempotent() || context->request->hasBodyStream())
+        return false;
+    return (now - context->timing.connectStartMs) >= delayMs;
+}
+
+void AsyncHttpClient::fireHedge(const std::shared_ptr<RequestContext>& original) {
+    lock();
+    if (original->cancelled.load() || original->responseProcessed || original->headersComplete ||
+        original->hedge.fired || !original->request) {
+        unlock();
+        return;
+    }
+    // The copy takes a parallel slot and a rate-limit token like any request; without them, try again next loop().
+    if (_maxParallel > 0 && _activeRequests.size() >= _maxParallel) {
+        unlock();
+        return;
+    }
+    if (_rateLimiter.enabled()) {
+        std::string key = circuitKey(original.get());
+        if (_rateLimiter.tryAcquire(key, millis(), nullptr) != RateLimiter::Result::kGranted) {
+            unlock();
+            return;
+        }
+    }
+    auto copy = makeContext();
+    copy->request = original->request->clone();
+    copy->response = makeResponse();
+    copy->id = original->id;
+    copy->redirect = original->redirect;
+    copy->retry.attempt = original->retry.attempt;
+    copy->route = original->route;
+    if (copy->route.endpoint >= 0)
+        copy->route.tried |= 1u << copy->route.endpoint; // race another endpoint when the group has one
+    copy->timing.started = true;
+    copy->timing.firstAttemptMs = original->timing.firstAttemptMs;
+    copy->hedge.fired = true;
+    copy->hedge.copy = true;
+    copy->hedge.sibling = original;
+    original->hedge.fired = true;
+    original->hedge.sibling = copy;
+    _hedgesFired++;
+    _activeRequests.push_back(copy);
+    unlock();
+    executeRequest(copy.get());
+}
+
+std::shared_ptr<AsyncHttpClient::RequestContext> AsyncHttpClient::detachHedgeSiblingLocked(RequestContext* keep) {
+    std::shared_ptr<RequestContext> other = keep->hedge.sibling.lock();
+    keep->hedge.sibling.reset();
+    if (!other)
+        return nullptr;
+    other->hedge.sibling.reset();
+    if (keep->hedge.copy) {
+        // The copy carries the request from now on: callbacks and batch membership follow it.
+        keep->onSuccess = std::move(other->onSuccess);
+        keep->onError = std::move(other->onError);
+        keep->batch = std::move(other->batch);
+        keep->batchIndex = other->batchIndex;
+        keep->hedge.copy = false;
+        other->hedge.copy = true;
+        _contextsById[keep->id] = keep;
+    }
+    if (other->cancelled.load())
+        return nullptr;
+    return other;
+}
+
+void AsyncHttpClient::resolveHedgeRace(RequestContext* winner) {
+    lock();
+    if (_hedgePolicy.enabled())
+        _headerLatency.record(millis() - winner->timing.connectStartMs);
+    bool copyWon = winner->hedge.copy;
+    std::shared_ptr<RequestContext> loser = detachHedgeSiblingLocked(winner);
+    if (loser && copyWon)
+        _hedgesWon++;
+    unlock();
+    if (loser)
+        cleanup(loser.get()); // no callbacks left on the loser: it goes away silently
+}
+
+bool AsyncHttpClient::handOverToHedgeSibling(RequestContext* failed) {
+    lock();
+    std::shared_ptr<RequestContext> survivor = failed->hedge.sibling.lock();
+    if (!survivor || survivor->cancelled.load() || survivor->responseProcessed) {
+        unlock();
+        return false;
+    }
+    // One copy failed while the other is still running: drop this one silently and let the other answer.
+    detachHedgeSiblingLocked(survivor.get());
+    unlock();
+    cleanup(failed);
+    return true;
+}
+
+const std::string& AsyncHttpClient::poolKey(RequestContext* context) const {
+    if (context->poolKey.empty())
+        context->poolKey = ConnectionPool::makeKey(context->request.get(), context->resolvedTlsConfig);
+    return context->poolKey;
+}
+
+std::string AsyncHttpClient::circuitKey(const RequestContext* context) const {
+    const AsyncHttpRequest* request = context->request.get();
+    return RateLimiter::makeOriginKey(request->getHost().c_str(), request->getPort(), request->isSecure());
+}
+
+bool AsyncHttpClient::admitThroughCircuitBreaker(RequestContext* context) {
+    lock();
+    bool enabled = _circuitBreaker.enabled();
+    unlock();
+    if (!enabled)
+        return true;
+    std::string key = circuitKey(context);
+    lock();
+    CircuitBreaker::Decision decision = _circuitBreaker.allow(key, millis());
+    if (decision == CircuitBreaker::Decision::kProbe)
+        context->circuitProbe = true;
+    unlock();
+    return decision != CircuitBreaker::Decision::kReject;
+}
+
+void AsyncHttpClient::setMemoryBudget(const AsyncHttpMemoryBudget& budget) {
+    lock();
+    _memoryPolicy = budget;
+    _memoryBudget.configure(budget.maxBytes);
+    unlock();
+    tryDequeue(); // a larger budget may admit queued requests
+}
+
+AsyncHttpMemoryStats AsyncHttpClient::getMemoryStats() const {
+    return _memoryBudget.stats();
+}
+
+size_t AsyncHttpClient::admissionCost(const RequestContext* context) const {
+    // Header buffer (bounded by the header limit), request arena, TLS record buffers and the in-memory upload body.
+    size_t cost = (_maxHeaderBytes > 0 ? _maxHeaderBytes : kDefaultMaxHeaderBytes) + _requestArenaSize;
+    const AsyncHttpRequest* request = context->request.get();
+    if (request) {
+        if (request->isSecure())
+            cost += _memoryPolicy.tlsReserve;
+        cost += request->getBodyLength();
+    }
+    return cost;
+}
+
+bool AsyncHttpClient::memoryAdmitsLocked(RequestContext* context) {
+    bool admits = _memoryBudget.fits(admissionCost(context)) &&
+                  (_memoryPolicy.minFreeHeap == 0 || freeHeapBytes() >= _memoryPolicy.minFreeHeap);
+    if (!admits && !context->memory.deferred) {
+        context->memory.deferred = true;
+        _memoryBudget.noteDeferred();
+    }
+    return admits;
+}
+
+bool AsyncHttpClient::chargeAdmission(RequestContext* context) {
+    lock();
+    bool enabled = _memoryPolicy.enabled();
+    bool failFast = _memoryPolicy.failFast;
+    size_t minFreeHeap = _memoryPolicy.minFreeHeap;
+    size_t cost = admissionCost(context);
+    unlock();
+    if (!enabled || context->memory.reserved > 0)
+        return true;
+    if (!failFast) {
+        _memoryBudget.charge(cost); // admitted by nextDispatchableLocked()
+    } else if (!_memoryBudget.tryCharge(cost)) {
+        _memoryBudget.noteRejected();
+        return false;
+    } else if (minFreeHeap > 0 && freeHeapBytes() < minFreeHeap) {
+        _memoryBudget.release(cost);
+        _memoryBudget.noteRejected();
+        return false;
+    }
+    context->memory.reserved = cost;
+    return true;
+}
+
+bool AsyncHttpClient::chargeBody(RequestContext* context, size_t bytes) {
+    lock();
+    bool enabled = _memoryPolicy.enabled();
+    unlock();
+    if (!enabled)
+        return true;
+    // A request running alone is bounded by the body size limit only, like one larger than the whole budget.
+    bool alone = _memoryBudget.used() == context->memory.reserved + context->memory.body;
+    if (alone) {
+        _memoryBudget.charge(bytes);
+    } else if (!_memoryBudget.tryCharge(bytes)) {
+        _memoryBudget.noteRejected();
+        return false;
+    }
+    context->memory.body += bytes;
+    return true;
+}
+
+void AsyncHttpClient::releaseMemory(RequestContext* context) {
+    size_t charged = context->memory.reserved + context->memory.body;
+    if (charged > 0)
+        _memoryBudget.release(charged);
+    context->memory.reserved = 0;
+    context->memory.body = 0;
+}
+
+void AsyncHttpClient::recordCircuitOutcome(RequestContext* context, bool failed) {
+    lock();
+    bool enabled = _circuitBreaker.enabled();
+    unlock();
+    if (!enabled)
+        return;
+    std::string key = circuitKey(context);
+    lock();
+    if (failed)
+        _circuitBreaker.recordFailure(key, millis());
+    else
+        _circuitBreaker.recordSuccess(key, millis());
+    context->circuitProbe = false;
+    unlock();
+}
+
+AsyncHttpRetryPolicy AsyncHttpClient::resolveRetryPolicy(const RequestContext* context) const {
+    if (context->request && context->request->hasRetryPolicy())
+        return *context->request->getRetryPolicy();
+    lock();
+    AsyncHttpRetryPolicy policy = _retryPolicy;
+    unlock();
+    return policy;
+}
+
+bool AsyncHttpClient::maybeRetryError(RequestContext* context, HttpClientError errorCode) {
+    // Only failures before any response byte was delivered are transparent to retry.
+    if (!context->request || context->headersComplete)
+        return false;
+    AsyncHttpRetryPolicy::RetryOn condition;
+    switch (errorCode) {
+    case CONNECTION_FAILED:
+        condition = AsyncHttpRetryPolicy::kRetryOnConnectFailed;
+        break;
+    case CONNECT_TIMEOUT:
+        condition = AsyncHttpRetryPolicy::kRetryOnConnectTimeout;
+        break;
+    case CONNECTION_CLOSED:
+        condition = context->usingPooledConnection ? AsyncHttpRetryPolicy::kRetryOnStaleConnection
+                                                   : AsyncHttpRetryPolicy::kRetryOnConnectionClosed;
+        break;
+    case TLS_HANDSHAKE_FAILED:
+    case TLS_HANDSHAKE_TIMEOUT:
+        condition = AsyncHttpRetryPolicy::kRetryOnTlsHandshake;
+        break;
+    default:
+        return false;
+    }
+    AsyncHttpRetryPolicy policy = resolveRetryPolicy(context);
+    if (!policy.enabled() || !policy.retries(condition))
+        return false;
+    return scheduleRetry(context, policy,
+                         policy.backoffDelayMs(context->retry.attempt, static_cast<uint32_t>(random(0x7FFFFFFF))));
+}
+
+bool AsyncHttpClient::maybeRetryStatus(RequestContext* context) {
+    int status = context->response ? context->response->getStatusCode() : 0;
+    AsyncHttpRetryPolicy::RetryOn condition;
+    if (status == 503)
+        condition = AsyncHttpRetryPolicy::kRetryOnStatus503;
+    else if (status == 429)
+        condition = AsyncHttpRetryPolicy::kRetryOnStatus429;
+    else
+        return false;
+    AsyncHttpRetryPolicy policy = resolveRetryPolicy(context);
+    if (!policy.enabled() || !policy.retries(condition))
+        return false;
+    uint32_t delayMs = policy.backoffDelayMs(context->retry.attempt, static_cast<uint32_t>(random(0x7FFFFFFF)));
+    String retryAfter = context->response->getHeader("retry-after");
+    if (policy.honorRetryAfter && !retryAfter.isEmpty()) {
+        String date = context->response->getHeader("date");
+        uint32_t retryAfterMs = 0;
+        if (AsyncHttpRetryPolicy::parseRetryAfter(retryAfter.c_str(), date.isEmpty() ? nullptr : date.c_str(),
+                                                  &retryAfterMs)) {
+            if (retryAfterMs > policy.maxRetryAfterMs)
+                return false; // the server asks for longer than we are willing to wait: deliver the response
+            delayMs = retryAfterMs;
+        }
+    }
+    return scheduleRetry(context, policy, delayMs);
+}
+
+bool AsyncHttpClient::scheduleRetry(RequestContext* context, const AsyncHttpRetryPolicy& policy, uint32_t delayMs) {
+    if (context->cancelled.load() || context->retry.attempt >= policy.maxAttempts)
+        return false;
+    AsyncHttpRequest* request = context->request.get();
+    if (!request->isIdempotent() && !policy.retryNonIdempotent)
+        return false;
+    uint32_t now = millis();
+    uint32_t timeout = request->getTimeout();
+    if (timeout > 0 && (now - context->timing.firstAttemptMs) + delayMs >= timeout)
+        return false; // the retry could not finish within the request's total timeout
+    if (request->msUntilDeadline(now) <= delayMs)
+        return false; // nor before its deadline
+    if (request->hasBodyStream() && !request->rewindBodyStream())
+        return false;
+    if (!requeueAttempt(context, delayMs, true))
+        return false;
+    // A slot was freed: let other pending requests use it while this one backs off.
+    if (!_inTryDequeue.load(std::memory_order_acquire))
+        tryDequeue();
+    return true;
+}
+
+bool AsyncHttpClient::maybeReplayStaleConnection(RequestContext* context, HttpClientError errorCode) {
+    // The server closed the pooled connection while it sat idle and our request met the FIN / RST: nothing was
+    // processed, so an idempotent request is sent again on a new connection, once, regardless of the retry policy.
+    if (errorCode != CONNECTION_CLOSED || !context->usingPooledConnection || context->retry.staleReplayed)
+        return false;
+    if (!context->request || context->cancelled.load() || context->headersComplete ||
+        context->responseBuffer.length() > 0)
+        return false;
+    AsyncHttpRequest* request = context->request.get();
+    uint32_t now = millis();
+    uint32_t timeout = request->getTimeout();
+    if (!request->isIdempotent() || request->msUntilDeadline(now) == 0 ||
+        (timeout > 0 && now - context->timing.firstAttemptMs >= timeout))
+        return false;
+    if (request->hasBodyStream() && !request->rewindBodyStream())
+        return false;
+    context->retry.staleReplayed = true;
+    context->retry.freshConnection = true; // the other idle connections to the origin are likely stale as well
+    if (!requeueAttempt(context, 0, false)) {
+        context->retry.freshConnection = false;
+        return false;
+    }
+    lock();
+    _staleReplays++;
+    unlock();
+    if (!_inTryDequeue.load(std::memory_order_acquire))
+        tryDequeue();
+    return true;
+}
+
+void AsyncHttpClient::routeToEndpoint(RequestContext* context, uint32_t now) {
+    AsyncHttpRequest* request = context->request.get();
+    RequestContext::RouteState& route = context->route;
+    lock();
+    if (_endpointGroups.empty() && route.group.empty()) {
+        unlock();
+        return;
+    }
+    if (!route.group.empty()) {
+        // Still routed unless a redirect took the request to another host.
+        const EndpointGroups::Endpoint* current = _endpointGroups.endpoint(route.group, route.endpoint);
+        if (!request->getHost().equalsIgnoreCase(route.group.c_str()) &&
+            !(current && request->getHost().equalsIgnoreCase(current->host.c_str())))
+            route = RequestContext::RouteState();
+    }
+    if (route.group.empty()) {
+        if (!_endpointGroups.hasGroup(request->getHost().c_str())) {
+            unlock();
+            return;
+        }
+        route.group = request->getHost().c_str();
+    }
+    unlock();
+    // Pool keys of the candidates use the request's TLS profile, like the connection the request would open.
+    AsyncHttpTLSConfig tls = resolveTlsConfig(request);
+    ConnectionPool* pool = _connectionPool.get();
+    EndpointGroups::WarmProbe warm;
+    if (pool && _keepAliveEnabled && !equalsIgnoreCase(request->getHeader("Connection"), "close"))
+        warm = [pool, &tls](const EndpointGroups::Endpoint& endpoint) {
+            std::string key = ConnectionPool::makeKey(endpoint.host.c_str(), endpoint.port, endpoint.secure, tls);
+            return pool->idleCount(key) > 0;
+        };
+    lock();
+    int index = _endpointGroups.select(route.group, route.tried, now, warm);
+    if (index < 0) {
+        route.tried = 0; // every endpoint failed this request once (a retry): start over
+        index = _endpointGroups.select(route.group, 0, now, warm);
+    }
+    const EndpointGroups::Endpoint* endpoint = _endpointGroups.endpoint(route.group, index);
+    route.endpoint = index;
+    if (endpoint)
+        request->setTarget(String(endpoint->host.c_str()), endpoint->port, endpoint->secure);
+    else
+        route = RequestContext::RouteState(); // the group was removed
+    unlock();
+}
+
+void AsyncHttpClient::recordEndpointOutcome(RequestContext* context, bool failed) {
+    RequestContext::RouteState& route = context->route;
+    if (route.endpoint < 0)
+        return;
+    uint32_t now = millis();
+    lock();
+    if (failed)
+        _endpointGroups.recordFailure(route.group, route.endpoint, now);
+    else
+        _endpointGroups.recordSuccess(route.group, route.endpoint, now - context->timing.connectStartMs);
+    unlock();
+}
+
+bool AsyncHttpClient::maybeFailOverEndpoint(RequestContext* context, HttpClientError errorCode) {
+    // Nothing reached the application yet: the request is sent to another endpoint of its group instead of failing.
+    RequestContext::RouteState& route = context->route;
+    if (route.endpoint < 0 || !context->request || context->cancelled.load() || context->headersComplete)
+        return false;
+    AsyncHttpRequest* request = context->request.get();
+    switch (errorCode) {
+    case CONNECTION_FAILED:
+    case CONNECT_TIMEOUT:
+    case TLS_HANDSHAKE_FAILED:
+    case TLS_HANDSHAKE_TIMEOUT:
+    case CIRCUIT_OPEN:
+        break;
+    case CONNECTION_CLOSED:
+        // Closed before answering: the server may have seen the request.
+        if (context->usingPooledConnection || !request->isIdempotent())
+            return false;
+        break;
+    default:
+        return false;
+    }
+    uint32_t now = millis();
+    uint32_t timeout = request->getTimeout();
+    if (request->msUntilDeadline(now) == 0 || (timeout > 0 && now - context->timing.firstAttemptMs >= timeout))
+        return false;
+    uint32_t tried = route.tried | (1u << route.endpoint);
+    lock();
+    size_t endpoints = _endpointGroups.size(route.group);
+    uint32_t all = endpoints >= 32 ? 0xFFFFFFFFu : (1u << endpoints) - 1;
+    bool candidate = route.failovers < _endpointGroups.policy().maxFailovers && (tried & all) != all;
+    unlock();
+    if (!candidate)
+        return false;
+    if (request->hasBodyStream() && !request->rewindBodyStream())
+        return false;
+    uint8_t failovers = route.failovers;
+    route.tried = tried;
+    route.failovers++;
+    if (!requeueAttempt(context, 0, false)) {
+        route.failovers = failovers;
+        return false;
+    }
+    lock();
+    _endpointFailovers++;
+    unlock();
+    if (!_inTryDequeue.load(std::memory_order_acquire))
+        tryDequeue();
+    return true;
+}
+
+bool AsyncHttpClient::pipelineEligible(const RequestContext* context) const {
+    if (_pipelineDepth < 2 || !_connectionPool || !context->requestKeepAlive || context->hedge.copy)
+        return false;
+    // HEAD responses advertise a Content-Length they do not carry; streamed bodies hold the connection while they
+    // upload.
+    const AsyncHttpRequest* request = context->request.get();
+    return request->isIdempotent() && request->getMethod() != HTTP_METHOD_HEAD && !request->hasBodyStream();
+}
+
+bool AsyncHttpClient::attachToPipeline(RequestContext* context) {
+    const std::string& key = poolKey(context);
+    std::shared_ptr<Pipeline> pipeline;
+    lock();
+    auto it = _pipelines.find(key);
+    if (it != _pipelines.end() && it->second->open && it->second->inFlight.size() < _pipelineDepth) {
+        pipeline = it->second;
+        pipeline->inFlight.push_back(context);
+        context->pipeline = pipeline;
+        _pipelinedRequests++;
+    }
+    unlock();
+    if (!pipeline)
+        return false;
+    context->usingPooledConnection = true;
+    context->timing.connectTimeoutMs = 0;
+#if !ASYNC_TCP_HAS_TIMEOUT
+    context->timing.timeoutTimer = context->timing.firstAttemptMs;
+#endif
+    // The transport's handlers stay with the front request until its response is complete (advancePipeline()).
+    writeRequest(context, pipeline->transport);
+    return true;
+}
+
+void AsyncHttpClient::openPipeline(RequestContext* context) {
+    // Only reused connections start a pipeline: the server already answered on them with keep-alive.
+    const std::string& key = poolKey(context);
+    uint32_t now = millis();
+    lock();
+    auto refused = std::find_if(_pipelineRefused.begin(), _pipelineRefused.end(),
+                                [&key](const PipelineRefusal& refusal) { return refusal.poolKey == key; });
+    if (refused != _pipelineRefused.end() && static_cast<int32_t>(now - refused->untilMs) >= 0) {
+        _pipelineRefused.erase(refused);
+        refused = _pipelineRefused.end();
+    }
+    if (refused == _pipelineRefused.end()) {
+        std::shared_ptr<Pipeline> pipeline = std::make_shared<Pipeline>();
+        pipeline->transport = context->transport;
+        pipeline->poolKey = key;
+        pipeline->inFlight.push_back(context);
+        context->pipeline = pipeline;
+        _pipelines[key] = std::move(pipeline); // replaces a full one, which keeps serving its own requests
+    }
+    unlock();
+}
+
+bool AsyncHttpClient::leavePipeline(RequestContext* context, bool* reusable, std::shared_ptr<Pipeline>* handover,
+                                    std::vector<RequestContext*>* orphans) {
+    std::shared_ptr<Pipeline> pipeline = std::move(context->pipeline);
+    if (!pipeline)
+        return false;
+    bool kept = false;
+    lock();
+    std::deque<RequestContext*>& inFlight = pipeline->inFlight;
+    bool front = !inFlight.empty() && inFlight.front() == context;
+    auto pos = std::find(inFlight.begin(), inFlight.end(), context);
+    if (pos != inFlight.end())
+        inFlight.erase(pos);
+    if (!front) {
+        // A queued request left (abort, deadline) while its response is still on the way: the connection can only
+        // finish the front response; everything else behind it goes back to the queue.
+        pipeline->open = false;
+        pipeline->closeAfterHead = true;
+        if (inFlight.size() > 1) {
+            orphans->insert(orphans->end(), inFlight.begin() + 1, inFlight.end());
+            inFlight.erase(inFlight.begin() + 1, inFlight.end());
+        }
+    } else {
+        bool reuse = reusable && *reusable && !pipeline->closeAfterHead;
+        if (reuse && inFlight.empty() && pipeline->carry.length() > 0)
+            reuse = false; // bytes nobody asked for: the connection is out of step
+        if (reusable)
+            *reusable = reuse;
+        if (reuse && !inFlight.empty()) {
+            inFlight.front()->connectionReuses = context->connectionReuses + 1;
+            *handover = pipeline;
+            kept = true;
+        } else if (!inFlight.empty()) {
+            // The connection ends here (error, `Connection: close`, close-delimited body, abort): re-queue the rest.
+            // When the server ended it, stop pipelining to this origin for a while; an abort, deadline or timeout of
+            // our own says nothing about the server.
+            orphans->insert(orphans->end(), inFlight.begin(), inFlight.end());
+            inFlight.clear();
+            if (reusable && !pipeline->closeAfterHead &&
+                (context->serverBrokeConnection || context->serverRequestedClose))
+                refusePipelining(pipeline->poolKey);
+            pipeline->open = false;
+        }
+    }
+    if (!kept && (inFlight.empty() || !pipeline->open)) {
+        auto it = _pipelines.find(pipeline->poolKey);
+        if (it != _pipelines.end() && it->second == pipeline)
+            _pipelines.erase(it);
+    }
+    unlock();
+    return kept;
+}
+
+void AsyncHttpClient::refusePipelining(const std::string& key) {
+    uint32_t now = millis();
+    _pipelineRefused.erase(std::remove_if(_pipelineRefused.begin(), _pipelineRefused.end(),
+                                          [&key, now](const PipelineRefusal& refusal) {
+                                              return refusal.poolKey == key ||
+                                                     static_cast<int32_t>(now - refusal.untilMs) >= 0;
+                                          }),
+                           _pipelineRefused.end());
+    PipelineRefusal refusal;
+    refusal.poolKey = key;
+    refusal.untilMs = now + kPipelineRefusalMs;
+    _pipelineRefused.push_back(std::move(refusal));
+}
+
+void AsyncHttpClient::advancePipeline(const std::shared_ptr<Pipeline>& pipeline) {
+    std::shared_ptr<RequestContext> next;
+    lock();
+    RequestContext* front = pipeline->inFlight.empty() ? nullptr : pipeline->inFlight.front();
+    for (auto& sp : _activeRequests) {
+        if (sp.get() == front) {
+            next = sp;
+            break;
+        }
+    }
+    unlock();
+    if (!next) {
+        pipeline->transport->close();
+        delete pipeline->transport;
+        return;
+    }
+    uint32_t now = millis();
+    next->transport = pipeline->transport;
+    armTransport(next.get(), now, next->request->msUntilDeadline(now));
+    if (pipeline->carry.length() > 0) {
+        // The front response arrived together with (part of) this one.
+        HttpBuffer carry(std::move(pipeline->carry));
+        handleData(next.get(), const_cast<char*>(carry.c_str()), carry.length());
+    }
+}
+
+void AsyncHttpClient::requeueOrphans(const std::vector<RequestContext*>& orphans) {
+    if (orphans.empty())
+        return;
+    // requeueAttempt() puts each at the front of the pending queue: walk backwards to keep their order.
+    for (auto it = orphans.rbegin(); it != orphans.rend(); ++it) {
+        RequestContext* orphan = *it;
+        orphan->pipeline.reset();
+        if (requeueAttempt(orphan, 0, false)) {
+            lock();
+            _pipelineRequeues++;
+            unlock();
+        }
+    }
+    if (!_inTryDequeue.load(std::memory_order_acquire))
+        tryDequeue();
+}
+
+size_t AsyncHttpClient::pipelineBodyBytes(const RequestContext* context, size_t available) const {
+    // On a pipelined connection the bytes after this response's body belong to the next response.
+    if (!context->pipeline || !context->pipelineFramed || context->chunk.chunked)
+        return available;
+    size_t remaining = context->expectedContentLength > context->receivedContentLength
+                           ? context->expectedContentLength - context->receivedContentLength
+                           : 0;
+    return std::min(available, remaining);
+}
+
+void AsyncHttpClient::notePipelineFraming(RequestContext* context) {
+    if (!context->pipeline)
+        return;
+    int status = context->response->getStatusCode();
+    context->pipelineFramed = context->chunk.chunked || context->expectedContentLength > 0 || status == 204 ||
+                              status == 304 || !context->response->getHeader("content-length").isEmpty();
+    if (!context->pipelineFramed) {
+        // The body ends when the server closes the connection: the requests behind it will be re-queued then.
+        lock();
+        context->pipeline->open = false;
+        context->pipeline->closeAfterHead = true;
+        unlock();
+    }
+}
+
+bool AsyncHttpClient::requeueAttempt(RequestContext* context, uint32_t delayMs, bool countsAsRetry) {
+    if (context->pipeline) {
+        // Before taking the lock: the requests queued behind this one on its connection are re-queued as well.
+        std::vector<RequestContext*> orphans;
+        leavePipeline(context, nullptr, nullptr, &orphans);
+        requeueOrphans(orphans);
+    }
+    uint32_t now = millis();
+    // Move the context from the active set back to the front of the pending queue; the request object is reused.
+    lock();
+    auto it = std::find_if(_activeRequests.begin(), _activeRequests.end(),
+                           [context](const std::shared_ptr<RequestContext>& ptr) { return ptr.get() == context; });
+    if (it == _activeRequests.end()) {
+        unlock();
+        return false;
+    }
+    std::shared_ptr<RequestContext> keep = std::move(*it);
+    _activeRequests.erase(it);
+    AsyncTransport* toDelete = context->transport; // closed outside the lock, like cleanup()
+    context->transport = nullptr;
+    resetResponseState(context);
+    if (countsAsRetry)
+        context->retry.attempt++;
+    context->retry.waiting = true;
+    context->retry.notBeforeMs = now + delayMs;
+    _retryWaitingCount++;
+    pushPendingLocked(std::move(keep), true);
+    scheduleDispatchWakeLocked(context->retry.notBeforeMs);
+    unlock();
+    if (toDelete) {
+        toDelete->close();
+        delete toDelete;
+    }
+    return true;
+}
+
 void AsyncHttpClient::sendStreamData(RequestContext* context) {
     if (!context->transport || !context->request->hasBodyStream())
         return;
@@ -1129,21 +2954,38 @@ void AsyncHttpClient::sendStreamData(RequestContext* context) {
     auto provider = context->request->getBodyProvider();
     if (!provider)
         return;
+    lock();
+    size_t minFreeHeap = _memoryPolicy.minFreeHeap;
+    unlock();
+    if (minFreeHeap > 0 && freeHeapBytes() < minFreeHeap)
+        return; // throttled: loop() resumes the upload once the heap recovers
+    // One write per pass: with TCP_NODELAY each becomes its own segment, so larger chunks mean fewer, fuller ones.
     uint8_t temp[512];
+    uint8_t* buffer = temp;
+    size_t chunk = std::min<size_t>(resolveSocketOptions(context->request.get()).txChunkBytes, 8192);
+    if (chunk == 0)
+        chunk = sizeof(temp);
+    if (chunk > sizeof(temp)) {
+        if (context->streamChunk.size() != chunk)
+            context->streamChunk.resize(chunk);
+        buffer = context->streamChunk.data();
+    }
     bool final = false;
-    int written = provider(temp, sizeof(temp), &final);
+    int written = provider(buffer, chunk, &final);
     if (written < 0) {
         triggerError(context, BODY_STREAM_READ_FAILED, "Body stream read failed");
         return;
     }
-    if (written > (int)sizeof(temp)) {
+    if (written > (int)chunk) {
         triggerError(context, BODY_STREAM_READ_FAILED, "Body stream provider overrun");
         return;
     }
     if (written > 0)
-        context->transport->write((const char*)temp, written);
-    if (final)
+        context->transport->write((const char*)buffer, written);
+    if (final) {
         context->streamingBodyInProgress = false;
+        std::vector<uint8_t>().swap(context->streamChunk);
+    }
 }
 
 bool AsyncHttpClient::shouldEnforceBodyLimit(RequestContext* context) {
@@ -1201,11 +3043,35 @@ AsyncHttpTLSConfig AsyncHttpClient::resolveTlsConfig(const AsyncHttpRequest* req
 AsyncTransport* AsyncHttpClient::buildTransport(RequestContext* context) {
     if (!context || !context->request)
         return nullptr;
-    if (context->request->isSecure()) {
-        AsyncHttpTLSConfig cfg = context->resolvedTlsConfig;
-        if (cfg.handshakeTimeoutMs == 0)
-            cfg.handshakeTimeoutMs = _defaultTlsConfig.handshakeTimeoutMs;
-        return createTlsTransport(cfg);
-    }
-    return createTcpTransport();
+    // resolvedTlsConfig stays untouched (it keys the connection pool); only this transport's handshake is bounded
+    // by the request's remaining deadline budget.
+    AsyncHttpTLSConfig cfg = context->resolvedTlsConfig;
+    if (cfg.handshakeTimeoutMs == 0)
+        cfg.handshakeTimeoutMs = _defaultTlsConfig.handshakeTimeoutMs;
+    uint32_t budgetMs = context->request->msUntilDeadline(millis());
+    if (budgetMs < cfg.handshakeTimeoutMs)
+        cfg.handshakeTimeoutMs = budgetMs > 0 ? budgetMs : 1;
+    return makeTransport(*context->request, cfg, poolKey(context));
+}
+
+AsyncTransport* AsyncHttpClient::makeTransport(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls,
+                                               const std::string& key) {
+    lock();
+    TransportFactory factory = _transportFactory;
+    unlock();
+    if (factory)
+        return factory(request, tls);
+    AsyncHttpSocketOptions options = resolveSocketOptions(&request);
+    if (request.isSecure())
+        return createTlsTransport(tls, options, key);
+    return createTcpTransport(options);
+}
+
+AsyncHttpSocketOptions AsyncHttpClient::resolveSocketOptions(const AsyncHttpRequest* request) const {
+    if (request && request->hasSocketOptions())
+        return *request->getSocketOptions();
+    lock();
+    AsyncHttpSocketOptions options = _socketOptions;
+    unlock();
+    return options;
 }
@@ -9,12 +9,29 @@
 #include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "HttpRequest.h"
 #include "HttpResponse.h"
 #include "HttpCommon.h"
 #include "AsyncTransport.h"
+#include "CallbackExecutor.h"
+#include "CircuitBreaker.h"
+#include "ConnectionPool.h"
+#include "DnsCache.h"
+#include "EndpointGroups.h"
+#include "HedgePolicy.h"
+#include "HttpFuture.h"
+#include "HttpMemory.h"
+#include "MemoryBudget.h"
+#include "ObjectPool.h"
+#include "RateLimiter.h"
+#include "RequestArena.h"
+#include "SubmissionQueue.h"
+#include "TlsSessionCache.h"
 #if ASYNC_HTTP_ENABLE_GZIP_DECODE
 #include "GzipDecoder.h"
 #endif
@@ -26,8 +43,9 @@
 #endif
 
 class AsyncCookieJar;
-class ConnectionPool;
 class RedirectHandler;
+class RequestBatcher;
+struct RequestBatchState;
 
 class AsyncHttpClient {
   public:
@@ -46,6 +64,26 @@ class AsyncHttpClient {
         kPreserveAll
     };
 
+    // Outcome of one request of a batch(), at the same index as the submitted request.
+    struct BatchItemResult {
+        uint32_t requestId = 0; // 0 if the item was never submitted (invalid request or fail-fast)
+        bool success = false;
+        std::shared_ptr<AsyncHttpResponse> response; // set when success
+        HttpClientError error = CONNECTION_FAILED;    // meaningful when !success
+        String errorMessage;
+    };
+    typedef std::function<void(const std::vector<BatchItemResult>& results)> BatchCallback;
+
+    struct BatchOptions {
+        uint16_t maxParallel; // 0 => submit all at once (client-wide setMaxParallel() still applies)
+        bool failFast;        // first error aborts the remaining items (reported as ABORTED)
+        BatchOptions() : maxParallel(0), failFast(false) {}
+    };
+
+    // Creates the transport for a new connection (advanced / testing hook). nullptr factory => TCP / TLS transports.
+    typedef std::function<AsyncTransport*(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls)>
+        TransportFactory;
+
     AsyncHttpClient();
     ~AsyncHttpClient();
 
@@ -57,6 +95,15 @@ class AsyncHttpClient {
     uint32_t head(const char* url, SuccessCallback onSuccess, ErrorCallback onError = nullptr);
     uint32_t patch(const char* url, const char* data, SuccessCallback onSuccess, ErrorCallback onError = nullptr);
 
+    // Future-returning variants (see HttpFuture.h): chain them with then(), or co_await them from a C++20 coroutine.
+    AsyncHttpFuture getAsync(const char* url);
+    AsyncHttpFuture postAsync(const char* url, const char* data);
+    AsyncHttpFuture putAsync(const char* url, const char* data);
+    AsyncHttpFuture delAsync(const char* url);
+    AsyncHttpFuture headAsync(const char* url);
+    AsyncHttpFuture patchAsync(const char* url, const char* data);
+    AsyncHttpFuture requestAsync(std::unique_ptr<AsyncHttpRequest> request);
+
     // Configuration methods
     void setHeader(const char* name, const char* value);
     void removeHeader(const char* name);
@@ -70,6 +117,57 @@ class AsyncHttpClient {
     void setMaxHeaderBytes(size_t maxBytes);
     void setMaxBodySize(size_t maxSize);
     void setMaxParallel(uint16_t maxParallel);
+    // Token-bucket rate limits (requestsPerSecond <= 0 disables). Requests over the limit wait in the pending queue
+    // and are released by loop() / the auto-loop task once a token is available.
+    void setRateLimit(float requestsPerSecond, uint16_t burst = 1);          // all requests
+    void setPerOriginRateLimit(float requestsPerSecond, uint16_t burst = 1); // each scheme://host:port
+    // Override for one origin, e.g. "https://api.example.com" (takes precedence over setPerOriginRateLimit()).
+    void setOriginRateLimit(const char* origin, float requestsPerSecond, uint16_t burst = 1);
+    // Default retry policy for transient failures (per-request override: AsyncHttpRequest::setRetryPolicy()).
+    void setRetryPolicy(const AsyncHttpRetryPolicy& policy);
+    // Per-origin circuit breaker (failureRatePercent == 0 disables, the default). Once `failureRatePercent` of the
+    // last `window` attempts to an origin failed to connect / complete the TLS handshake / receive headers (and at
+    // least `minRequests` were seen), requests to it fail immediately with CIRCUIT_OPEN for `openMs`; then a single
+    // probe request is let through and its outcome closes or re-opens the circuit.
+    void setCircuitBreaker(uint8_t failureRatePercent, uint32_t openMs = 30000, uint8_t minRequests = 5,
+                           uint8_t window = 20);
+    // Hedging for idempotent requests without a body stream: when no response headers arrived after the policy's
+    // delay, a copy is sent on a fresh connection and the first to answer wins (the other is cancelled). The delay is
+    // checked by loop() / the auto-loop task. Disabled by default.
+    void setHedgePolicy(const AsyncHttpHedgePolicy& policy);
+    uint32_t getHedgesFired() const; // hedge copies sent
+    uint32_t getHedgesWon() const;   // hedge copies that answered before the original
+    // Idempotent requests replayed on a fresh connection because the pooled connection they were sent on turned out
+    // to be closed by the server before any response byte arrived (done once per request, without an error callback).
+    uint32_t getStaleConnectionReplays() const;
+    // Process-wide object pools (see ObjectPool.h) for request contexts, requests, responses and gzip windows,
+    // shared by every client. Call once at startup before the first request; exhausted pools fall back to the heap.
+    static bool configureObjectPools(const AsyncHttpPoolConfig& config);
+    static AsyncHttpPoolStats getObjectPoolStats();
+    // Process-wide DNS cache used by the TCP and TLS transports (see DnsCache.h): answers are kept for their TTL,
+    // failures briefly, and concurrent lookups of a host are shared. `resolver` replaces lwIP's (nullptr restores
+    // it); pinned hosts never hit DNS; preResolve() starts a lookup so a later connection finds the address cached.
+    static void configureDnsCache(const AsyncHttpDnsConfig& config);
+    static void setResolver(AsyncHttpResolver* resolver);
+    static bool pinHost(const char* host, const char* ipv4); // false when `ipv4` is not a dotted quad
+    static bool unpinHost(const char* host);
+    static bool preResolve(const char* host);
+    static void clearDnsCache();
+    static AsyncHttpDnsStats getDnsStats();
+    // Process-wide TLS session cache (see TlsSessionCache.h): after a full handshake the session is saved per origin
+    // and TLS profile, and later connections to that origin offer it for an abbreviated handshake.
+    static void configureTlsSessionCache(const AsyncHttpTlsSessionConfig& config);
+    static void clearTlsSessionCache();
+    static AsyncHttpTlsSessionStats getTlsSessionStats();
+    // Per-request scratch arena (see RequestArena.h) for serializing the request and parsing the response headers;
+    // 0 disables it. With `preferPsram` the slab is taken from PSRAM when the board has it. Applies to requests
+    // created afterwards.
+    void setRequestArena(size_t bytes, bool preferPsram = false);
+    // Client-wide memory budget (see MemoryBudget.h): requests whose admission estimate does not fit wait in the
+    // pending queue (or fail with MEMORY_BUDGET_EXCEEDED when `failFast`), a buffered body that would overflow it
+    // fails its request, and body uploads pause while free heap is below `minFreeHeap`. Disabled by default.
+    void setMemoryBudget(const AsyncHttpMemoryBudget& budget);
+    AsyncHttpMemoryStats getMemoryStats() const;
     void setDefaultTlsConfig(const AsyncHttpTLSConfig& config);
     void setTlsCACert(const char* pem);
     void setTlsClientCert(const char* certPem, const char* privateKeyPem);
@@ -77,6 +175,40 @@ class AsyncHttpClient {
     void setTlsInsecure(bool allowInsecure);
     void setTlsHandshakeTimeout(uint32_t timeoutMs);
     void setKeepAlive(bool enable, uint16_t idleMs = 5000);
+    // Socket options for new connections (see AsyncHttpSocketOptions; per-request override:
+    // AsyncHttpRequest::setSocketOptions()). TCP_NODELAY is on by default; TCP keepalive probes are off.
+    void setSocketOptions(const AsyncHttpSocketOptions& options);
+    AsyncHttpSocketOptions getSocketOptions() const;
+    // Caps on idle keep-alive connections with LRU (optionally memory-weighted) eviction; unlimited by default.
+    void setConnectionPoolLimits(const AsyncHttpConnectionPoolLimits& limits);
+    AsyncHttpConnectionPoolStats getConnectionPoolStats() const;
+    // Opens `count` connections to the origin of `url` (TCP connect + TLS handshake, with the client's TLS settings)
+    // and parks them in the keep-alive pool, so the next requests there skip the handshake. Requires keep-alive;
+    // returns the number of connections started (they complete asynchronously).
+    uint16_t preconnect(const char* url, uint16_t count = 1);
+    // Keeps at least `minIdle` idle connections (open or being opened) to the origin of `url`: loop() re-opens the
+    // ones the pool pruned or the server closed. 0 stops warming the origin.
+    void keepWarm(const char* url, uint16_t minIdle);
+    // HTTP/1.1 pipelining (off by default): an idempotent request without a streamed body, to an origin that already
+    // has a request in flight on a reused keep-alive connection, is written behind it on that connection (up to
+    // `maxDepth` requests per connection) instead of waiting for a connection of its own. Responses are matched in
+    // order. When the server closes the connection or answers with `Connection: close`, the requests still waiting
+    // are re-queued and the origin falls back to one request per connection for a minute (or until setPipelining()
+    // is called again). Aborts, deadlines and timeouts only retire the connection they happened on.
+    // Requires keep-alive; in-flight pipelined requests count towards setMaxParallel().
+    void setPipelining(bool enable, uint8_t maxDepth = 4);
+    uint32_t getPipelinedRequests() const; // requests written behind another one on the same connection
+    uint32_t getPipelineRequeues() const;  // pipelined requests re-queued because their connection went away
+    // Endpoint groups (see EndpointGroups.h): a request to http(s)://<name>/... is sent to one endpoint of the group
+    // `name`, the healthy one with the lowest latency average (idle pooled connections count as faster), with the
+    // URL's path and query. Connect, TLS and open-circuit failures move the request to another endpoint without an
+    // error callback (up to the policy's maxFailovers). `endpoints` is a comma-separated list of URLs, e.g.
+    // "https://eu.api.example.com,https://us.api.example.com:8443". Returns false when one does not parse.
+    bool setEndpointGroup(const char* name, const char* endpoints);
+    bool removeEndpointGroup(const char* name);
+    void setEndpointPolicy(const AsyncHttpEndpointPolicy& policy);
+    std::vector<AsyncHttpEndpointStats> getEndpointStats(const char* name) const;
+    uint32_t getEndpointFailovers() const; // requests moved to another endpoint after a failure
     AsyncHttpTLSConfig getDefaultTlsConfig() const {
         return _defaultTlsConfig;
     }
@@ -97,8 +229,19 @@ class AsyncHttpClient {
     uint32_t request(std::unique_ptr<AsyncHttpRequest> request, SuccessCallback onSuccess,
                      ErrorCallback onError = nullptr);
     // Removed per-request chunk overload (was experimental)
-    // Abort by id (returns true if found and aborted)
+    // Abort by id (returns true if found and aborted, or if the abort was deferred because the client was busy)
     bool abort(uint32_t requestId);
+    // Abort every active or queued request tagged with AsyncHttpRequest::setGroup(groupId) / every request, in a
+    // single pass. Each aborted request gets its ABORTED error callback. Returns the number of requests aborted.
+    size_t abortGroup(uint32_t groupId);
+    size_t abortAll();
+
+    // Submit a group of requests and get a single completion once every item finished (success, error or abort).
+    // Returns the batch id (never 0), usable with abortBatch().
+    uint32_t batch(std::vector<std::unique_ptr<AsyncHttpRequest>> requests, BatchCallback onComplete,
+                   const BatchOptions& options = BatchOptions());
+    // Abort every unfinished item of a batch; its completion still fires. Returns false if the batch is unknown/done.
+    bool abortBatch(uint32_t batchId);
 
     // Global streaming body callback (applies for all responses unless overridden per-request in future)
     void onBodyChunk(BodyChunkCallback cb) {
@@ -108,16 +251,25 @@ class AsyncHttpClient {
         unlock();
     }
 
+    // Choose where success / error / body chunk callbacks run (nullptr => inline in the network context).
+    // See CallbackExecutor.h for the provided executors.
+    void setCallbackExecutor(std::shared_ptr<CallbackExecutor> executor);
+
+    void setTransportFactory(TransportFactory factory);
+
     void loop(); // manual timeout / queue progression
 
   private:
     friend class AsyncCookieJar;
     friend class ConnectionPool;
     friend class RedirectHandler;
+    friend class RequestBatcher;
+    friend struct RequestBatchState;
 
     // Lightweight locking helpers (no-op unless ESP32 auto-loop task is enabled)
     void lock() const;
     void unlock() const;
+    bool tryLock() const; // non-blocking; always succeeds when no mutex is compiled in
 
     // Internal auto-loop task for fallback timeout mode
 #if !ASYNC_TCP_HAS_TIMEOUT && defined(ARDUINO_ARCH_ESP32) && defined(ASYNC_HTTP_ENABLE_AUTOLOOP)
@@ -125,12 +277,15 @@ class AsyncHttpClient {
     TaskHandle_t _autoLoopTaskHandle = nullptr;
 #endif
 
+    struct Pipeline;
+
     struct RequestContext {
         struct ChunkParseState {
             bool chunked = false;
             bool chunkedComplete = false;
             size_t currentChunkRemaining = 0;
             bool awaitingFinalChunkTerminator = false;
+            bool awaitingChunkDataCrlf = false; // chunk data delivered, its trailing CRLF not consumed yet
             size_t trailerLineCount = 0;
         };
 
@@ -138,7 +293,36 @@ class AsyncHttpClient {
             uint8_t redirectCount = 0;
         };
 
+        struct RetryState {
+            uint8_t attempt = 1;      // 1 for the first attempt
+            bool waiting = false;     // parked in _pendingQueue until notBeforeMs
+            uint32_t notBeforeMs = 0;
+            bool staleReplayed = false;   // already replayed once after a stale pooled connection
+            bool freshConnection = false; // the next attempt must not take a pooled connection
+        };
+
+        struct HedgeState {
+            bool fired = false; // a hedge copy was already sent for this request (at most one)
+            bool copy = false;  // hedge copy: fresh connection, callbacks stay on the original until it wins
+            std::weak_ptr<RequestContext> sibling; // the other copy while both race for the response headers
+        };
+
+        struct RouteState {
+            std::string group;  // endpoint group named by the request's URL host (empty = not routed)
+            int endpoint = -1;  // endpoint of the current attempt
+            uint32_t tried = 0; // endpoints this request failed on (bit per index)
+            uint8_t failovers = 0;
+        };
+
+        struct MemoryState {
+            size_t reserved = 0;   // admission estimate charged to the client's memory budget
+            size_t body = 0;       // buffered response body charged to it
+            bool deferred = false; // counted once as waiting for memory
+        };
+
         struct TimingState {
+            bool started = false;        // firstAttemptMs is set
+            uint32_t firstAttemptMs = 0; // first execution; the total timeout spans retries and redirects
             uint32_t connectStartMs = 0;
             uint32_t connectTimeoutMs = 0;
 #if !ASYNC_TCP_HAS_TIMEOUT
@@ -146,6 +330,17 @@ class AsyncHttpClient {
 #endif
         };
 
+        // Bound once per context and copied onto every connection it uses (retries, redirects, pooled connections).
+        // They hold the context weakly: a transport never keeps its context alive.
+        struct TransportHandlers {
+            bool bound = false;
+            AsyncTransport::ConnectHandler onConnect;
+            AsyncTransport::DataHandler onData;
+            AsyncTransport::DisconnectHandler onDisconnect;
+            AsyncTransport::ErrorHandler onError;
+            AsyncTransport::TimeoutHandler onTimeout;
+        };
+
 #if ASYNC_HTTP_ENABLE_GZIP_DECODE
         struct GzipState {
             bool gzipEncoded = false;
@@ -161,7 +356,9 @@ class AsyncHttpClient {
         SuccessCallback onSuccess;
         ErrorCallback onError;
         AsyncTransport* transport = nullptr;
-        String responseBuffer;
+        TransportHandlers handlers;
+        RequestArena arena; // transient parse/serialize buffers, released in one shot by cleanup()
+        HttpBuffer responseBuffer{AsyncHttpBufferKind::kReceiveBuffer}; // header block and chunk framing
         bool headersComplete = false;
         bool responseProcessed = false;
         size_t expectedContentLength = 0;
@@ -170,49 +367,161 @@ class AsyncHttpClient {
         ChunkParseState chunk;
         uint32_t id = 0;
         RedirectState redirect;
+        RetryState retry;
+        HedgeState hedge;
+        RouteState route;
+        MemoryState memory;
+        bool queued = false;  // sits in _pendingQueue
+        bool dropped = false; // aborted while queued: left in _pendingQueue as a tombstone, skipped and purged later
+        bool circuitProbe = false; // half-open probe for its origin; cleared once an outcome is recorded
         bool notifiedEndCallback = false;
         // perRequestChunkCb removed
         TimingState timing;
         bool headersSent = false;
         bool streamingBodyInProgress = false;
+        std::vector<uint8_t> streamChunk; // body stream staging when txChunkBytes exceeds the on-stack 512 bytes
         bool requestKeepAlive = false;
         bool serverRequestedClose = false;
+        // Response `Keep-Alive: timeout=N, max=M` (0 / no limit if absent): bounds how long the pool keeps it.
+        uint32_t serverKeepAliveTimeoutMs = 0;
+        uint32_t serverKeepAliveMax = ConnectionPool::kNoRequestLimit;
         bool usingPooledConnection = false;
         AsyncHttpTLSConfig resolvedTlsConfig;
+        std::string poolKey;           // see AsyncHttpClient::poolKey()
+        uint32_t connectionReuses = 0; // requests the current connection served before this one
+        // Set while the request is in flight on a pipelined connection; `transport` is only set for the one whose
+        // response is being received (the front of pipeline->inFlight).
+        std::shared_ptr<Pipeline> pipeline;
+        bool pipelineFramed = false; // the response's end is known without a close (Content-Length, chunked, 204/304)
+        bool serverBrokeConnection = false; // the server closed it mid-response or sent bytes that do not parse
+        // Batch membership (batch items carry no per-item callbacks; completion is routed to the batcher).
+        std::shared_ptr<RequestBatchState> batch;
+        size_t batchIndex = 0;
 #if ASYNC_HTTP_ENABLE_GZIP_DECODE
         GzipState gzip;
 #endif
     };
 
+    // Requests written back-to-back on one keep-alive connection, in the order their responses will arrive.
+    struct Pipeline {
+        AsyncTransport* transport = nullptr;
+        std::string poolKey;
+        std::deque<RequestContext*> inFlight; // front() owns the transport and receives its bytes
+        bool open = true;                     // further requests may be appended
+        bool closeAfterHead = false;          // a queued request left early: the responses no longer line up
+        HttpBuffer carry{AsyncHttpBufferKind::kReceiveBuffer}; // bytes past the front response (the next ones)
+    };
+
+    // Work handed from request()/abort() to the draining context through the lock-free submission ring.
+    struct Submission {
+        enum Kind : uint8_t { kNone, kRequest, kAbort };
+        Kind kind = kNone;
+        std::shared_ptr<RequestContext> context;
+        uint32_t requestId = 0;
+    };
+
     std::vector<HttpHeader> _defaultHeaders;
     uint32_t _defaultTimeout; // total
     String _defaultUserAgent;
     BodyChunkCallback _bodyChunkCallback;
-    uint32_t _nextRequestId = 1;
+    std::atomic<uint32_t> _nextRequestId{1};
     uint16_t _maxParallel = 0; // 0 => unlimited
     size_t _maxBodySize = 0;   // 0 => unlimited
     bool _followRedirects = false;
     uint8_t _maxRedirectHops = 3;
     size_t _maxHeaderBytes = 0;
+    size_t _requestArenaSize = ASYNC_HTTP_REQUEST_ARENA_SIZE;
+    bool _requestArenaPsram = false;
+    AsyncHttpMemoryBudget _memoryPolicy;
+    MemoryBudget _memoryBudget;
     std::vector<std::shared_ptr<RequestContext>> _activeRequests;
     std::deque<std::shared_ptr<RequestContext>> _pendingQueue;
+    size_t _pendingDropped = 0; // tombstones in _pendingQueue
+    // id -> context for every request accepted by executeOrQueue() and not cleaned up yet (O(1) abort lookup). A hedged
+    // request is indexed by whichever copy carries its callbacks.
+    std::unordered_map<uint32_t, RequestContext*> _contextsById;
     uint32_t _defaultConnectTimeout = 5000;
     AsyncHttpTLSConfig _defaultTlsConfig;
+    AsyncHttpSocketOptions _socketOptions;
     bool _keepAliveEnabled = false;
     uint32_t _keepAliveIdleMs = 5000;
     std::atomic_bool _inTryDequeue{false}; // cross-task reentrancy guard
+    RateLimiter _rateLimiter;
+    AsyncHttpRetryPolicy _retryPolicy;
+    CircuitBreaker _circuitBreaker;
+    AsyncHttpHedgePolicy _hedgePolicy;
+    LatencyWindow _headerLatency; // time-to-headers samples for percentile hedge delays
+    uint32_t _hedgesFired = 0;
+    uint32_t _hedgesWon = 0;
+    uint32_t _staleReplays = 0;
+    uint8_t _pipelineDepth = 0; // 0 = pipelining off
+    std::unordered_map<std::string, std::shared_ptr<Pipeline>> _pipelines; // by pool key, while accepting requests
+    struct PipelineRefusal {
+        std::string poolKey;
+        uint32_t untilMs = 0;
+    };
+    std::vector<PipelineRefusal> _pipelineRefused; // origins whose server broke a pipeline, for a while
+    uint32_t _pipelinedRequests = 0;
+    uint32_t _pipelineRequeues = 0;
+    EndpointGroups _endpointGroups;
+    uint32_t _endpointFailovers = 0;
+    size_t _retryWaitingCount = 0;  // pending contexts waiting for their backoff to elapse
+    bool _dispatchWaiting = false;  // pending requests held back by the rate limiter or a retry backoff
+    uint32_t _dispatchWakeMs = 0;   // when loop() should try dispatching them again
+    MpscQueue<Submission> _submissions{ASYNC_HTTP_SUBMIT_QUEUE_CAPACITY};
+    std::atomic_bool _drainingSubmissions{false}; // single-consumer guard for _submissions
+    // Submissions that found the ring full, drained after it; later ones follow them here until it empties.
+    std::mutex _submitOverflowMutex;
+    std::deque<Submission> _submitOverflow;
+    std::atomic<size_t> _submitOverflowCount{0};
     std::unique_ptr<AsyncCookieJar> _cookieJar;
     std::unique_ptr<ConnectionPool> _connectionPool;
+    // Connections opened by preconnect()/keepWarm() that have not finished connecting yet.
+    struct Warmup {
+        AsyncTransport* transport = nullptr;
+        std::string poolKey;
+        uint32_t startedMs = 0;
+        uint32_t timeoutMs = 0; // connect + TLS handshake
+    };
+    struct WarmTarget {
+        String url;
+        std::string poolKey; // refreshed on every check (the TLS settings may change)
+        uint16_t minIdle = 0;
+        uint32_t retryAtMs = 0; // after a failed warm-up
+    };
+    std::vector<Warmup> _warmups;
+    std::vector<WarmTarget> _warmTargets;
+    uint32_t _nextWarmCheckMs = 0;
     std::unique_ptr<RedirectHandler> _redirectHandler;
+    std::unique_ptr<RequestBatcher> _batcher;
+    std::shared_ptr<CallbackExecutor> _callbackExecutor; // nullptr => inline
+    TransportFactory _transportFactory;
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(ASYNC_HTTP_ENABLE_AUTOLOOP)
     mutable SemaphoreHandle_t _reqMutex = nullptr; // recursive mutex
+    mutable int _lockDepth = 0;                     // held recursions (only touched by the holder)
 #endif
 
     // Internal methods
+    AsyncHttpFuture makeRequestAsync(HttpMethod method, const char* url, const char* data);
     uint32_t makeRequest(HttpMethod method, const char* url, const char* data, SuccessCallback onSuccess,
                          ErrorCallback onError);
+    std::shared_ptr<RequestContext> makeContext() const;
+    static std::shared_ptr<AsyncHttpResponse> makeResponse();
+    std::shared_ptr<RequestContext> createContext(std::unique_ptr<AsyncHttpRequest> request);
+    void submitContext(std::shared_ptr<RequestContext> context);
     void executeOrQueue(std::shared_ptr<RequestContext> context);
+    void pushSubmission(Submission&& submission);
+    bool popOverflowSubmission(Submission* out);
+    void drainSubmissions();
+    void drainSubmissionsLocked();
+    bool hasSubmissions() const;
+    void processSubmission(Submission& submission);
+    bool abortNow(uint32_t requestId);
+    size_t abortMatching(bool all, uint32_t groupId);
+    void pushPendingLocked(std::shared_ptr<RequestContext> context, bool front);
+    void purgeDroppedFrontLocked();
+    void bindTransportHandlers(RequestContext* context);
     void executeRequest(RequestContext* context);
     void handleConnect(RequestContext* context);
     void handleData(RequestContext* context, char* data, size_t len);
@@ -223,15 +532,77 @@ class AsyncHttpClient {
     void handleDisconnect(RequestContext* context);
     void handleTransportError(RequestContext* context, HttpClientError error, const char* message);
     bool parseResponseHeaders(RequestContext* context, const String& headerData);
+    bool parseResponseHeaders(RequestContext* context, const char* headerData, size_t len);
     static bool parseChunkSizeLine(const String& line, uint32_t* outSize);
+    static bool parseChunkSizeLine(const char* line, size_t len, uint32_t* outSize);
     void processResponse(RequestContext* context);
     void cleanup(RequestContext* context);
     void triggerError(RequestContext* context, HttpClientError errorCode, const char* errorMessage);
+    std::shared_ptr<CallbackExecutor> currentCallbackExecutor() const;
+    void dispatchSuccess(SuccessCallback callback, std::shared_ptr<AsyncHttpResponse> response);
+    void dispatchError(ErrorCallback callback, HttpClientError errorCode, const char* errorMessage);
+    void dispatchBodyChunk(const BodyChunkCallback& callback, const char* data, size_t len, bool final);
+    void dispatchTask(CallbackExecutor::Task&& task);
     void tryDequeue();
+    bool nextDispatchableLocked(uint32_t now, size_t* outIndex);
+    void scheduleDispatchWakeLocked(uint32_t wakeMs);
+    void resetResponseState(RequestContext* context);
+    AsyncHttpRetryPolicy resolveRetryPolicy(const RequestContext* context) const;
+    bool maybeRetryError(RequestContext* context, HttpClientError errorCode);
+    bool maybeRetryStatus(RequestContext* context);
+    bool scheduleRetry(RequestContext* context, const AsyncHttpRetryPolicy& policy, uint32_t delayMs);
+    bool maybeReplayStaleConnection(RequestContext* context, HttpClientError errorCode);
+    bool requeueAttempt(RequestContext* context, uint32_t delayMs, bool countsAsRetry);
+    // Endpoint groups (see setEndpointGroup()).
+    void routeToEndpoint(RequestContext* context, uint32_t now);
+    void recordEndpointOutcome(RequestContext* context, bool failed);
+    bool maybeFailOverEndpoint(RequestContext* context, HttpClientError errorCode);
+    // Pipelining (see setPipelining()).
+    bool pipelineEligible(const RequestContext* context) const;
+    bool attachToPipeline(RequestContext* context);
+    void openPipeline(RequestContext* context);
+    // Removes `context` from its pipeline. Returns true when the pipeline keeps the context's transport for the next
+    // request (then set in *handover); requests that can no longer be answered on the connection go to *orphans.
+    // `reusable` (in/out) is whether the connection could be recycled; null when the request is only being retried
+    // or redirected.
+    bool leavePipeline(RequestContext* context, bool* reusable, std::shared_ptr<Pipeline>* handover,
+                       std::vector<RequestContext*>* orphans);
+    void refusePipelining(const std::string& key); // lock held; also drops expired refusals
+    void advancePipeline(const std::shared_ptr<Pipeline>& pipeline);
+    void requeueOrphans(const std::vector<RequestContext*>& orphans);
+    size_t pipelineBodyBytes(const RequestContext* context, size_t available) const;
+    void notePipelineFraming(RequestContext* context);
+    void armTransport(RequestContext* context, uint32_t now, uint32_t budgetMs);
+    void writeRequest(RequestContext* context, AsyncTransport* transport);
+    std::string circuitKey(const RequestContext* context) const;
+    // Connection pool key of the current attempt (origin + TLS profile digest), computed on first use.
+    const std::string& poolKey(RequestContext* context) const;
+    bool admitThroughCircuitBreaker(RequestContext* context);
+    size_t admissionCost(const RequestContext* context) const;
+    bool memoryAdmitsLocked(RequestContext* context);
+    bool chargeAdmission(RequestContext* context);
+    bool chargeBody(RequestContext* context, size_t bytes);
+    void releaseMemory(RequestContext* context);
+    void recordCircuitOutcome(RequestContext* context, bool failed);
+    void expirePendingDeadlines(uint32_t now);
+    bool isHedgeCandidate(const RequestContext* context, uint32_t now, uint32_t delayMs) const;
+    void fireHedge(const std::shared_ptr<RequestContext>& original);
+    std::shared_ptr<RequestContext> detachHedgeSiblingLocked(RequestContext* keep);
+    void resolveHedgeRace(RequestContext* winner);
+    bool handOverToHedgeSibling(RequestContext* failed);
     void sendStreamData(RequestContext* context);
     bool shouldEnforceBodyLimit(RequestContext* context);
     AsyncTransport* buildTransport(RequestContext* context);
+    AsyncTransport* makeTransport(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls,
+                                  const std::string& key);
+    uint16_t startWarmups(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls, const std::string& key,
+                          uint16_t count);
+    void finishWarmup(AsyncTransport* transport, bool connected);
+    void expireWarmups(uint32_t now);
+    void maintainWarmConnections(uint32_t now);
+    void dropWarmups();
     AsyncHttpTLSConfig resolveTlsConfig(const AsyncHttpRequest* request) const;
+    AsyncHttpSocketOptions resolveSocketOptions(const AsyncHttpRequest* request) const;
 
   private:
 };
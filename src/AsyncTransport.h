@@ -1,18 +1,20 @@
 #ifndef ASYNC_TRANSPORT_H
 #define ASYNC_TRANSPORT_H
 
-#include <functional>
 #include <cstddef>
 #include <stdint.h>
+#include <string>
 #include "HttpCommon.h"
+#include "InplaceFunction.h"
 
 class AsyncTransport {
   public:
-    typedef std::function<void(void*, AsyncTransport*)> ConnectHandler;
-    typedef std::function<void(void*, AsyncTransport*, void*, size_t)> DataHandler;
-    typedef std::function<void(void*, AsyncTransport*)> DisconnectHandler;
-    typedef std::function<void(void*, AsyncTransport*, HttpClientError, const char*)> ErrorHandler;
-    typedef std::function<void(void*, AsyncTransport*, uint32_t)> TimeoutHandler;
+    // Handlers are stored inline (no heap allocation); captures must fit ASYNC_HTTP_INPLACE_FUNCTION_SIZE bytes.
+    typedef InplaceFunction<void(void*, AsyncTransport*)> ConnectHandler;
+    typedef InplaceFunction<void(void*, AsyncTransport*, void*, size_t)> DataHandler;
+    typedef InplaceFunction<void(void*, AsyncTransport*)> DisconnectHandler;
+    typedef InplaceFunction<void(void*, AsyncTransport*, HttpClientError, const char*)> ErrorHandler;
+    typedef InplaceFunction<void(void*, AsyncTransport*, uint32_t)> TimeoutHandler;
 
     virtual ~AsyncTransport() {}
 
@@ -32,7 +34,14 @@ class AsyncTransport {
     virtual uint32_t getHandshakeTimeoutMs() const = 0;
 };
 
-AsyncTransport* createTcpTransport();
-AsyncTransport* createTlsTransport(const AsyncHttpTLSConfig& config);
+AsyncTransport* createTcpTransport(const AsyncHttpSocketOptions& options = AsyncHttpSocketOptions());
+// `poolKey` (ConnectionPool::makeKey()) keys the connection's TLS session; empty: derived from `config`.
+AsyncTransport* createTlsTransport(const AsyncHttpTLSConfig& config,
+                                   const AsyncHttpSocketOptions& options = AsyncHttpSocketOptions(),
+                                   const std::string& poolKey = std::string());
+
+// Applies Nagle / keepalive settings to a connected AsyncClient (AsyncTCP ignores them before the connection exists).
+class AsyncClient;
+void applySocketOptions(AsyncClient* client, const AsyncHttpSocketOptions& options);
 
 #endif // ASYNC_TRANSPORT_H
@@ -0,0 +1,65 @@
+#include "CallbackExecutor.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+FreeRtosCallbackExecutor::FreeRtosCallbackExecutor(size_t queueLength, uint32_t stackWords, UBaseType_t priority,
+                                                   BaseType_t core, TickType_t postTimeoutTicks)
+    : _postTimeoutTicks(postTimeoutTicks) {
+    if (queueLength == 0)
+        queueLength = 1;
+    // Queue items are heap-allocated Task pointers; nullptr is the stop sentinel.
+    _queue = xQueueCreate(queueLength, sizeof(Task*));
+    _stopped = xSemaphoreCreateBinary();
+    if (_queue && _stopped)
+        xTaskCreatePinnedToCore(taskThunk, "AsyncHttpCb", stackWords, this, priority, &_task, core);
+}
+
+FreeRtosCallbackExecutor::~FreeRtosCallbackExecutor() {
+    if (_task && _queue) {
+        Task* sentinel = nullptr;
+        xQueueSend(_queue, &sentinel, portMAX_DELAY);
+        xSemaphoreTake(_stopped, portMAX_DELAY);
+        _task = nullptr;
+    }
+    if (_queue) {
+        Task* pending = nullptr;
+        while (xQueueReceive(_queue, &pending, 0) == pdTRUE)
+            delete pending;
+        vQueueDelete(_queue);
+        _queue = nullptr;
+    }
+    if (_stopped) {
+        vSemaphoreDelete(_stopped);
+        _stopped = nullptr;
+    }
+}
+
+bool FreeRtosCallbackExecutor::post(Task&& task) {
+    if (!_queue || !_task)
+        return false;
+    Task* boxed = new Task(std::move(task));
+    if (xQueueSend(_queue, &boxed, _postTimeoutTicks) != pdTRUE) {
+        task = std::move(*boxed); // hand it back so the caller can run it inline
+        delete boxed;
+        return false;
+    }
+    return true;
+}
+
+void FreeRtosCallbackExecutor::taskThunk(void* param) {
+    FreeRtosCallbackExecutor* self = static_cast<FreeRtosCallbackExecutor*>(param);
+    for (;;) {
+        Task* task = nullptr;
+        if (xQueueReceive(self->_queue, &task, portMAX_DELAY) != pdTRUE)
+            continue;
+        if (!task)
+            break;
+        if (*task)
+            (*task)();
+        delete task;
+    }
+    xSemaphoreGive(self->_stopped);
+    vTaskDelete(nullptr);
+}
+
+#endif
@@ -0,0 +1,173 @@
+// Pluggable executors deciding where user callbacks (success, error, body chunk) run.
+//
+// By default the client invokes callbacks inline from the network context (AsyncTCP task). Installing an executor
+// via AsyncHttpClient::setCallbackExecutor() lets the network task hand the completed work over (responses are
+// moved, body chunk bytes are copied) and return immediately, so slow application code no longer stalls other
+// connections.
+//
+// Ordering: the client posts the callbacks of a request in order (chunks, final chunk, success/error). Executors
+// that run tasks on a single worker preserve that order; a multi-threaded pool does not.
+
+#ifndef CALLBACK_EXECUTOR_H
+#define CALLBACK_EXECUTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
+#if !defined(ARDUINO)
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+class CallbackExecutor {
+  public:
+    typedef std::function<void()> Task;
+
+    virtual ~CallbackExecutor() {}
+
+    // Run or schedule the task. Returning false means the task was not accepted: the task must then be left intact
+    // (not moved from) and the client runs it inline.
+    virtual bool post(Task&& task) = 0;
+
+    // True when post() runs the task synchronously (lets the client skip copying body chunk bytes).
+    virtual bool runsInline() const {
+        return false;
+    }
+};
+
+// Today's behavior: callbacks run in the calling (network) context.
+class InlineCallbackExecutor : public CallbackExecutor {
+  public:
+    bool post(Task&& task) override {
+        if (task)
+            task();
+        return true;
+    }
+    bool runsInline() const override {
+        return true;
+    }
+};
+
+// Adapter for an application-provided post function (e.g. an event loop or an existing work queue).
+class FunctionCallbackExecutor : public CallbackExecutor {
+  public:
+    typedef std::function<bool(Task&&)> PostFunction;
+
+    explicit FunctionCallbackExecutor(PostFunction postFn) : _postFn(std::move(postFn)) {}
+
+    bool post(Task&& task) override {
+        if (!_postFn)
+            return false;
+        return _postFn(std::move(task));
+    }
+
+  private:
+    PostFunction _postFn;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+// Dedicated FreeRTOS task draining a queue of callbacks. post() blocks up to postTimeoutTicks when the queue is
+// full (backpressure on the network task); on timeout the client falls back to running the callback inline.
+class FreeRtosCallbackExecutor : public CallbackExecutor {
+  public:
+    explicit FreeRtosCallbackExecutor(size_t queueLength = 16, uint32_t stackWords = 4096, UBaseType_t priority = 1,
+                                      BaseType_t core = tskNO_AFFINITY, TickType_t postTimeoutTicks = portMAX_DELAY);
+    ~FreeRtosCallbackExecutor() override;
+
+    bool post(Task&& task) override;
+
+  private:
+    static void taskThunk(void* param);
+
+    QueueHandle_t _queue = nullptr;
+    TaskHandle_t _task = nullptr;
+    SemaphoreHandle_t _stopped = nullptr;
+    TickType_t _postTimeoutTicks;
+};
+#endif
+
+#if !defined(ARDUINO)
+// Host-only executor backed by std::thread workers (used by native tests). With one worker (default) callbacks
+// keep their posting order.
+class ThreadPoolCallbackExecutor : public CallbackExecutor {
+  public:
+    explicit ThreadPoolCallbackExecutor(size_t workers = 1) {
+        if (workers == 0)
+            workers = 1;
+        for (size_t i = 0; i < workers; ++i)
+            _workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~ThreadPoolCallbackExecutor() override {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _stopping = true;
+        }
+        _cv.notify_all();
+        for (auto& t : _workers)
+            t.join();
+    }
+
+    bool post(Task&& task) override {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (_stopping)
+                return false;
+            _tasks.push_back(std::move(task));
+        }
+        _cv.notify_one();
+        return true;
+    }
+
+    // Block until every task posted so far has run.
+    void waitIdle() {
+        std::unique_lock<std::mutex> guard(_mutex);
+        _idleCv.wait(guard, [this]() { return _tasks.empty() && _running == 0; });
+    }
+
+  private:
+    void workerLoop() {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> guard(_mutex);
+                _cv.wait(guard, [this]() { return _stopping || !_tasks.empty(); });
+                if (_tasks.empty())
+                    return; // stopping and drained
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+                _running++;
+            }
+            if (task)
+                task();
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _running--;
+            }
+            _idleCv.notify_all();
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::condition_variable _idleCv;
+    std::deque<Task> _tasks;
+    std::vector<std::thread> _workers;
+    size_t _running = 0;
+    bool _stopping = false;
+};
+#endif
+
+#endif // CALLBACK_EXECUTOR_H
@@ -0,0 +1,148 @@
+#include "CircuitBreaker.h"
+
+// Closed origins with no failure in their window are dropped beyond this count (an origin with a clean
+// window behaves like a fresh one, so nothing that matters is lost).
+static constexpr size_t kMaxHealthyOrigins = 8;
+
+void CircuitBreaker::configure(uint8_t failureRatePercent, uint32_t openMs, uint8_t minRequests, uint8_t window) {
+    _failureRatePercent = failureRatePercent > 100 ? 100 : failureRatePercent;
+    _openMs = openMs;
+    if (window == 0)
+        window = 1;
+    if (window > kMaxWindow)
+        window = kMaxWindow;
+    _window = window;
+    if (minRequests == 0)
+        minRequests = 1;
+    _minRequests = minRequests > window ? window : minRequests;
+    _origins.clear();
+}
+
+CircuitBreaker::Origin* CircuitBreaker::find(const std::string& originKey) {
+    for (auto& origin : _origins) {
+        if (origin.key == originKey)
+            return &origin;
+    }
+    return nullptr;
+}
+
+const CircuitBreaker::Origin* CircuitBreaker::find(const std::string& originKey) const {
+    for (const auto& origin : _origins) {
+        if (origin.key == originKey)
+            return &origin;
+    }
+    return nullptr;
+}
+
+CircuitBreaker::Origin* CircuitBreaker::findOrCreate(const std::string& originKey) {
+    Origin* origin = find(originKey);
+    if (origin)
+        return origin;
+    pruneHealthy();
+    Origin fresh;
+    fresh.key = originKey;
+    _origins.push_back(fresh);
+    return &_origins.back();
+}
+
+void CircuitBreaker::pruneHealthy() {
+    size_t healthy = 0;
+    for (const auto& origin : _origins) {
+        if (origin.state == State::kClosed && origin.failures == 0)
+            healthy++;
+    }
+    if (healthy < kMaxHealthyOrigins)
+        return;
+    for (size_t i = 0; i < _origins.size();) {
+        if (_origins[i].state == State::kClosed && _origins[i].failures == 0)
+            _origins.erase(_origins.begin() + i);
+        else
+            ++i;
+    }
+}
+
+CircuitBreaker::Decision CircuitBreaker::allow(const std::string& originKey, uint32_t nowMs, uint32_t* retryInMs) {
+    if (retryInMs)
+        *retryInMs = 0;
+    if (!enabled())
+        return Decision::kAllow;
+    Origin* origin = find(originKey);
+    if (!origin || origin->state == State::kClosed)
+        return Decision::kAllow;
+    if (origin->state == State::kOpen) {
+        uint32_t elapsed = nowMs - origin->openedAtMs; // wraps correctly
+        if (elapsed < _openMs) {
+            if (retryInMs)
+                *retryInMs = _openMs - elapsed;
+            return Decision::kReject;
+        }
+        origin->state = State::kHalfOpen;
+        origin->probeInFlight = false;
+    }
+    if (origin->probeInFlight)
+        return Decision::kReject;
+    origin->probeInFlight = true;
+    return Decision::kProbe;
+}
+
+void CircuitBreaker::recordSuccess(const std::string& originKey, uint32_t nowMs) {
+    if (!enabled())
+        return;
+    Origin* origin = find(originKey);
+    if (origin) // unknown origins are closed with a clean window: nothing to record
+        record(origin, false, nowMs);
+}
+
+void CircuitBreaker::recordFailure(const std::string& originKey, uint32_t nowMs) {
+    if (!enabled())
+        return;
+    record(findOrCreate(originKey), true, nowMs);
+}
+
+void CircuitBreaker::releaseProbe(const std::string& originKey) {
+    Origin* origin = find(originKey);
+    if (origin)
+        origin->probeInFlight = false;
+}
+
+void CircuitBreaker::record(Origin* origin, bool failed, uint32_t nowMs) {
+    switch (origin->state) {
+    case State::kOpen:
+        // Late outcome of a request started before the circuit opened: the cool-down stands.
+        return;
+    case State::kHalfOpen:
+        origin->probeInFlight = false;
+        if (failed) {
+            open(origin, nowMs);
+        } else {
+            origin->state = State::kClosed;
+            origin->failures = 0;
+            origin->samples = 0;
+        }
+        return;
+    case State::kClosed:
+        break;
+    }
+    uint32_t mask = _window >= 32 ? 0xFFFFFFFFu : ((1u << _window) - 1u);
+    origin->failures = ((origin->failures << 1) | (failed ? 1u : 0u)) & mask;
+    if (origin->samples < _window)
+        origin->samples++;
+    if (!failed || origin->samples < _minRequests)
+        return;
+    uint32_t failedCount = static_cast<uint32_t>(__builtin_popcount(origin->failures));
+    if (failedCount * 100u >= static_cast<uint32_t>(_failureRatePercent) * origin->samples)
+        open(origin, nowMs);
+}
+
+void CircuitBreaker::open(Origin* origin, uint32_t nowMs) {
+    origin->state = State::kOpen;
+    origin->openedAtMs = nowMs;
+    origin->probeInFlight = false;
+    origin->failures = 0;
+    origin->samples = 0;
+}
+
+CircuitBreaker::State CircuitBreaker::state(const std::string& originKey) const {
+    const Origin* origin = find(originKey);
+    return origin ? origin->state : State::kClosed;
+}
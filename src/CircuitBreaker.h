@@ -0,0 +1,76 @@
+/**
+ * Per-origin circuit breaker (closed / open / half-open).
+ *
+ * An origin opens once enough of its last `window` attempts failed; requests are then refused without
+ * touching the network for `openMs`, after which a single probe decides whether it closes again.
+ * Time is passed in by the caller (millis()).
+ */
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CircuitBreaker {
+  public:
+    enum class State {
+        kClosed,
+        kOpen,
+        kHalfOpen,
+    };
+
+    enum class Decision {
+        kAllow,  // circuit closed
+        kProbe,  // half-open: this request is the probe and must report an outcome (or releaseProbe())
+        kReject, // open, or a probe is already in flight
+    };
+
+    static constexpr uint8_t kMaxWindow = 32;
+
+    // failureRatePercent == 0 disables the breaker. window is clamped to [1, kMaxWindow] and minRequests to
+    // [1, window]. Reconfiguring resets every origin to closed.
+    void configure(uint8_t failureRatePercent, uint32_t openMs, uint8_t minRequests, uint8_t window);
+    bool enabled() const {
+        return _failureRatePercent > 0;
+    }
+
+    // On kReject, *retryInMs (optional) receives the time until the circuit lets a probe through
+    // (0 when a probe is currently in flight).
+    Decision allow(const std::string& originKey, uint32_t nowMs, uint32_t* retryInMs = nullptr);
+    void recordSuccess(const std::string& originKey, uint32_t nowMs);
+    void recordFailure(const std::string& originKey, uint32_t nowMs);
+    // The probe ended without an outcome (aborted, local error): let the next request probe instead.
+    void releaseProbe(const std::string& originKey);
+
+    State state(const std::string& originKey) const;
+    size_t trackedOrigins() const {
+        return _origins.size();
+    }
+
+  private:
+    struct Origin {
+        std::string key;
+        State state = State::kClosed;
+        uint32_t failures = 0; // bit i set = attempt i (0 = most recent) failed
+        uint8_t samples = 0;
+        bool probeInFlight = false;
+        uint32_t openedAtMs = 0;
+    };
+
+    Origin* find(const std::string& originKey);
+    const Origin* find(const std::string& originKey) const;
+    Origin* findOrCreate(const std::string& originKey);
+    void record(Origin* origin, bool failed, uint32_t nowMs);
+    void open(Origin* origin, uint32_t nowMs);
+    void pruneHealthy();
+
+    uint8_t _failureRatePercent = 0;
+    uint8_t _minRequests = 5;
+    uint8_t _window = 20;
+    uint32_t _openMs = 30000;
+    std::vector<Origin> _origins;
+};
+
+#endif // CIRCUIT_BREAKER_H
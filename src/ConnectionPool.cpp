@@ -1,21 +1,13 @@
 #include "ConnectionPool.h"
 #include "AsyncHttpClient.h"
+#include "RateLimiter.h"
+
+#include <cstring>
 
 ConnectionPool::ConnectionPool(AsyncHttpClient* client) : _client(client) {}
 
 ConnectionPool::~ConnectionPool() {
-    std::vector<AsyncTransport*> toDelete;
-    lock();
-    for (auto& pooled : _idleConnections) {
-        if (pooled.transport)
-            toDelete.push_back(pooled.transport);
-    }
-    _idleConnections.clear();
-    unlock();
-    for (auto* transport : toDelete) {
-        transport->close(true);
-        delete transport;
-    }
+    dropAll();
 }
 
 void ConnectionPool::lock() const {
@@ -28,50 +20,231 @@ void ConnectionPool::unlock() const {
         _client->unlock();
 }
 
-bool ConnectionPool::tlsConfigEquals(const AsyncHttpTLSConfig& a, const AsyncHttpTLSConfig& b) const {
-    return a.caCert == b.caCert && a.clientCert == b.clientCert && a.clientPrivateKey == b.clientPrivateKey &&
-           a.fingerprint == b.fingerprint && a.insecure == b.insecure && a.handshakeTimeoutMs == b.handshakeTimeoutMs;
+// Word-at-a-time multiply/rotate hash: a CA bundle is hashed once per attempt, so it has to be cheap on kilobytes.
+// The length is mixed in as well so adjacent fields cannot run into each other.
+static void digestBytes(uint64_t* hash, const char* data, size_t len) {
+    uint64_t h = *hash ^ (static_cast<uint64_t>(len) * 0x9E3779B97F4A7C15ULL);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h ^= word;
+        h = ((h << 29) | (h >> 35)) * 0x9E3779B97F4A7C15ULL;
+    }
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < len; ++i, shift += 8)
+        tail |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << shift;
+    h ^= tail;
+    h = ((h << 29) | (h >> 35)) * 0x9E3779B97F4A7C15ULL;
+    *hash = h;
 }
 
-AsyncTransport* ConnectionPool::checkoutPooledTransport(const AsyncHttpRequest* request,
-                                                        const AsyncHttpTLSConfig& tlsCfg, bool keepAliveEnabled) {
-    if (!keepAliveEnabled || !request)
-        return nullptr;
-    AsyncTransport* found = nullptr;
+uint64_t ConnectionPool::tlsDigest(const AsyncHttpTLSConfig& tlsCfg) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    digestBytes(&hash, tlsCfg.caCert.c_str(), tlsCfg.caCert.length());
+    digestBytes(&hash, tlsCfg.clientCert.c_str(), tlsCfg.clientCert.length());
+    digestBytes(&hash, tlsCfg.clientPrivateKey.c_str(), tlsCfg.clientPrivateKey.length());
+    digestBytes(&hash, tlsCfg.fingerprint.c_str(), tlsCfg.fingerprint.length());
+    // The handshake timeout is left out: it does not change what an established connection (or a saved session)
+    // can be reused for, and deadlines clamp it per request.
+    char insecure = static_cast<char>(tlsCfg.insecure);
+    digestBytes(&hash, &insecure, 1);
+    // Final avalanche (MurmurHash3 fmix64) so every input bit reaches the hex digits of the key.
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+std::string ConnectionPool::makeKey(const AsyncHttpRequest* request, const AsyncHttpTLSConfig& tlsCfg) {
+    return makeKey(request->getHost().c_str(), request->getPort(), request->isSecure(), tlsCfg);
+}
+
+std::string ConnectionPool::makeKey(const char* host, uint16_t port, bool secure, const AsyncHttpTLSConfig& tlsCfg) {
+    std::string key = RateLimiter::makeOriginKey(host, port, secure);
+    if (secure) {
+        static const char kHex[] = "0123456789abcdef";
+        uint64_t digest = tlsDigest(tlsCfg);
+        key.push_back('#');
+        for (int shift = 60; shift >= 0; shift -= 4)
+            key.push_back(kHex[(digest >> shift) & 0xF]);
+    }
+    return key;
+}
+
+static bool namedAs(const char* name, size_t len, const char* expected) {
+    for (size_t i = 0; i < len; ++i) {
+        char c = name[i];
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+        if (expected[i] == '\0' || c != expected[i])
+            return false;
+    }
+    return expected[len] == '\0';
+}
+
+void ConnectionPool::parseKeepAliveHeader(const char* value, uint32_t* timeoutMs, uint32_t* maxRequests) {
+    // Parameters are `name=digits`, separated by commas and optional spaces; unknown ones are skipped.
+    const char* p = value;
+    while (p && *p) {
+        while (*p == ' ' || *p == '\t' || *p == ',')
+            ++p;
+        const char* name = p;
+        while (*p && *p != '=' && *p != ',')
+            ++p;
+        size_t nameLen = static_cast<size_t>(p - name);
+        while (nameLen > 0 && (name[nameLen - 1] == ' ' || name[nameLen - 1] == '\t'))
+            --nameLen;
+        if (*p != '=')
+            continue;
+        ++p;
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        bool digits = *p >= '0' && *p <= '9';
+        uint64_t number = 0;
+        while (*p >= '0' && *p <= '9') {
+            if (number < 0xFFFFFFFFu)
+                number = number * 10 + static_cast<uint64_t>(*p - '0');
+            ++p;
+        }
+        if (number > 0xFFFFFFFFu)
+            number = 0xFFFFFFFFu;
+        if (digits && namedAs(name, nameLen, "timeout") && timeoutMs)
+            *timeoutMs = number > 0xFFFFFFFFu / 1000 ? 0xFFFFFFFFu : static_cast<uint32_t>(number) * 1000;
+        else if (digits && namedAs(name, nameLen, "max") && maxRequests)
+            *maxRequests = static_cast<uint32_t>(number);
+        while (*p && *p != ',')
+            ++p;
+    }
+}
+
+bool ConnectionPool::expiredAt(const PooledConnection& pooled, uint32_t now, uint32_t idleMs) {
+    uint32_t idle = now - pooled.lastUsedMs;
+    return idle > idleMs || (pooled.serverIdleMs > 0 && idle >= pooled.serverIdleMs);
+}
+
+void ConnectionPool::setLimits(const AsyncHttpConnectionPoolLimits& limits) {
+    std::vector<AsyncTransport*> evicted;
     lock();
-    for (auto it = _idleConnections.begin(); it != _idleConnections.end();) {
-        bool removeEntry = false;
-        if (!it->transport || !it->transport->canSend()) {
-            removeEntry = true;
-        } else {
-            bool match = it->host.equalsIgnoreCase(request->getHost()) && it->port == request->getPort() &&
-                         it->secure == request->isSecure();
-            if (match && it->secure)
-                match = tlsConfigEquals(it->tlsConfig, tlsCfg);
-            if (match) {
-                found = it->transport;
-                _idleConnections.erase(it);
-                break;
+    _limits = limits;
+    // Re-derive the byte estimate with the new per-connection costs.
+    _stats.idleBytes = _stats.idleTls * costOf(true) + (_stats.idle - _stats.idleTls) * costOf(false);
+    if (_limits.maxIdlePerOrigin > 0) {
+        for (auto& entry : _idle) {
+            std::vector<PooledConnection>& stack = entry.second.connections;
+            while (stack.size() > _limits.maxIdlePerOrigin) {
+                evicted.push_back(stack.front().transport);
+                stack.erase(stack.begin());
+                forgetLocked(entry.second.secure);
+                _stats.evictions++;
+            }
+        }
+    }
+    enforceLimitsLocked(millis(), &evicted);
+    unlock();
+    for (auto* transport : evicted) {
+        transport->close(true);
+        delete transport;
+    }
+}
+
+AsyncHttpConnectionPoolStats ConnectionPool::stats() const {
+    lock();
+    AsyncHttpConnectionPoolStats stats = _stats;
+    unlock();
+    return stats;
+}
+
+void ConnectionPool::forgetLocked(bool secure) {
+    if (_stats.idle > 0)
+        _stats.idle--;
+    if (secure && _stats.idleTls > 0)
+        _stats.idleTls--;
+    size_t cost = costOf(secure);
+    _stats.idleBytes = _stats.idleBytes > cost ? _stats.idleBytes - cost : 0;
+}
+
+void ConnectionPool::enforceLimitsLocked(uint32_t now, std::vector<AsyncTransport*>* evicted) {
+    for (;;) {
+        bool over = (_limits.maxIdle > 0 && _stats.idle > _limits.maxIdle) ||
+                    (_limits.maxIdleBytes > 0 && _stats.idleBytes > _limits.maxIdleBytes);
+        if (!over)
+            return;
+        // Each stack is ordered oldest first and all its connections cost the same, so the victim is the bottom
+        // entry of one of the stacks: one pass over the origins.
+        IdleStack* victim = nullptr;
+        uint64_t victimScore = 0;
+        for (auto& entry : _idle) {
+            IdleStack& stack = entry.second;
+            if (stack.connections.empty())
+                continue;
+            uint64_t age = static_cast<uint64_t>(now - stack.connections.front().lastUsedMs) + 1;
+            uint64_t score = _limits.costWeighted ? age * costOf(stack.secure) : age;
+            if (!victim || score > victimScore) {
+                victim = &stack;
+                victimScore = score;
             }
         }
-        if (removeEntry) {
-            AsyncTransport* toDelete = it->transport;
-            it = _idleConnections.erase(it);
-            if (toDelete) {
-                toDelete->close(true);
-                delete toDelete;
+        if (!victim)
+            return;
+        evicted->push_back(victim->connections.front().transport);
+        victim->connections.erase(victim->connections.begin());
+        forgetLocked(victim->secure);
+        _stats.evictions++;
+    }
+}
+
+AsyncTransport* ConnectionPool::checkoutPooledTransport(const std::string& key, bool keepAliveEnabled,
+                                                        uint32_t* reuses) {
+    if (!keepAliveEnabled || key.empty())
+        return nullptr;
+    AsyncTransport* found = nullptr;
+    uint32_t foundReuses = 0;
+    std::vector<AsyncTransport*> dead;
+    uint32_t now = millis();
+    lock();
+    auto it = _idle.find(key);
+    if (it != _idle.end()) {
+        IdleStack& stack = it->second;
+        while (!stack.connections.empty() && !found) {
+            PooledConnection candidate = stack.connections.back();
+            stack.connections.pop_back();
+            forgetLocked(stack.secure);
+            bool alive = candidate.transport && candidate.transport->canSend();
+            if (alive && !expiredAt(candidate, now, 0xFFFFFFFFu)) {
+                found = candidate.transport;
+                foundReuses = candidate.reuses;
+            } else {
+                // Closed, or about to be closed by the server (pruning may not have run since it expired).
+                if (alive)
+                    _stats.expired++;
+                else
+                    _stats.closed++;
+                if (candidate.transport)
+                    dead.push_back(candidate.transport);
             }
-            continue;
         }
-        ++it;
+        stack.lastUsedMs = now;
     }
+    if (found)
+        _stats.hits++;
+    else
+        _stats.misses++;
     unlock();
+    for (auto* transport : dead) {
+        transport->close(true);
+        delete transport;
+    }
     if (found) {
         found->setDataHandler(nullptr, nullptr);
         found->setDisconnectHandler(nullptr, nullptr);
         found->setErrorHandler(nullptr, nullptr);
         found->setTimeoutHandler(nullptr, nullptr);
     }
+    if (reuses)
+        *reuses = foundReuses;
     return found;
 }
 
@@ -80,12 +253,20 @@ void ConnectionPool::dropPooledTransport(AsyncTransport* transport, bool closeTr
         return;
     bool removed = false;
     lock();
-    for (auto it = _idleConnections.begin(); it != _idleConnections.end(); ++it) {
-        if (it->transport == transport) {
-            _idleConnections.erase(it);
-            removed = true;
-            break;
+    // Idle sockets rarely close on their own; a pointer scan over all stacks keeps the entries small.
+    for (auto& entry : _idle) {
+        std::vector<PooledConnection>& stack = entry.second.connections;
+        for (auto it = stack.begin(); it != stack.end(); ++it) {
+            if (it->transport == transport) {
+                stack.erase(it);
+                forgetLocked(entry.second.secure);
+                _stats.closed++;
+                removed = true;
+                break;
+            }
         }
+        if (removed)
+            break;
     }
     unlock();
     if (removed && closeTransport) {
@@ -100,17 +281,30 @@ void ConnectionPool::pruneIdleConnections(bool keepAliveEnabled, uint32_t keepAl
     uint32_t now = millis();
     std::vector<AsyncTransport*> staleTransports;
     lock();
-    for (auto it = _idleConnections.begin(); it != _idleConnections.end();) {
-        bool stale = !keepAliveEnabled || !it->transport || !it->transport->canSend() ||
-                     (now - it->lastUsedMs) > keepAliveIdleMs;
-        if (stale) {
-            AsyncTransport* toDelete = it->transport;
-            it = _idleConnections.erase(it);
-            if (toDelete)
-                staleTransports.push_back(toDelete);
-        } else {
-            ++it;
+    for (auto entry = _idle.begin(); entry != _idle.end();) {
+        std::vector<PooledConnection>& stack = entry->second.connections;
+        // The bottom of each stack holds the least recently used connections.
+        size_t keep = 0;
+        for (size_t i = 0; i < stack.size(); ++i) {
+            const PooledConnection& pooled = stack[i];
+            bool alive = pooled.transport && pooled.transport->canSend();
+            if (!alive || expiredAt(pooled, now, keepAliveIdleMs)) {
+                forgetLocked(entry->second.secure);
+                if (alive)
+                    _stats.expired++;
+                else
+                    _stats.closed++;
+                if (pooled.transport)
+                    staleTransports.push_back(pooled.transport);
+            } else {
+                stack[keep++] = pooled;
+            }
         }
+        stack.resize(keep);
+        if (stack.empty() && (now - entry->second.lastUsedMs) > keepAliveIdleMs)
+            entry = _idle.erase(entry);
+        else
+            ++entry;
     }
     unlock();
     for (auto* t : staleTransports) {
@@ -119,14 +313,23 @@ void ConnectionPool::pruneIdleConnections(bool keepAliveEnabled, uint32_t keepAl
     }
 }
 
+void ConnectionPool::takeAllLocked(std::vector<AsyncTransport*>* out) {
+    for (auto& entry : _idle) {
+        for (auto& pooled : entry.second.connections) {
+            if (pooled.transport)
+                out->push_back(pooled.transport);
+        }
+    }
+    _idle.clear();
+    _stats.idle = 0;
+    _stats.idleTls = 0;
+    _stats.idleBytes = 0;
+}
+
 void ConnectionPool::dropAll() {
     std::vector<AsyncTransport*> toDelete;
     lock();
-    for (auto& pooled : _idleConnections) {
-        if (pooled.transport)
-            toDelete.push_back(pooled.transport);
-    }
-    _idleConnections.clear();
+    takeAllLocked(&toDelete);
     unlock();
     for (auto* transport : toDelete) {
         transport->close(true);
@@ -134,6 +337,21 @@ void ConnectionPool::dropAll() {
     }
 }
 
+size_t ConnectionPool::idleCount() const {
+    lock();
+    size_t count = _stats.idle;
+    unlock();
+    return count;
+}
+
+size_t ConnectionPool::idleCount(const std::string& key) const {
+    lock();
+    auto it = _idle.find(key);
+    size_t count = it != _idle.end() ? it->second.connections.size() : 0;
+    unlock();
+    return count;
+}
+
 bool ConnectionPool::shouldRecycleTransport(const AsyncHttpRequest* request,
                                             const std::shared_ptr<AsyncHttpResponse>& response,
                                             AsyncTransport* transport, bool responseProcessed, bool requestKeepAlive,
@@ -155,42 +373,64 @@ bool ConnectionPool::shouldRecycleTransport(const AsyncHttpRequest* request,
     return true;
 }
 
-void ConnectionPool::releaseConnectionToPool(AsyncTransport* transport, const AsyncHttpRequest* request,
-                                             const AsyncHttpTLSConfig& tlsCfg) {
-    if (!transport || !request)
+void ConnectionPool::releaseConnectionToPool(AsyncTransport* transport, const std::string& key, uint32_t reuses,
+                                             uint32_t serverTimeoutMs, uint32_t serverMaxRequests) {
+    if (!transport || key.empty())
         return;
     PooledConnection pooled;
     pooled.transport = transport;
-    pooled.host = request->getHost();
-    pooled.port = request->getPort();
-    pooled.secure = request->isSecure();
-    pooled.tlsConfig = tlsCfg;
     pooled.lastUsedMs = millis();
+    pooled.reuses = reuses;
+    lock();
+    uint32_t margin = _limits.serverTimeoutMarginMs;
+    bool retire = serverMaxRequests == 0 || (serverTimeoutMs > 0 && serverTimeoutMs <= margin);
+    if (retire)
+        _stats.expired++; // the server will not take another request (or not for long enough to be worth it)
+    unlock();
+    if (retire) {
+        transport->close(true);
+        delete transport;
+        return;
+    }
+    if (serverTimeoutMs > 0)
+        pooled.serverIdleMs = serverTimeoutMs - margin;
 
     pooled.transport->setConnectHandler(nullptr, nullptr);
     pooled.transport->setTimeoutHandler(nullptr, nullptr);
     pooled.transport->setDataHandler(
-        [](void* arg, AsyncTransport* t, void* data, size_t len) {
-            (void)data;
-            (void)len;
-            auto self = static_cast<ConnectionPool*>(arg);
-            self->dropPooledTransport(t, true);
-        },
-        this);
-    pooled.transport->setDisconnectHandler(
-        [](void* arg, AsyncTransport* t) {
-            auto self = static_cast<ConnectionPool*>(arg);
-            self->dropPooledTransport(t, true);
-        },
-        this);
+        [this](void*, AsyncTransport* t, void*, size_t) { dropPooledTransport(t, true); }, nullptr);
+    pooled.transport->setDisconnectHandler([this](void*, AsyncTransport* t) { dropPooledTransport(t, true); },
+                                           nullptr);
     pooled.transport->setErrorHandler(
-        [](void* arg, AsyncTransport* t, HttpClientError, const char*) {
-            auto self = static_cast<ConnectionPool*>(arg);
-            self->dropPooledTransport(t, true);
-        },
-        this);
+        [this](void*, AsyncTransport* t, HttpClientError, const char*) { dropPooledTransport(t, true); }, nullptr);
 
+    std::vector<AsyncTransport*> evicted;
     lock();
-    _idleConnections.push_back(pooled);
+    auto inserted = _idle.emplace(key, IdleStack());
+    IdleStack& stack = inserted.first->second;
+    if (inserted.second)
+        stack.secure = key.compare(0, 8, "https://") == 0;
+    if (_limits.maxIdlePerOrigin > 0 && stack.connections.size() >= _limits.maxIdlePerOrigin) {
+        // The origin's coldest connection makes room for the warm one.
+        evicted.push_back(stack.connections.front().transport);
+        stack.connections.erase(stack.connections.begin());
+        forgetLocked(stack.secure);
+        _stats.evictions++;
+    }
+    stack.connections.push_back(pooled);
+    stack.lastUsedMs = pooled.lastUsedMs;
+    _stats.idle++;
+    if (stack.secure)
+        _stats.idleTls++;
+    _stats.idleBytes += costOf(stack.secure);
+    if (reuses == 0)
+        _stats.pooled++;
+    else if (reuses > _stats.maxReuses)
+        _stats.maxReuses = reuses;
+    enforceLimitsLocked(pooled.lastUsedMs, &evicted);
     unlock();
+    for (auto* victim : evicted) {
+        victim->close(true);
+        delete victim;
+    }
 }
@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "AsyncTransport.h"
 #include "HttpRequest.h"
@@ -10,28 +12,86 @@
 
 class AsyncHttpClient;
 
+// Bounds on idle keep-alive connections (0 = unlimited). An idle TLS connection keeps its mbedTLS context and record
+// buffers, so the byte cap weighs it by `tlsConnectionBytes` against `tcpConnectionBytes` for plain HTTP.
+struct AsyncHttpConnectionPoolLimits {
+    uint16_t maxIdle = 0;            // idle connections across all origins
+    uint16_t maxIdlePerOrigin = 0;   // per origin + TLS profile
+    size_t maxIdleBytes = 0;         // estimated memory held by idle connections
+    size_t tlsConnectionBytes = 40960;
+    size_t tcpConnectionBytes = 1024;
+    // Eviction victim: false = least recently used; true = largest idle time x memory cost, so a cold TLS socket goes
+    // before a slightly colder plain one.
+    bool costWeighted = false;
+    // Connections are retired this long before the idle timeout a server advertises in `Keep-Alive: timeout=N`, so
+    // a request is not written into a socket the server is about to close.
+    uint32_t serverTimeoutMarginMs = 1000;
+};
+
+struct AsyncHttpConnectionPoolStats {
+    size_t idle = 0;            // idle connections now
+    size_t idleTls = 0;         // ...of which TLS
+    size_t idleBytes = 0;       // their estimated memory
+    uint32_t hits = 0;          // checkouts served from the pool
+    uint32_t misses = 0;        // checkouts that had to open a new connection
+    uint32_t evictions = 0;     // idle connections closed to respect the limits
+    uint32_t expired = 0;       // closed by the idle timeout (the client's or the server's Keep-Alive timeout)
+    uint32_t closed = 0;        // found closed by the server while idle
+    uint32_t pooled = 0;        // distinct connections that entered the pool (hits / pooled = average reuse)
+    uint32_t maxReuses = 0;     // most requests served by one pooled connection after its first
+};
+
+// Idle keep-alive connections indexed by pool key: the origin plus, for HTTPS, a digest of the TLS profile (CA,
+// client certificate and key, fingerprint, verification mode), so a checkout is one hash lookup and entries do not
+// keep copies of the PEM strings. Each key holds a LIFO stack: the most recently used socket is reused first and
+// the coldest ones age out.
 class ConnectionPool {
   public:
     struct PooledConnection {
         AsyncTransport* transport = nullptr;
-        String host;
-        uint16_t port = 0;
-        bool secure = false;
-        AsyncHttpTLSConfig tlsConfig;
         uint32_t lastUsedMs = 0;
+        uint32_t reuses = 0; // requests served after the first one
+        // From the server's last `Keep-Alive` header: idle time left before it closes the socket (already reduced by
+        // the safety margin; 0 = not advertised). Its `max` is checked on release: a connection that reaches the pool
+        // accepts at least one more request, and the next response's header replaces the count.
+        uint32_t serverIdleMs = 0;
+    };
+
+    static const uint32_t kNoRequestLimit = 0xFFFFFFFFu;
+
+    // `Keep-Alive: timeout=5, max=99` → 5000 ms and 99 requests. Missing parameters leave the outputs untouched.
+    static void parseKeepAliveHeader(const char* value, uint32_t* timeoutMs, uint32_t* maxRequests);
+
+    struct IdleStack {
+        std::vector<PooledConnection> connections; // back() is the most recently used
+        uint32_t lastUsedMs = 0;                   // empty stacks are kept (with their capacity) until they age out
+        bool secure = false;
     };
 
     explicit ConnectionPool(AsyncHttpClient* client);
     ~ConnectionPool();
 
-    AsyncTransport* checkoutPooledTransport(const AsyncHttpRequest* request, const AsyncHttpTLSConfig& tlsCfg,
-                                            bool keepAliveEnabled);
-    void releaseConnectionToPool(AsyncTransport* transport, const AsyncHttpRequest* request,
-                                 const AsyncHttpTLSConfig& tlsCfg);
+    // "https://host:443#<tls digest>" (the origin key alone for plain HTTP). Computed once per attempt.
+    static std::string makeKey(const AsyncHttpRequest* request, const AsyncHttpTLSConfig& tlsCfg);
+    static std::string makeKey(const char* host, uint16_t port, bool secure, const AsyncHttpTLSConfig& tlsCfg);
+    static uint64_t tlsDigest(const AsyncHttpTLSConfig& tlsCfg);
+
+    void setLimits(const AsyncHttpConnectionPoolLimits& limits);
+    AsyncHttpConnectionPoolStats stats() const;
+
+    // `reuses` receives how many requests the connection served before (pass it back on release).
+    AsyncTransport* checkoutPooledTransport(const std::string& key, bool keepAliveEnabled, uint32_t* reuses = nullptr);
+    // `serverTimeoutMs` / `serverMaxRequests` come from the response's Keep-Alive header (0 / kNoRequestLimit when it
+    // had none); a connection the server will not keep long enough, or will not accept another request on, is closed.
+    void releaseConnectionToPool(AsyncTransport* transport, const std::string& key, uint32_t reuses = 0,
+                                 uint32_t serverTimeoutMs = 0, uint32_t serverMaxRequests = kNoRequestLimit);
     void dropPooledTransport(AsyncTransport* transport, bool closeTransport);
     void pruneIdleConnections(bool keepAliveEnabled, uint32_t keepAliveIdleMs);
     void dropAll();
 
+    size_t idleCount() const;
+    size_t idleCount(const std::string& key) const;
+
     static bool shouldRecycleTransport(const AsyncHttpRequest* request,
                                        const std::shared_ptr<AsyncHttpResponse>& response, AsyncTransport* transport,
                                        bool responseProcessed, bool requestKeepAlive, bool serverRequestedClose,
@@ -41,10 +101,18 @@ class ConnectionPool {
   private:
     void lock() const;
     void unlock() const;
-    bool tlsConfigEquals(const AsyncHttpTLSConfig& a, const AsyncHttpTLSConfig& b) const;
+    void takeAllLocked(std::vector<AsyncTransport*>* out);
+    size_t costOf(bool secure) const {
+        return secure ? _limits.tlsConnectionBytes : _limits.tcpConnectionBytes;
+    }
+    void forgetLocked(bool secure); // bookkeeping for one connection leaving the idle set
+    static bool expiredAt(const PooledConnection& pooled, uint32_t now, uint32_t idleMs);
+    void enforceLimitsLocked(uint32_t now, std::vector<AsyncTransport*>* evicted);
 
     AsyncHttpClient* _client = nullptr;
-    std::vector<PooledConnection> _idleConnections;
+    std::unordered_map<std::string, IdleStack> _idle;
+    AsyncHttpConnectionPoolLimits _limits;
+    AsyncHttpConnectionPoolStats _stats; // idle / idleTls / idleBytes are kept up to date incrementally
 };
 
 #endif // CONNECTION_POOL_H
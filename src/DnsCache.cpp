@@ -0,0 +1,365 @@
+#include "DnsCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+#endif
+
+namespace {
+
+std::string lowercase(const char* host) {
+    std::string out(host ? host : "");
+    for (char& c : out)
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+// lwIP's asynchronous resolver. The answer comes back on the tcpip thread (AsyncTCP forwards its own lookups to the
+// async_tcp task instead): callbacks registered with resolve() run there and must not block or call into AsyncTCP.
+class LwipResolver : public AsyncHttpResolver {
+  public:
+    void resolve(const char* host, Completion done) override {
+        Completion* pending = new Completion(std::move(done));
+        ip_addr_t addr;
+#if CONFIG_LWIP_TCPIP_CORE_LOCKING
+        bool lock = !sys_thread_tcpip(LWIP_CORE_LOCK_QUERY_HOLDER);
+        if (lock)
+            LOCK_TCPIP_CORE();
+#endif
+        err_t err = dns_gethostbyname(host, &addr, found, pending);
+#if CONFIG_LWIP_TCPIP_CORE_LOCKING
+        if (lock)
+            UNLOCK_TCPIP_CORE();
+#endif
+        if (err == ERR_INPROGRESS)
+            return; // found() runs later
+        found(host, err == ERR_OK ? &addr : nullptr, pending);
+    }
+
+  private:
+    static void found(const char* name, const ip_addr_t* addr, void* arg) {
+        (void)name;
+        Completion* pending = static_cast<Completion*>(arg);
+        if (addr && IP_IS_V4(addr))
+            (*pending)(true, ip4_addr_get_u32(ip_2_ip4(addr)), 0);
+        else
+            (*pending)(false, 0, 0);
+        delete pending;
+    }
+};
+#endif
+
+} // namespace
+
+void DnsCache::configure(const AsyncHttpDnsConfig& config) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _config = config;
+}
+
+AsyncHttpDnsConfig DnsCache::config() const {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _config;
+}
+
+void DnsCache::setResolver(AsyncHttpResolver* resolver) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _resolver = resolver;
+}
+
+AsyncHttpResolver* DnsCache::activeResolver() const {
+    if (_resolver)
+        return _resolver;
+#if defined(ARDUINO_ARCH_ESP32)
+    static LwipResolver lwip;
+    return &lwip;
+#else
+    return nullptr;
+#endif
+}
+
+DnsCache::Entry* DnsCache::find(const std::string& host) {
+    for (Entry& entry : _entries) {
+        if (entry.host == host)
+            return &entry;
+    }
+    return nullptr;
+}
+
+bool DnsCache::fresh(const Entry& entry, uint32_t nowMs) const {
+    switch (entry.state) {
+    case State::kPinned:
+        return true;
+    case State::kPositive:
+    case State::kNegative:
+        return nowMs - entry.startedMs < entry.ttlMs;
+    case State::kPending:
+        break;
+    }
+    return false;
+}
+
+DnsCache::Result DnsCache::resolve(const char* host, uint32_t nowMs, uint32_t* ipv4, Callback callback,
+                                   uint32_t* waiter) {
+    if (parseIPv4(host, ipv4))
+        return Result::kResolved;
+    std::string key = lowercase(host);
+    std::unique_lock<std::mutex> guard(_mutex);
+    Entry* entry = find(key);
+    if (entry && entry->state == State::kPinned) {
+        _stats.hits++;
+        *ipv4 = entry->ipv4;
+        return Result::kResolved;
+    }
+    if (!_config.enabled || !activeResolver())
+        return Result::kBypass;
+    if (entry && fresh(*entry, nowMs)) {
+        entry->lastUsedMs = nowMs;
+        if (entry->state == State::kNegative) {
+            _stats.negativeHits++;
+            return Result::kFailed;
+        }
+        _stats.hits++;
+        *ipv4 = entry->ipv4;
+        return Result::kResolved;
+    }
+    Waiter w;
+    if (callback) {
+        w.id = ++_nextWaiterId;
+        w.callback = std::move(callback);
+        if (waiter)
+            *waiter = w.id;
+    }
+    if (entry && entry->state == State::kPending) {
+        _stats.coalesced++;
+        entry->lastUsedMs = nowMs;
+        if (w.callback)
+            entry->waiters.push_back(std::move(w));
+        return Result::kPending;
+    }
+    _stats.misses++;
+    if (!entry) {
+        evictIfFull();
+        _entries.emplace_back();
+        entry = &_entries.back();
+        entry->host = key;
+    }
+    if (w.callback)
+        entry->waiters.push_back(std::move(w));
+    startLookup(guard, entry, nowMs);
+    return Result::kPending;
+}
+
+void DnsCache::startLookup(std::unique_lock<std::mutex>& guard, Entry* entry, uint32_t nowMs) {
+    entry->state = State::kPending;
+    entry->startedMs = nowMs;
+    entry->lastUsedMs = nowMs;
+    entry->lookupId = ++_nextLookupId;
+    uint32_t lookupId = entry->lookupId;
+    std::string host = entry->host;
+    AsyncHttpResolver* resolver = activeResolver();
+    // The resolver may answer synchronously (lwIP's own table): complete() takes the lock again.
+    guard.unlock();
+    resolver->resolve(host.c_str(), [this, lookupId](bool found, uint32_t ipv4, uint32_t ttlMs) {
+        complete(lookupId, found, ipv4, ttlMs);
+    });
+    guard.lock();
+}
+
+void DnsCache::complete(uint32_t lookupId, bool found, uint32_t ipv4, uint32_t ttlMs) {
+    std::vector<uint32_t> waiters;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        auto it = std::find_if(_entries.begin(), _entries.end(), [lookupId](const Entry& entry) {
+            return entry.state == State::kPending && entry.lookupId == lookupId;
+        });
+        if (it == _entries.end())
+            return; // pinned meanwhile
+        waiters = takeWaiters(&*it);
+        if (found) {
+            it->state = State::kPositive;
+            it->ipv4 = ipv4;
+            it->ttlMs = ttlMs == 0 ? _config.ttlMs : std::min(ttlMs, _config.maxTtlMs);
+        } else {
+            _stats.failures++;
+            it->state = State::kNegative;
+            it->ipv4 = 0;
+            it->ttlMs = _config.negativeTtlMs;
+        }
+        if (it->ttlMs == 0)
+            _entries.erase(it); // not cached
+    }
+    deliver(waiters, found, ipv4);
+}
+
+std::vector<uint32_t> DnsCache::takeWaiters(Entry* entry) {
+    std::vector<uint32_t> ids;
+    ids.reserve(entry->waiters.size());
+    for (Waiter& w : entry->waiters) {
+        ids.push_back(w.id);
+        _delivering.push_back(std::move(w));
+    }
+    entry->waiters.clear();
+    return ids;
+}
+
+void DnsCache::deliver(const std::vector<uint32_t>& ids, bool found, uint32_t ipv4) {
+    // Outside the lock: a callback may connect, fail the request and delete its transport (which cancels). Each
+    // waiter is looked up again just before its call, so one cancelled meanwhile (by an earlier callback or from
+    // another task) is skipped.
+    for (uint32_t id : ids) {
+        Callback callback;
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            auto it = std::find_if(_delivering.begin(), _delivering.end(),
+                                   [id](const Waiter& w) { return w.id == id; });
+            if (it == _delivering.end())
+                continue;
+            callback = std::move(it->callback);
+            _delivering.erase(it);
+        }
+        callback(found, ipv4);
+    }
+}
+
+void DnsCache::cancel(uint32_t waiter) {
+    if (waiter == 0)
+        return;
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (Entry& entry : _entries) {
+        auto it = std::find_if(entry.waiters.begin(), entry.waiters.end(),
+                               [waiter](const Waiter& w) { return w.id == waiter; });
+        if (it != entry.waiters.end()) {
+            entry.waiters.erase(it);
+            return;
+        }
+    }
+    auto it = std::find_if(_delivering.begin(), _delivering.end(),
+                           [waiter](const Waiter& w) { return w.id == waiter; });
+    if (it != _delivering.end())
+        _delivering.erase(it);
+}
+
+bool DnsCache::preResolve(const char* host, uint32_t nowMs) {
+    uint32_t ipv4 = 0;
+    if (parseIPv4(host, &ipv4))
+        return true;
+    std::string key = lowercase(host);
+    std::unique_lock<std::mutex> guard(_mutex);
+    Entry* entry = find(key);
+    if (entry && entry->state == State::kPinned)
+        return true;
+    if (!_config.enabled || !activeResolver())
+        return false;
+    if (entry && (entry->state == State::kPending || fresh(*entry, nowMs)))
+        return true;
+    _stats.misses++;
+    if (!entry) {
+        evictIfFull();
+        _entries.emplace_back();
+        entry = &_entries.back();
+        entry->host = key;
+    }
+    startLookup(guard, entry, nowMs);
+    return true;
+}
+
+void DnsCache::pin(const char* host, uint32_t ipv4) {
+    std::string key = lowercase(host);
+    std::vector<uint32_t> waiters;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        Entry* entry = find(key);
+        if (!entry) {
+            _entries.emplace_back();
+            entry = &_entries.back();
+            entry->host = key;
+        }
+        waiters = takeWaiters(entry); // connections waiting on a lookup take the pinned address
+        entry->state = State::kPinned;
+        entry->ipv4 = ipv4;
+    }
+    deliver(waiters, true, ipv4);
+}
+
+bool DnsCache::unpin(const char* host) {
+    std::string key = lowercase(host);
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto it = std::find_if(_entries.begin(), _entries.end(),
+                           [&key](const Entry& entry) { return entry.host == key && entry.state == State::kPinned; });
+    if (it == _entries.end())
+        return false;
+    _entries.erase(it);
+    return true;
+}
+
+void DnsCache::clear() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _entries.erase(std::remove_if(_entries.begin(), _entries.end(),
+                                  [](const Entry& entry) {
+                                      return entry.state == State::kPositive || entry.state == State::kNegative;
+                                  }),
+                   _entries.end());
+    _stats = AsyncHttpDnsStats();
+}
+
+AsyncHttpDnsStats DnsCache::stats() const {
+    std::lock_guard<std::mutex> guard(_mutex);
+    AsyncHttpDnsStats stats = _stats;
+    stats.entries = _entries.size();
+    return stats;
+}
+
+void DnsCache::evictIfFull() {
+    size_t cached = 0;
+    Entry* victim = nullptr;
+    for (Entry& entry : _entries) {
+        if (entry.state != State::kPositive && entry.state != State::kNegative)
+            continue; // pins and lookups in flight stay
+        cached++;
+        if (!victim || (int32_t)(entry.lastUsedMs - victim->lastUsedMs) < 0)
+            victim = &entry;
+    }
+    if (victim && cached >= _config.maxEntries) {
+        _entries.erase(_entries.begin() + (victim - _entries.data()));
+        _stats.evictions++;
+    }
+}
+
+bool DnsCache::parseIPv4(const char* text, uint32_t* ipv4) {
+    if (!text)
+        return false;
+    uint32_t bytes[4];
+    int part = 0;
+    const char* p = text;
+    while (part < 4) {
+        if (!isdigit(static_cast<unsigned char>(*p)))
+            return false;
+        uint32_t value = 0;
+        int digits = 0;
+        while (isdigit(static_cast<unsigned char>(*p))) {
+            value = value * 10 + static_cast<uint32_t>(*p++ - '0');
+            if (++digits > 3 || value > 255)
+                return false;
+        }
+        bytes[part++] = value;
+        if (part < 4 && *p++ != '.')
+            return false;
+    }
+    if (*p != '\0')
+        return false;
+    // Network byte order: the first octet in the lowest-addressed byte, whatever the host's endianness.
+    unsigned char* out = reinterpret_cast<unsigned char*>(ipv4);
+    for (int i = 0; i < 4; ++i)
+        out[i] = static_cast<unsigned char>(bytes[i]);
+    return true;
+}
+
+DnsCache& DnsCache::shared() {
+    static DnsCache cache;
+    return cache;
+}
@@ -0,0 +1,126 @@
+/**
+ * Host name resolution cache for the TCP and TLS transports.
+ *
+ * Keeps answers for a TTL, failed lookups for a shorter one, shares lookups in flight and supports pinned
+ * hosts. Lookups go through an AsyncHttpResolver (lwIP's dns_gethostbyname() on ESP32). Addresses are IPv4
+ * in network byte order. Time is passed in by the caller (millis()).
+ */
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "InplaceFunction.h"
+
+struct AsyncHttpDnsConfig {
+    bool enabled = true;           // off: transports pass host names to AsyncTCP (pinned hosts still apply)
+    uint32_t ttlMs = 30000;        // for answers without a TTL (lwIP does not report the record's)
+    uint32_t maxTtlMs = 300000;    // clamp for TTLs reported by the resolver
+    uint32_t negativeTtlMs = 2000; // failed lookups are answered from the cache this long (0 = not cached)
+    uint16_t maxEntries = 16;      // the least recently used unpinned entry is evicted beyond this
+};
+
+struct AsyncHttpDnsStats {
+    uint32_t hits = 0;         // answered from a fresh entry or a pin
+    uint32_t negativeHits = 0; // failed from a fresh negative entry, without a lookup
+    uint32_t misses = 0;       // had to start a lookup
+    uint32_t coalesced = 0;    // joined a lookup already in flight
+    uint32_t failures = 0;     // lookups that found no address
+    uint32_t evictions = 0;
+    size_t entries = 0; // including pins and lookups in flight
+};
+
+class AsyncHttpResolver {
+  public:
+    // Reports the lookup's outcome exactly once, possibly before resolve() returns. ttlMs 0 = unknown.
+    typedef InplaceFunction<void(bool found, uint32_t ipv4, uint32_t ttlMs)> Completion;
+
+    virtual ~AsyncHttpResolver() {}
+    virtual void resolve(const char* host, Completion done) = 0;
+};
+
+class DnsCache {
+  public:
+    enum class Result {
+        kResolved, // *ipv4 holds the address
+        kFailed,   // fresh negative entry: fail without a lookup
+        kPending,  // the callback runs once the lookup completes (maybe before resolve() returns)
+        kBypass,   // cache disabled or no resolver: connect by name
+    };
+    typedef InplaceFunction<void(bool found, uint32_t ipv4)> Callback;
+
+    DnsCache() {}
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    // Keeps the entries; a smaller maxEntries takes effect on the next insertion.
+    void configure(const AsyncHttpDnsConfig& config);
+    AsyncHttpDnsConfig config() const;
+    // nullptr restores the platform default. The resolver must outlive the lookups it was given.
+    void setResolver(AsyncHttpResolver* resolver);
+
+    // IP literals and pinned hosts resolve at once. *waiter (optional) receives a handle for cancel() when the
+    // result is kPending. With an empty callback a miss only starts (or joins) the lookup.
+    Result resolve(const char* host, uint32_t nowMs, uint32_t* ipv4, Callback callback, uint32_t* waiter);
+    // The callback of `waiter` will not run unless it has already started, also while the lookup's other callbacks
+    // are being called (the lookup itself goes on and still fills the cache).
+    void cancel(uint32_t waiter);
+    // Starts a lookup unless the host has a fresh entry or one in flight. False when nothing can resolve it.
+    bool preResolve(const char* host, uint32_t nowMs);
+
+    void pin(const char* host, uint32_t ipv4);
+    bool unpin(const char* host);
+    // Drops cached answers (not pins, not lookups in flight) and resets the counters.
+    void clear();
+    AsyncHttpDnsStats stats() const;
+
+    // Dotted-quad "a.b.c.d" to network byte order; false for anything else.
+    static bool parseIPv4(const char* text, uint32_t* ipv4);
+
+    static DnsCache& shared();
+
+  private:
+    enum class State : uint8_t { kPending, kPositive, kNegative, kPinned };
+    struct Waiter {
+        uint32_t id = 0;
+        Callback callback;
+    };
+    struct Entry {
+        std::string host; // lowercased
+        State state = State::kPending;
+        uint32_t ipv4 = 0;
+        uint32_t startedMs = 0; // lookup start: the TTL counts from here
+        uint32_t ttlMs = 0;
+        uint32_t lastUsedMs = 0;
+        uint32_t lookupId = 0;
+        std::vector<Waiter> waiters;
+    };
+
+    AsyncHttpResolver* activeResolver() const;
+    Entry* find(const std::string& host);
+    bool fresh(const Entry& entry, uint32_t nowMs) const;
+    // Starts a lookup for `entry` (the lock is released around the resolver call).
+    void startLookup(std::unique_lock<std::mutex>& guard, Entry* entry, uint32_t nowMs);
+    void complete(uint32_t lookupId, bool found, uint32_t ipv4, uint32_t ttlMs);
+    // Moves `entry`'s waiters to _delivering (under the lock) and returns their ids, in order.
+    std::vector<uint32_t> takeWaiters(Entry* entry);
+    // Calls the waiters taken by takeWaiters() that were not cancelled meanwhile, outside the lock.
+    void deliver(const std::vector<uint32_t>& ids, bool found, uint32_t ipv4);
+    void evictIfFull();
+
+    mutable std::mutex _mutex;
+    AsyncHttpDnsConfig _config;
+    AsyncHttpResolver* _resolver = nullptr;
+    std::vector<Entry> _entries;
+    // Waiters of a completed lookup not called yet: cancel() still reaches them while complete() runs the others.
+    std::vector<Waiter> _delivering;
+    uint32_t _nextLookupId = 0;
+    uint32_t _nextWaiterId = 0;
+    AsyncHttpDnsStats _stats;
+};
+
+#endif // DNS_CACHE_H
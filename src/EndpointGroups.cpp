@@ -0,0 +1,176 @@
+#include "EndpointGroups.h"
+
+#include <cctype>
+
+#include "UrlParser.h"
+
+static std::string lowercase(const std::string& text) {
+    std::string out(text);
+    for (char& c : out)
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+void EndpointGroups::configure(const AsyncHttpEndpointPolicy& policy) {
+    _policy = policy;
+    if (_policy.ewmaWeightPercent == 0)
+        _policy.ewmaWeightPercent = 1;
+    if (_policy.ewmaWeightPercent > 100)
+        _policy.ewmaWeightPercent = 100;
+    if (_policy.warmBonusPercent > 100)
+        _policy.warmBonusPercent = 100;
+}
+
+bool EndpointGroups::setGroup(const std::string& name, const std::vector<std::string>& endpointUrls) {
+    if (name.empty() || endpointUrls.empty() || endpointUrls.size() > kMaxEndpoints)
+        return false;
+    Group group;
+    group.name = lowercase(name);
+    for (const std::string& url : endpointUrls) {
+        UrlParser::ParsedUrl parsed;
+        if (!UrlParser::parse(url, parsed))
+            return false;
+        Endpoint endpoint;
+        endpoint.host = lowercase(parsed.host);
+        endpoint.port = parsed.port;
+        endpoint.secure = parsed.secure;
+        group.endpoints.push_back(endpoint);
+    }
+    Group* existing = find(group.name);
+    if (existing)
+        *existing = std::move(group);
+    else
+        _groups.push_back(std::move(group));
+    return true;
+}
+
+bool EndpointGroups::removeGroup(const std::string& name) {
+    std::string key = lowercase(name);
+    for (size_t i = 0; i < _groups.size(); ++i) {
+        if (_groups[i].name == key) {
+            _groups.erase(_groups.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EndpointGroups::hasGroup(const std::string& name) const {
+    return find(name) != nullptr;
+}
+
+size_t EndpointGroups::size(const std::string& name) const {
+    const Group* group = find(name);
+    return group ? group->endpoints.size() : 0;
+}
+
+EndpointGroups::Group* EndpointGroups::find(const std::string& name) {
+    return const_cast<Group*>(static_cast<const EndpointGroups*>(this)->find(name));
+}
+
+const EndpointGroups::Group* EndpointGroups::find(const std::string& name) const {
+    std::string key = lowercase(name);
+    for (const auto& group : _groups) {
+        if (group.name == key)
+            return &group;
+    }
+    return nullptr;
+}
+
+EndpointGroups::Endpoint* EndpointGroups::mutableEndpoint(const std::string& name, int index) {
+    return const_cast<Endpoint*>(endpoint(name, index));
+}
+
+bool EndpointGroups::healthy(const Endpoint& endpoint, uint32_t nowMs) const {
+    if (endpoint.failurePermille < static_cast<uint32_t>(_policy.unhealthyPercent) * 10)
+        return true;
+    return nowMs - endpoint.lastFailureMs >= _policy.retryUnhealthyMs;
+}
+
+uint32_t EndpointGroups::blend(uint32_t average, uint32_t sample) const {
+    uint32_t weight = _policy.ewmaWeightPercent;
+    uint64_t mixed = static_cast<uint64_t>(average) * (100 - weight) + static_cast<uint64_t>(sample) * weight;
+    return static_cast<uint32_t>((mixed + 50) / 100);
+}
+
+int EndpointGroups::select(const std::string& name, uint32_t excluded, uint32_t nowMs, const WarmProbe& warm) {
+    Group* group = find(name);
+    if (!group)
+        return -1;
+    int best = -1;
+    uint64_t bestScore = 0;
+    int fallback = -1; // every candidate unhealthy: the one that failed longest ago
+    for (size_t i = 0; i < group->endpoints.size(); ++i) {
+        if (excluded & (1u << i))
+            continue;
+        const Endpoint& endpoint = group->endpoints[i];
+        if (!healthy(endpoint, nowMs)) {
+            if (fallback < 0 ||
+                (int32_t)(endpoint.lastFailureMs - group->endpoints[fallback].lastFailureMs) < 0)
+                fallback = static_cast<int>(i);
+            continue;
+        }
+        // Endpoints without a sample score 0 and are tried first, least selected first.
+        uint64_t score = endpoint.latencyMs;
+        if (score > 0 && warm && warm(endpoint))
+            score = score * (100 - _policy.warmBonusPercent) / 100;
+        score = (score << 20) + (endpoint.latencyMs == 0 ? endpoint.selected : 0);
+        if (best < 0 || score < bestScore) {
+            best = static_cast<int>(i);
+            bestScore = score;
+        }
+    }
+    if (best < 0)
+        best = fallback;
+    if (best >= 0)
+        group->endpoints[best].selected++;
+    return best;
+}
+
+const EndpointGroups::Endpoint* EndpointGroups::endpoint(const std::string& name, int index) const {
+    const Group* group = find(name);
+    if (!group || index < 0 || static_cast<size_t>(index) >= group->endpoints.size())
+        return nullptr;
+    return &group->endpoints[index];
+}
+
+void EndpointGroups::recordSuccess(const std::string& name, int index, uint32_t latencyMs) {
+    Endpoint* endpoint = mutableEndpoint(name, index);
+    if (!endpoint)
+        return;
+    if (latencyMs == 0)
+        latencyMs = 1; // 0 means "no sample"
+    endpoint->latencyMs = endpoint->latencyMs == 0 ? latencyMs : blend(endpoint->latencyMs, latencyMs);
+    endpoint->failurePermille = static_cast<uint16_t>(blend(endpoint->failurePermille, 0));
+}
+
+void EndpointGroups::recordFailure(const std::string& name, int index, uint32_t nowMs) {
+    Endpoint* endpoint = mutableEndpoint(name, index);
+    if (!endpoint)
+        return;
+    endpoint->failures++;
+    endpoint->lastFailureMs = nowMs;
+    // The first outcome counts fully: an endpoint that fails its first connection is not tried again at once.
+    bool firstOutcome = endpoint->latencyMs == 0 && endpoint->failures == 1;
+    endpoint->failurePermille = static_cast<uint16_t>(firstOutcome ? 1000 : blend(endpoint->failurePermille, 1000));
+}
+
+std::vector<AsyncHttpEndpointStats> EndpointGroups::stats(const std::string& name, uint32_t nowMs) const {
+    std::vector<AsyncHttpEndpointStats> out;
+    const Group* group = find(name);
+    if (!group)
+        return out;
+    for (const Endpoint& endpoint : group->endpoints) {
+        AsyncHttpEndpointStats stats;
+        stats.host = endpoint.host;
+        stats.port = endpoint.port;
+        stats.secure = endpoint.secure;
+        stats.latencyMs = endpoint.latencyMs;
+        stats.failurePercent = static_cast<uint8_t>((endpoint.failurePermille + 5) / 10);
+        stats.healthy = healthy(endpoint, nowMs);
+        stats.selected = endpoint.selected;
+        stats.failures = endpoint.failures;
+        out.push_back(stats);
+    }
+    return out;
+}
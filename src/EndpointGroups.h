@@ -0,0 +1,92 @@
+/**
+ * Endpoint groups: one logical origin served by several concrete endpoints (e.g. regional copies of an API).
+ *
+ * Requests go to the healthy endpoint with the lowest latency average, where a warm pooled connection counts
+ * as faster; an endpoint whose failure average is too high is skipped for a while. Time is passed in by the
+ * caller (millis()).
+ */
+#ifndef ENDPOINT_GROUPS_H
+#define ENDPOINT_GROUPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct AsyncHttpEndpointPolicy {
+    uint8_t ewmaWeightPercent = 20;   // weight of the newest sample in the latency and failure averages
+    uint8_t unhealthyPercent = 50;    // failure average at which an endpoint is skipped...
+    uint32_t retryUnhealthyMs = 10000; // ...until this long after its last failure
+    uint8_t warmBonusPercent = 50;    // latency discount for an endpoint with an idle pooled connection
+    uint8_t maxFailovers = 2;         // connect-phase failures moved to another endpoint, per request
+};
+
+struct AsyncHttpEndpointStats {
+    std::string host;
+    uint16_t port = 0;
+    bool secure = false;
+    uint32_t latencyMs = 0;     // EWMA (0 = no sample yet)
+    uint8_t failurePercent = 0; // EWMA of failed attempts
+    bool healthy = true;
+    uint32_t selected = 0;
+    uint32_t failures = 0;
+};
+
+class EndpointGroups {
+  public:
+    static constexpr size_t kMaxEndpoints = 32; // per group (tried endpoints are tracked in a bitmask)
+
+    struct Endpoint {
+        std::string host; // lowercased
+        uint16_t port = 0;
+        bool secure = false;
+        uint32_t latencyMs = 0;
+        uint16_t failurePermille = 0;
+        uint32_t lastFailureMs = 0;
+        uint32_t selected = 0;
+        uint32_t failures = 0;
+    };
+    // True when the pool holds an idle connection to the endpoint.
+    typedef std::function<bool(const Endpoint& endpoint)> WarmProbe;
+
+    void configure(const AsyncHttpEndpointPolicy& policy);
+    const AsyncHttpEndpointPolicy& policy() const {
+        return _policy;
+    }
+
+    // Endpoints are URLs ("https://eu.api.example.com", "http://10.0.0.2:8080"); a path is ignored. Replaces a group
+    // of the same name (its statistics are reset). False when a URL does not parse or the list is empty/too long.
+    bool setGroup(const std::string& name, const std::vector<std::string>& endpointUrls);
+    bool removeGroup(const std::string& name);
+    bool hasGroup(const std::string& name) const;
+    size_t size(const std::string& name) const; // endpoints in the group (0 when unknown)
+    bool empty() const {
+        return _groups.empty();
+    }
+
+    // Index of the endpoint to use, skipping those whose bit is set in `excluded`; -1 when none is left.
+    int select(const std::string& name, uint32_t excluded, uint32_t nowMs, const WarmProbe& warm);
+    const Endpoint* endpoint(const std::string& name, int index) const;
+    void recordSuccess(const std::string& name, int index, uint32_t latencyMs);
+    void recordFailure(const std::string& name, int index, uint32_t nowMs);
+
+    std::vector<AsyncHttpEndpointStats> stats(const std::string& name, uint32_t nowMs) const;
+
+  private:
+    struct Group {
+        std::string name; // lowercased
+        std::vector<Endpoint> endpoints;
+    };
+
+    Group* find(const std::string& name);
+    const Group* find(const std::string& name) const;
+    Endpoint* mutableEndpoint(const std::string& name, int index);
+    bool healthy(const Endpoint& endpoint, uint32_t nowMs) const;
+    uint32_t blend(uint32_t average, uint32_t sample) const;
+
+    AsyncHttpEndpointPolicy _policy;
+    std::vector<Group> _groups;
+};
+
+#endif // ENDPOINT_GROUPS_H
@@ -58,11 +58,15 @@ const char* GzipDecoder::lastError() const {
 #include <stdlib.h>
 #include <string.h>
 
+#include "HttpMemory.h"
+#include "ObjectPool.h"
 #include "third_party/miniz/miniz_tinfl.h"
 
 static constexpr size_t kGzipFixedHeaderSize = 10;
 static constexpr size_t kGzipTrailerSize = 8;
 static constexpr size_t kTinflDictSize = 32768;
+// One allocation per response holds the dictionary followed by the decompressor state (pooled when configured).
+static constexpr size_t kInflateWindowSize = kTinflDictSize + sizeof(tinfl_decompressor);
 
 static constexpr uint8_t kGzipId1 = 0x1f;
 static constexpr uint8_t kGzipId2 = 0x8b;
@@ -120,12 +124,10 @@ GzipDecoder::~GzipDecoder() {
 
 void GzipDecoder::reset() {
     if (_dict) {
-        free(_dict);
+        if (!HttpObjectPools::gzipWindows().release(_dict))
+            HttpMemory::release(_dict);
         _dict = nullptr;
-    }
-    if (_decomp) {
-        free(_decomp);
-        _decomp = nullptr;
+        _decomp = nullptr; // same block
     }
 
     _state = State::kHeader;
@@ -170,18 +172,15 @@ bool GzipDecoder::initInflater() {
     if (_decomp)
         return true;
 
-    _dict = malloc(kTinflDictSize);
+    _dict = HttpObjectPools::gzipWindows().tryAllocate(kInflateWindowSize);
+    if (!_dict)
+        _dict = HttpMemory::allocate(AsyncHttpBufferKind::kGzipWindow, kInflateWindowSize);
     if (!_dict) {
         setError("Out of memory (gzip dict)");
         return false;
     }
     memset(_dict, 0, kTinflDictSize);
-
-    _decomp = malloc(sizeof(tinfl_decompressor));
-    if (!_decomp) {
-        setError("Out of memory (tinfl)");
-        return false;
-    }
+    _decomp = static_cast<uint8_t*>(_dict) + kTinflDictSize;
     tinfl_init(static_cast<tinfl_decompressor*>(_decomp));
     _dictOfs = 0;
     return true;
@@ -0,0 +1,32 @@
+#include "HedgePolicy.h"
+#include <algorithm>
+
+void LatencyWindow::record(uint32_t ms) {
+    _samples[_next] = ms;
+    _next = (_next + 1) % kCapacity;
+    if (_count < kCapacity)
+        _count++;
+}
+
+uint32_t LatencyWindow::percentile(uint8_t pct) const {
+    if (_count == 0)
+        return 0;
+    if (pct == 0)
+        pct = 1;
+    if (pct > 100)
+        pct = 100;
+    uint32_t sorted[kCapacity];
+    std::copy(_samples, _samples + _count, sorted);
+    size_t rank = (static_cast<size_t>(pct) * _count + 99) / 100; // ceil(pct% of count), 1-based
+    if (rank == 0)
+        rank = 1;
+    std::nth_element(sorted, sorted + rank - 1, sorted + _count);
+    return sorted[rank - 1];
+}
+
+uint32_t AsyncHttpHedgePolicy::effectiveDelayMs(const LatencyWindow& observed) const {
+    if (latencyPercentile == 0 || observed.size() < minSamples)
+        return delayMs;
+    uint32_t delay = observed.percentile(latencyPercentile);
+    return delay < minDelayMs ? minDelayMs : delay;
+}
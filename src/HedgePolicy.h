@@ -0,0 +1,42 @@
+/**
+ * Request hedging: when an idempotent request has not received its response headers after a delay,
+ * a second copy is sent on a fresh connection and the first one to answer wins. The delay is fixed or
+ * a percentile of recent time-to-headers (LatencyWindow).
+ */
+#ifndef HEDGE_POLICY_H
+#define HEDGE_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size ring of the most recent latency samples (ms).
+class LatencyWindow {
+  public:
+    static constexpr size_t kCapacity = 32;
+
+    void record(uint32_t ms);
+    size_t size() const {
+        return _count;
+    }
+    // Nearest-rank percentile (1..100) of the samples; 0 when empty.
+    uint32_t percentile(uint8_t pct) const;
+
+  private:
+    uint32_t _samples[kCapacity] = {};
+    size_t _next = 0;
+    size_t _count = 0;
+};
+
+struct AsyncHttpHedgePolicy {
+    uint32_t delayMs = 0;          // hedge after this long without response headers; 0 disables hedging
+    uint8_t latencyPercentile = 0; // 1..99: use this percentile of observed time-to-headers instead of delayMs
+    uint8_t minSamples = 8;        // percentile mode falls back to delayMs until this many samples were seen
+    uint32_t minDelayMs = 20;      // lower bound for percentile-derived delays
+
+    bool enabled() const {
+        return delayMs > 0;
+    }
+    uint32_t effectiveDelayMs(const LatencyWindow& observed) const;
+};
+
+#endif // HEDGE_POLICY_H
@@ -15,6 +15,13 @@
 #define ASYNC_HTTP_ALLOW_INSECURE_TLS 0
 #endif
 
+// Capacity of the lock-free submission ring used by request()/abort() from other tasks (rounded up to a power of
+// two). When the ring is full, submissions go to an overflow list behind it, guarded by a mutex of its own that is
+// only held to append or take one entry.
+#ifndef ASYNC_HTTP_SUBMIT_QUEUE_CAPACITY
+#define ASYNC_HTTP_SUBMIT_QUEUE_CAPACITY 16
+#endif
+
 // Library version (single source of truth inside code). Keep in sync with library.json and library.properties.
 #ifndef ESP_ASYNC_WEB_CLIENT_VERSION
 #define ESP_ASYNC_WEB_CLIENT_VERSION "2.1.2"
@@ -39,6 +46,19 @@ struct AsyncHttpTLSConfig {
     uint32_t handshakeTimeoutMs = 12000; // fallback if not overridden
 };
 
+// Socket options for new connections (client default: AsyncHttpClient::setSocketOptions(); per request:
+// AsyncHttpRequest::setSocketOptions()). They are applied once the TCP connection is up and stay with it while it is
+// pooled. The TCP stack's own window and send buffer are fixed by lwIP at build time (TCP_WND / TCP_SND_BUF); the
+// buffer hints size the library's buffers around them.
+struct AsyncHttpSocketOptions {
+    bool noDelay = true;              // TCP_NODELAY: small writes (request head, body chunks) go out without waiting
+                                      // for the ACK of the previous segment (Nagle + delayed ACK)
+    uint32_t keepAliveIntervalMs = 0; // TCP keepalive probes after this long idle and at this interval (0 = off)
+    uint8_t keepAliveCount = 3;       // unanswered probes before the connection is dropped
+    size_t rxBufferHint = 0;          // TLS: bytes reserved up front for encrypted records (0 = grow on demand)
+    size_t txChunkBytes = 512;        // streamed request bodies: bytes per write (0 = 512, at most 8192)
+};
+
 enum HttpClientError {
     CONNECTION_FAILED = -1,
     HEADER_PARSE_FAILED = -2,
@@ -57,7 +77,10 @@ enum HttpClientError {
     TLS_CERT_INVALID = -15,
     TLS_FINGERPRINT_MISMATCH = -16,
     TLS_HANDSHAKE_TIMEOUT = -17,
-    GZIP_DECODE_FAILED = -18
+    GZIP_DECODE_FAILED = -18,
+    CIRCUIT_OPEN = -19,
+    DEADLINE_EXCEEDED = -20,
+    MEMORY_BUDGET_EXCEEDED = -21
 };
 
 inline const char* httpClientErrorToString(HttpClientError error) {
@@ -98,6 +121,12 @@ inline const char* httpClientErrorToString(HttpClientError error) {
         return "TLS handshake timeout";
     case GZIP_DECODE_FAILED:
         return "Failed to decode gzip body";
+    case CIRCUIT_OPEN:
+        return "Circuit breaker open for this origin";
+    case DEADLINE_EXCEEDED:
+        return "Request deadline exceeded";
+    case MEMORY_BUDGET_EXCEEDED:
+        return "Client memory budget exhausted";
     default:
         return "Network error";
     }
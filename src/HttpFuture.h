@@ -0,0 +1,268 @@
+// Single-shot futures for AsyncHttpClient (getAsync(), requestAsync(), ...).
+//
+// A future completes exactly once, from the context that delivers the request's callbacks (network task, or the
+// installed callback executor). Its continuation runs there too: either the function given to then() or, when
+// compiled as C++20, the coroutine suspended in `co_await`. Nothing blocks and no thread is created; exceptions are
+// not used.
+//
+//   client.getAsync("http://api.example/login")
+//       .then([&](AsyncHttpResult& login) {
+//           if (!login.success)
+//               return AsyncHttpFuture::makeReady(std::move(login)); // propagate the failure
+//           return client.getAsync("http://api.example/config");
+//       })
+//       .then([](AsyncHttpResult& config) { /* ... */ });
+//
+// Completion callbacks capture a single pointer, so the std::function objects handed to the client keep it in their
+// inline storage instead of allocating.
+
+#ifndef HTTP_FUTURE_H
+#define HTTP_FUTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "HttpCommon.h"
+#include "HttpResponse.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define ASYNC_HTTP_HAS_COROUTINES 1
+#endif
+#endif
+#ifndef ASYNC_HTTP_HAS_COROUTINES
+#define ASYNC_HTTP_HAS_COROUTINES 0
+#endif
+
+struct AsyncHttpResult {
+    bool success = false;
+    std::shared_ptr<AsyncHttpResponse> response; // set when success
+    HttpClientError error = CONNECTION_FAILED;    // meaningful when !success
+    String errorMessage;
+};
+
+class AsyncHttpFuture {
+  public:
+    typedef std::function<void(AsyncHttpResult& result)> Continuation;
+
+    // Shared by the future and the completing side (reference counted, freed by whichever lets go last).
+    class State {
+      public:
+        State() : _refs(2) {} // the future + the completing side
+
+        void release() {
+            if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+        bool ready() const {
+            return (_flags.load(std::memory_order_acquire) & kReady) != 0;
+        }
+        AsyncHttpResult& result() {
+            return _result;
+        }
+        uint32_t requestId() const {
+            return _requestId.load(std::memory_order_relaxed);
+        }
+        void setRequestId(uint32_t id) {
+            _requestId.store(id, std::memory_order_relaxed);
+        }
+
+        // Completing side: publish the result, run the continuation if one is attached, then drop the completing
+        // side's reference.
+        void complete(AsyncHttpResult&& result) {
+            _result = std::move(result);
+            if (_flags.fetch_or(kReady, std::memory_order_acq_rel) & kHasContinuation)
+                runContinuation();
+            release();
+        }
+
+        // Callbacks for AsyncHttpClient::request(): exactly one of them fires and completes the state.
+        std::function<void(std::shared_ptr<AsyncHttpResponse>)> successCallback() {
+            return [this](std::shared_ptr<AsyncHttpResponse> response) {
+                AsyncHttpResult result;
+                result.success = true;
+                result.response = std::move(response);
+                complete(std::move(result));
+            };
+        }
+        std::function<void(HttpClientError, const char*)> errorCallback() {
+            return [this](HttpClientError error, const char* message) {
+                AsyncHttpResult result;
+                result.error = error;
+                result.errorMessage = message ? message : "";
+                complete(std::move(result));
+            };
+        }
+
+        // Future side: false when the result was already published, in which case the continuation is left for
+        // the caller to run (runContinuation()) or discard (dropContinuation()).
+        bool attach(Continuation&& continuation) {
+            _continuation = std::move(continuation);
+            return (_flags.fetch_or(kHasContinuation, std::memory_order_acq_rel) & kReady) == 0;
+        }
+        void runContinuation() {
+            Continuation continuation = std::move(_continuation);
+            _continuation = nullptr;
+            continuation(_result);
+        }
+        void dropContinuation() {
+            _continuation = nullptr;
+        }
+
+      private:
+        ~State() {}
+
+        static constexpr uint8_t kReady = 1;
+        static constexpr uint8_t kHasContinuation = 2;
+
+        std::atomic<uint8_t> _refs;
+        std::atomic<uint8_t> _flags{0};
+        std::atomic<uint32_t> _requestId{0};
+        AsyncHttpResult _result;
+        Continuation _continuation;
+    };
+
+    AsyncHttpFuture() {}
+    explicit AsyncHttpFuture(State* state) : _state(state) {} // adopts the future's reference
+    AsyncHttpFuture(AsyncHttpFuture&& other) noexcept : _state(other._state) {
+        other._state = nullptr;
+    }
+    AsyncHttpFuture& operator=(AsyncHttpFuture&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _state = other._state;
+            other._state = nullptr;
+        }
+        return *this;
+    }
+    AsyncHttpFuture(const AsyncHttpFuture&) = delete;
+    AsyncHttpFuture& operator=(const AsyncHttpFuture&) = delete;
+    ~AsyncHttpFuture() {
+        reset();
+    }
+
+    // Already completed future, e.g. to pass a result through a then() chain unchanged.
+    static AsyncHttpFuture makeReady(AsyncHttpResult result) {
+        State* state = new State();
+        state->complete(std::move(result));
+        return AsyncHttpFuture(state);
+    }
+
+    bool valid() const {
+        return _state != nullptr;
+    }
+    bool isReady() const {
+        return _state && _state->ready();
+    }
+    // Id of the underlying request (for AsyncHttpClient::abort()); 0 if it was rejected up front.
+    uint32_t requestId() const {
+        return _state ? _state->requestId() : 0;
+    }
+    // Polling access once isReady().
+    AsyncHttpResult& result() {
+        return _state->result();
+    }
+
+    // then() consumes the future (valid() is false afterwards). The continuation runs once, with the result, from
+    // the completion context - or immediately when the future is already complete. A continuation returning void
+    // ends the chain; one returning an AsyncHttpFuture yields a future completing with that future's result (an
+    // invalid future completes it with ABORTED).
+    template <typename F>
+    typename std::enable_if<std::is_void<decltype(std::declval<F&>()(std::declval<AsyncHttpResult&>()))>::value>::type
+    then(F f) {
+        attachOrRun(Continuation(std::move(f)));
+    }
+
+    template <typename F>
+    typename std::enable_if<std::is_same<decltype(std::declval<F&>()(std::declval<AsyncHttpResult&>())),
+                                         AsyncHttpFuture>::value,
+                            AsyncHttpFuture>::type
+    then(F f) {
+        if (!_state)
+            return AsyncHttpFuture();
+        State* next = new State();
+        attachOrRun([next, f = std::move(f)](AsyncHttpResult& result) mutable {
+            AsyncHttpFuture inner = f(result);
+            if (!inner.valid()) {
+                AsyncHttpResult stopped;
+                stopped.error = ABORTED;
+                stopped.errorMessage = "Future chain stopped";
+                next->complete(std::move(stopped));
+                return;
+            }
+            inner.then([next](AsyncHttpResult& innerResult) { next->complete(std::move(innerResult)); });
+        });
+        return AsyncHttpFuture(next);
+    }
+
+#if ASYNC_HTTP_HAS_COROUTINES
+    // `AsyncHttpResult result = co_await client.getAsync(url);` - the coroutine resumes in the completion context.
+    bool await_ready() const noexcept {
+        return !_state || _state->ready();
+    }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        if (_state->attach([handle](AsyncHttpResult&) { handle.resume(); }))
+            return true; // do not touch *this: the coroutine may already be running again
+        _state->dropContinuation();
+        return false;
+    }
+    AsyncHttpResult await_resume() {
+        if (!_state) {
+            AsyncHttpResult invalid;
+            invalid.errorMessage = "Invalid future";
+            return invalid;
+        }
+        return std::move(_state->result());
+    }
+#endif
+
+  private:
+    void reset() {
+        if (_state) {
+            _state->release();
+            _state = nullptr;
+        }
+    }
+
+    void attachOrRun(Continuation&& continuation) {
+        State* state = _state;
+        if (!state)
+            return;
+        _state = nullptr;
+        if (!state->attach(std::move(continuation)))
+            state->runContinuation();
+        state->release();
+    }
+
+    State* _state = nullptr;
+};
+
+#if ASYNC_HTTP_HAS_COROUTINES
+// Return type for fire-and-forget coroutines that co_await client futures:
+//   AsyncHttpTask refresh(AsyncHttpClient& client) { AsyncHttpResult r = co_await client.getAsync(url); ... }
+// The coroutine starts immediately and frees itself when it returns.
+struct AsyncHttpTask {
+    struct promise_type {
+        AsyncHttpTask get_return_object() noexcept {
+            return AsyncHttpTask();
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            abort();
+        }
+    };
+};
+#endif
+
+#endif // HTTP_FUTURE_H
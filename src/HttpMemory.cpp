@@ -0,0 +1,221 @@
+#include "HttpMemory.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+namespace {
+
+void* defaultAllocate(size_t size, AsyncHttpMemoryRegion region, void* user) {
+    (void)user;
+#if defined(ARDUINO_ARCH_ESP32)
+    if (region == AsyncHttpMemoryRegion::kExternal) {
+        void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (p)
+            return p; // no PSRAM (or full): internal RAM below
+    }
+#else
+    (void)region;
+#endif
+    return malloc(size);
+}
+
+void* defaultReallocate(void* p, size_t size, AsyncHttpMemoryRegion region, void* user) {
+    (void)user;
+#if defined(ARDUINO_ARCH_ESP32)
+    if (region == AsyncHttpMemoryRegion::kExternal) {
+        void* moved = heap_caps_realloc(p, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (moved)
+            return moved;
+    }
+#else
+    (void)region;
+#endif
+    return realloc(p, size);
+}
+
+void defaultRelease(void* p, void* user) {
+    (void)user;
+    free(p); // also releases heap_caps allocations
+}
+
+AsyncHttpAllocator gAllocator;
+AsyncHttpPlacementPolicy gPolicy;
+
+} // namespace
+
+void HttpMemory::setAllocator(const AsyncHttpAllocator& allocator) {
+    gAllocator = allocator;
+}
+
+void HttpMemory::setPlacementPolicy(const AsyncHttpPlacementPolicy& policy) {
+    gPolicy = policy;
+}
+
+AsyncHttpPlacementPolicy HttpMemory::placementPolicy() {
+    return gPolicy;
+}
+
+AsyncHttpMemoryRegion HttpMemory::regionFor(AsyncHttpBufferKind kind, size_t size) {
+    if (!gPolicy.enabled || size < gPolicy.externalThreshold)
+        return AsyncHttpMemoryRegion::kInternal;
+    bool external = false;
+    switch (kind) {
+    case AsyncHttpBufferKind::kResponseBody:
+        external = gPolicy.responseBody;
+        break;
+    case AsyncHttpBufferKind::kReceiveBuffer:
+        external = gPolicy.receiveBuffer;
+        break;
+    case AsyncHttpBufferKind::kTlsRecord:
+        external = gPolicy.tlsRecord;
+        break;
+    case AsyncHttpBufferKind::kGzipWindow:
+        external = gPolicy.gzipWindow;
+        break;
+    case AsyncHttpBufferKind::kRequestArena:
+        external = gPolicy.requestArena;
+        break;
+    }
+    return external ? AsyncHttpMemoryRegion::kExternal : AsyncHttpMemoryRegion::kInternal;
+}
+
+void* HttpMemory::allocate(AsyncHttpBufferKind kind, size_t size) {
+    return allocate(regionFor(kind, size), size);
+}
+
+void* HttpMemory::allocate(AsyncHttpMemoryRegion region, size_t size) {
+    if (gAllocator.allocate)
+        return gAllocator.allocate(size, region, gAllocator.user);
+    return defaultAllocate(size, region, nullptr);
+}
+
+void* HttpMemory::reallocate(AsyncHttpBufferKind kind, void* p, size_t size) {
+    AsyncHttpMemoryRegion region = regionFor(kind, size);
+    if (gAllocator.reallocate)
+        return gAllocator.reallocate(p, size, region, gAllocator.user);
+    return defaultReallocate(p, size, region, nullptr);
+}
+
+void HttpMemory::release(void* p) {
+    if (!p)
+        return;
+    if (gAllocator.release)
+        gAllocator.release(p, gAllocator.user);
+    else
+        defaultRelease(p, nullptr);
+}
+
+HttpBuffer::~HttpBuffer() {
+    HttpMemory::release(_data);
+}
+
+HttpBuffer::HttpBuffer(const HttpBuffer& other) : _kind(other._kind) {
+    concat(other.c_str(), other._length);
+}
+
+HttpBuffer& HttpBuffer::operator=(const HttpBuffer& other) {
+    if (this != &other) {
+        clear();
+        concat(other.c_str(), other._length);
+    }
+    return *this;
+}
+
+HttpBuffer::HttpBuffer(HttpBuffer&& other) noexcept
+    : _kind(other._kind), _data(other._data), _length(other._length), _capacity(other._capacity) {
+    other._data = nullptr;
+    other._length = 0;
+    other._capacity = 0;
+}
+
+HttpBuffer& HttpBuffer::operator=(HttpBuffer&& other) noexcept {
+    if (this != &other) {
+        HttpMemory::release(_data);
+        _kind = other._kind;
+        _data = other._data;
+        _length = other._length;
+        _capacity = other._capacity;
+        other._data = nullptr;
+        other._length = 0;
+        other._capacity = 0;
+    }
+    return *this;
+}
+
+bool HttpBuffer::grow(size_t needed) {
+    if (needed <= _capacity)
+        return true;
+    // Geometric growth keeps appends amortized O(1); reserve() sizes exactly.
+    size_t capacity = _capacity + _capacity / 2;
+    if (capacity < needed)
+        capacity = needed;
+    if (capacity < 64)
+        capacity = 64;
+    return reserve(capacity);
+}
+
+bool HttpBuffer::reserve(size_t capacity) {
+    if (capacity <= _capacity)
+        return true;
+    char* data = static_cast<char*>(HttpMemory::reallocate(_kind, _data, capacity + 1));
+    if (!data)
+        return false;
+    if (!_data)
+        data[0] = '\0';
+    _data = data;
+    _capacity = capacity;
+    return true;
+}
+
+bool HttpBuffer::concat(const char* data, size_t len) {
+    if (len == 0)
+        return true;
+    if (!grow(_length + len))
+        return false;
+    memcpy(_data + _length, data, len);
+    _length += len;
+    _data[_length] = '\0';
+    return true;
+}
+
+void HttpBuffer::remove(size_t index, size_t count) {
+    if (index >= _length)
+        return;
+    if (count > _length - index)
+        count = _length - index;
+    memmove(_data + index, _data + index + count, _length - index - count);
+    _length -= count;
+    _data[_length] = '\0';
+}
+
+void HttpBuffer::clear() {
+    _length = 0;
+    if (_data)
+        _data[0] = '\0';
+}
+
+int HttpBuffer::indexOf(char c, size_t from) const {
+    if (from >= _length)
+        return -1;
+    const void* hit = memchr(_data + from, c, _length - from);
+    return hit ? static_cast<int>(static_cast<const char*>(hit) - _data) : -1;
+}
+
+int HttpBuffer::indexOf(const char* needle, size_t from) const {
+    size_t needleLen = strlen(needle);
+    if (needleLen == 0 || needleLen > _length)
+        return -1;
+    for (size_t i = from; i + needleLen <= _length; ++i) {
+        const void* hit = memchr(_data + i, needle[0], _length - needleLen + 1 - i);
+        if (!hit)
+            return -1;
+        i = static_cast<size_t>(static_cast<const char*>(hit) - _data);
+        if (memcmp(_data + i, needle, needleLen) == 0)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
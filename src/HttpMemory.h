@@ -0,0 +1,137 @@
+/**
+ * Allocator hook and placement policy for the client's large buffers.
+ *
+ * The placement policy decides, per buffer kind and size, whether a buffer goes to internal RAM or PSRAM;
+ * the allocator provides the bytes. Off by default. Configure before the first request: buffers are
+ * released through the allocator installed at that time.
+ */
+#ifndef HTTP_MEMORY_H
+#define HTTP_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+enum class AsyncHttpBufferKind : uint8_t {
+    kResponseBody,  // stored response body (large, read once by the application)
+    kReceiveBuffer, // header block / chunk framing awaiting parsing (small, touched on every packet)
+    kTlsRecord,     // encrypted bytes awaiting mbedTLS (touched on every record)
+    kGzipWindow,    // 32 KiB inflate dictionary
+    kRequestArena,  // per-request scratch slab
+};
+
+enum class AsyncHttpMemoryRegion : uint8_t { kInternal, kExternal };
+
+// Where bytes come from. Null members fall back to the default heap (on ESP32 the external region is PSRAM when
+// the board has it, internal RAM otherwise).
+struct AsyncHttpAllocator {
+    void* (*allocate)(size_t size, AsyncHttpMemoryRegion region, void* user) = nullptr;
+    void* (*reallocate)(void* p, size_t size, AsyncHttpMemoryRegion region, void* user) = nullptr;
+    void (*release)(void* p, void* user) = nullptr;
+    void* user = nullptr;
+};
+
+// Which buffers may live in external RAM: large, cold ones (bodies, inflate windows) go there once they reach
+// `externalThreshold`; the hot, small ones stay internal.
+struct AsyncHttpPlacementPolicy {
+    bool enabled = false;            // off: every buffer is internal
+    size_t externalThreshold = 4096; // smaller buffers always stay internal
+    bool responseBody = true;
+    bool receiveBuffer = false;
+    bool tlsRecord = false;
+    bool gzipWindow = true;
+    bool requestArena = false;
+};
+
+class HttpMemory {
+  public:
+    static void setAllocator(const AsyncHttpAllocator& allocator);
+    static void setPlacementPolicy(const AsyncHttpPlacementPolicy& policy);
+    static AsyncHttpPlacementPolicy placementPolicy();
+
+    static AsyncHttpMemoryRegion regionFor(AsyncHttpBufferKind kind, size_t size);
+    static void* allocate(AsyncHttpBufferKind kind, size_t size);
+    static void* allocate(AsyncHttpMemoryRegion region, size_t size);
+    // Grows or shrinks `p` (nullptr allocates); the region follows the new size.
+    static void* reallocate(AsyncHttpBufferKind kind, void* p, size_t size);
+    static void release(void* p);
+};
+
+// std allocator over HttpMemory for one buffer kind (e.g. std::vector<uint8_t, HttpMemoryAllocator<...>>).
+template <typename T, AsyncHttpBufferKind Kind> class HttpMemoryAllocator {
+  public:
+    typedef T value_type;
+    template <typename U> struct rebind {
+        typedef HttpMemoryAllocator<U, Kind> other;
+    };
+
+    HttpMemoryAllocator() {}
+    template <typename U> HttpMemoryAllocator(const HttpMemoryAllocator<U, Kind>&) {}
+
+    T* allocate(size_t n) {
+        void* p = HttpMemory::allocate(Kind, n * sizeof(T));
+        if (!p)
+            abort(); // out of memory, as with the default allocator built without exceptions
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t n) {
+        (void)n;
+        HttpMemory::release(p);
+    }
+
+    template <typename U> bool operator==(const HttpMemoryAllocator<U, Kind>&) const {
+        return true;
+    }
+    template <typename U> bool operator!=(const HttpMemoryAllocator<U, Kind>&) const {
+        return false;
+    }
+};
+
+// Growable byte buffer placed through HttpMemory. Mirrors the subset of Arduino String the client uses for its
+// receive buffer and response body, but is binary-safe (searches honour the length, not the first NUL) and keeps
+// a NUL terminator after the content.
+class HttpBuffer {
+  public:
+    explicit HttpBuffer(AsyncHttpBufferKind kind) : _kind(kind) {}
+    ~HttpBuffer();
+    HttpBuffer(const HttpBuffer& other);
+    HttpBuffer& operator=(const HttpBuffer& other);
+    HttpBuffer(HttpBuffer&& other) noexcept;
+    HttpBuffer& operator=(HttpBuffer&& other) noexcept;
+
+    // False when the allocator failed (the content is unchanged).
+    bool concat(const char* data, size_t len);
+    bool reserve(size_t capacity);
+    // Erases `count` bytes at `index` (clamped to the content).
+    void remove(size_t index, size_t count);
+    // Empties the buffer and keeps its capacity.
+    void clear();
+
+    int indexOf(char c, size_t from = 0) const;
+    int indexOf(const char* needle, size_t from = 0) const;
+    char charAt(size_t index) const {
+        return index < _length ? _data[index] : '\0';
+    }
+    const char* c_str() const {
+        return _data ? _data : "";
+    }
+    size_t length() const {
+        return _length;
+    }
+    size_t capacity() const {
+        return _capacity;
+    }
+    AsyncHttpBufferKind kind() const {
+        return _kind;
+    }
+
+  private:
+    bool grow(size_t needed);
+
+    AsyncHttpBufferKind _kind;
+    char* _data = nullptr;
+    size_t _length = 0;
+    size_t _capacity = 0; // usable bytes, excluding the terminator
+};
+
+#endif // HTTP_MEMORY_H
@@ -1,14 +1,17 @@
 #include "HttpRequest.h"
+#include "ObjectPool.h"
 #include "UrlParser.h"
+#include <cstdio>
 #include <cstring>
 
-static size_t decimalLength(size_t value) {
-    size_t len = 1;
-    while (value >= 10) {
-        value /= 10;
-        ++len;
-    }
-    return len;
+void* AsyncHttpRequest::operator new(size_t size) {
+    void* p = HttpObjectPools::requests().tryAllocate(size);
+    return p ? p : ::operator new(size);
+}
+
+void AsyncHttpRequest::operator delete(void* p) {
+    if (!HttpObjectPools::requests().release(p))
+        ::operator delete(p);
 }
 
 AsyncHttpRequest::AsyncHttpRequest(HttpMethod method, const String& url)
@@ -74,46 +77,78 @@ String AsyncHttpRequest::buildHeadersOnly() const {
     return buildAllHeaders(0);
 }
 
-String AsyncHttpRequest::buildAllHeaders(size_t extraReserve) const {
+// Feeds the request head to `sink.append(data, len)` piece by piece; shared by the String and buffer builders.
+template <typename Sink> void AsyncHttpRequest::emitHead(Sink& sink) const {
     const char* method = methodToString();
-    size_t headerLen = 0;
-    headerLen += strlen(method) + 1 + _path.length() + strlen(" HTTP/1.1\r\n");
-    headerLen += strlen("Host: ") + _host.length() + strlen("\r\n");
+    sink.append(method, strlen(method));
+    sink.append(" ", 1);
+    sink.append(_path.c_str(), _path.length());
+    sink.append(" HTTP/1.1\r\nHost: ", strlen(" HTTP/1.1\r\nHost: "));
+    sink.append(_host.c_str(), _host.length());
+    sink.append("\r\n", 2);
     for (const auto& header : _headers) {
-        headerLen += header.name.length() + 2 + header.value.length() + 2;
+        sink.append(header.name.c_str(), header.name.length());
+        sink.append(": ", 2);
+        sink.append(header.value.c_str(), header.value.length());
+        sink.append("\r\n", 2);
     }
-    if (_bodyProvider != nullptr) {
-        headerLen += strlen("Content-Length: ") + decimalLength(_streamLength) + 2;
-    } else if (!_body.isEmpty()) {
-        headerLen += strlen("Content-Length: ") + decimalLength(_body.length()) + 2;
+    if (_bodyProvider != nullptr || !_body.isEmpty()) {
+        // Stream length: the caller must provide an accurate one.
+        size_t length = _bodyProvider != nullptr ? _streamLength : _body.length();
+        char digits[24];
+        int n = snprintf(digits, sizeof(digits), "%lu", (unsigned long)length);
+        sink.append("Content-Length: ", strlen("Content-Length: "));
+        sink.append(digits, n > 0 ? (size_t)n : 0);
+        sink.append("\r\n", 2);
     }
-    headerLen += 2;
+    sink.append("\r\n", 2);
+}
 
-    String req;
-    req.reserve(headerLen + extraReserve);
-    req += method;
-    req += ' ';
-    req += _path;
-    req += " HTTP/1.1\r\n";
-    req += "Host: ";
-    req += _host;
-    req += "\r\n";
-    for (const auto& header : _headers) {
-        req += header.name;
-        req += ": ";
-        req += header.value;
-        req += "\r\n";
+namespace {
+struct LengthSink {
+    size_t length = 0;
+    void append(const char* data, size_t len) {
+        (void)data;
+        length += len;
+    }
+};
+
+struct BufferSink {
+    char* out;
+    size_t written = 0;
+    void append(const char* data, size_t len) {
+        memcpy(out + written, data, len);
+        written += len;
     }
-    if (_bodyProvider != nullptr) {
-        req += "Content-Length: ";
-        req += String(_streamLength); // caller must provide accurate length
-        req += "\r\n";
-    } else if (!_body.isEmpty()) {
-        req += "Content-Length: ";
-        req += String(_body.length());
-        req += "\r\n";
+};
+
+struct StringSink {
+    String& out;
+    void append(const char* data, size_t len) {
+        out.concat(data, len);
     }
-    req += "\r\n";
+};
+} // namespace
+
+size_t AsyncHttpRequest::serializedLength(bool includeBody) const {
+    LengthSink sink;
+    emitHead(sink);
+    return sink.length + (includeBody ? _body.length() : 0);
+}
+
+size_t AsyncHttpRequest::serialize(char* out, bool includeBody) const {
+    BufferSink sink{out};
+    emitHead(sink);
+    if (includeBody)
+        sink.append(_body.c_str(), _body.length());
+    return sink.written;
+}
+
+String AsyncHttpRequest::buildAllHeaders(size_t extraReserve) const {
+    String req;
+    req.reserve(serializedLength(false) + extraReserve);
+    StringSink sink{req};
+    emitHead(sink);
     return req;
 }
 
@@ -230,3 +265,42 @@ void AsyncHttpRequest::setTlsConfig(const AsyncHttpTLSConfig& config) {
         _tlsConfig.reset(new AsyncHttpTLSConfig());
     *_tlsConfig = config;
 }
+
+std::unique_ptr<AsyncHttpRequest> AsyncHttpRequest::clone() const {
+    std::unique_ptr<AsyncHttpRequest> copy(new AsyncHttpRequest(_method, _url));
+    copy->_host = _host;
+    copy->_path = _path; // may carry query parameters added after parsing
+    copy->_port = _port;
+    copy->_secure = _secure;
+    copy->_headers = _headers;
+    copy->_body = _body;
+    copy->_streamLength = _streamLength;
+    copy->_bodyProvider = _bodyProvider;
+    copy->_bodyRewind = _bodyRewind;
+    copy->_timeout = _timeout;
+    copy->_deadlineMs = _deadlineMs;
+    copy->_hasDeadline = _hasDeadline;
+    copy->_groupId = _groupId;
+    copy->_queryFinalized = _queryFinalized;
+    copy->_acceptGzip = _acceptGzip;
+    copy->_noStoreBody = _noStoreBody;
+    if (_tlsConfig)
+        copy->setTlsConfig(*_tlsConfig);
+    if (_socketOptions)
+        copy->setSocketOptions(*_socketOptions);
+    if (_retryPolicy)
+        copy->setRetryPolicy(*_retryPolicy);
+    return copy;
+}
+
+void AsyncHttpRequest::setSocketOptions(const AsyncHttpSocketOptions& options) {
+    if (!_socketOptions)
+        _socketOptions.reset(new AsyncHttpSocketOptions());
+    *_socketOptions = options;
+}
+
+void AsyncHttpRequest::setRetryPolicy(const AsyncHttpRetryPolicy& policy) {
+    if (!_retryPolicy)
+        _retryPolicy.reset(new AsyncHttpRetryPolicy());
+    *_retryPolicy = policy;
+}
@@ -6,6 +6,7 @@
 #include <functional>
 #include <memory>
 #include "HttpCommon.h"
+#include "RetryPolicy.h"
 
 enum HttpMethod {
     HTTP_METHOD_GET,
@@ -44,6 +45,10 @@ class AsyncHttpRequest {
     AsyncHttpRequest(HttpMethod method, const String& url);
     ~AsyncHttpRequest();
 
+    // Served from the request pool when AsyncHttpClient::configureObjectPools() reserved slots (heap otherwise).
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+
     // Request configuration
     HttpMethod getMethod() const {
         return _method;
@@ -64,6 +69,14 @@ class AsyncHttpRequest {
         return _secure;
     }
 
+    // Sends the request to another server than the one its URL names (endpoint groups): the connection, the Host
+    // header and TLS SNI use `host`; getUrl() keeps the original URL.
+    void setTarget(const String& host, uint16_t port, bool secure) {
+        _host = host;
+        _port = port;
+        _secure = secure;
+    }
+
     // Headers management
     void setHeader(const String& name, const String& value);
     void removeHeader(const String& name);
@@ -79,6 +92,9 @@ class AsyncHttpRequest {
     String getBody() const {
         return _body;
     }
+    size_t getBodyLength() const { // in-memory body only (0 for a body stream)
+        return _body.length();
+    }
     bool hasBody() const {
         return !_body.isEmpty() || _bodyProvider != nullptr;
     }
@@ -87,6 +103,20 @@ class AsyncHttpRequest {
     void setBodyStream(size_t totalLength, BodyStreamProvider provider) {
         _streamLength = totalLength;
         _bodyProvider = provider;
+        _bodyRewind = nullptr;
+    }
+    // Rewind restarts the stream from its first byte (returns false if it cannot); required for automatic retries.
+    typedef std::function<bool()> BodyStreamRewind;
+    void setBodyStream(size_t totalLength, BodyStreamProvider provider, BodyStreamRewind rewind) {
+        _streamLength = totalLength;
+        _bodyProvider = provider;
+        _bodyRewind = rewind;
+    }
+    bool canRewindBodyStream() const {
+        return _bodyRewind != nullptr;
+    }
+    bool rewindBodyStream() {
+        return _bodyRewind && _bodyRewind();
     }
     bool hasBodyStream() const {
         return _bodyProvider != nullptr;
@@ -106,6 +136,26 @@ class AsyncHttpRequest {
         return _timeout;
     }
 
+    // Absolute end-to-end deadline in millis() time (e.g. millis() + 3000). Unlike setTimeout() it also covers
+    // the time spent queued; it spans redirects and retries and bounds the connect / TLS handshake timeouts.
+    void setDeadline(uint32_t deadlineMs) {
+        _deadlineMs = deadlineMs;
+        _hasDeadline = true;
+    }
+    bool hasDeadline() const {
+        return _hasDeadline;
+    }
+    uint32_t getDeadline() const {
+        return _deadlineMs;
+    }
+    // Milliseconds left at `nowMs`: UINT32_MAX without a deadline, 0 once it passed.
+    uint32_t msUntilDeadline(uint32_t nowMs) const {
+        if (!_hasDeadline)
+            return UINT32_MAX;
+        int32_t left = static_cast<int32_t>(_deadlineMs - nowMs);
+        return left > 0 ? static_cast<uint32_t>(left) : 0;
+    }
+
     // User Agent
     void setUserAgent(const String& userAgent) {
         setHeader("User-Agent", userAgent);
@@ -114,6 +164,10 @@ class AsyncHttpRequest {
     // Build HTTP request string
     String buildHttpRequest() const;
     String buildHeadersOnly() const; // when streaming body
+    // Allocation-free variants: size of the serialized request (the head, plus the in-memory body when
+    // `includeBody`) and writing it into a caller-provided buffer of at least that size (not NUL-terminated).
+    size_t serializedLength(bool includeBody) const;
+    size_t serialize(char* out, bool includeBody) const;
 
     // URL parsing
     bool parseUrl(const String& url);
@@ -144,6 +198,40 @@ class AsyncHttpRequest {
         return _tlsConfig.get();
     }
 
+    // Socket options for the connection this request opens (overrides AsyncHttpClient::setSocketOptions()); a pooled
+    // connection keeps the options it was opened with.
+    void setSocketOptions(const AsyncHttpSocketOptions& options);
+    bool hasSocketOptions() const {
+        return _socketOptions != nullptr;
+    }
+    const AsyncHttpSocketOptions* getSocketOptions() const {
+        return _socketOptions.get();
+    }
+
+    // Per-request retry policy (overrides AsyncHttpClient::setRetryPolicy()).
+    void setRetryPolicy(const AsyncHttpRetryPolicy& policy);
+    bool hasRetryPolicy() const {
+        return _retryPolicy != nullptr;
+    }
+    const AsyncHttpRetryPolicy* getRetryPolicy() const {
+        return _retryPolicy.get();
+    }
+    // Cancellation group (0 = none): AsyncHttpClient::abortGroup() aborts every request carrying the tag.
+    void setGroup(uint32_t groupId) {
+        _groupId = groupId;
+    }
+    uint32_t getGroup() const {
+        return _groupId;
+    }
+
+    // Independent copy (URL, headers, body or body stream callbacks, options) used to send a hedged duplicate.
+    std::unique_ptr<AsyncHttpRequest> clone() const;
+
+    // GET, HEAD, PUT and DELETE may be repeated without changing the outcome (RFC 9110 9.2.2).
+    bool isIdempotent() const {
+        return _method != HTTP_METHOD_POST && _method != HTTP_METHOD_PATCH;
+    }
+
     // (Per-request response chunk callback removed – use global client.onBodyChunk)
 
   private:
@@ -157,13 +245,20 @@ class AsyncHttpRequest {
     String _body;
     size_t _streamLength = 0;
     BodyStreamProvider _bodyProvider = nullptr;
+    BodyStreamRewind _bodyRewind = nullptr;
     uint32_t _timeout;
+    uint32_t _deadlineMs = 0;
+    bool _hasDeadline = false;
+    uint32_t _groupId = 0;
     bool _queryFinalized = true;
     bool _acceptGzip = false;
     bool _noStoreBody = false;
     std::unique_ptr<AsyncHttpTLSConfig> _tlsConfig;
+    std::unique_ptr<AsyncHttpSocketOptions> _socketOptions;
+    std::unique_ptr<AsyncHttpRetryPolicy> _retryPolicy;
 
     String buildAllHeaders(size_t extraReserve) const;
+    template <typename Sink> void emitHead(Sink& sink) const;
     const char* methodToString() const;
 };
 
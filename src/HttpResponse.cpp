@@ -51,6 +51,32 @@ void AsyncHttpResponse::setTrailer(const String& name, const String& value) {
     _trailers.push_back(HttpHeader(lowerName, value));
 }
 
+static void setLowercaseField(std::vector<HttpHeader>& fields, const char* name, const char* value) {
+    for (auto& field : fields) {
+        if (field.name == name) {
+            field.value = value;
+            return;
+        }
+    }
+    fields.emplace_back();
+    fields.back().name = name;
+    fields.back().value = value;
+}
+
+void AsyncHttpResponse::setLowercaseHeader(const char* name, const char* value) {
+    setLowercaseField(_headers, name, value);
+}
+
+void AsyncHttpResponse::setLowercaseTrailer(const char* name, const char* value) {
+    setLowercaseField(_trailers, name, value);
+}
+
+String AsyncHttpResponse::getBody() const {
+    String body;
+    body.concat(_body.c_str(), _body.length());
+    return body;
+}
+
 void AsyncHttpResponse::appendBody(const char* data, size_t len) {
     if (data && len > 0) {
         _body.concat(data, len);
@@ -72,6 +98,6 @@ void AsyncHttpResponse::clear() {
     _statusText = "";
     _headers.clear();
     _trailers.clear();
-    _body = "";
+    _body.clear();
     _contentLength = 0;
 }
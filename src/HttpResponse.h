@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <vector>
 #include "HttpCommon.h"
+#include "HttpMemory.h"
 
 class AsyncHttpResponse {
   public:
@@ -29,8 +30,13 @@ class AsyncHttpResponse {
     }
 
     // Response body
-    String getBody() const {
-        return _body;
+    String getBody() const;
+    // Stored body without a String copy (NUL-terminated; getBodyLength() counts embedded NULs).
+    const char* getBodyData() const {
+        return _body.c_str();
+    }
+    size_t getBodyLength() const {
+        return _body.length();
     }
     size_t getContentLength() const {
         return _contentLength;
@@ -56,6 +62,13 @@ class AsyncHttpResponse {
     }
     void setHeader(const String& name, const String& value);
     void setTrailer(const String& name, const String& value);
+    // Parser fast path: `name` is already lower case and both strings are NUL-terminated, so the only allocations
+    // are the stored copies.
+    void setLowercaseHeader(const char* name, const char* value);
+    void setLowercaseTrailer(const char* name, const char* value);
+    void reserveHeaders(size_t count) {
+        _headers.reserve(count);
+    }
     void appendBody(const char* data, size_t len);
     void setContentLength(size_t length);
     void reserveBody(size_t length);
@@ -66,7 +79,7 @@ class AsyncHttpResponse {
     String _statusText;
     std::vector<HttpHeader> _headers;
     std::vector<HttpHeader> _trailers;
-    String _body;
+    HttpBuffer _body{AsyncHttpBufferKind::kResponseBody}; // placed per HttpMemory's policy (PSRAM when large)
     size_t _contentLength;
 };
 
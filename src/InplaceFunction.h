@@ -0,0 +1,128 @@
+/**
+ * Fixed-capacity, non-allocating callable wrapper (a std::function restricted to its small buffer).
+ *
+ * A callable that does not fit `Capacity` bytes is rejected at compile time instead of spilling to the
+ * heap. Used for the AsyncTransport handlers, which are rebound on every connection.
+ */
+#ifndef INPLACE_FUNCTION_H
+#define INPLACE_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Inline storage of the transport handlers: the client's handlers capture the client pointer and a smart pointer
+// to the request context.
+#ifndef ASYNC_HTTP_INPLACE_FUNCTION_SIZE
+#define ASYNC_HTTP_INPLACE_FUNCTION_SIZE (4 * sizeof(void*))
+#endif
+
+template <typename Signature, size_t Capacity = ASYNC_HTTP_INPLACE_FUNCTION_SIZE> class InplaceFunction;
+
+template <typename R, typename... Args, size_t Capacity> class InplaceFunction<R(Args...), Capacity> {
+  public:
+    static constexpr size_t kCapacity = Capacity;
+
+    InplaceFunction() noexcept {}
+    InplaceFunction(std::nullptr_t) noexcept {}
+
+    template <typename F, typename Callable = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Callable, InplaceFunction>::value>::type>
+    InplaceFunction(F&& callable) {
+        static_assert(sizeof(Callable) <= Capacity,
+                      "callable too large for InplaceFunction: capture less or raise the capacity");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "over-aligned callable");
+        static_assert(std::is_copy_constructible<Callable>::value, "InplaceFunction requires a copyable callable");
+        ::new (static_cast<void*>(_storage)) Callable(std::forward<F>(callable));
+        _ops = &OpsFor<Callable>::kOps;
+    }
+
+    InplaceFunction(const InplaceFunction& other) {
+        copyFrom(other);
+    }
+    InplaceFunction(InplaceFunction&& other) noexcept {
+        moveFrom(other);
+    }
+    InplaceFunction& operator=(const InplaceFunction& other) {
+        if (this != &other) {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+    InplaceFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+    ~InplaceFunction() {
+        reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return _ops != nullptr;
+    }
+
+    // Like std::function, calling an empty InplaceFunction is a programming error (checked by the caller).
+    R operator()(Args... args) const {
+        return _ops->invoke(const_cast<unsigned char*>(_storage), std::forward<Args>(args)...);
+    }
+
+  private:
+    struct Ops {
+        R (*invoke)(void* callable, Args&&... args);
+        void (*copy)(void* dst, const void* src);
+        void (*move)(void* dst, void* src); // move-constructs into dst, then destroys src
+        void (*destroy)(void* callable);
+    };
+
+    template <typename Callable> struct OpsFor {
+        static R invoke(void* callable, Args&&... args) {
+            return (*static_cast<Callable*>(callable))(std::forward<Args>(args)...);
+        }
+        static void copy(void* dst, const void* src) {
+            ::new (dst) Callable(*static_cast<const Callable*>(src));
+        }
+        static void move(void* dst, void* src) {
+            Callable* from = static_cast<Callable*>(src);
+            ::new (dst) Callable(std::move(*from));
+            from->~Callable();
+        }
+        static void destroy(void* callable) {
+            static_cast<Callable*>(callable)->~Callable();
+        }
+        static constexpr Ops kOps = {&invoke, &copy, &move, &destroy};
+    };
+
+    void copyFrom(const InplaceFunction& other) {
+        if (other._ops) {
+            other._ops->copy(_storage, other._storage);
+            _ops = other._ops;
+        }
+    }
+    void moveFrom(InplaceFunction& other) noexcept {
+        if (other._ops) {
+            other._ops->move(_storage, other._storage);
+            _ops = other._ops;
+            other._ops = nullptr;
+        }
+    }
+    void reset() noexcept {
+        if (_ops) {
+            _ops->destroy(_storage);
+            _ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char _storage[Capacity];
+    const Ops* _ops = nullptr;
+};
+
+#endif // INPLACE_FUNCTION_H
@@ -0,0 +1,51 @@
+#include "MemoryBudget.h"
+
+void MemoryBudget::configure(size_t maxBytes) {
+    _limit.store(maxBytes, std::memory_order_relaxed);
+    _peak.store(_used.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _deferred.store(0, std::memory_order_relaxed);
+    _rejected.store(0, std::memory_order_relaxed);
+}
+
+bool MemoryBudget::tryCharge(size_t bytes) {
+    size_t used = _used.load(std::memory_order_relaxed);
+    do {
+        size_t limit = _limit.load(std::memory_order_relaxed);
+        if (limit > 0 && used > 0 && (used >= limit || bytes > limit - used))
+            return false;
+    } while (!_used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+    raisePeak(used + bytes);
+    return true;
+}
+
+void MemoryBudget::charge(size_t bytes) {
+    raisePeak(_used.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryBudget::release(size_t bytes) {
+    size_t used = _used.load(std::memory_order_relaxed);
+    while (!_used.compare_exchange_weak(used, used > bytes ? used - bytes : 0, std::memory_order_relaxed)) {
+    }
+}
+
+bool MemoryBudget::fits(size_t bytes) const {
+    size_t limit = _limit.load(std::memory_order_relaxed);
+    size_t used = _used.load(std::memory_order_relaxed);
+    return limit == 0 || used == 0 || (used < limit && bytes <= limit - used);
+}
+
+void MemoryBudget::raisePeak(size_t used) {
+    size_t peak = _peak.load(std::memory_order_relaxed);
+    while (used > peak && !_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+}
+
+AsyncHttpMemoryStats MemoryBudget::stats() const {
+    AsyncHttpMemoryStats stats;
+    stats.used = _used.load(std::memory_order_relaxed);
+    stats.peak = _peak.load(std::memory_order_relaxed);
+    stats.limit = _limit.load(std::memory_order_relaxed);
+    stats.deferred = _deferred.load(std::memory_order_relaxed);
+    stats.rejected = _rejected.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,68 @@
+/**
+ * Client-wide memory budget for in-flight requests.
+ *
+ * Each request is charged an admission estimate when it starts plus the body it buffers, and released
+ * when it ends; the client holds (or fails) new requests while the estimate does not fit.
+ */
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct AsyncHttpMemoryBudget {
+    size_t maxBytes = 0;          // budget shared by all in-flight requests; 0 disables the budget
+    size_t minFreeHeap = 0;       // also hold back new requests (and pause body uploads) below this much free heap
+    bool failFast = false;        // fail requests that do not fit with MEMORY_BUDGET_EXCEEDED instead of queueing
+    size_t tlsReserve = 20480;    // charged per HTTPS request: mbedTLS in (16 KiB) + out (4 KiB) record buffers
+
+    bool enabled() const {
+        return maxBytes > 0 || minFreeHeap > 0;
+    }
+};
+
+struct AsyncHttpMemoryStats {
+    size_t used = 0;        // bytes currently charged to in-flight requests
+    size_t peak = 0;        // highest `used` since the budget was configured
+    size_t limit = 0;       // AsyncHttpMemoryBudget::maxBytes
+    uint32_t deferred = 0;  // requests that had to wait in the queue for memory
+    uint32_t rejected = 0;  // requests failed with MEMORY_BUDGET_EXCEEDED (fail-fast admission or buffered body)
+};
+
+class MemoryBudget {
+  public:
+    // Sets the limit (0 = unlimited) and clears the peak and the counters; current charges are kept.
+    void configure(size_t maxBytes);
+
+    // Charges `bytes` if they fit under the limit. An empty budget always accepts, so a request larger than the
+    // whole budget still runs, alone.
+    bool tryCharge(size_t bytes);
+    // Charges unconditionally (the caller already decided to admit).
+    void charge(size_t bytes);
+    void release(size_t bytes);
+    // Whether tryCharge(bytes) would currently succeed.
+    bool fits(size_t bytes) const;
+
+    void noteDeferred() {
+        _deferred.fetch_add(1, std::memory_order_relaxed);
+    }
+    void noteRejected() {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t used() const {
+        return _used.load(std::memory_order_relaxed);
+    }
+    AsyncHttpMemoryStats stats() const;
+
+  private:
+    void raisePeak(size_t used);
+
+    std::atomic<size_t> _limit{0};
+    std::atomic<size_t> _used{0};
+    std::atomic<size_t> _peak{0};
+    std::atomic<uint32_t> _deferred{0};
+    std::atomic<uint32_t> _rejected{0};
+};
+
+#endif // MEMORY_BUDGET_H
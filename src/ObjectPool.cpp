@@ -0,0 +1,122 @@
+#include "ObjectPool.h"
+
+BlockPool::~BlockPool() {
+    ::operator delete(_slab);
+}
+
+bool BlockPool::configure(size_t capacity) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_stats.inUse > 0)
+        return false;
+    ::operator delete(_slab);
+    _slab = nullptr;
+    _slabBytes = 0;
+    _free = nullptr;
+    _stats = Stats();
+    _stats.capacity = capacity;
+    return true;
+}
+
+void* BlockPool::tryAllocate(size_t size) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_stats.capacity == 0)
+        return nullptr;
+    if (!_slab) {
+        // The first allocation sizes the blocks (rounded up to keep every block suitably aligned).
+        const size_t align = alignof(std::max_align_t);
+        size_t blockSize = (size < sizeof(FreeBlock) ? sizeof(FreeBlock) : size);
+        blockSize = (blockSize + align - 1) / align * align;
+        _slab = static_cast<unsigned char*>(::operator new(blockSize * _stats.capacity, std::nothrow));
+        if (!_slab) {
+            _stats.misses++;
+            return nullptr;
+        }
+        _slabBytes = blockSize * _stats.capacity;
+        _stats.blockSize = blockSize;
+        for (size_t i = _stats.capacity; i > 0; --i) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(_slab + (i - 1) * blockSize);
+            block->next = _free;
+            _free = block;
+        }
+    }
+    if (size > _stats.blockSize || !_free) {
+        _stats.misses++;
+        return nullptr;
+    }
+    FreeBlock* block = _free;
+    _free = block->next;
+    _stats.inUse++;
+    if (_stats.inUse > _stats.highWater)
+        _stats.highWater = _stats.inUse;
+    return block;
+}
+
+bool BlockPool::release(void* p) {
+    if (!p)
+        return true;
+    std::lock_guard<std::mutex> guard(_mutex);
+    const unsigned char* bytes = static_cast<const unsigned char*>(p);
+    if (!_slab || bytes < _slab || bytes >= _slab + _slabBytes)
+        return false;
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = _free;
+    _free = block;
+    _stats.inUse--;
+    return true;
+}
+
+bool BlockPool::owns(const void* p) const {
+    std::lock_guard<std::mutex> guard(_mutex);
+    const unsigned char* bytes = static_cast<const unsigned char*>(p);
+    return _slab && bytes >= _slab && bytes < _slab + _slabBytes;
+}
+
+BlockPool::Stats BlockPool::stats() const {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _stats;
+}
+
+// Never destroyed: pooled objects may still be released while static destructors run at exit.
+BlockPool& HttpObjectPools::contexts() {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+}
+
+BlockPool& HttpObjectPools::requests() {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+}
+
+BlockPool& HttpObjectPools::responses() {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+}
+
+BlockPool& HttpObjectPools::gzipWindows() {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+}
+
+BlockPool& HttpObjectPools::arenas() {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+}
+
+bool HttpObjectPools::configure(const AsyncHttpPoolConfig& config) {
+    bool ok = contexts().configure(config.contexts);
+    ok = requests().configure(config.requests) && ok;
+    ok = responses().configure(config.responses) && ok;
+    ok = gzipWindows().configure(config.gzipWindows) && ok;
+    ok = arenas().configure(config.arenas) && ok;
+    return ok;
+}
+
+AsyncHttpPoolStats HttpObjectPools::stats() {
+    AsyncHttpPoolStats stats;
+    stats.contexts = contexts().stats();
+    stats.requests = requests().stats();
+    stats.responses = responses().stats();
+    stats.gzipWindows = gzipWindows().stats();
+    stats.arenas = arenas().stats();
+    return stats;
+}
@@ -0,0 +1,118 @@
+/**
+ * Fixed-capacity block pools for the client's per-request objects.
+ *
+ * A BlockPool hands out equal-size blocks carved from one slab reserved on first use; when it is exhausted
+ * the caller falls back to the heap and a miss is counted. HttpObjectPools holds the process-wide pools
+ * (responses and requests can outlive their client), all disabled until configured.
+ */
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+class BlockPool {
+  public:
+    struct Stats {
+        size_t capacity = 0;  // blocks (0 = pool disabled)
+        size_t blockSize = 0; // bytes per block (0 until the first allocation)
+        size_t inUse = 0;
+        size_t highWater = 0; // most blocks ever in use at once
+        uint32_t misses = 0;  // allocations that fell back to the heap while the pool was enabled
+    };
+
+    BlockPool() {}
+    ~BlockPool();
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    // Sets the number of blocks and resets the counters. Refused (false) while blocks are in use.
+    bool configure(size_t capacity);
+
+    // A block of at least `size` bytes, or nullptr (disabled, exhausted, too large): the caller allocates
+    // from the heap instead.
+    void* tryAllocate(size_t size);
+    // Returns the block to the pool; false when `p` does not belong to it (the caller frees it).
+    bool release(void* p);
+    bool owns(const void* p) const;
+
+    Stats stats() const;
+
+  private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    mutable std::mutex _mutex;
+    unsigned char* _slab = nullptr;
+    size_t _slabBytes = 0;
+    FreeBlock* _free = nullptr;
+    Stats _stats;
+};
+
+// std allocator over a BlockPool, for std::allocate_shared (object and control block share one block).
+template <typename T> class PoolAllocator {
+  public:
+    typedef T value_type;
+
+    explicit PoolAllocator(BlockPool* pool) : _pool(pool) {}
+    template <typename U> PoolAllocator(const PoolAllocator<U>& other) : _pool(other.pool()) {}
+
+    T* allocate(size_t n) {
+        void* p = _pool->tryAllocate(n * sizeof(T));
+        return static_cast<T*>(p ? p : ::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        (void)n;
+        if (!_pool->release(p))
+            ::operator delete(p);
+    }
+
+    BlockPool* pool() const {
+        return _pool;
+    }
+    template <typename U> bool operator==(const PoolAllocator<U>& other) const {
+        return _pool == other.pool();
+    }
+    template <typename U> bool operator!=(const PoolAllocator<U>& other) const {
+        return _pool != other.pool();
+    }
+
+  private:
+    BlockPool* _pool;
+};
+
+// Number of pooled slots per object kind (0 = heap only, the default).
+struct AsyncHttpPoolConfig {
+    uint16_t contexts = 0;    // in-flight requests (one context per request, two while a hedge races)
+    uint16_t requests = 0;    // AsyncHttpRequest objects, including those created by the application
+    uint16_t responses = 0;   // AsyncHttpResponse objects, held until the application drops its shared_ptr
+    uint8_t gzipWindows = 0;  // 32 KiB inflate windows (only used with ASYNC_HTTP_ENABLE_GZIP_DECODE)
+    uint16_t arenas = 0;      // request arena slabs (one per in-flight request, see RequestArena.h)
+};
+
+struct AsyncHttpPoolStats {
+    BlockPool::Stats contexts;
+    BlockPool::Stats requests;
+    BlockPool::Stats responses;
+    BlockPool::Stats gzipWindows;
+    BlockPool::Stats arenas;
+};
+
+class HttpObjectPools {
+  public:
+    // Call at startup, before the first request: a pool with blocks in use keeps its previous capacity and the
+    // call returns false.
+    static bool configure(const AsyncHttpPoolConfig& config);
+    static AsyncHttpPoolStats stats();
+
+    static BlockPool& contexts();
+    static BlockPool& requests();
+    static BlockPool& responses();
+    static BlockPool& gzipWindows();
+    static BlockPool& arenas();
+};
+
+#endif // OBJECT_POOL_H
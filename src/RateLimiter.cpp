@@ -0,0 +1,159 @@
+#include "RateLimiter.h"
+#include <cctype>
+
+static constexpr uint64_t kMicroPerToken = 1000000ULL;
+// Default-configured origins whose bucket refilled completely are dropped beyond this count
+// (a full bucket is equivalent to a fresh one, so nothing is lost).
+static constexpr size_t kMaxIdleOrigins = 8;
+
+void TokenBucket::configure(float requestsPerSecond, uint32_t burst, uint32_t nowMs) {
+    if (requestsPerSecond <= 0) {
+        _refillPerMs = 0;
+        _tokens = _capacity = 0;
+        return;
+    }
+    if (burst == 0)
+        burst = 1;
+    // micro-tokens per ms = rps * 1e6 / 1e3
+    uint32_t perMs = static_cast<uint32_t>(requestsPerSecond * 1000.0f + 0.5f);
+    _refillPerMs = perMs > 0 ? perMs : 1;
+    _capacity = static_cast<uint64_t>(burst) * kMicroPerToken;
+    _tokens = _capacity; // start full: an initial burst is allowed
+    _lastRefillMs = nowMs;
+}
+
+void TokenBucket::refill(uint32_t nowMs) {
+    uint32_t elapsed = nowMs - _lastRefillMs; // wraps correctly
+    _lastRefillMs = nowMs;
+    if (elapsed == 0 || _tokens >= _capacity)
+        return;
+    uint64_t add = static_cast<uint64_t>(elapsed) * _refillPerMs;
+    _tokens = (_capacity - _tokens <= add) ? _capacity : _tokens + add;
+}
+
+bool TokenBucket::tryAcquire(uint32_t nowMs) {
+    if (!enabled())
+        return true;
+    refill(nowMs);
+    if (_tokens < kMicroPerToken)
+        return false;
+    _tokens -= kMicroPerToken;
+    return true;
+}
+
+uint32_t TokenBucket::msUntilAvailable(uint32_t nowMs) {
+    if (!enabled())
+        return 0;
+    refill(nowMs);
+    if (_tokens >= kMicroPerToken)
+        return 0;
+    uint64_t missing = kMicroPerToken - _tokens;
+    return static_cast<uint32_t>((missing + _refillPerMs - 1) / _refillPerMs);
+}
+
+bool TokenBucket::isFull(uint32_t nowMs) {
+    if (!enabled())
+        return true;
+    refill(nowMs);
+    return _tokens >= _capacity;
+}
+
+void RateLimiter::setGlobal(float requestsPerSecond, uint32_t burst, uint32_t nowMs) {
+    _global.configure(requestsPerSecond, burst, nowMs);
+}
+
+void RateLimiter::setPerOriginDefault(float requestsPerSecond, uint32_t burst) {
+    _originRate = requestsPerSecond > 0 ? requestsPerSecond : 0;
+    _originBurst = burst;
+    // Default buckets are rebuilt lazily with the new settings; explicit overrides stay.
+    std::vector<OriginBucket> kept;
+    for (auto& origin : _origins) {
+        if (origin.overridden)
+            kept.push_back(origin);
+    }
+    _origins.swap(kept);
+}
+
+void RateLimiter::setOrigin(const std::string& originKey, float requestsPerSecond, uint32_t burst, uint32_t nowMs) {
+    for (auto& origin : _origins) {
+        if (origin.key == originKey) {
+            origin.overridden = true;
+            origin.bucket.configure(requestsPerSecond, burst, nowMs);
+            return;
+        }
+    }
+    OriginBucket origin;
+    origin.key = originKey;
+    origin.overridden = true;
+    origin.bucket.configure(requestsPerSecond, burst, nowMs);
+    _origins.push_back(origin);
+}
+
+bool RateLimiter::enabled() const {
+    if (_global.enabled() || _originRate > 0)
+        return true;
+    for (const auto& origin : _origins) {
+        if (origin.bucket.enabled())
+            return true;
+    }
+    return false;
+}
+
+RateLimiter::OriginBucket* RateLimiter::findOrCreate(const std::string& originKey, uint32_t nowMs) {
+    for (auto& origin : _origins) {
+        if (origin.key == originKey)
+            return &origin;
+    }
+    if (_originRate <= 0)
+        return nullptr;
+    pruneIdle(nowMs);
+    OriginBucket origin;
+    origin.key = originKey;
+    origin.bucket.configure(_originRate, _originBurst, nowMs);
+    _origins.push_back(origin);
+    return &_origins.back();
+}
+
+void RateLimiter::pruneIdle(uint32_t nowMs) {
+    size_t idle = 0;
+    for (auto& origin : _origins) {
+        if (!origin.overridden)
+            idle++;
+    }
+    if (idle < kMaxIdleOrigins)
+        return;
+    for (size_t i = 0; i < _origins.size();) {
+        if (!_origins[i].overridden && _origins[i].bucket.isFull(nowMs))
+            _origins.erase(_origins.begin() + i);
+        else
+            ++i;
+    }
+}
+
+RateLimiter::Result RateLimiter::tryAcquire(const std::string& originKey, uint32_t nowMs, uint32_t* waitMs) {
+    if (waitMs)
+        *waitMs = 0;
+    uint32_t globalWait = _global.msUntilAvailable(nowMs);
+    if (globalWait > 0) {
+        if (waitMs)
+            *waitMs = globalWait;
+        return Result::kGlobalLimited;
+    }
+    OriginBucket* origin = findOrCreate(originKey, nowMs);
+    if (origin && !origin->bucket.tryAcquire(nowMs)) {
+        if (waitMs)
+            *waitMs = origin->bucket.msUntilAvailable(nowMs);
+        return Result::kOriginLimited;
+    }
+    _global.tryAcquire(nowMs);
+    return Result::kGranted;
+}
+
+std::string RateLimiter::makeOriginKey(const std::string& host, uint16_t port, bool secure) {
+    std::string key = secure ? "https://" : "http://";
+    for (char c : host)
+        key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    key.push_back(':');
+    key += std::to_string(port);
+    return key;
+}
@@ -0,0 +1,79 @@
+/**
+ * Token-bucket rate limiting for the request dispatcher (global and per-origin).
+ *
+ * Buckets hold up to `burst` tokens and refill continuously at `requestsPerSecond`; each dispatched
+ * request consumes one token from the global bucket and one from its origin's bucket. Time is passed
+ * in by the caller (millis()), and arithmetic is integer-only (micro-tokens) to stay cheap on ESP32.
+ */
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TokenBucket {
+  public:
+    // requestsPerSecond <= 0 disables the bucket (always grants). burst is clamped to >= 1.
+    void configure(float requestsPerSecond, uint32_t burst, uint32_t nowMs);
+    bool enabled() const {
+        return _refillPerMs > 0;
+    }
+    bool tryAcquire(uint32_t nowMs);
+    // 0 when a token is available now.
+    uint32_t msUntilAvailable(uint32_t nowMs);
+    bool isFull(uint32_t nowMs);
+
+  private:
+    void refill(uint32_t nowMs);
+
+    uint64_t _tokens = 0;   // micro-tokens
+    uint64_t _capacity = 0; // micro-tokens
+    uint32_t _refillPerMs = 0;
+    uint32_t _lastRefillMs = 0;
+};
+
+class RateLimiter {
+  public:
+    enum class Result {
+        kGranted,
+        kOriginLimited,
+        kGlobalLimited,
+    };
+
+    void setGlobal(float requestsPerSecond, uint32_t burst, uint32_t nowMs);
+    // Default applied to every origin without an explicit override.
+    void setPerOriginDefault(float requestsPerSecond, uint32_t burst);
+    void setOrigin(const std::string& originKey, float requestsPerSecond, uint32_t burst, uint32_t nowMs);
+
+    bool enabled() const;
+
+    // Takes one token from both the global and the origin bucket, or none. On refusal, *waitMs (optional)
+    // receives the time until the limiting bucket has a token again.
+    Result tryAcquire(const std::string& originKey, uint32_t nowMs, uint32_t* waitMs);
+
+    size_t trackedOrigins() const {
+        return _origins.size();
+    }
+
+    // "http://host:80" style key (host lowercased) shared by the client and setOrigin() callers.
+    static std::string makeOriginKey(const std::string& host, uint16_t port, bool secure);
+
+  private:
+    struct OriginBucket {
+        std::string key;
+        bool overridden = false;
+        TokenBucket bucket;
+    };
+
+    OriginBucket* findOrCreate(const std::string& originKey, uint32_t nowMs);
+    void pruneIdle(uint32_t nowMs);
+
+    TokenBucket _global;
+    float _originRate = 0;
+    uint32_t _originBurst = 1;
+    std::vector<OriginBucket> _origins;
+};
+
+#endif // RATE_LIMITER_H
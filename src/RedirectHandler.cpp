@@ -150,7 +150,14 @@ bool RedirectHandler::buildRedirectRequest(AsyncHttpClient::RequestContext* cont
 
     std::unique_ptr<AsyncHttpRequest> newRequest(new AsyncHttpRequest(newMethod, targetUrl));
     newRequest->setTimeout(context->request->getTimeout());
+    if (context->request->hasDeadline())
+        newRequest->setDeadline(context->request->getDeadline());
+    newRequest->setGroup(context->request->getGroup());
     newRequest->setNoStoreBody(context->request->getNoStoreBody());
+    if (context->request->hasRetryPolicy())
+        newRequest->setRetryPolicy(*context->request->getRetryPolicy());
+    if (context->request->hasSocketOptions())
+        newRequest->setSocketOptions(*context->request->getSocketOptions());
 
     bool sameOrigin = isSameOrigin(context->request.get(), newRequest.get());
     AsyncHttpClient::RedirectHeaderPolicy headerPolicy;
@@ -233,41 +240,9 @@ void RedirectHandler::resetContextForRedirect(AsyncHttpClient::RequestContext* c
                                               std::unique_ptr<AsyncHttpRequest> newRequest) {
     if (!context || !_client)
         return;
-    if (context->transport) {
-        context->transport->close();
-        delete context->transport;
-        context->transport = nullptr;
-    }
-    context->request.reset();
-    context->response.reset();
+    _client->resetResponseState(context);
     context->request = std::move(newRequest);
-    context->response = std::make_shared<AsyncHttpResponse>();
-    context->responseBuffer = "";
-    context->headersComplete = false;
-    context->responseProcessed = false;
-    context->expectedContentLength = 0;
-    context->receivedContentLength = 0;
-    context->receivedBodyLength = 0;
-    context->chunk.chunked = false;
-    context->chunk.chunkedComplete = false;
-    context->chunk.currentChunkRemaining = 0;
-    context->chunk.awaitingFinalChunkTerminator = false;
-    context->chunk.trailerLineCount = 0;
-    context->headersSent = false;
-    context->streamingBodyInProgress = false;
-    context->notifiedEndCallback = false;
-    context->requestKeepAlive = false;
-    context->serverRequestedClose = false;
-    context->usingPooledConnection = false;
-    context->resolvedTlsConfig = AsyncHttpTLSConfig();
-#if ASYNC_HTTP_ENABLE_GZIP_DECODE
-    context->gzip.gzipEncoded = false;
-    context->gzip.gzipDecodeActive = false;
-    context->gzip.gzipDecoder.reset();
-#endif
-#if !ASYNC_TCP_HAS_TIMEOUT
-    context->timing.timeoutTimer = millis();
-#endif
+    // Timing is left alone: the request timeout and deadline span the whole redirect chain.
     _client->executeRequest(context);
 }
 
@@ -0,0 +1,76 @@
+#include "RequestArena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+RequestArena::~RequestArena() {
+    reset();
+    releaseSlab();
+}
+
+void RequestArena::configure(size_t capacity, AllocFn slabAlloc, FreeFn slabFree) {
+    reset();
+    releaseSlab();
+    _slabAlloc = slabAlloc;
+    _slabFree = slabFree;
+    _stats = Stats();
+    _stats.capacity = capacity;
+}
+
+void RequestArena::releaseSlab() {
+    if (!_slab)
+        return;
+    if (_slabFree)
+        _slabFree(_slab);
+    else
+        std::free(_slab);
+    _slab = nullptr;
+}
+
+void* RequestArena::allocate(size_t size, size_t align) {
+    if (align == 0)
+        align = 1;
+    if (_stats.capacity > 0 && !_slab)
+        _slab = static_cast<unsigned char*>(_slabAlloc ? _slabAlloc(_stats.capacity) : std::malloc(_stats.capacity));
+    if (_slab) {
+        size_t offset = (_stats.used + align - 1) & ~(align - 1);
+        if (offset <= _stats.capacity && size <= _stats.capacity - offset) {
+            _stats.used = offset + size;
+            if (_stats.used > _stats.highWater)
+                _stats.highWater = _stats.used;
+            return _slab + offset;
+        }
+    }
+
+    // Slab full, disabled or not allocatable: one heap block per allocation, freed by reset().
+    const size_t header = (sizeof(Overflow) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) *
+                          alignof(std::max_align_t);
+    if (align > alignof(std::max_align_t) || size > SIZE_MAX - header)
+        return nullptr;
+    Overflow* block = static_cast<Overflow*>(std::malloc(header + size));
+    if (!block)
+        return nullptr;
+    block->next = _overflow;
+    _overflow = block;
+    _stats.overflows++;
+    return reinterpret_cast<unsigned char*>(block) + header;
+}
+
+char* RequestArena::copy(const char* data, size_t len) {
+    char* out = static_cast<char*>(allocate(len + 1));
+    if (!out)
+        return nullptr;
+    if (len > 0)
+        memcpy(out, data, len);
+    out[len] = '\0';
+    return out;
+}
+
+void RequestArena::reset() {
+    while (_overflow) {
+        Overflow* next = _overflow->next;
+        std::free(_overflow);
+        _overflow = next;
+    }
+    _stats.used = 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * Per-request bump arena for transient parsing and serialization buffers.
+ *
+ * Scratch space is bumped out of one slab and released all at once by reset(); allocations that do not
+ * fit fall back to the heap and are freed by the same reset().
+ */
+#ifndef REQUEST_ARENA_H
+#define REQUEST_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Default slab size: room for a typical request head plus a typical response header block.
+#ifndef ASYNC_HTTP_REQUEST_ARENA_SIZE
+#define ASYNC_HTTP_REQUEST_ARENA_SIZE 1536
+#endif
+
+class RequestArena {
+  public:
+    typedef void* (*AllocFn)(size_t size);
+    typedef void (*FreeFn)(void* p);
+
+    struct Stats {
+        size_t capacity = 0;    // slab bytes (0 = arena disabled: every allocation goes to the heap)
+        size_t used = 0;        // slab bytes handed out since the last reset()
+        size_t highWater = 0;   // most slab bytes used between two resets
+        uint32_t overflows = 0; // allocations served by the heap because the slab was full or disabled
+    };
+
+    RequestArena() {}
+    ~RequestArena();
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    // Sets the slab size and the allocator used for it (nullptr: malloc/free). Drops the current slab, so call it
+    // before the arena is used or right after a reset().
+    void configure(size_t capacity, AllocFn slabAlloc = nullptr, FreeFn slabFree = nullptr);
+
+    // `size` bytes aligned to `align` (a power of two), or nullptr when even the heap fallback failed. Valid until
+    // the next reset().
+    void* allocate(size_t size, size_t align = 1);
+    // NUL-terminated copy of `len` bytes of `data`.
+    char* copy(const char* data, size_t len);
+
+    // Releases everything allocated since the last reset in one shot (the slab itself is kept).
+    void reset();
+
+    Stats stats() const {
+        return _stats;
+    }
+
+  private:
+    // Heap fallback blocks are chained through this header so reset() can free them.
+    struct Overflow {
+        Overflow* next;
+    };
+
+    void releaseSlab();
+
+    unsigned char* _slab = nullptr;
+    AllocFn _slabAlloc = nullptr;
+    FreeFn _slabFree = nullptr;
+    Overflow* _overflow = nullptr;
+    Stats _stats;
+};
+
+#endif // REQUEST_ARENA_H
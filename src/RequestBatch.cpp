@@ -0,0 +1,207 @@
+#include "RequestBatch.h"
+#include <algorithm>
+#include <cstdint>
+
+RequestBatcher::RequestBatcher(AsyncHttpClient* client) : _client(client) {}
+
+void RequestBatcher::lock() const {
+    if (_client)
+        _client->lock();
+}
+
+void RequestBatcher::unlock() const {
+    if (_client)
+        _client->unlock();
+}
+
+uint32_t RequestBatcher::submit(std::vector<std::unique_ptr<AsyncHttpRequest>> requests,
+                                AsyncHttpClient::BatchCallback onComplete,
+                                const AsyncHttpClient::BatchOptions& options) {
+    auto state = std::make_shared<RequestBatchState>();
+    state->onComplete = std::move(onComplete);
+    state->options = options;
+    size_t count = requests.size();
+    state->results.resize(count);
+    state->finished.assign(count, false);
+    state->remaining = count;
+    state->waiting.reserve(count);
+
+    bool invalidItem = false;
+    for (size_t i = 0; i < count; ++i) {
+        std::unique_ptr<AsyncHttpRequest> request = std::move(requests[i]);
+        if (!request || request->getHost().length() == 0 || request->getPath().length() == 0) {
+            AsyncHttpClient::BatchItemResult& result = state->results[i];
+            result.error = CONNECTION_FAILED;
+            result.errorMessage = request ? "Invalid URL" : "Request is null";
+            state->finished[i] = true;
+            state->remaining--;
+            invalidItem = true;
+            continue;
+        }
+        std::shared_ptr<AsyncHttpClient::RequestContext> ctx = _client->createContext(std::move(request));
+        ctx->batch = state;
+        ctx->batchIndex = i;
+        state->waiting.push_back(std::move(ctx));
+    }
+
+    std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>> toStart;
+    std::vector<uint32_t> toAbort;
+    lock();
+    state->id = _nextBatchId++;
+    if (_nextBatchId == 0)
+        _nextBatchId = 1;
+    _active.push_back(state);
+    if (invalidItem && state->options.failFast)
+        abortRemainingLocked(state.get(), &toAbort);
+    else
+        takeStartableLocked(state.get(), &toStart);
+    bool done = markCompletedLocked(state);
+    unlock();
+
+    uint32_t id = state->id;
+    run(toStart, toAbort);
+    if (done)
+        complete(state);
+    return id;
+}
+
+bool RequestBatcher::abortBatch(uint32_t batchId) {
+    std::shared_ptr<RequestBatchState> state;
+    std::vector<uint32_t> toAbort;
+    lock();
+    for (const auto& candidate : _active) {
+        if (candidate->id == batchId) {
+            state = candidate;
+            break;
+        }
+    }
+    if (!state || state->aborting) {
+        unlock();
+        return false;
+    }
+    abortRemainingLocked(state.get(), &toAbort);
+    bool done = markCompletedLocked(state);
+    unlock();
+    run(std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>>(), toAbort);
+    if (done)
+        complete(state);
+    return true;
+}
+
+void RequestBatcher::onItemSucceeded(AsyncHttpClient::RequestContext* context) {
+    finishItem(context, true, CONNECTION_FAILED, nullptr);
+}
+
+void RequestBatcher::onItemFailed(AsyncHttpClient::RequestContext* context, HttpClientError error,
+                                  const char* message) {
+    finishItem(context, false, error, message);
+}
+
+void RequestBatcher::finishItem(AsyncHttpClient::RequestContext* context, bool success, HttpClientError error,
+                                const char* message) {
+    if (!context || !context->batch)
+        return;
+    std::shared_ptr<RequestBatchState> state = std::move(context->batch);
+    std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>> toStart;
+    std::vector<uint32_t> toAbort;
+    lock();
+    size_t index = context->batchIndex;
+    if (index >= state->results.size() || state->finished[index]) {
+        unlock();
+        return;
+    }
+    state->finished[index] = true;
+    state->remaining--;
+    if (state->inFlight > 0)
+        state->inFlight--;
+    AsyncHttpClient::BatchItemResult& result = state->results[index];
+    result.requestId = context->id;
+    result.success = success;
+    if (success) {
+        result.response = context->response;
+    } else {
+        result.error = error;
+        result.errorMessage = message ? message : "";
+    }
+    if (!success && state->options.failFast && !state->aborting)
+        abortRemainingLocked(state.get(), &toAbort);
+    else
+        takeStartableLocked(state.get(), &toStart);
+    bool done = markCompletedLocked(state);
+    unlock();
+
+    run(toStart, toAbort);
+    if (done)
+        complete(state);
+}
+
+void RequestBatcher::abortRemainingLocked(RequestBatchState* state, std::vector<uint32_t>* inFlightIds) {
+    state->aborting = true;
+    for (size_t i = state->nextWaiting; i < state->waiting.size(); ++i) {
+        std::shared_ptr<AsyncHttpClient::RequestContext>& ctx = state->waiting[i];
+        if (!ctx)
+            continue;
+        size_t index = ctx->batchIndex;
+        ctx->batch.reset();
+        if (index < state->results.size() && !state->finished[index]) {
+            AsyncHttpClient::BatchItemResult& result = state->results[index];
+            result.error = ABORTED;
+            result.errorMessage = "Batch aborted";
+            state->finished[index] = true;
+            state->remaining--;
+        }
+    }
+    state->waiting.clear();
+    state->nextWaiting = 0;
+    for (size_t i = 0; i < state->results.size(); ++i) {
+        if (!state->finished[i] && state->results[i].requestId != 0)
+            inFlightIds->push_back(state->results[i].requestId);
+    }
+}
+
+void RequestBatcher::takeStartableLocked(RequestBatchState* state,
+                                         std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>>* out) {
+    size_t limit = state->options.maxParallel > 0 ? state->options.maxParallel : SIZE_MAX;
+    while (!state->aborting && state->nextWaiting < state->waiting.size() && state->inFlight < limit) {
+        std::shared_ptr<AsyncHttpClient::RequestContext> ctx = std::move(state->waiting[state->nextWaiting++]);
+        state->results[ctx->batchIndex].requestId = ctx->id;
+        state->inFlight++;
+        out->push_back(std::move(ctx));
+    }
+    if (state->nextWaiting >= state->waiting.size()) {
+        state->waiting.clear();
+        state->nextWaiting = 0;
+    }
+}
+
+bool RequestBatcher::markCompletedLocked(const std::shared_ptr<RequestBatchState>& state) {
+    if (state->remaining > 0 || state->completed)
+        return false;
+    state->completed = true;
+    auto it = std::find(_active.begin(), _active.end(), state);
+    if (it != _active.end())
+        _active.erase(it);
+    return true;
+}
+
+void RequestBatcher::complete(const std::shared_ptr<RequestBatchState>& state) {
+    if (!state->onComplete)
+        return;
+    _client->dispatchTask([state]() { state->onComplete(state->results); });
+}
+
+void RequestBatcher::run(const std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>>& toStart,
+                         const std::vector<uint32_t>& toAbort) {
+    // Outside the lock: starting or aborting an item may complete it (and re-enter finishItem) synchronously.
+    for (const auto& ctx : toStart) {
+        lock();
+        bool aborted = ctx->batch && ctx->batch->aborting; // an earlier item of this run failed fast
+        unlock();
+        if (aborted)
+            finishItem(ctx.get(), false, ABORTED, "Batch aborted");
+        else
+            _client->submitContext(ctx);
+    }
+    for (uint32_t id : toAbort)
+        _client->abort(id);
+}
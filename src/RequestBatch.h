@@ -0,0 +1,58 @@
+#ifndef REQUEST_BATCH_H
+#define REQUEST_BATCH_H
+
+#include <memory>
+#include <vector>
+#include "AsyncHttpClient.h"
+
+// Shared state of one AsyncHttpClient::batch() call. Items point at it from their RequestContext (batch +
+// batchIndex), so no per-item callback objects are allocated.
+struct RequestBatchState {
+    uint32_t id = 0;
+    AsyncHttpClient::BatchCallback onComplete;
+    AsyncHttpClient::BatchOptions options;
+    std::vector<AsyncHttpClient::BatchItemResult> results;
+    std::vector<bool> finished;
+    // Items not yet handed to the client (only used when options.maxParallel limits the batch).
+    std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>> waiting;
+    size_t nextWaiting = 0;
+    size_t inFlight = 0;
+    size_t remaining = 0;
+    bool aborting = false;
+    bool completed = false;
+};
+
+class RequestBatcher {
+  public:
+    explicit RequestBatcher(AsyncHttpClient* client);
+
+    uint32_t submit(std::vector<std::unique_ptr<AsyncHttpRequest>> requests, AsyncHttpClient::BatchCallback onComplete,
+                    const AsyncHttpClient::BatchOptions& options);
+    bool abortBatch(uint32_t batchId);
+
+    // Called by the client when a batch item finished (before its context is cleaned up).
+    void onItemSucceeded(AsyncHttpClient::RequestContext* context);
+    void onItemFailed(AsyncHttpClient::RequestContext* context, HttpClientError error, const char* message);
+
+  private:
+    void lock() const;
+    void unlock() const;
+    void finishItem(AsyncHttpClient::RequestContext* context, bool success, HttpClientError error,
+                    const char* message);
+    // Caller holds the lock. Marks waiting items ABORTED and collects the ids of submitted, unfinished items.
+    void abortRemainingLocked(RequestBatchState* state, std::vector<uint32_t>* inFlightIds);
+    // Caller holds the lock. Moves waiting items into *out up to the batch parallelism limit.
+    void takeStartableLocked(RequestBatchState* state,
+                             std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>>* out);
+    // Caller holds the lock. Returns true exactly once, when the last item finished.
+    bool markCompletedLocked(const std::shared_ptr<RequestBatchState>& state);
+    void complete(const std::shared_ptr<RequestBatchState>& state);
+    void run(const std::vector<std::shared_ptr<AsyncHttpClient::RequestContext>>& toStart,
+             const std::vector<uint32_t>& toAbort);
+
+    AsyncHttpClient* _client = nullptr;
+    uint32_t _nextBatchId = 1;
+    std::vector<std::shared_ptr<RequestBatchState>> _active;
+};
+
+#endif // REQUEST_BATCH_H
@@ -0,0 +1,32 @@
+/**
+ * Connects an AsyncClient to a host name through the shared DnsCache (used by the TCP and TLS transports).
+ *
+ * A cached or pinned address connects at once and a cached failure fails at once. On a miss the connection goes to
+ * AsyncTCP by name, as it did without the cache: AsyncTCP hands lwIP's answer to its own task, while the cache's
+ * lookup (which lwIP shares with AsyncTCP's) fills the cache for the connections after it. Nothing waits on the
+ * cache's lookup, whose answer arrives on the tcpip thread, where connecting or reporting errors is not safe.
+ */
+#ifndef RESOLVING_CONNECTOR_H
+#define RESOLVING_CONNECTOR_H
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+
+#include "DnsCache.h"
+
+// Same contract as AsyncClient::connect(host, port).
+inline bool connectResolving(AsyncClient* client, const char* host, uint16_t port) {
+    uint32_t ipv4 = 0;
+    switch (DnsCache::shared().resolve(host, millis(), &ipv4, nullptr, nullptr)) {
+    case DnsCache::Result::kResolved:
+        return client->connect(IPAddress(ipv4), port);
+    case DnsCache::Result::kFailed:
+        return false;
+    case DnsCache::Result::kPending:
+    case DnsCache::Result::kBypass:
+        break;
+    }
+    return client->connect(host, port);
+}
+
+#endif // RESOLVING_CONNECTOR_H
@@ -0,0 +1,114 @@
+#include "RetryPolicy.h"
+#include <cctype>
+#include <cstring>
+
+uint32_t AsyncHttpRetryPolicy::backoffDelayMs(uint8_t retryNumber, uint32_t randomValue) const {
+    if (retryNumber == 0)
+        retryNumber = 1;
+    uint32_t delay = baseDelayMs;
+    for (uint8_t i = 1; i < retryNumber && delay < maxDelayMs; ++i)
+        delay = delay > (UINT32_MAX >> 1) ? UINT32_MAX : delay << 1;
+    if (maxDelayMs > 0 && delay > maxDelayMs)
+        delay = maxDelayMs;
+    uint8_t jitter = jitterPercent > 100 ? 100 : jitterPercent;
+    uint32_t jitterSpan = static_cast<uint32_t>((static_cast<uint64_t>(delay) * jitter) / 100);
+    if (jitterSpan > 0)
+        delay -= randomValue % (jitterSpan + 1);
+    return delay;
+}
+
+static const char* skipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t')
+        ++p;
+    return p;
+}
+
+bool AsyncHttpRetryPolicy::parseRetryAfter(const char* value, const char* dateHeader, uint32_t* outMs) {
+    if (!value || !outMs)
+        return false;
+    const char* p = skipSpaces(value);
+    if (std::isdigit(static_cast<unsigned char>(*p))) {
+        uint64_t seconds = 0;
+        while (std::isdigit(static_cast<unsigned char>(*p))) {
+            seconds = seconds * 10 + static_cast<uint64_t>(*p - '0');
+            if (seconds > UINT32_MAX / 1000)
+                seconds = UINT32_MAX / 1000; // saturate; the caller caps the wait anyway
+            ++p;
+        }
+        if (*skipSpaces(p) != '\0')
+            return false;
+        *outMs = static_cast<uint32_t>(seconds * 1000);
+        return true;
+    }
+    int64_t retryAt = 0;
+    int64_t now = 0;
+    if (!dateHeader || !parseHttpDate(p, &retryAt) || !parseHttpDate(dateHeader, &now))
+        return false;
+    int64_t deltaSeconds = retryAt - now;
+    if (deltaSeconds < 0)
+        deltaSeconds = 0;
+    if (deltaSeconds > static_cast<int64_t>(UINT32_MAX / 1000))
+        deltaSeconds = UINT32_MAX / 1000;
+    *outMs = static_cast<uint32_t>(deltaSeconds * 1000);
+    return true;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's days_from_civil).
+static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+static bool parseNumber(const char** p, int digits, int* out) {
+    int v = 0;
+    for (int i = 0; i < digits; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>((*p)[i])))
+            return false;
+        v = v * 10 + ((*p)[i] - '0');
+    }
+    *p += digits;
+    *out = v;
+    return true;
+}
+
+bool AsyncHttpRetryPolicy::parseHttpDate(const char* value, int64_t* outEpochSeconds) {
+    static const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                          "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    if (!value || !outEpochSeconds)
+        return false;
+    const char* p = skipSpaces(value);
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    const char* comma = std::strchr(p, ',');
+    if (!comma)
+        return false;
+    p = skipSpaces(comma + 1);
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    if (!parseNumber(&p, 2, &day) || *p++ != ' ')
+        return false;
+    int month = 0;
+    for (int i = 0; i < 12; ++i) {
+        if (std::strncmp(p, kMonths[i], 3) == 0) {
+            month = i + 1;
+            break;
+        }
+    }
+    if (month == 0)
+        return false;
+    p += 3;
+    if (*p++ != ' ' || !parseNumber(&p, 4, &year) || *p++ != ' ')
+        return false;
+    if (!parseNumber(&p, 2, &hour) || *p++ != ':' || !parseNumber(&p, 2, &minute) || *p++ != ':' ||
+        !parseNumber(&p, 2, &second))
+        return false;
+    if (std::strncmp(skipSpaces(p), "GMT", 3) != 0)
+        return false;
+    if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+        return false;
+    *outEpochSeconds = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+                       hour * 3600 + minute * 60 + second;
+    return true;
+}
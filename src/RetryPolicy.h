@@ -0,0 +1,50 @@
+/**
+ * Retry policy for transient failures: which errors are retried, how many attempts, and the
+ * exponential backoff (with jitter) between them. Also parses `Retry-After` (delta-seconds, or an
+ * HTTP-date evaluated against the response `Date` header so no wall clock is required).
+ */
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <cstdint>
+
+struct AsyncHttpRetryPolicy {
+    enum RetryOn : uint16_t {
+        kRetryOnConnectFailed = 1 << 0,    // CONNECTION_FAILED
+        kRetryOnConnectTimeout = 1 << 1,   // CONNECT_TIMEOUT
+        kRetryOnStaleConnection = 1 << 2,  // CONNECTION_CLOSED before headers on a reused pooled connection
+        kRetryOnConnectionClosed = 1 << 3, // CONNECTION_CLOSED before headers on a fresh connection
+        kRetryOnTlsHandshake = 1 << 4,     // TLS_HANDSHAKE_FAILED / TLS_HANDSHAKE_TIMEOUT
+        kRetryOnStatus503 = 1 << 5,
+        kRetryOnStatus429 = 1 << 6,
+        kRetryOnDefault = kRetryOnConnectFailed | kRetryOnConnectTimeout | kRetryOnStaleConnection |
+                          kRetryOnStatus503 | kRetryOnStatus429,
+    };
+
+    uint8_t maxAttempts = 1;     // total attempts including the first one; 1 disables retries
+    uint32_t baseDelayMs = 200;  // delay before the first retry, doubled for each further retry
+    uint32_t maxDelayMs = 5000;  // backoff cap
+    uint8_t jitterPercent = 50;  // up to this share of the delay is randomly removed (0 = deterministic)
+    uint16_t retryOn = kRetryOnDefault;
+    bool retryNonIdempotent = false; // POST / PATCH are only retried when set
+    bool honorRetryAfter = true;     // use the server's Retry-After on 503 / 429 instead of the backoff
+    uint32_t maxRetryAfterMs = 30000; // larger Retry-After values are not waited for (the response is delivered)
+
+    bool enabled() const {
+        return maxAttempts > 1;
+    }
+    bool retries(RetryOn condition) const {
+        return (retryOn & condition) != 0;
+    }
+
+    // Delay before retry number `retryNumber` (1 = first retry). randomValue feeds the jitter.
+    uint32_t backoffDelayMs(uint8_t retryNumber, uint32_t randomValue) const;
+
+    // Retry-After as delta-seconds, or as an IMF-fixdate relative to `dateHeader` (may be null). Returns false when
+    // the value cannot be interpreted.
+    static bool parseRetryAfter(const char* value, const char* dateHeader, uint32_t* outMs);
+    // IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT") to seconds since the Unix epoch.
+    static bool parseHttpDate(const char* value, int64_t* outEpochSeconds);
+};
+
+#endif // RETRY_POLICY_H
@@ -0,0 +1,98 @@
+/**
+ * Bounded multi-producer / single-consumer queue used to hand new requests and aborts from
+ * application tasks to the client's network/loop context without taking the client mutex.
+ *
+ * Implementation: fixed ring of cells, each carrying a sequence number (Vyukov bounded queue).
+ *  - tryPush() is lock-free and may be called concurrently from any number of tasks; it fails
+ *    (returns false) instead of blocking when the ring is full.
+ *  - tryPop() must only be called by one consumer at a time (the caller provides that exclusion).
+ */
+#ifndef SUBMISSION_QUEUE_H
+#define SUBMISSION_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+template <typename T> class MpscQueue {
+  public:
+    // Capacity is rounded up to the next power of two (minimum 2).
+    explicit MpscQueue(size_t capacity) : _mask(roundUpPow2(capacity) - 1) {
+        _cells.reset(new Cell[_mask + 1]);
+        for (size_t i = 0; i <= _mask; ++i)
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        _enqueuePos.store(0, std::memory_order_relaxed);
+        _dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Moves from value only when the push succeeds.
+    bool tryPush(T&& value) {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[pos & _mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T* out) {
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = _cells[pos & _mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0)
+            return false; // empty (or the producer owning this slot has not published yet)
+        if (out)
+            *out = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+        _dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Snapshot only: may be stale as soon as it returns when producers are active.
+    bool empty() const {
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        size_t seq = _cells[pos & _mask].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0;
+    }
+
+    size_t capacity() const {
+        return _mask + 1;
+    }
+
+  private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static size_t roundUpPow2(size_t v) {
+        size_t p = 2;
+        while (p < v)
+            p <<= 1;
+        return p;
+    }
+
+    std::unique_ptr<Cell[]> _cells;
+    const size_t _mask;
+    std::atomic<size_t> _enqueuePos{0};
+    std::atomic<size_t> _dequeuePos{0};
+};
+
+#endif // SUBMISSION_QUEUE_H
@@ -1,26 +1,27 @@
 #include "AsyncTransport.h"
+#include "ResolvingConnector.h"
 #include <Arduino.h>
 #include <AsyncTCP.h>
 
 class AsyncTcpTransport : public AsyncTransport {
   public:
-    AsyncTcpTransport();
+    explicit AsyncTcpTransport(const AsyncHttpSocketOptions& options);
     ~AsyncTcpTransport() override;
 
     void setConnectHandler(ConnectHandler handler, void* arg) override {
-        _connectHandler = handler;
+        _connectHandler = std::move(handler);
         _connectArg = arg;
     }
     void setDataHandler(DataHandler handler, void* arg) override {
-        _dataHandler = handler;
+        _dataHandler = std::move(handler);
         _dataArg = arg;
     }
     void setDisconnectHandler(DisconnectHandler handler, void* arg) override {
-        _disconnectHandler = handler;
+        _disconnectHandler = std::move(handler);
         _disconnectArg = arg;
     }
     void setErrorHandler(ErrorHandler handler, void* arg) override {
-        _errorHandler = handler;
+        _errorHandler = std::move(handler);
         _errorArg = arg;
     }
     void setTimeout(uint32_t timeoutMs) override {
@@ -33,7 +34,7 @@ class AsyncTcpTransport : public AsyncTransport {
     }
     void setTimeoutHandler(TimeoutHandler handler, void* arg) override {
 #if ASYNC_TCP_HAS_TIMEOUT
-        _timeoutHandler = handler;
+        _timeoutHandler = std::move(handler);
         _timeoutArg = arg;
         if (_client) {
             _client->onTimeout(
@@ -53,7 +54,7 @@ class AsyncTcpTransport : public AsyncTransport {
     bool connect(const char* host, uint16_t port) override {
         if (!_client)
             return false;
-        return _client->connect(host, port);
+        return connectResolving(_client, host, port);
     }
     size_t write(const char* data, size_t len) override {
         if (!_client)
@@ -89,8 +90,8 @@ class AsyncTcpTransport : public AsyncTransport {
 
   private:
     static void handleConnectThunk(void* arg, AsyncClient* client) {
-        (void)client;
         auto self = static_cast<AsyncTcpTransport*>(arg);
+        applySocketOptions(client, self->_options);
         if (self->_connectHandler)
             self->_connectHandler(self->_connectArg, self);
     }
@@ -115,6 +116,7 @@ class AsyncTcpTransport : public AsyncTransport {
     }
 
     AsyncClient* _client;
+    AsyncHttpSocketOptions _options;
     ConnectHandler _connectHandler = nullptr;
     DataHandler _dataHandler = nullptr;
     DisconnectHandler _disconnectHandler = nullptr;
@@ -127,7 +129,7 @@ class AsyncTcpTransport : public AsyncTransport {
     void* _timeoutArg = nullptr;
 };
 
-AsyncTcpTransport::AsyncTcpTransport() {
+AsyncTcpTransport::AsyncTcpTransport(const AsyncHttpSocketOptions& options) : _options(options) {
     _client = new AsyncClient();
     _client->onConnect(handleConnectThunk, this);
     _client->onData(handleDataThunk, this);
@@ -148,6 +150,14 @@ AsyncTcpTransport::~AsyncTcpTransport() {
     }
 }
 
-AsyncTransport* createTcpTransport() {
-    return new AsyncTcpTransport();
+AsyncTransport* createTcpTransport(const AsyncHttpSocketOptions& options) {
+    return new AsyncTcpTransport(options);
+}
+
+void applySocketOptions(AsyncClient* client, const AsyncHttpSocketOptions& options) {
+    if (!client)
+        return;
+    client->setNoDelay(options.noDelay);
+    if (options.keepAliveIntervalMs > 0)
+        client->setKeepAlive(options.keepAliveIntervalMs, options.keepAliveCount);
 }
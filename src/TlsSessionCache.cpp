@@ -0,0 +1,131 @@
+#include "TlsSessionCache.h"
+
+namespace {
+
+// Saved sessions carry the master secret: overwrite it before the memory goes back to the heap.
+void wipe(std::vector<uint8_t>& data) {
+    volatile uint8_t* p = data.data();
+    for (size_t i = 0; i < data.size(); ++i)
+        p[i] = 0;
+    data.clear();
+}
+
+} // namespace
+
+void TlsSessionCache::configure(const AsyncHttpTlsSessionConfig& config) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _config = config;
+    if (!_config.enabled) {
+        while (!_entries.empty())
+            erase(_entries.size() - 1);
+    }
+}
+
+AsyncHttpTlsSessionConfig TlsSessionCache::config() const {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _config;
+}
+
+bool TlsSessionCache::lookup(const std::string& key, uint32_t nowMs, std::vector<uint8_t>* out) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_config.enabled)
+        return false;
+    Entry* entry = find(key);
+    if (!entry)
+        return false;
+    if (nowMs - entry->createdMs >= _config.maxAgeMs) {
+        erase(entry - _entries.data());
+        _stats.expired++;
+        return false;
+    }
+    entry->lastUsedMs = nowMs;
+    if (out)
+        *out = entry->data;
+    return true;
+}
+
+void TlsSessionCache::store(const std::string& key, const uint8_t* data, size_t len, bool resumed, uint32_t nowMs) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_config.enabled || _config.maxEntries == 0 || !data || len == 0)
+        return;
+    Entry* entry = find(key);
+    if (entry) {
+        wipe(entry->data);
+        if (!resumed)
+            entry->createdMs = nowMs;
+    } else {
+        evictIfFull();
+        _entries.emplace_back();
+        entry = &_entries.back();
+        entry->key = key;
+        entry->createdMs = nowMs;
+    }
+    entry->data.assign(data, data + len);
+    entry->lastUsedMs = nowMs;
+    _stats.stored++;
+}
+
+bool TlsSessionCache::remove(const std::string& key) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    Entry* entry = find(key);
+    if (!entry)
+        return false;
+    erase(entry - _entries.data());
+    return true;
+}
+
+void TlsSessionCache::recordHandshake(bool offered, bool resumed) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (offered)
+        _stats.offered++;
+    if (resumed)
+        _stats.resumed++;
+    else
+        _stats.full++;
+}
+
+void TlsSessionCache::clear() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    while (!_entries.empty())
+        erase(_entries.size() - 1);
+    _stats = AsyncHttpTlsSessionStats();
+}
+
+AsyncHttpTlsSessionStats TlsSessionCache::stats() const {
+    std::lock_guard<std::mutex> guard(_mutex);
+    AsyncHttpTlsSessionStats stats = _stats;
+    stats.entries = _entries.size();
+    for (const Entry& entry : _entries)
+        stats.bytes += entry.data.size();
+    return stats;
+}
+
+TlsSessionCache::Entry* TlsSessionCache::find(const std::string& key) {
+    for (Entry& entry : _entries) {
+        if (entry.key == key)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void TlsSessionCache::erase(size_t index) {
+    wipe(_entries[index].data);
+    _entries.erase(_entries.begin() + index);
+}
+
+void TlsSessionCache::evictIfFull() {
+    while (!_entries.empty() && _entries.size() >= _config.maxEntries) {
+        size_t victim = 0;
+        for (size_t i = 1; i < _entries.size(); ++i) {
+            if ((int32_t)(_entries[i].lastUsedMs - _entries[victim].lastUsedMs) < 0)
+                victim = i;
+        }
+        erase(victim);
+        _stats.evictions++;
+    }
+}
+
+TlsSessionCache& TlsSessionCache::shared() {
+    static TlsSessionCache cache;
+    return cache;
+}
@@ -0,0 +1,75 @@
+/**
+ * Client-side TLS session cache for the TLS transport.
+ *
+ * After a full handshake the transport saves the session under the connection's pool key, and the next
+ * connection to that origin offers it so the server can resume instead of running a full handshake. Entries
+ * expire `maxAgeMs` after their full handshake; their bytes hold the master secret and are wiped on removal.
+ */
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct AsyncHttpTlsSessionConfig {
+    bool enabled = true;         // off: every connection runs a full handshake (cached sessions are dropped)
+    uint32_t maxAgeMs = 3600000; // lifetime of a session, counted from its full handshake
+    uint8_t maxEntries = 4;      // the least recently used session is evicted beyond this
+};
+
+struct AsyncHttpTlsSessionStats {
+    uint32_t offered = 0; // handshakes that offered a cached session
+    uint32_t resumed = 0; // ...and were resumed by the server
+    uint32_t full = 0;    // completed handshakes that were not resumptions
+    uint32_t stored = 0;  // sessions saved after a handshake
+    uint32_t expired = 0; // sessions dropped for their age
+    uint32_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0; // saved session data held by the cache
+};
+
+class TlsSessionCache {
+  public:
+    TlsSessionCache() {}
+    TlsSessionCache(const TlsSessionCache&) = delete;
+    TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+    // Disabling drops the cached sessions; a smaller maxEntries takes effect on the next store.
+    void configure(const AsyncHttpTlsSessionConfig& config);
+    AsyncHttpTlsSessionConfig config() const;
+
+    // Copies the saved session for `key` into *out. False when disabled, unknown or expired (then it is dropped).
+    bool lookup(const std::string& key, uint32_t nowMs, std::vector<uint8_t>* out);
+    // Saves the session of a completed handshake. A resumed one keeps the age of the session it resumed.
+    void store(const std::string& key, const uint8_t* data, size_t len, bool resumed, uint32_t nowMs);
+    bool remove(const std::string& key);
+    void recordHandshake(bool offered, bool resumed);
+
+    // Drops the sessions and resets the counters.
+    void clear();
+    AsyncHttpTlsSessionStats stats() const;
+
+    static TlsSessionCache& shared();
+
+  private:
+    struct Entry {
+        std::string key;
+        std::vector<uint8_t> data;
+        uint32_t createdMs = 0; // full handshake that established the session
+        uint32_t lastUsedMs = 0;
+    };
+
+    Entry* find(const std::string& key);
+    void erase(size_t index);
+    void evictIfFull();
+
+    mutable std::mutex _mutex;
+    AsyncHttpTlsSessionConfig _config;
+    std::vector<Entry> _entries;
+    AsyncHttpTlsSessionStats _stats;
+};
+
+#endif // TLS_SESSION_CACHE_H
@@ -1,4 +1,8 @@
 #include "AsyncTransport.h"
+#include "ConnectionPool.h"
+#include "HttpMemory.h"
+#include "ResolvingConnector.h"
+#include "TlsSessionCache.h"
 #include <Arduino.h>
 #include <AsyncTCP.h>
 #include <cstring>
@@ -8,30 +12,41 @@
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/pk.h>
+#include <mbedtls/platform_util.h>
 #include <mbedtls/sha256.h>
 #include <mbedtls/ssl.h>
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/version.h>
 
+// Saved sessions (mbedtls_ssl_session_save/load, 2.19+) are resumed over TLS 1.2; TLS 1.3 tickets arrive after the
+// handshake and are not cached.
+#if defined(MBEDTLS_VERSION_NUMBER) && (MBEDTLS_VERSION_NUMBER >= 0x02130000) && defined(MBEDTLS_SSL_PROTO_TLS1_2)
+#define ASYNC_HTTP_TLS_SESSION_CACHE 1
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member // 2.x: session fields are public
+#endif
+#endif
+
 class AsyncTlsTransport : public AsyncTransport {
   public:
-    explicit AsyncTlsTransport(const AsyncHttpTLSConfig& config);
+    AsyncTlsTransport(const AsyncHttpTLSConfig& config, const AsyncHttpSocketOptions& options,
+                      const std::string& poolKey);
     ~AsyncTlsTransport() override;
 
     void setConnectHandler(ConnectHandler handler, void* arg) override {
-        _connectHandler = handler;
+        _connectHandler = std::move(handler);
         _connectArg = arg;
     }
     void setDataHandler(DataHandler handler, void* arg) override {
-        _dataHandler = handler;
+        _dataHandler = std::move(handler);
         _dataArg = arg;
     }
     void setDisconnectHandler(DisconnectHandler handler, void* arg) override {
-        _disconnectHandler = handler;
+        _disconnectHandler = std::move(handler);
         _disconnectArg = arg;
     }
     void setErrorHandler(ErrorHandler handler, void* arg) override {
-        _errorHandler = handler;
+        _errorHandler = std::move(handler);
         _errorArg = arg;
     }
     void setTimeout(uint32_t timeoutMs) override {
@@ -44,7 +59,7 @@ class AsyncTlsTransport : public AsyncTransport {
     }
     void setTimeoutHandler(TimeoutHandler handler, void* arg) override {
 #if ASYNC_TCP_HAS_TIMEOUT
-        _timeoutHandler = handler;
+        _timeoutHandler = std::move(handler);
         _timeoutArg = arg;
         if (_client) {
             _client->onTimeout(
@@ -82,8 +97,9 @@ class AsyncTlsTransport : public AsyncTransport {
     enum class State { Idle, TcpConnecting, Handshaking, Established, Closed, Failed };
 
     static void handleTcpConnectThunk(void* arg, AsyncClient* client) {
-        (void)client;
-        static_cast<AsyncTlsTransport*>(arg)->handleTcpConnect();
+        auto self = static_cast<AsyncTlsTransport*>(arg);
+        applySocketOptions(client, self->_options);
+        self->handleTcpConnect();
     }
     static void handleTcpDataThunk(void* arg, AsyncClient* client, void* data, size_t len) {
         (void)client;
@@ -113,9 +129,13 @@ class AsyncTlsTransport : public AsyncTransport {
     bool verifyFingerprint();
     void resetBuffers();
     void shutdownClient();
+    void offerCachedSession();
+    void storeSession();
+    void forgetOfferedSession();
 
     AsyncClient* _client;
     AsyncHttpTLSConfig _config;
+    AsyncHttpSocketOptions _options;
     ConnectHandler _connectHandler = nullptr;
     DataHandler _dataHandler = nullptr;
     DisconnectHandler _disconnectHandler = nullptr;
@@ -131,7 +151,7 @@ class AsyncTlsTransport : public AsyncTransport {
     State _state = State::Idle;
     uint32_t _handshakeStartMs = 0;
 
-    std::vector<uint8_t> _encryptedBuffer;
+    std::vector<uint8_t, HttpMemoryAllocator<uint8_t, AsyncHttpBufferKind::kTlsRecord>> _encryptedBuffer;
     size_t _encryptedOffset = 0;
     std::vector<uint8_t> _fingerprintBytes;
     bool _fingerprintInvalid = false;
@@ -144,6 +164,12 @@ class AsyncTlsTransport : public AsyncTransport {
     mbedtls_entropy_context _entropy;
     mbedtls_ctr_drbg_context _ctrDrbg;
     bool _sslReady = false;
+#if ASYNC_HTTP_TLS_SESSION_CACHE
+    std::string _poolKey;    // the client's key for this connection; sessions are cached under it
+    std::string _sessionKey; // empty: the session cache is not used for this connection
+    mbedtls_ssl_session _offeredSession;
+    bool _sessionOffered = false;
+#endif
 };
 
 static int hexValue(char c) {
@@ -188,7 +214,9 @@ static std::vector<uint8_t> parseFingerprintString(const String& text, bool* out
     return bytes;
 }
 
-AsyncTlsTransport::AsyncTlsTransport(const AsyncHttpTLSConfig& config) : _client(new AsyncClient()), _config(config) {
+AsyncTlsTransport::AsyncTlsTransport(const AsyncHttpTLSConfig& config, const AsyncHttpSocketOptions& options,
+                                     const std::string& poolKey)
+    : _client(new AsyncClient()), _config(config), _options(options) {
     _client->onConnect(handleTcpConnectThunk, this);
     _client->onData(handleTcpDataThunk, this);
     _client->onDisconnect(handleTcpDisconnectThunk, this);
@@ -200,6 +228,12 @@ AsyncTlsTransport::AsyncTlsTransport(const AsyncHttpTLSConfig& config) : _client
     mbedtls_pk_init(&_clientKey);
     mbedtls_entropy_init(&_entropy);
     mbedtls_ctr_drbg_init(&_ctrDrbg);
+#if ASYNC_HTTP_TLS_SESSION_CACHE
+    _poolKey = poolKey;
+    mbedtls_ssl_session_init(&_offeredSession);
+#else
+    (void)poolKey;
+#endif
     bool fpValid = true;
     _fingerprintBytes = parseFingerprintString(_config.fingerprint, &fpValid);
     _fingerprintInvalid = (_config.fingerprint.length() > 0 && !fpValid);
@@ -214,6 +248,9 @@ AsyncTlsTransport::~AsyncTlsTransport() {
     mbedtls_pk_free(&_clientKey);
     mbedtls_ctr_drbg_free(&_ctrDrbg);
     mbedtls_entropy_free(&_entropy);
+#if ASYNC_HTTP_TLS_SESSION_CACHE
+    mbedtls_ssl_session_free(&_offeredSession);
+#endif
 }
 
 void AsyncTlsTransport::shutdownClient() {
@@ -240,7 +277,8 @@ bool AsyncTlsTransport::connect(const char* host, uint16_t port) {
     _port = port;
     _handshakeStartMs = millis();
     _state = State::TcpConnecting;
-    return _client->connect(host, port);
+    // _host keeps the name for SNI and certificate checks; the socket connects to the resolved address.
+    return connectResolving(_client, host, port);
 }
 
 void AsyncTlsTransport::handleTcpConnect() {
@@ -257,6 +295,9 @@ void AsyncTlsTransport::handleTcpConnect() {
 void AsyncTlsTransport::resetBuffers() {
     _encryptedBuffer.clear();
     _encryptedOffset = 0;
+    // Kept across records (clear() does not release it): one allocation instead of growing record by record.
+    if (_options.rxBufferHint > _encryptedBuffer.capacity())
+        _encryptedBuffer.reserve(_options.rxBufferHint);
 }
 
 bool AsyncTlsTransport::setupSsl() {
@@ -302,10 +343,76 @@ bool AsyncTlsTransport::setupSsl() {
     if (_host.length() > 0)
         mbedtls_ssl_set_hostname(&_ssl, _host.c_str());
     mbedtls_ssl_set_bio(&_ssl, this, sslSend, sslRecv, nullptr);
+    offerCachedSession();
     _sslReady = true;
     return true;
 }
 
+void AsyncTlsTransport::offerCachedSession() {
+#if ASYNC_HTTP_TLS_SESSION_CACHE
+#if !defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+    // A resumed session would have no peer certificate to check the fingerprint against.
+    if (!_fingerprintBytes.empty())
+        return;
+#endif
+    // The client's pool key comes from the request's TLS profile; _config is this connection's copy, which a deadline
+    // may have adjusted.
+    _sessionKey = _poolKey.empty() ? ConnectionPool::makeKey(_host.c_str(), _port, true, _config) : _poolKey;
+    std::vector<uint8_t> saved;
+    if (!TlsSessionCache::shared().lookup(_sessionKey, millis(), &saved))
+        return;
+    bool loaded = mbedtls_ssl_session_load(&_offeredSession, saved.data(), saved.size()) == 0 &&
+                  mbedtls_ssl_set_session(&_ssl, &_offeredSession) == 0;
+    mbedtls_platform_zeroize(saved.data(), saved.size());
+    if (!loaded) {
+        // Saved by a differently configured mbedTLS, or corrupt: not worth offering again.
+        mbedtls_ssl_session_free(&_offeredSession);
+        TlsSessionCache::shared().remove(_sessionKey);
+        return;
+    }
+    _sessionOffered = true;
+#endif
+}
+
+void AsyncTlsTransport::storeSession() {
+#if ASYNC_HTTP_TLS_SESSION_CACHE
+    if (_sessionKey.empty())
+        return;
+    mbedtls_ssl_session current;
+    mbedtls_ssl_session_init(&current);
+    bool exported = mbedtls_ssl_get_session(&_ssl, &current) == 0;
+#if MBEDTLS_VERSION_NUMBER >= 0x03020000
+    exported = exported && mbedtls_ssl_get_version_number(&_ssl) == MBEDTLS_SSL_VERSION_TLS1_2;
+#endif
+    if (exported) {
+        // A resumed TLS 1.2 handshake keeps the master secret of the offered session; a full one derives a new one.
+        const unsigned char* offeredMaster = _offeredSession.MBEDTLS_PRIVATE(master);
+        bool resumed = _sessionOffered && std::memcmp(current.MBEDTLS_PRIVATE(master), offeredMaster,
+                                                      sizeof(current.MBEDTLS_PRIVATE(master))) == 0;
+        TlsSessionCache::shared().recordHandshake(_sessionOffered, resumed);
+        size_t len = 0;
+        mbedtls_ssl_session_save(&current, nullptr, 0, &len); // sizes the buffer
+        if (len > 0) {
+            std::vector<uint8_t> saved(len);
+            if (mbedtls_ssl_session_save(&current, saved.data(), saved.size(), &len) == 0)
+                TlsSessionCache::shared().store(_sessionKey, saved.data(), len, resumed, millis());
+            mbedtls_platform_zeroize(saved.data(), saved.size());
+        }
+    }
+    mbedtls_ssl_session_free(&current);
+    mbedtls_ssl_session_free(&_offeredSession);
+#endif
+}
+
+void AsyncTlsTransport::forgetOfferedSession() {
+#if ASYNC_HTTP_TLS_SESSION_CACHE
+    // The handshake that offered it failed: the next connection starts over with a full handshake.
+    if (_sessionOffered)
+        TlsSessionCache::shared().remove(_sessionKey);
+    _sessionOffered = false;
+#endif
+}
+
 void AsyncTlsTransport::continueHandshake() {
     if (!_sslReady || _state != State::Handshaking)
         return;
@@ -314,6 +421,7 @@ void AsyncTlsTransport::continueHandshake() {
         if (rc == 0) {
             if (!verifyPeerCertificate())
                 return;
+            storeSession();
             _state = State::Established;
             if (_connectHandler)
                 _connectHandler(_connectArg, this);
@@ -395,6 +503,8 @@ void AsyncTlsTransport::flushApplicationData() {
 void AsyncTlsTransport::handleTcpDisconnect() {
     if (_state == State::Closed || _state == State::Failed)
         return;
+    if (_state == State::Handshaking)
+        forgetOfferedSession();
     _state = State::Closed;
     if (_disconnectHandler)
         _disconnectHandler(_disconnectArg, this);
@@ -481,6 +591,8 @@ void AsyncTlsTransport::fail(HttpClientError code, const char* message, int deta
     (void)detail;
     if (_state == State::Failed || _state == State::Closed)
         return;
+    if (_state == State::Handshaking)
+        forgetOfferedSession();
     _state = State::Failed;
     if (_errorHandler)
         _errorHandler(_errorArg, this, code, message);
@@ -549,11 +661,14 @@ class AsyncTlsTransport : public AsyncTransport {
 };
 #endif
 
-AsyncTransport* createTlsTransport(const AsyncHttpTLSConfig& config) {
+AsyncTransport* createTlsTransport(const AsyncHttpTLSConfig& config, const AsyncHttpSocketOptions& options,
+                                   const std::string& poolKey) {
 #if defined(ARDUINO_ARCH_ESP32)
-    return new AsyncTlsTransport(config);
+    return new AsyncTlsTransport(config, options, poolKey);
 #else
     (void)config;
+    (void)options;
+    (void)poolKey;
     return nullptr;
 #endif
 }
@@ -0,0 +1,159 @@
+/**
+ * Transport that captures the client's handlers so tests can play the server side.
+ *
+ * Shared by the Arduino-side suites. Include it after AsyncHttpClient.h (which the suites pull in with
+ * `#define private public`). installFakeTransports() routes every connection of a client to a new FakeTransport and
+ * collects them in gTransports, in the order the client opened them; the transports are owned (and deleted) by the
+ * client.
+ *
+ * Options, reset by installFakeTransports():
+ *  - FakeTransport::gConnectSucceeds: false makes every connect() fail immediately.
+ *  - FakeTransport::gRefused: hosts whose connect() fails immediately.
+ *  - FakeTransport::gRecordWrites: keep the written bytes (`written`) and the size of every write (`writes`). Off by
+ *    default so the transport does not allocate while the client writes.
+ */
+#ifndef FAKE_TRANSPORT_H
+#define FAKE_TRANSPORT_H
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AsyncHttpClient.h"
+
+class FakeTransport : public AsyncTransport {
+  public:
+    void setConnectHandler(ConnectHandler handler, void* arg) override {
+        (void)arg;
+        onConnect = std::move(handler);
+    }
+    void setDataHandler(DataHandler handler, void* arg) override {
+        (void)arg;
+        onData = std::move(handler);
+    }
+    void setDisconnectHandler(DisconnectHandler handler, void* arg) override {
+        (void)arg;
+        onDisconnect = std::move(handler);
+    }
+    void setErrorHandler(ErrorHandler handler, void* arg) override {
+        (void)arg;
+        onError = std::move(handler);
+    }
+    void setTimeout(uint32_t timeoutMs) override {
+        (void)timeoutMs;
+    }
+    void setTimeoutHandler(TimeoutHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    bool connect(const char* host, uint16_t port) override {
+        this->host = host;
+        this->port = port;
+        return gConnectSucceeds && (gRefused.empty() || gRefused.count(host) == 0);
+    }
+    size_t write(const char* data, size_t len) override {
+        if (gRecordWrites) {
+            written.append(data, len);
+            writes.push_back(len);
+        }
+        return len;
+    }
+    bool canSend() const override {
+        return !closed;
+    }
+    void close(bool now = false) override {
+        (void)now;
+        closed = true;
+    }
+    bool isSecure() const override {
+        return false;
+    }
+    bool isHandshaking() const override {
+        return false;
+    }
+    uint32_t getHandshakeStartMs() const override {
+        return 0;
+    }
+    uint32_t getHandshakeTimeoutMs() const override {
+        return 0;
+    }
+
+    ~FakeTransport() override {
+        gDestroyed++;
+    }
+
+    // The client may delete the transport from inside these handlers: invoke copies and do not touch members after.
+
+    // Accepts the connection, then sends the response.
+    void serve(const char* response) {
+        ConnectHandler connectCb = onConnect;
+        DataHandler dataCb = onData;
+        connectCb(nullptr, this);
+        std::vector<char> buf(response, response + strlen(response));
+        dataCb(nullptr, this, buf.data(), buf.size());
+    }
+    // Completes the connection (TCP connect, or the TLS handshake for a TLS transport).
+    void accept() {
+        ConnectHandler connectCb = onConnect;
+        connectCb(nullptr, this);
+    }
+    // Response on a connection that is already open.
+    void respond(const char* response) {
+        DataHandler dataCb = onData;
+        std::vector<char> buf(response, response + strlen(response));
+        dataCb(nullptr, this, buf.data(), buf.size());
+    }
+    // The server closes the connection.
+    void disconnect() {
+        closed = true;
+        DisconnectHandler disconnectCb = onDisconnect;
+        disconnectCb(nullptr, this);
+    }
+    void fail(HttpClientError error = CONNECTION_FAILED) {
+        ErrorHandler errorCb = onError;
+        errorCb(nullptr, this, error, httpClientErrorToString(error));
+    }
+
+    static inline int gDestroyed = 0;
+    static inline bool gConnectSucceeds = true;
+    static inline std::set<std::string> gRefused;
+    static inline bool gRecordWrites = false;
+
+    ConnectHandler onConnect;
+    DataHandler onData;
+    DisconnectHandler onDisconnect;
+    ErrorHandler onError;
+    String host;
+    uint16_t port = 0;
+    bool closed = false;
+    std::string written;
+    std::vector<size_t> writes;
+};
+
+inline std::vector<FakeTransport*> gTransports;
+
+// Creates the transport for a connection: a test can return a FakeTransport subclass or look at the TLS settings.
+using FakeTransportMaker = FakeTransport* (*)(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls);
+
+inline FakeTransport* makePlainFakeTransport(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls) {
+    (void)request;
+    (void)tls;
+    return new FakeTransport();
+}
+
+inline void installFakeTransports(AsyncHttpClient& client, FakeTransportMaker make = makePlainFakeTransport) {
+    gTransports.clear();
+    FakeTransport::gDestroyed = 0;
+    FakeTransport::gConnectSucceeds = true;
+    FakeTransport::gRefused.clear();
+    FakeTransport::gRecordWrites = false;
+    client.setTransportFactory([make](const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls) {
+        FakeTransport* t = make(request, tls);
+        gTransports.push_back(t);
+        return static_cast<AsyncTransport*>(t);
+    });
+}
+
+#endif // FAKE_TRANSPORT_H
@@ -0,0 +1,46 @@
+/**
+ * Completion counters and handlers shared by the Arduino-side suites.
+ *
+ * Include it after AsyncHttpClient.h. onOk()/onErr() count every completion and keep the last status, body and error;
+ * resetCounters() clears them at the start of a test. kOk is a complete response that closes the connection.
+ */
+#ifndef TEST_CALLBACKS_H
+#define TEST_CALLBACKS_H
+
+#include <memory>
+
+#include "AsyncHttpClient.h"
+
+inline int gSuccess = 0;
+inline int gErrors = 0;
+inline int gAborted = 0;
+inline HttpClientError gLastError = CONNECTION_FAILED;
+inline int gLastStatus = 0;
+inline String gLastBody;
+
+inline void resetCounters() {
+    gSuccess = 0;
+    gErrors = 0;
+    gAborted = 0;
+    gLastError = CONNECTION_FAILED;
+    gLastStatus = 0;
+    gLastBody = "";
+}
+
+inline void onOk(std::shared_ptr<AsyncHttpResponse> response) {
+    gSuccess++;
+    gLastStatus = response->getStatusCode();
+    gLastBody = response->getBody();
+}
+
+inline void onErr(HttpClientError error, const char* message) {
+    (void)message;
+    gErrors++;
+    gLastError = error;
+    if (error == ABORTED)
+        gAborted++;
+}
+
+inline const char* const kOk = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+
+#endif // TEST_CALLBACKS_H
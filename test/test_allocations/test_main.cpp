@@ -0,0 +1,210 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+
+// Counts every heap allocation made through operator new (the client, Arduino String and std containers).
+static volatile size_t gAllocations = 0;
+
+void* operator new(size_t size) {
+    gAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        abort();
+    return p;
+}
+void operator delete(void* p) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static std::vector<size_t> gBindingAllocations; // per connection, recorded when the transport is destroyed
+static std::vector<size_t> gSerializationAllocations;
+
+// Snapshots the allocation counter when the client starts installing handlers and when it connects: everything in
+// between is handler binding.
+class RecordingTransport : public FakeTransport {
+  public:
+    void setConnectHandler(ConnectHandler handler, void* arg) override {
+        allocationsAtFirstHandler = gAllocations;
+        FakeTransport::setConnectHandler(std::move(handler), arg);
+    }
+    bool connect(const char* host, uint16_t port) override {
+        allocationsAtConnect = gAllocations;
+        return FakeTransport::connect(host, port);
+    }
+    size_t write(const char* data, size_t len) override {
+        allocationsAtWrite = gAllocations;
+        return FakeTransport::write(data, len);
+    }
+    ~RecordingTransport() override {
+        gBindingAllocations.push_back(allocationsAtConnect - allocationsAtFirstHandler);
+        gSerializationAllocations.push_back(allocationsAtWrite - allocationsAtServe);
+    }
+    // serve() -> write(): serializing the request.
+    void serve(const char* response) {
+        allocationsAtServe = gAllocations;
+        FakeTransport::serve(response);
+    }
+
+    size_t allocationsAtFirstHandler = 0;
+    size_t allocationsAtConnect = 0;
+    size_t allocationsAtServe = 0;
+    size_t allocationsAtWrite = 0;
+};
+
+static FakeTransport* makeRecordingTransport(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls) {
+    (void)request;
+    (void)tls;
+    return new RecordingTransport();
+}
+
+static void installRecordingTransports(AsyncHttpClient& client) {
+    installFakeTransports(client, makeRecordingTransport);
+    gTransports.reserve(8);
+    gBindingAllocations.clear();
+    gSerializationAllocations.clear();
+    gBindingAllocations.reserve(8);
+    gSerializationAllocations.reserve(8);
+}
+
+static RecordingTransport* transportAt(size_t index) {
+    return static_cast<RecordingTransport*>(gTransports[index]);
+}
+
+static const char* kOkResponse = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+static int gSuccess = 0;
+
+static void onOk(std::shared_ptr<AsyncHttpResponse> response) {
+    (void)response;
+    gSuccess++;
+}
+
+static size_t runOneGet(AsyncHttpClient& client) {
+    size_t before = gAllocations;
+    client.get("http://api.example/data", onOk);
+    client.loop();
+    transportAt(gTransports.size() - 1)->serve(kOkResponse);
+    return gAllocations - before;
+}
+
+static void test_installing_transport_handlers_does_not_allocate() {
+    AsyncHttpClient client;
+    installRecordingTransports(client);
+    AsyncHttpRetryPolicy retry;
+    retry.maxAttempts = 2;
+    retry.baseDelayMs = 0;
+    client.setRetryPolicy(retry);
+    client.get("http://api.example/data", onOk);
+    client.loop();
+    gTransports[0]->fail(); // second attempt on a new connection reuses the handlers bound for the context
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    transportAt(1)->serve(kOkResponse);
+    TEST_ASSERT_EQUAL(2, (int)gBindingAllocations.size());
+    TEST_ASSERT_EQUAL(0, (int)gBindingAllocations[0]);
+    TEST_ASSERT_EQUAL(0, (int)gBindingAllocations[1]);
+}
+
+static void test_allocations_per_request() {
+    gSuccess = 0;
+    AsyncHttpClient client;
+    installRecordingTransports(client);
+    runOneGet(client); // warm-up: lazily created client state
+    const int kRuns = 8;
+    size_t total = 0;
+    for (int i = 0; i < kRuns; ++i)
+        total += runOneGet(client);
+    TEST_ASSERT_EQUAL(kRuns + 1, gSuccess);
+
+    // What the handler binding used to cost: five std::function objects capturing the client and a shared_ptr to
+    // the context, built on every connection.
+    std::shared_ptr<int> context = std::make_shared<int>(0);
+    size_t before = gAllocations;
+    {
+        std::function<void(void*, AsyncTransport*)> handlers[5];
+        for (auto& handler : handlers)
+            handler = [&client, context](void*, AsyncTransport*) { (void)client; };
+    }
+    size_t stdFunctionBinding = gAllocations - before;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "allocations per GET: %u (handler binding: 0; std::function binding was +%u)",
+             (unsigned)(total / kRuns), (unsigned)stdFunctionBinding);
+    TEST_MESSAGE(msg);
+}
+
+static const char* kHeavyResponse = "HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: application/json; charset=utf-8\r\n"
+                                   "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+                                   "X-Request-Identifier: 5f1c2a7e-8d4b-4c3e-9a61-0b7d2e4f9c13\r\n"
+                                   "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+                                   "Transfer-Encoding: chunked\r\n"
+                                   "Connection: close";
+
+static void test_request_arena_replaces_transient_strings() {
+    AsyncHttpPoolConfig pools;
+    pools.arenas = 2; // arena slabs recycled across requests
+    TEST_ASSERT_TRUE(AsyncHttpClient::configureObjectPools(pools));
+    {
+        AsyncHttpClient client;
+        installRecordingTransports(client);
+        client.setHeader("X-Device-Identifier", "esp32-sensor-node-0042-livingroom");
+        runOneGet(client); // warm-up: the arena pool reserves its slab
+        runOneGet(client);
+        size_t serialization = gSerializationAllocations.back(); // the transport is gone once the response is done
+        TEST_ASSERT_EQUAL(0, (int)serialization);
+
+        // The String builder the client used before, for comparison.
+        std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(HTTP_METHOD_GET, "http://api.example/data"));
+        request->setHeader("X-Device-Identifier", "esp32-sensor-node-0042-livingroom");
+        size_t before = gAllocations;
+        String legacy = request->buildHttpRequest();
+        size_t stringSerialization = gAllocations - before;
+
+        // Header parsing only allocates what the response keeps: the header vector (reserved once) and the stored
+        // names and values. The status text "OK" and most names fit the small-string buffer where there is one.
+        auto ctx = client.makeContext();
+        ctx->request = std::move(request);
+        ctx->response = client.makeResponse();
+        before = gAllocations;
+        TEST_ASSERT_TRUE(client.parseResponseHeaders(ctx.get(), kHeavyResponse, strlen(kHeavyResponse)));
+        size_t parsing = gAllocations - before;
+        const size_t kHeaders = 6;
+        TEST_ASSERT_TRUE(parsing <= 2 + 2 * kHeaders);
+        TEST_ASSERT_TRUE(ctx->response->getHeader("Transfer-Encoding") == "chunked");
+        TEST_ASSERT_EQUAL(0, (int)ctx->arena.stats().overflows);
+
+        char msg[200];
+        snprintf(msg, sizeof(msg),
+                 "request serialization: 0 allocations (String builder: %u); parsing %u headers: %u (stored copies)",
+                 (unsigned)stringSerialization, (unsigned)kHeaders, (unsigned)parsing);
+        TEST_MESSAGE(msg);
+    }
+    TEST_ASSERT_TRUE(AsyncHttpClient::configureObjectPools(AsyncHttpPoolConfig()));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_installing_transport_handlers_does_not_allocate);
+    RUN_TEST(test_allocations_per_request);
+    RUN_TEST(test_request_arena_replaces_transient_strings);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static std::vector<std::unique_ptr<AsyncHttpRequest>> makeRequests(size_t count) {
+    std::vector<std::unique_ptr<AsyncHttpRequest>> requests;
+    for (size_t i = 0; i < count; ++i) {
+        String url = String("http://host") + String((int)i) + ".example/item";
+        requests.emplace_back(new AsyncHttpRequest(HTTP_METHOD_GET, url));
+    }
+    return requests;
+}
+
+static void test_batch_aggregates_results_in_order() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    int completions = 0;
+    std::vector<AsyncHttpClient::BatchItemResult> seen;
+    uint32_t id = client.batch(makeRequests(3), [&](const std::vector<AsyncHttpClient::BatchItemResult>& results) {
+        completions++;
+        seen = results;
+    });
+    TEST_ASSERT_NOT_EQUAL(0, id);
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests[0]->onSuccess.operator bool());
+
+    // Complete out of order; results stay at the submitted index.
+    gTransports[2]->serve(kOk);
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(0, completions);
+    gTransports[1]->serve(kOk);
+
+    TEST_ASSERT_EQUAL(1, completions);
+    TEST_ASSERT_EQUAL(3, (int)seen.size());
+    TEST_ASSERT_FALSE(seen[0].success);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, seen[0].error);
+    TEST_ASSERT_TRUE(seen[1].success);
+    TEST_ASSERT_EQUAL(200, seen[1].response->getStatusCode());
+    TEST_ASSERT_TRUE(seen[2].success);
+    TEST_ASSERT_EQUAL_STRING("ok", seen[2].response->getBody().c_str());
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+}
+
+static void test_batch_respects_parallel_limit() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpClient::BatchOptions options;
+    options.maxParallel = 2;
+    int completions = 0;
+    client.batch(makeRequests(5), [&](const std::vector<AsyncHttpClient::BatchItemResult>&) { completions++; },
+                 options);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[0]->serve(kOk);
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    TEST_ASSERT_EQUAL_STRING("host2.example", gTransports[2]->host.c_str());
+    for (size_t i = 1; i < 5; ++i) {
+        TEST_ASSERT_TRUE(gTransports.size() > i);
+        gTransports[i]->serve(kOk);
+    }
+    TEST_ASSERT_EQUAL(5, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(1, completions);
+}
+
+static void test_batch_fail_fast_aborts_remaining() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpClient::BatchOptions options;
+    options.maxParallel = 2;
+    options.failFast = true;
+    int completions = 0;
+    std::vector<AsyncHttpClient::BatchItemResult> seen;
+    client.batch(
+        makeRequests(4),
+        [&](const std::vector<AsyncHttpClient::BatchItemResult>& results) {
+            completions++;
+            seen = results;
+        },
+        options);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[1]->fail();
+
+    TEST_ASSERT_EQUAL(1, completions);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size()); // items 2 and 3 never started
+    TEST_ASSERT_EQUAL(ABORTED, seen[0].error);     // in flight, aborted
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, seen[1].error);
+    TEST_ASSERT_EQUAL(ABORTED, seen[2].error);
+    TEST_ASSERT_EQUAL(0, (int)seen[2].requestId);
+    TEST_ASSERT_EQUAL(ABORTED, seen[3].error);
+    TEST_ASSERT_EQUAL(2, FakeTransport::gDestroyed); // in-flight connection torn down
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+}
+
+static void test_batch_abort_and_edge_cases() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+
+    int completions = 0;
+    size_t emptySize = 99;
+    client.batch(std::vector<std::unique_ptr<AsyncHttpRequest>>(),
+                 [&](const std::vector<AsyncHttpClient::BatchItemResult>& results) {
+                     completions++;
+                     emptySize = results.size();
+                 });
+    TEST_ASSERT_EQUAL(1, completions);
+    TEST_ASSERT_EQUAL(0, (int)emptySize);
+
+    std::vector<AsyncHttpClient::BatchItemResult> seen;
+    auto requests = makeRequests(2);
+    requests.emplace_back(nullptr);
+    uint32_t id = client.batch(std::move(requests), [&](const std::vector<AsyncHttpClient::BatchItemResult>& results) {
+        completions++;
+        seen = results;
+    });
+    TEST_ASSERT_EQUAL(1, completions);
+    TEST_ASSERT_TRUE(client.abortBatch(id));
+    TEST_ASSERT_FALSE(client.abortBatch(id));
+    TEST_ASSERT_EQUAL(2, completions);
+    TEST_ASSERT_EQUAL(ABORTED, seen[0].error);
+    TEST_ASSERT_EQUAL(ABORTED, seen[1].error);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, seen[2].error);
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_aggregates_results_in_order);
+    RUN_TEST(test_batch_respects_parallel_limit);
+    RUN_TEST(test_batch_fail_fast_aborts_remaining);
+    RUN_TEST(test_batch_abort_and_edge_cases);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,130 @@
+// Host/device benchmarks. Not part of the unit suites (left out of the esp32dev test_filter): run them on demand
+// with `pio test -e esp32dev -f test_benchmarks`. Timings are reported with TEST_MESSAGE; the assertions only check
+// that the measured work was done.
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+// With hundreds of queued requests, per-id aborts used to scan the active list and the pending queue for every call
+// (quadratic overall). They are an index lookup each, and abortGroup() is one pass.
+static double timeAbortsNs(bool useGroup, uint32_t count) {
+    gAborted = 0;
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setMaxParallel(1);
+    std::vector<uint32_t> ids;
+    ids.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(HTTP_METHOD_GET, "http://api.example/bench"));
+        request->setGroup(3);
+        ids.push_back(client.request(std::move(request), onOk, onErr));
+    }
+    client.loop();
+    TEST_ASSERT_EQUAL(count - 1, (uint32_t)client._pendingQueue.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (useGroup) {
+        TEST_ASSERT_EQUAL(count, (uint32_t)client.abortGroup(3));
+    } else {
+        // Newest first: the worst case for a front-to-back scan.
+        for (size_t i = ids.size(); i > 0; --i)
+            TEST_ASSERT_TRUE(client.abort(ids[i - 1]));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    TEST_ASSERT_EQUAL((int)count, gAborted);
+    client.loop(); // sheds any tombstones left behind
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(0, (int)client._contextsById.size());
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+}
+
+static void test_abort_benchmark_with_hundreds_queued() {
+    const uint32_t kQueued = 500;
+    double perIdNs = timeAbortsNs(false, kQueued);
+    double groupNs = timeAbortsNs(true, kQueued);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%u queued: abort(id) %.0f ns/request, abortGroup() %.0f ns/request",
+             (unsigned)kQueued, perIdNs, groupNs);
+    TEST_MESSAGE(msg);
+}
+
+// A PEM-sized CA bundle entry: the pool keys TLS connections by a digest of it instead of comparing the PEMs.
+static AsyncHttpTLSConfig makeTls(char fill) {
+    String pem = "-----BEGIN CERTIFICATE-----\n";
+    for (int line = 0; line < 32; ++line) {
+        for (int i = 0; i < 64; ++i)
+            pem += fill;
+        pem += '\n';
+    }
+    pem += "-----END CERTIFICATE-----\n";
+    AsyncHttpTLSConfig tls;
+    tls.caCert = pem;
+    return tls;
+}
+
+static void test_checkout_benchmark_32_idle_tls_connections() {
+    // 32 idle HTTPS connections: 8 hosts x 4 sockets, all with the same 2 KiB CA.
+    const int kHosts = 8;
+    const int kPerHost = 4;
+    const int kRounds = 2000;
+    AsyncHttpTLSConfig tls = makeTls('Q');
+    ConnectionPool pool(nullptr);
+    std::vector<std::unique_ptr<AsyncHttpRequest>> requests;
+    for (int h = 0; h < kHosts; ++h) {
+        String url = "https://device-" + String(h) + ".iot.example.com/telemetry";
+        requests.emplace_back(new AsyncHttpRequest(HTTP_METHOD_POST, url));
+        for (int i = 0; i < kPerHost; ++i)
+            pool.releaseConnectionToPool(new FakeTransport(), ConnectionPool::makeKey(requests.back().get(), tls));
+    }
+    const AsyncHttpRequest& target = *requests.back();
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        std::string key = ConnectionPool::makeKey(&target, tls); // once per attempt, includes the TLS digest
+        AsyncTransport* t = pool.checkoutPooledTransport(key, true);
+        TEST_ASSERT_NOT_NULL(t);
+        pool.releaseConnectionToPool(t, key);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::string cachedKey = ConnectionPool::makeKey(&target, tls);
+    for (int round = 0; round < kRounds; ++round) {
+        AsyncTransport* t = pool.checkoutPooledTransport(cachedKey, true);
+        TEST_ASSERT_NOT_NULL(t);
+        pool.releaseConnectionToPool(t, cachedKey);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double keyedNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / kRounds;
+    double lookupNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / kRounds;
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "32 idle TLS connections, 2 KiB CA, checkout + release: %.0f ns (%.0f ns with the attempt's key already "
+             "computed)",
+             keyedNs, lookupNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(kHosts * kPerHost, (int)pool.idleCount());
+
+    pool.dropAll(); // deletes the transports
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_abort_benchmark_with_hundreds_queued);
+    RUN_TEST(test_checkout_benchmark_32_idle_tls_connections);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,116 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+
+// Executor that parks tasks until the test runs them (stands in for an application task).
+static std::vector<CallbackExecutor::Task> gQueued;
+
+static std::shared_ptr<CallbackExecutor> makeQueueExecutor() {
+    return std::make_shared<FunctionCallbackExecutor>([](CallbackExecutor::Task&& task) {
+        gQueued.push_back(std::move(task));
+        return true;
+    });
+}
+
+static void runQueued() {
+    std::vector<CallbackExecutor::Task> tasks;
+    tasks.swap(gQueued);
+    for (auto& t : tasks)
+        t();
+}
+
+static AsyncHttpClient::RequestContext* makeContext() {
+    auto ctx = new AsyncHttpClient::RequestContext();
+    ctx->request.reset(new AsyncHttpRequest(HTTP_METHOD_GET, "http://example.com/"));
+    ctx->response = std::make_shared<AsyncHttpResponse>();
+    return ctx;
+}
+
+static void test_success_callback_runs_on_executor() {
+    gQueued.clear();
+    AsyncHttpClient client;
+    client.setCallbackExecutor(makeQueueExecutor());
+
+    bool called = false;
+    String body;
+    String streamed;
+    bool finalSeen = false;
+    client.onBodyChunk([&](const char* data, size_t len, bool final) {
+        if (data && len)
+            streamed.concat(data, len);
+        if (final)
+            finalSeen = true;
+    });
+    auto ctx = makeContext();
+    ctx->onSuccess = [&](std::shared_ptr<AsyncHttpResponse> resp) {
+        called = true;
+        body = resp->getBody();
+    };
+
+    char frame[] = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Type: text/plain\r\n\r\nhello";
+    client.handleData(ctx, frame, strlen(frame));
+    // Network context returned without running user code.
+    TEST_ASSERT_FALSE(called);
+    TEST_ASSERT_TRUE(gQueued.size() >= 2);
+    // Chunk bytes were copied: clobbering the receive buffer must not affect the deferred callback.
+    memset(frame, 'x', strlen(frame));
+
+    runQueued();
+    TEST_ASSERT_TRUE(called);
+    TEST_ASSERT_TRUE(finalSeen);
+    TEST_ASSERT_EQUAL_STRING("hello", body.c_str());
+    TEST_ASSERT_EQUAL_STRING("hello", streamed.c_str());
+}
+
+static void test_error_callback_runs_on_executor_with_copied_message() {
+    gQueued.clear();
+    AsyncHttpClient client;
+    client.setCallbackExecutor(makeQueueExecutor());
+
+    HttpClientError seen = CONNECTION_FAILED;
+    String message;
+    auto ctx = makeContext();
+    ctx->onError = [&](HttpClientError err, const char* msg) {
+        seen = err;
+        message = msg;
+    };
+    char transient[] = "transient message";
+    client.triggerError(ctx, REQUEST_TIMEOUT, transient);
+    memset(transient, 0, sizeof(transient));
+
+    TEST_ASSERT_EQUAL(1, (int)gQueued.size());
+    runQueued();
+    TEST_ASSERT_EQUAL(REQUEST_TIMEOUT, seen);
+    TEST_ASSERT_EQUAL_STRING("transient message", message.c_str());
+}
+
+static void test_declining_executor_falls_back_inline() {
+    AsyncHttpClient client;
+    client.setCallbackExecutor(
+        std::make_shared<FunctionCallbackExecutor>([](CallbackExecutor::Task&&) { return false; }));
+    bool called = false;
+    auto ctx = makeContext();
+    ctx->onError = [&](HttpClientError, const char*) { called = true; };
+    client.triggerError(ctx, ABORTED, "Aborted by user");
+    TEST_ASSERT_TRUE(called);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_success_callback_runs_on_executor);
+    RUN_TEST(test_error_callback_runs_on_executor_with_copied_message);
+    RUN_TEST(test_declining_executor_falls_back_inline);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
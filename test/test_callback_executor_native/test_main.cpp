@@ -0,0 +1,112 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CallbackExecutor.h"
+
+static void test_inline_executor_runs_synchronously() {
+    InlineCallbackExecutor executor;
+    TEST_ASSERT_TRUE(executor.runsInline());
+    int calls = 0;
+    TEST_ASSERT_TRUE(executor.post([&calls]() { calls++; }));
+    TEST_ASSERT_EQUAL(1, calls);
+}
+
+static void test_function_executor_forwards_and_can_decline() {
+    std::vector<CallbackExecutor::Task> queued;
+    bool accept = true;
+    FunctionCallbackExecutor executor([&](CallbackExecutor::Task&& task) {
+        if (!accept)
+            return false;
+        queued.push_back(std::move(task));
+        return true;
+    });
+    TEST_ASSERT_FALSE(executor.runsInline());
+
+    int calls = 0;
+    TEST_ASSERT_TRUE(executor.post([&calls]() { calls++; }));
+    TEST_ASSERT_EQUAL(0, calls);
+    TEST_ASSERT_EQUAL(1, (int)queued.size());
+    queued[0]();
+    TEST_ASSERT_EQUAL(1, calls);
+
+    // A declined task must be left intact so the caller can still run it inline.
+    accept = false;
+    CallbackExecutor::Task task = [&calls]() { calls += 10; };
+    TEST_ASSERT_FALSE(executor.post(std::move(task)));
+    TEST_ASSERT_TRUE(static_cast<bool>(task));
+    task();
+    TEST_ASSERT_EQUAL(11, calls);
+}
+
+static void test_thread_pool_runs_off_caller_thread_in_order() {
+    ThreadPoolCallbackExecutor executor(1);
+    std::thread::id caller = std::this_thread::get_id();
+    std::vector<int> order;
+    std::atomic<bool> offThread{true};
+    for (int i = 0; i < 100; ++i) {
+        TEST_ASSERT_TRUE(executor.post([&, i]() {
+            if (std::this_thread::get_id() == caller)
+                offThread.store(false);
+            order.push_back(i);
+        }));
+    }
+    executor.waitIdle();
+    TEST_ASSERT_TRUE(offThread.load());
+    TEST_ASSERT_EQUAL(100, (int)order.size());
+    for (int i = 0; i < 100; ++i)
+        TEST_ASSERT_EQUAL(i, order[i]);
+}
+
+static void test_thread_pool_decouples_slow_callbacks() {
+    // A slow callback must not block the posting ("network") thread: the callbacks cannot finish before the
+    // latch opens, which only happens once every post() has returned. (Bounded, so a regression fails, not hangs.)
+    ThreadPoolCallbackExecutor executor(2);
+    std::atomic<bool> latch{false};
+    std::atomic<int> done{0};
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(executor.post([&latch, &done]() {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!latch.load() && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            done++;
+        }));
+    }
+    TEST_ASSERT_EQUAL(0, done.load());
+    latch.store(true);
+    executor.waitIdle();
+    TEST_ASSERT_EQUAL(4, done.load());
+}
+
+static void test_thread_pool_moves_owned_payload() {
+    ThreadPoolCallbackExecutor executor;
+    auto payload = std::make_shared<std::string>("response");
+    std::weak_ptr<std::string> watch = payload;
+    std::string seen;
+    executor.post([&seen, payload]() mutable {
+        seen = *payload;
+        payload.reset();
+    });
+    payload.reset();
+    executor.waitIdle();
+    TEST_ASSERT_EQUAL_STRING("response", seen.c_str());
+    TEST_ASSERT_TRUE(watch.expired());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_inline_executor_runs_synchronously);
+    RUN_TEST(test_function_executor_forwards_and_can_decline);
+    RUN_TEST(test_thread_pool_runs_off_caller_thread_in_order);
+    RUN_TEST(test_thread_pool_decouples_slow_callbacks);
+    RUN_TEST(test_thread_pool_moves_owned_payload);
+    return UNITY_END();
+}
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static uint32_t getInGroup(AsyncHttpClient& client, const char* url, uint32_t groupId) {
+    std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(HTTP_METHOD_GET, url));
+    request->setGroup(groupId);
+    return client.request(std::move(request), onOk, onErr);
+}
+
+static void test_abort_group_hits_active_and_queued_requests() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setMaxParallel(2);
+    getInGroup(client, "http://api.example/a", 7);  // active
+    getInGroup(client, "http://api.example/b", 8);  // active, other group
+    getInGroup(client, "http://api.example/c", 7);  // queued
+    getInGroup(client, "http://api.example/d", 8);  // queued, other group
+    getInGroup(client, "http://api.example/e", 7);  // queued
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(3, (int)client._pendingQueue.size());
+
+    TEST_ASSERT_EQUAL(3, (int)client.abortGroup(7));
+    TEST_ASSERT_EQUAL(3, gAborted);
+    TEST_ASSERT_EQUAL(0, (int)client.abortGroup(7));
+    // The freed slot went to the surviving group-8 request; both of them still complete.
+    TEST_ASSERT_EQUAL(2, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    gTransports[1]->serve(kOk);
+    gTransports[2]->serve(kOk);
+    TEST_ASSERT_EQUAL(2, gSuccess);
+    TEST_ASSERT_EQUAL(3, gErrors);
+    TEST_ASSERT_EQUAL(0, (int)client._contextsById.size());
+}
+
+static void test_abort_all() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setMaxParallel(1);
+    for (int i = 0; i < 4; ++i)
+        client.get("http://api.example/x", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(4, (int)client.abortAll());
+    TEST_ASSERT_EQUAL(4, gAborted);
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(0, (int)client._contextsById.size());
+    TEST_ASSERT_EQUAL(1, FakeTransport::gDestroyed); // queued requests never opened a connection
+}
+
+static void test_abort_by_id_leaves_tombstone_that_is_skipped() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setMaxParallel(1);
+    client.get("http://api.example/a", onOk, onErr);
+    client.get("http://api.example/b", onOk, onErr);
+    uint32_t queuedId = client.get("http://api.example/c", onOk, onErr);
+    client.loop();
+
+    TEST_ASSERT_TRUE(client.abort(queuedId));
+    TEST_ASSERT_FALSE(client.abort(queuedId)); // already reported
+    TEST_ASSERT_EQUAL(1, gAborted);
+    TEST_ASSERT_EQUAL(1, (int)client._pendingDropped);
+
+    // Completing the active request dispatches /b, then sheds the tombstone that reached the front.
+    gTransports[0]->serve(kOk);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(0, (int)client._pendingDropped);
+    gTransports[1]->serve(kOk);
+    TEST_ASSERT_EQUAL(2, gSuccess);
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_FALSE(client.abort(queuedId));
+}
+
+static void test_abort_unknown_id_returns_false() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    TEST_ASSERT_FALSE(client.abort(0));
+    TEST_ASSERT_FALSE(client.abort(12345)); // never issued
+    uint32_t id = client.get("http://api.example/a", onOk, onErr);
+    TEST_ASSERT_FALSE(client.abort(id + 1));
+    gTransports[0]->serve(kOk);
+    TEST_ASSERT_FALSE(client.abort(id)); // finished
+    TEST_ASSERT_EQUAL(0, gAborted);
+}
+
+static void test_submissions_past_a_full_ring_keep_their_order() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    // Another context is draining: submissions wait, and those beyond the ring capacity spill over behind it.
+    client._drainingSubmissions = true;
+    const size_t count = client._submissions.capacity() + 4;
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < count; ++i)
+        ids.push_back(client.get("http://api.example/x", onOk, onErr));
+    TEST_ASSERT_EQUAL(0, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(4, (int)client._submitOverflow.size());
+
+    client._drainingSubmissions = false;
+    client.loop();
+    TEST_ASSERT_EQUAL((int)count, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(0, (int)client._submitOverflow.size());
+    for (size_t i = 0; i < count; ++i)
+        TEST_ASSERT_EQUAL(ids[i], client._activeRequests[i]->id);
+    TEST_ASSERT_EQUAL((int)count, (int)client.abortAll());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_abort_group_hits_active_and_queued_requests);
+    RUN_TEST(test_abort_all);
+    RUN_TEST(test_abort_by_id_leaves_tombstone_that_is_skipped);
+    RUN_TEST(test_abort_unknown_id_returns_false);
+    RUN_TEST(test_submissions_past_a_full_ring_keep_their_order);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
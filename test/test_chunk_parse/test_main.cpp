@@ -11,6 +11,7 @@ static bool gSuccessCalled = false;
 static bool gErrorCalled = false;
 static HttpClientError gLastError = CONNECTION_FAILED;
 static String gLastBody;
+static std::shared_ptr<AsyncHttpResponse> gLastResponse;
 static std::vector<HttpHeader> gLastTrailers;
 static String gStreamedBody;
 static bool gStreamFinalCalled = false;
@@ -20,6 +21,7 @@ static void resetState() {
     gErrorCalled = false;
     gLastError = CONNECTION_FAILED;
     gLastBody = "";
+    gLastResponse.reset();
     gLastTrailers.clear();
     gStreamedBody = "";
     gStreamFinalCalled = false;
@@ -44,6 +46,7 @@ static AsyncHttpClient::RequestContext* makeContext(AsyncHttpClient& client) {
     ctx->onSuccess = [](const std::shared_ptr<AsyncHttpResponse>& resp) {
         gSuccessCalled = true;
         gLastBody = resp->getBody();
+        gLastResponse = resp;
         gLastTrailers = resp->getTrailers();
     };
     ctx->onError = [](HttpClientError error, const char* message) {
@@ -144,6 +147,107 @@ static void test_chunk_body_limit_ignored_for_no_store_streaming() {
     TEST_ASSERT_TRUE(gStreamFinalCalled);
 }
 
+static void test_last_response_header_is_parsed() {
+    resetState();
+    AsyncHttpClient client;
+    auto ctx = makeContext(client);
+
+    // The header block ends at the blank line: the last header has no CRLF of its own in headerData.
+    String payload = "HTTP/1.1 200 OK\r\n"
+                     "X-First: 1\r\n"
+                     "Content-Length: 2\r\n"
+                     "\r\n"
+                     "ok";
+
+    client.handleData(ctx, const_cast<char*>(payload.c_str()), payload.length());
+
+    TEST_ASSERT_TRUE(gSuccessCalled);
+    TEST_ASSERT_FALSE(gErrorCalled);
+    TEST_ASSERT_EQUAL_STRING("ok", gLastBody.c_str());
+    TEST_ASSERT_EQUAL_STRING("1", gLastResponse->getHeader("X-First").c_str());
+    TEST_ASSERT_EQUAL_STRING("2", gLastResponse->getHeader("Content-Length").c_str());
+}
+
+static void test_last_header_selects_chunked_decoding() {
+    resetState();
+    AsyncHttpClient client;
+    auto ctx = makeContext(client);
+
+    String payload = "HTTP/1.1 200 OK\r\n"
+                     "Transfer-Encoding: chunked\r\n"
+                     "\r\n"
+                     "3\r\nabc\r\n"
+                     "0\r\n\r\n";
+
+    client.handleData(ctx, const_cast<char*>(payload.c_str()), payload.length());
+
+    TEST_ASSERT_TRUE(gSuccessCalled);
+    TEST_ASSERT_FALSE(gErrorCalled);
+    TEST_ASSERT_EQUAL_STRING("abc", gLastBody.c_str());
+}
+
+static void test_chunk_crlf_after_direct_data_is_consumed() {
+    resetState();
+    AsyncHttpClient client;
+    auto ctx = makeContext(client);
+
+    ctx->headersComplete = true;
+    ctx->chunk.chunked = true;
+
+    auto feed = [&](const char* data) { client.handleData(ctx, const_cast<char*>(data), strlen(data)); };
+
+    // Each chunk's data arrives on its own and is delivered straight from the packet; its CRLF comes after.
+    feed("4\r\n");
+    feed("Wiki");
+    feed("\r\n5\r\n");
+    feed("pedia");
+    feed("\r");
+    feed("\n0\r\n\r\n");
+
+    TEST_ASSERT_TRUE(gSuccessCalled);
+    TEST_ASSERT_FALSE(gErrorCalled);
+    TEST_ASSERT_EQUAL_STRING("Wikipedia", gLastBody.c_str());
+}
+
+static void test_direct_chunk_data_without_crlf_is_error() {
+    resetState();
+    AsyncHttpClient client;
+    auto ctx = makeContext(client);
+
+    ctx->headersComplete = true;
+    ctx->chunk.chunked = true;
+
+    auto feed = [&](const char* data) { client.handleData(ctx, const_cast<char*>(data), strlen(data)); };
+
+    feed("4\r\n");
+    feed("Wiki");
+    feed("XY0\r\n\r\n");
+
+    TEST_ASSERT_TRUE(gErrorCalled);
+    TEST_ASSERT_FALSE(gSuccessCalled);
+    TEST_ASSERT_EQUAL_INT(CHUNKED_DECODE_FAILED, gLastError);
+}
+
+static void test_chunk_data_buffered_before_its_crlf() {
+    resetState();
+    AsyncHttpClient client;
+    auto ctx = makeContext(client);
+
+    ctx->headersComplete = true;
+    ctx->chunk.chunked = true;
+
+    auto feed = [&](const char* data) { client.handleData(ctx, const_cast<char*>(data), strlen(data)); };
+
+    // "Wiki" stays buffered until its CRLF arrives; the next packet must be appended behind it, not decoded as data.
+    feed("4\r\nWiki");
+    feed("\r\n5\r\nped");
+    feed("ia\r\n0\r\n\r\n");
+
+    TEST_ASSERT_TRUE(gSuccessCalled);
+    TEST_ASSERT_FALSE(gErrorCalled);
+    TEST_ASSERT_EQUAL_STRING("Wikipedia", gLastBody.c_str());
+}
+
 void setup() {
     delay(2000);
     UNITY_BEGIN();
@@ -151,6 +255,11 @@ void setup() {
     RUN_TEST(test_chunk_missing_crlf_is_error);
     RUN_TEST(test_chunk_body_limit_enforced);
     RUN_TEST(test_chunk_body_limit_ignored_for_no_store_streaming);
+    RUN_TEST(test_last_response_header_is_parsed);
+    RUN_TEST(test_last_header_selects_chunked_decoding);
+    RUN_TEST(test_chunk_crlf_after_direct_data_is_consumed);
+    RUN_TEST(test_direct_chunk_data_without_crlf_is_error);
+    RUN_TEST(test_chunk_data_buffered_before_its_crlf);
     UNITY_END();
 }
 
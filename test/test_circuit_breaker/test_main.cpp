@@ -0,0 +1,115 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static const char* kDown = "http://down.example/ingest";
+
+// Trip the breaker for kDown: 3 failed connects out of 3 (threshold 50%, minRequests 3, 1 s cool-down).
+static void tripCircuit(AsyncHttpClient& client) {
+    FakeTransport::gConnectSucceeds = false; // the backend is down
+    client.setCircuitBreaker(50, 1000, 3, 4);
+    for (int i = 0; i < 3; ++i)
+        client.get(kDown, onOk, onErr);
+    TEST_ASSERT_EQUAL(3, gErrors);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gLastError);
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+}
+
+static void test_open_circuit_fails_fast_without_connecting() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    tripCircuit(client);
+
+    for (int i = 0; i < 5; ++i)
+        client.get(kDown, onOk, onErr);
+    TEST_ASSERT_EQUAL(8, gErrors);
+    TEST_ASSERT_EQUAL(CIRCUIT_OPEN, gLastError);
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size()); // no transport built while open
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+
+    // Other origins are unaffected.
+    FakeTransport::gConnectSucceeds = true;
+    client.get("http://up.example/", onOk, onErr);
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(8, gErrors);
+}
+
+static void test_half_open_lets_a_single_probe_through() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    tripCircuit(client);
+
+    delay(1000);
+    FakeTransport::gConnectSucceeds = true; // the backend is back
+    client.get(kDown, onOk, onErr);          // probe: connecting
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    client.get(kDown, onOk, onErr); // refused while the probe is in flight
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(CIRCUIT_OPEN, gLastError);
+
+    gTransports[3]->serve(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    client.get(kDown, onOk, onErr); // closed again
+    TEST_ASSERT_EQUAL(5, (int)gTransports.size());
+}
+
+static void test_failed_probe_reopens_circuit() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    tripCircuit(client);
+
+    delay(1000);
+    client.get(kDown, onOk, onErr); // probe fails to connect
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gLastError);
+
+    delay(500);
+    client.get(kDown, onOk, onErr); // new cool-down started at the failed probe
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(CIRCUIT_OPEN, gLastError);
+    delay(500);
+    client.get(kDown, onOk, onErr);
+    TEST_ASSERT_EQUAL(5, (int)gTransports.size());
+}
+
+static void test_aborted_probe_hands_over_to_next_request() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    tripCircuit(client);
+
+    delay(1000);
+    FakeTransport::gConnectSucceeds = true;
+    uint32_t probe = client.get(kDown, onOk, onErr);
+    TEST_ASSERT_TRUE(client.abort(probe));
+    TEST_ASSERT_EQUAL(ABORTED, gLastError);
+    client.get(kDown, onOk, onErr); // becomes the new probe
+    TEST_ASSERT_EQUAL(5, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(ABORTED, gLastError);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_open_circuit_fails_fast_without_connecting);
+    RUN_TEST(test_half_open_lets_a_single_probe_through);
+    RUN_TEST(test_failed_probe_reopens_circuit);
+    RUN_TEST(test_aborted_probe_hands_over_to_next_request);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,105 @@
+#include <unity.h>
+
+#include <string>
+
+#include "CircuitBreaker.h"
+
+static const std::string kOrigin = "http://api.example:80";
+
+static void test_disabled_always_allows() {
+    CircuitBreaker breaker;
+    for (int i = 0; i < 10; ++i)
+        breaker.recordFailure(kOrigin, 1000);
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, 1000) == CircuitBreaker::Decision::kAllow);
+    TEST_ASSERT_EQUAL(0, (int)breaker.trackedOrigins());
+}
+
+static void test_opens_on_failure_rate_after_min_requests() {
+    CircuitBreaker breaker;
+    breaker.configure(50, 5000, 4, 8);
+    breaker.recordFailure(kOrigin, 1000);
+    breaker.recordFailure(kOrigin, 1000);
+    breaker.recordFailure(kOrigin, 1000); // 3 samples < minRequests
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kClosed);
+    breaker.recordSuccess(kOrigin, 1000); // 3/4 failed, but a success never opens
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kClosed);
+    breaker.recordFailure(kOrigin, 1000); // 4/5 failed
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kOpen);
+
+    uint32_t retryIn = 0;
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, 2000, &retryIn) == CircuitBreaker::Decision::kReject);
+    TEST_ASSERT_EQUAL(4000, retryIn);
+    TEST_ASSERT_TRUE(breaker.allow("http://other.example:80", 2000) == CircuitBreaker::Decision::kAllow);
+}
+
+static void test_window_forgets_old_failures() {
+    CircuitBreaker breaker;
+    breaker.configure(50, 5000, 4, 4);
+    breaker.recordFailure(kOrigin, 1000);
+    for (int i = 0; i < 4; ++i)
+        breaker.recordSuccess(kOrigin, 1000);
+    // The old failure slid out of the 4-wide window: 2 of 4 needed again.
+    breaker.recordFailure(kOrigin, 1000);
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kClosed);
+    breaker.recordFailure(kOrigin, 1000);
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kOpen);
+}
+
+static void test_half_open_probe_cycle() {
+    CircuitBreaker breaker;
+    breaker.configure(100, 1000, 1, 1);
+    uint32_t start = 0xFFFFFE00u; // millis() wraps during the cool-down
+    breaker.recordFailure(kOrigin, start);
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 999) == CircuitBreaker::Decision::kReject);
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 1000) == CircuitBreaker::Decision::kProbe);
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kHalfOpen);
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 1000) == CircuitBreaker::Decision::kReject);
+
+    breaker.recordFailure(kOrigin, start + 1100); // failed probe: open for another second
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 2000) == CircuitBreaker::Decision::kReject);
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 2100) == CircuitBreaker::Decision::kProbe);
+
+    breaker.releaseProbe(kOrigin); // aborted probe: the next request probes
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 2100) == CircuitBreaker::Decision::kProbe);
+    breaker.recordSuccess(kOrigin, start + 2200);
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kClosed);
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, start + 2200) == CircuitBreaker::Decision::kAllow);
+}
+
+static void test_late_outcomes_while_open_are_ignored() {
+    CircuitBreaker breaker;
+    breaker.configure(50, 1000, 2, 4);
+    breaker.recordFailure(kOrigin, 1000);
+    breaker.recordFailure(kOrigin, 1000);
+    TEST_ASSERT_TRUE(breaker.state(kOrigin) == CircuitBreaker::State::kOpen);
+    breaker.recordSuccess(kOrigin, 1500); // request started before the circuit opened
+    TEST_ASSERT_TRUE(breaker.allow(kOrigin, 1500) == CircuitBreaker::Decision::kReject);
+}
+
+static void test_healthy_origins_are_pruned() {
+    CircuitBreaker breaker;
+    breaker.configure(50, 1000, 2, 4);
+    for (int i = 0; i < 20; ++i) {
+        std::string key = "http://host" + std::to_string(i) + ":80";
+        breaker.recordFailure(key, 1000);
+        breaker.recordSuccess(key, 1000);
+        breaker.recordSuccess(key, 1000);
+        breaker.recordSuccess(key, 1000);
+        breaker.recordSuccess(key, 1000); // failure slid out: indistinguishable from a fresh origin
+    }
+    TEST_ASSERT_TRUE(breaker.trackedOrigins() <= 9);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_always_allows);
+    RUN_TEST(test_opens_on_failure_rate_after_min_requests);
+    RUN_TEST(test_window_forgets_old_failures);
+    RUN_TEST(test_half_open_probe_cycle);
+    RUN_TEST(test_late_outcomes_while_open_are_ignored);
+    RUN_TEST(test_healthy_origins_are_pruned);
+    return UNITY_END();
+}
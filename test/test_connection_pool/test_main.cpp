@@ -0,0 +1,341 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+
+#define private public
+#include "ConnectionPool.h"
+#undef private
+
+// Idle socket stand-in: only canSend()/close() matter to the pool.
+class IdleTransport : public AsyncTransport {
+  public:
+    void setConnectHandler(ConnectHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    void setDataHandler(DataHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    void setDisconnectHandler(DisconnectHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    void setErrorHandler(ErrorHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    void setTimeout(uint32_t timeoutMs) override {
+        (void)timeoutMs;
+    }
+    void setTimeoutHandler(TimeoutHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    bool connect(const char* host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        return true;
+    }
+    size_t write(const char* data, size_t len) override {
+        (void)data;
+        return len;
+    }
+    bool canSend() const override {
+        return !closed;
+    }
+    void close(bool now = false) override {
+        (void)now;
+        closed = true;
+    }
+    bool isSecure() const override {
+        return false;
+    }
+    bool isHandshaking() const override {
+        return false;
+    }
+    uint32_t getHandshakeStartMs() const override {
+        return 0;
+    }
+    uint32_t getHandshakeTimeoutMs() const override {
+        return 0;
+    }
+
+    bool closed = false;
+};
+
+// A PEM-sized CA bundle entry.
+static String makePem(char fill) {
+    String pem = "-----BEGIN CERTIFICATE-----\n";
+    for (int line = 0; line < 32; ++line) {
+        for (int i = 0; i < 64; ++i)
+            pem += fill;
+        pem += '\n';
+    }
+    pem += "-----END CERTIFICATE-----\n";
+    return pem;
+}
+
+static AsyncHttpTLSConfig makeTls(char fill) {
+    AsyncHttpTLSConfig tls;
+    tls.caCert = makePem(fill);
+    return tls;
+}
+
+static void test_key_separates_tls_profiles() {
+    AsyncHttpRequest a(HTTP_METHOD_GET, "https://API.example.com/x");
+    AsyncHttpRequest b(HTTP_METHOD_GET, "https://api.example.com/y");
+    AsyncHttpRequest plain(HTTP_METHOD_GET, "http://api.example.com/");
+    AsyncHttpTLSConfig caA = makeTls('A');
+    AsyncHttpTLSConfig caB = makeTls('B');
+
+    TEST_ASSERT_TRUE(ConnectionPool::makeKey(&a, caA) == ConnectionPool::makeKey(&b, caA));
+    TEST_ASSERT_FALSE(ConnectionPool::makeKey(&a, caA) == ConnectionPool::makeKey(&a, caB));
+    AsyncHttpTLSConfig insecure = caA;
+    insecure.insecure = true;
+    TEST_ASSERT_FALSE(ConnectionPool::makeKey(&a, caA) == ConnectionPool::makeKey(&a, insecure));
+    AsyncHttpTLSConfig clamped = caA;
+    clamped.handshakeTimeoutMs = 800; // e.g. cut down to a request's remaining deadline
+    TEST_ASSERT_TRUE(ConnectionPool::makeKey(&a, caA) == ConnectionPool::makeKey(&a, clamped));
+    // Plain HTTP ignores the TLS profile.
+    TEST_ASSERT_EQUAL_STRING("http://api.example.com:80", ConnectionPool::makeKey(&plain, caA).c_str());
+}
+
+static void test_checkout_is_lifo_per_key() {
+    ConnectionPool pool(nullptr);
+    IdleTransport* older = new IdleTransport();
+    IdleTransport* newer = new IdleTransport();
+    IdleTransport* other = new IdleTransport();
+    pool.releaseConnectionToPool(older, "https://a.example:443#1");
+    pool.releaseConnectionToPool(other, "https://b.example:443#1");
+    pool.releaseConnectionToPool(newer, "https://a.example:443#1");
+    TEST_ASSERT_EQUAL(3, (int)pool.idleCount());
+
+    TEST_ASSERT_EQUAL_PTR(newer, pool.checkoutPooledTransport("https://a.example:443#1", true));
+    TEST_ASSERT_EQUAL_PTR(older, pool.checkoutPooledTransport("https://a.example:443#1", true));
+    TEST_ASSERT_NULL(pool.checkoutPooledTransport("https://a.example:443#1", true));
+    TEST_ASSERT_NULL(pool.checkoutPooledTransport("https://a.example:443#2", true)); // other TLS profile
+    TEST_ASSERT_EQUAL(1, (int)pool.idleCount("https://b.example:443#1"));
+    delete older;
+    delete newer;
+}
+
+static void test_checkout_skips_closed_connections() {
+    ConnectionPool pool(nullptr);
+    IdleTransport* alive = new IdleTransport();
+    IdleTransport* dead = new IdleTransport();
+    pool.releaseConnectionToPool(alive, "http://a.example:80");
+    pool.releaseConnectionToPool(dead, "http://a.example:80");
+    dead->closed = true; // peer went away while idle; the pool deletes it on the way down the stack
+    TEST_ASSERT_EQUAL_PTR(alive, pool.checkoutPooledTransport("http://a.example:80", true));
+    TEST_ASSERT_EQUAL(0, (int)pool.idleCount());
+    delete alive;
+}
+
+static void test_prune_drops_aged_connections_and_stacks() {
+    ConnectionPool pool(nullptr);
+    IdleTransport* cold = new IdleTransport();
+    IdleTransport* warm = new IdleTransport();
+    pool.releaseConnectionToPool(cold, "http://a.example:80");
+    pool.releaseConnectionToPool(warm, "http://b.example:80");
+    uint32_t now = millis();
+    pool._idle["http://a.example:80"].connections[0].lastUsedMs = now - 5000;
+    pool._idle["http://a.example:80"].lastUsedMs = now - 5000;
+
+    pool.pruneIdleConnections(true, 1000);
+    TEST_ASSERT_EQUAL(1, (int)pool.idleCount());
+    TEST_ASSERT_EQUAL(1, (int)pool._idle.size()); // the empty, aged stack is gone too
+    TEST_ASSERT_EQUAL_PTR(warm, pool.checkoutPooledTransport("http://b.example:80", true));
+    delete warm;
+}
+
+static void test_per_origin_cap_evicts_the_origins_coldest_connection() {
+    ConnectionPool pool(nullptr);
+    AsyncHttpConnectionPoolLimits limits;
+    limits.maxIdlePerOrigin = 2;
+    pool.setLimits(limits);
+    IdleTransport* first = new IdleTransport();
+    IdleTransport* second = new IdleTransport();
+    IdleTransport* third = new IdleTransport();
+    IdleTransport* other = new IdleTransport();
+    pool.releaseConnectionToPool(first, "http://a.example:80");
+    pool.releaseConnectionToPool(other, "http://b.example:80");
+    pool.releaseConnectionToPool(second, "http://a.example:80");
+    pool.releaseConnectionToPool(third, "http://a.example:80"); // evicts (and deletes) `first`
+    TEST_ASSERT_EQUAL(2, (int)pool.idleCount("http://a.example:80"));
+    TEST_ASSERT_EQUAL(1, (int)pool.idleCount("http://b.example:80"));
+    TEST_ASSERT_EQUAL(1, (int)pool.stats().evictions);
+    TEST_ASSERT_EQUAL_PTR(third, pool.checkoutPooledTransport("http://a.example:80", true));
+    TEST_ASSERT_EQUAL_PTR(second, pool.checkoutPooledTransport("http://a.example:80", true));
+    delete second;
+    delete third;
+}
+
+static void test_global_cap_evicts_least_recently_used() {
+    ConnectionPool pool(nullptr);
+    AsyncHttpConnectionPoolLimits limits;
+    limits.maxIdle = 2;
+    pool.setLimits(limits);
+    IdleTransport* a = new IdleTransport();
+    IdleTransport* b = new IdleTransport();
+    IdleTransport* c = new IdleTransport();
+    pool.releaseConnectionToPool(a, "http://a.example:80");
+    delay(10);
+    pool.releaseConnectionToPool(b, "http://b.example:80");
+    delay(10);
+    pool.releaseConnectionToPool(c, "http://c.example:80"); // `a` is the oldest across origins
+    TEST_ASSERT_EQUAL(2, (int)pool.idleCount());
+    TEST_ASSERT_EQUAL(0, (int)pool.idleCount("http://a.example:80"));
+    TEST_ASSERT_EQUAL(1, (int)pool.stats().evictions);
+}
+
+static void test_cost_weighted_eviction_prefers_tls_connections() {
+    // A plain socket idle for 3 s and a TLS socket idle for 1 s: LRU closes the plain one, the memory-weighted policy
+    // closes the TLS one (40x the estimated memory).
+    for (int weighted = 0; weighted < 2; ++weighted) {
+        ConnectionPool pool(nullptr);
+        AsyncHttpConnectionPoolLimits limits;
+        limits.maxIdle = 2;
+        limits.costWeighted = weighted == 1;
+        pool.setLimits(limits);
+        IdleTransport* plain = new IdleTransport();
+        IdleTransport* tls = new IdleTransport();
+        IdleTransport* fresh = new IdleTransport();
+        pool.releaseConnectionToPool(plain, "http://plain.example:80");
+        delay(2000);
+        pool.releaseConnectionToPool(tls, "https://tls.example:443#1");
+        delay(1000);
+        pool.releaseConnectionToPool(fresh, "http://fresh.example:80");
+        TEST_ASSERT_EQUAL(weighted ? 1 : 0, (int)pool.idleCount("http://plain.example:80"));
+        TEST_ASSERT_EQUAL(weighted ? 0 : 1, (int)pool.idleCount("https://tls.example:443#1"));
+        AsyncHttpConnectionPoolStats stats = pool.stats();
+        TEST_ASSERT_EQUAL(weighted ? 0 : 1, (int)stats.idleTls);
+        TEST_ASSERT_EQUAL(weighted ? 2 * 1024 : 40960 + 1024, (int)stats.idleBytes);
+    }
+}
+
+static void test_byte_cap_counts_tls_connections_at_their_cost() {
+    ConnectionPool pool(nullptr);
+    AsyncHttpConnectionPoolLimits limits;
+    limits.maxIdleBytes = 100 * 1024; // two idle TLS connections, not three
+    pool.setLimits(limits);
+    for (int i = 0; i < 3; ++i) {
+        pool.releaseConnectionToPool(new IdleTransport(), "https://tls.example:443#1");
+        delay(5);
+    }
+    TEST_ASSERT_EQUAL(2, (int)pool.idleCount());
+    for (int i = 0; i < 10; ++i)
+        pool.releaseConnectionToPool(new IdleTransport(), "http://plain.example:80");
+    AsyncHttpConnectionPoolStats stats = pool.stats();
+    TEST_ASSERT_TRUE(stats.idleBytes <= limits.maxIdleBytes);
+    TEST_ASSERT_EQUAL(12, (int)stats.idle); // ten plain sockets fit next to two TLS ones
+    pool.dropAll();
+}
+
+static void test_stats_track_hits_misses_and_reuse() {
+    ConnectionPool pool(nullptr);
+    IdleTransport* t = new IdleTransport();
+    uint32_t reuses = 99;
+    TEST_ASSERT_NULL(pool.checkoutPooledTransport("http://a.example:80", true, &reuses));
+    pool.releaseConnectionToPool(t, "http://a.example:80"); // fresh connection after its first request
+    for (uint32_t served = 1; served <= 3; ++served) {
+        TEST_ASSERT_EQUAL_PTR(t, pool.checkoutPooledTransport("http://a.example:80", true, &reuses));
+        TEST_ASSERT_EQUAL(served - 1, reuses);
+        pool.releaseConnectionToPool(t, "http://a.example:80", reuses + 1);
+    }
+    AsyncHttpConnectionPoolStats stats = pool.stats();
+    TEST_ASSERT_EQUAL(3, (int)stats.hits);
+    TEST_ASSERT_EQUAL(1, (int)stats.misses);
+    TEST_ASSERT_EQUAL(1, (int)stats.pooled);
+    TEST_ASSERT_EQUAL(3, (int)stats.maxReuses);
+    TEST_ASSERT_EQUAL(1, (int)stats.idle);
+
+    t->closed = true;
+    pool.pruneIdleConnections(true, 60000);
+    TEST_ASSERT_EQUAL(1, (int)pool.stats().closed);
+    TEST_ASSERT_EQUAL(0, (int)pool.stats().idleBytes);
+}
+
+static void test_parses_keep_alive_header() {
+    uint32_t timeoutMs = 0;
+    uint32_t maxRequests = ConnectionPool::kNoRequestLimit;
+    ConnectionPool::parseKeepAliveHeader("timeout=5, max=99", &timeoutMs, &maxRequests);
+    TEST_ASSERT_EQUAL(5000, (int)timeoutMs);
+    TEST_ASSERT_EQUAL(99, (int)maxRequests);
+
+    timeoutMs = 0;
+    maxRequests = ConnectionPool::kNoRequestLimit;
+    ConnectionPool::parseKeepAliveHeader("Max = 0,TIMEOUT=15,foo=bar", &timeoutMs, &maxRequests);
+    TEST_ASSERT_EQUAL(15000, (int)timeoutMs);
+    TEST_ASSERT_EQUAL(0, (int)maxRequests);
+
+    timeoutMs = 0;
+    maxRequests = ConnectionPool::kNoRequestLimit;
+    ConnectionPool::parseKeepAliveHeader("timeouts=3, max=x, timeout", &timeoutMs, &maxRequests);
+    TEST_ASSERT_EQUAL(0, (int)timeoutMs); // nothing recognised: outputs untouched
+    TEST_ASSERT_TRUE(maxRequests == ConnectionPool::kNoRequestLimit);
+}
+
+static void test_server_keep_alive_timeout_bounds_idle_time() {
+    ConnectionPool pool(nullptr); // default 1000 ms safety margin
+    IdleTransport* t = new IdleTransport();
+    pool.releaseConnectionToPool(t, "http://a.example:80", 0, 3000, 50);
+    TEST_ASSERT_EQUAL(2000, (int)pool._idle["http://a.example:80"].connections[0].serverIdleMs);
+    delay(1500);
+    TEST_ASSERT_EQUAL_PTR(t, pool.checkoutPooledTransport("http://a.example:80", true));
+    pool.releaseConnectionToPool(t, "http://a.example:80", 1, 3000, 49);
+
+    // Past the server's timeout minus the margin: skipped at checkout even though pruning has not run.
+    delay(2000);
+    TEST_ASSERT_NULL(pool.checkoutPooledTransport("http://a.example:80", true));
+    TEST_ASSERT_EQUAL(1, (int)pool.stats().expired);
+
+    // Pruning applies the shorter of the client's idle time and the server's.
+    pool.releaseConnectionToPool(new IdleTransport(), "http://a.example:80", 0, 3000);
+    pool.releaseConnectionToPool(new IdleTransport(), "http://b.example:80");
+    delay(2100);
+    pool.pruneIdleConnections(true, 60000);
+    TEST_ASSERT_EQUAL(0, (int)pool.idleCount("http://a.example:80"));
+    TEST_ASSERT_EQUAL(1, (int)pool.idleCount("http://b.example:80"));
+    pool.dropAll();
+}
+
+static void test_retires_connections_the_server_will_not_keep() {
+    ConnectionPool pool(nullptr);
+    pool.releaseConnectionToPool(new IdleTransport(), "http://a.example:80", 0, 5000, 0); // max=0: last request
+    pool.releaseConnectionToPool(new IdleTransport(), "http://a.example:80", 0, 1000);   // within the margin
+    TEST_ASSERT_EQUAL(0, (int)pool.idleCount());
+    TEST_ASSERT_EQUAL(2, (int)pool.stats().expired);
+
+    AsyncHttpConnectionPoolLimits limits;
+    limits.serverTimeoutMarginMs = 200;
+    pool.setLimits(limits);
+    pool.releaseConnectionToPool(new IdleTransport(), "http://a.example:80", 0, 1000);
+    TEST_ASSERT_EQUAL(1, (int)pool.idleCount());
+    TEST_ASSERT_EQUAL(800, (int)pool._idle["http://a.example:80"].connections[0].serverIdleMs);
+    pool.dropAll();
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_key_separates_tls_profiles);
+    RUN_TEST(test_checkout_is_lifo_per_key);
+    RUN_TEST(test_checkout_skips_closed_connections);
+    RUN_TEST(test_prune_drops_aged_connections_and_stacks);
+    RUN_TEST(test_per_origin_cap_evicts_the_origins_coldest_connection);
+    RUN_TEST(test_global_cap_evicts_least_recently_used);
+    RUN_TEST(test_cost_weighted_eviction_prefers_tls_connections);
+    RUN_TEST(test_byte_cap_counts_tls_connections_at_their_cost);
+    RUN_TEST(test_stats_track_hits_misses_and_reuse);
+    RUN_TEST(test_parses_keep_alive_header);
+    RUN_TEST(test_server_keep_alive_timeout_bounds_idle_time);
+    RUN_TEST(test_retires_connections_the_server_will_not_keep);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,139 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static std::vector<uint32_t> gHandshakeTimeouts; // TLS handshake timeout handed to each transport
+
+static FakeTransport* makeTransportRecordingTls(const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls) {
+    (void)request;
+    gHandshakeTimeouts.push_back(tls.handshakeTimeoutMs);
+    return new FakeTransport();
+}
+
+static uint32_t getWithDeadline(AsyncHttpClient& client, const char* url, uint32_t deadlineMs) {
+    std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(HTTP_METHOD_GET, url));
+    request->setDeadline(deadlineMs);
+    return client.request(std::move(request), onOk, onErr);
+}
+
+static void test_queued_request_expires_without_connecting() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setMaxParallel(1);
+    client.get("http://slow.example/a", onOk, onErr); // occupies the only slot
+    getWithDeadline(client, "http://slow.example/b", millis() + 100);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)client._pendingQueue.size());
+
+    delay(100);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(DEADLINE_EXCEEDED, gLastError);
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size()); // never connected
+
+    client.setMaxParallel(0);
+    getWithDeadline(client, "http://slow.example/c", millis()); // already spent
+    TEST_ASSERT_EQUAL(2, gErrors);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+}
+
+static void test_active_request_fails_at_deadline() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    getWithDeadline(client, "http://slow.example/", millis() + 200);
+    delay(150);
+    client.loop();
+    TEST_ASSERT_EQUAL(0, gErrors);
+    delay(50);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(DEADLINE_EXCEEDED, gLastError);
+}
+
+static void test_connect_and_tls_timeouts_are_clamped() {
+    resetCounters();
+    AsyncHttpClient client;
+    gHandshakeTimeouts.clear();
+    installFakeTransports(client, makeTransportRecordingTls);
+    client.setTlsInsecure(true);
+    getWithDeadline(client, "https://secure.example/", millis() + 300);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(300, gHandshakeTimeouts[0]);
+    TEST_ASSERT_EQUAL(300, client._activeRequests[0]->timing.connectTimeoutMs);
+    // The pooled TLS configuration keeps the configured value.
+    TEST_ASSERT_EQUAL(12000, client._activeRequests[0]->resolvedTlsConfig.handshakeTimeoutMs);
+
+    client.get("https://secure.example/", onOk, onErr); // no deadline: defaults
+    TEST_ASSERT_EQUAL(12000, gHandshakeTimeouts[1]);
+    TEST_ASSERT_EQUAL(5000, client._activeRequests[1]->timing.connectTimeoutMs);
+}
+
+static void test_deadline_and_timeout_span_redirects() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setFollowRedirects(true, 3);
+    getWithDeadline(client, "http://a.example/start", millis() + 200);
+    delay(150);
+    gTransports[0]->serve("HTTP/1.1 302 Found\r\nLocation: http://b.example/next\r\nContent-Length: 0\r\n\r\n");
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(50, client._activeRequests[0]->timing.connectTimeoutMs); // what is left of the budget
+    delay(50);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(DEADLINE_EXCEEDED, gLastError);
+
+    // setTimeout() is no longer restarted by each hop either.
+    client.setTimeout(300);
+    client.get("http://a.example/start", onOk, onErr);
+    delay(200);
+    gTransports[2]->serve("HTTP/1.1 302 Found\r\nLocation: http://b.example/next\r\nContent-Length: 0\r\n\r\n");
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    delay(100);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, gErrors);
+    TEST_ASSERT_EQUAL(REQUEST_TIMEOUT, gLastError);
+}
+
+static void test_retry_is_skipped_when_deadline_is_too_close() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpRetryPolicy policy;
+    policy.maxAttempts = 3;
+    policy.baseDelayMs = 200;
+    policy.jitterPercent = 0;
+    client.setRetryPolicy(policy);
+    getWithDeadline(client, "http://flaky.example/", millis() + 150);
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gLastError);
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_queued_request_expires_without_connecting);
+    RUN_TEST(test_active_request_fails_at_deadline);
+    RUN_TEST(test_connect_and_tls_timeouts_are_clamped);
+    RUN_TEST(test_deadline_and_timeout_span_redirects);
+    RUN_TEST(test_retry_is_skipped_when_deadline_is_too_close);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,357 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "DnsCache.h"
+
+// Stand-in resolver: records lookups and lets the test answer them (or answers at once when `synchronous`).
+class FakeResolver : public AsyncHttpResolver {
+  public:
+    struct Lookup {
+        std::string host;
+        Completion done;
+    };
+
+    void resolve(const char* host, Completion done) override {
+        calls++;
+        if (synchronous) {
+            done(found, address, ttlMs);
+            return;
+        }
+        Lookup lookup;
+        lookup.host = host;
+        lookup.done = std::move(done);
+        pending.push_back(std::move(lookup));
+    }
+
+    void answer(size_t index, bool ok, uint32_t ipv4, uint32_t ttl = 0) {
+        Completion done = pending[index].done;
+        pending.erase(pending.begin() + index);
+        done(ok, ipv4, ttl);
+    }
+
+    int calls = 0;
+    std::vector<Lookup> pending;
+    bool synchronous = false;
+    bool found = true;
+    uint32_t address = 0;
+    uint32_t ttlMs = 0;
+};
+
+struct Outcome {
+    int calls = 0;
+    bool found = false;
+    uint32_t ipv4 = 0;
+};
+
+static DnsCache::Callback record(Outcome* outcome) {
+    return [outcome](bool found, uint32_t ipv4) {
+        outcome->calls++;
+        outcome->found = found;
+        outcome->ipv4 = ipv4;
+    };
+}
+
+static uint32_t ip(const char* text) {
+    uint32_t address = 0;
+    DnsCache::parseIPv4(text, &address);
+    return address;
+}
+
+static void test_parse_ipv4() {
+    uint32_t address = 0;
+    TEST_ASSERT_TRUE(DnsCache::parseIPv4("192.168.1.20", &address));
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&address);
+    TEST_ASSERT_EQUAL(192, bytes[0]); // network byte order
+    TEST_ASSERT_EQUAL(20, bytes[3]);
+    TEST_ASSERT_FALSE(DnsCache::parseIPv4("256.1.1.1", &address));
+    TEST_ASSERT_FALSE(DnsCache::parseIPv4("1.2.3", &address));
+    TEST_ASSERT_FALSE(DnsCache::parseIPv4("1.2.3.4.5", &address));
+    TEST_ASSERT_FALSE(DnsCache::parseIPv4("api.example.com", &address));
+    TEST_ASSERT_FALSE(DnsCache::parseIPv4("", &address));
+}
+
+static void test_literals_and_bypass_need_no_resolver() {
+    DnsCache cache;
+    uint32_t address = 0;
+    Outcome outcome;
+    TEST_ASSERT_TRUE(cache.resolve("10.0.0.7", 0, &address, record(&outcome), nullptr) == DnsCache::Result::kResolved);
+    TEST_ASSERT_EQUAL_UINT32(ip("10.0.0.7"), address);
+    // Host build without a resolver: the transport connects by name.
+    TEST_ASSERT_TRUE(cache.resolve("api.example.com", 0, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kBypass);
+    TEST_ASSERT_FALSE(cache.preResolve("api.example.com", 0));
+    TEST_ASSERT_EQUAL(0, outcome.calls);
+}
+
+static void test_caches_answer_until_ttl() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+    AsyncHttpDnsConfig config;
+    config.ttlMs = 10000;
+    cache.configure(config);
+
+    uint32_t address = 0;
+    Outcome outcome;
+    TEST_ASSERT_TRUE(cache.resolve("API.example.com", 1000, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL_STRING("api.example.com", resolver.pending[0].host.c_str());
+    resolver.answer(0, true, ip("93.184.216.34"));
+    TEST_ASSERT_EQUAL(1, outcome.calls);
+    TEST_ASSERT_TRUE(outcome.found);
+    TEST_ASSERT_EQUAL_UINT32(ip("93.184.216.34"), outcome.ipv4);
+
+    TEST_ASSERT_TRUE(cache.resolve("api.example.com", 10999, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kResolved);
+    TEST_ASSERT_EQUAL_UINT32(ip("93.184.216.34"), address);
+    TEST_ASSERT_EQUAL(1, resolver.calls);
+    // The TTL counts from the start of the lookup.
+    TEST_ASSERT_TRUE(cache.resolve("api.example.com", 11000, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL(2, resolver.calls);
+
+    // A TTL reported by the resolver is used, clamped to maxTtlMs.
+    resolver.answer(0, true, ip("93.184.216.35"), 600000);
+    TEST_ASSERT_TRUE(cache.resolve("api.example.com", 11000 + config.maxTtlMs - 1, &address, record(&outcome),
+                                   nullptr) == DnsCache::Result::kResolved);
+    TEST_ASSERT_TRUE(cache.resolve("api.example.com", 11000 + config.maxTtlMs, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+
+    AsyncHttpDnsStats stats = cache.stats();
+    TEST_ASSERT_EQUAL(2, (int)stats.hits);
+    TEST_ASSERT_EQUAL(3, (int)stats.misses);
+    TEST_ASSERT_EQUAL(1, (int)stats.entries);
+}
+
+static void test_negative_answers_are_cached_briefly() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+    AsyncHttpDnsConfig config;
+    config.negativeTtlMs = 2000;
+    cache.configure(config);
+
+    uint32_t address = 0;
+    Outcome outcome;
+    cache.resolve("gone.example", 0, &address, record(&outcome), nullptr);
+    resolver.answer(0, false, 0);
+    TEST_ASSERT_EQUAL(1, outcome.calls);
+    TEST_ASSERT_FALSE(outcome.found);
+    TEST_ASSERT_TRUE(cache.resolve("gone.example", 1999, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kFailed);
+    TEST_ASSERT_EQUAL(1, resolver.calls);
+    TEST_ASSERT_TRUE(cache.resolve("gone.example", 2000, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL(2, resolver.calls);
+    AsyncHttpDnsStats stats = cache.stats();
+    TEST_ASSERT_EQUAL(1, (int)stats.negativeHits);
+    TEST_ASSERT_EQUAL(1, (int)stats.failures);
+
+    // negativeTtlMs 0: failures are not remembered.
+    config.negativeTtlMs = 0;
+    cache.configure(config);
+    resolver.answer(0, false, 0);
+    TEST_ASSERT_TRUE(cache.resolve("gone.example", 2001, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+}
+
+static void test_concurrent_lookups_are_shared() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+
+    uint32_t address = 0;
+    Outcome outcomes[4];
+    uint32_t waiters[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i)
+        TEST_ASSERT_TRUE(cache.resolve("tiles.example", 0, &address, record(&outcomes[i]), &waiters[i]) ==
+                         DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL(1, resolver.calls);
+    cache.cancel(waiters[2]); // its connection was closed meanwhile
+    resolver.answer(0, true, ip("10.1.2.3"));
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(i == 2 ? 0 : 1, outcomes[i].calls);
+        if (i != 2)
+            TEST_ASSERT_EQUAL_UINT32(ip("10.1.2.3"), outcomes[i].ipv4);
+    }
+    TEST_ASSERT_EQUAL(3, (int)cache.stats().coalesced);
+}
+
+static void test_cancel_while_the_answer_is_delivered() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+
+    uint32_t address = 0;
+    Outcome outcome;
+    uint32_t first = 0;
+    uint32_t second = 0;
+    // The first connection's callback fails its request, which closes the second connection.
+    TEST_ASSERT_TRUE(cache.resolve(
+                         "tiles.example", 0, &address,
+                         [&](bool found, uint32_t ipv4) {
+                             (void)found;
+                             (void)ipv4;
+                             cache.cancel(second);
+                         },
+                         &first) == DnsCache::Result::kPending);
+    TEST_ASSERT_TRUE(cache.resolve("tiles.example", 0, &address, record(&outcome), &second) ==
+                     DnsCache::Result::kPending);
+    resolver.answer(0, true, ip("10.1.2.3"));
+    TEST_ASSERT_EQUAL(0, outcome.calls);
+
+    // Same for a pin that takes over the waiters of a lookup in flight.
+    TEST_ASSERT_TRUE(cache.resolve(
+                         "feeds.example", 0, &address,
+                         [&](bool found, uint32_t ipv4) {
+                             (void)found;
+                             (void)ipv4;
+                             cache.cancel(second);
+                         },
+                         &first) == DnsCache::Result::kPending);
+    TEST_ASSERT_TRUE(cache.resolve("feeds.example", 0, &address, record(&outcome), &second) ==
+                     DnsCache::Result::kPending);
+    cache.pin("feeds.example", ip("10.4.5.6"));
+    TEST_ASSERT_EQUAL(0, outcome.calls);
+}
+
+static void test_lookup_without_callback_fills_the_cache() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+
+    // What the transports do on a miss: connect by name and let the lookup fill the cache.
+    uint32_t address = 0;
+    uint32_t waiter = 0;
+    TEST_ASSERT_TRUE(cache.resolve("tiles.example", 0, &address, nullptr, &waiter) == DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL_UINT32(0, waiter);
+    TEST_ASSERT_TRUE(cache.resolve("tiles.example", 0, &address, nullptr, nullptr) == DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL(1, resolver.calls);
+    resolver.answer(0, true, ip("10.1.2.3"));
+    TEST_ASSERT_TRUE(cache.resolve("tiles.example", 10, &address, nullptr, nullptr) == DnsCache::Result::kResolved);
+    TEST_ASSERT_EQUAL_UINT32(ip("10.1.2.3"), address);
+    TEST_ASSERT_EQUAL(1, (int)cache.stats().coalesced);
+}
+
+static void test_synchronous_resolver() {
+    DnsCache cache;
+    FakeResolver resolver;
+    resolver.synchronous = true;
+    resolver.address = ip("10.9.9.9");
+    cache.setResolver(&resolver);
+
+    uint32_t address = 0;
+    Outcome outcome;
+    // Answered before resolve() returns: the callback has run once the call comes back.
+    TEST_ASSERT_TRUE(cache.resolve("sync.example", 0, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+    TEST_ASSERT_EQUAL(1, outcome.calls);
+    TEST_ASSERT_TRUE(cache.resolve("sync.example", 1, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kResolved);
+    TEST_ASSERT_EQUAL_UINT32(ip("10.9.9.9"), address);
+}
+
+static void test_pins_override_dns() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+
+    uint32_t address = 0;
+    Outcome waiting;
+    cache.resolve("device.local", 0, &address, record(&waiting), nullptr);
+    cache.pin("Device.local", ip("192.168.4.1"));
+    TEST_ASSERT_EQUAL(1, waiting.calls); // the pending connection takes the pinned address
+    TEST_ASSERT_EQUAL_UINT32(ip("192.168.4.1"), waiting.ipv4);
+    resolver.answer(0, true, ip("10.0.0.1")); // late answer does not replace the pin
+
+    Outcome outcome;
+    TEST_ASSERT_TRUE(cache.resolve("device.local", 999999, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kResolved);
+    TEST_ASSERT_EQUAL_UINT32(ip("192.168.4.1"), address);
+    cache.clear(); // keeps pins
+    AsyncHttpDnsConfig config;
+    config.enabled = false; // pins apply even with the cache off
+    cache.configure(config);
+    TEST_ASSERT_TRUE(cache.resolve("device.local", 0, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kResolved);
+    TEST_ASSERT_TRUE(cache.unpin("device.local"));
+    TEST_ASSERT_TRUE(cache.resolve("device.local", 0, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kBypass);
+    TEST_ASSERT_FALSE(cache.unpin("device.local"));
+}
+
+static void test_pre_resolve_and_eviction() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+    AsyncHttpDnsConfig config;
+    config.maxEntries = 2;
+    cache.configure(config);
+
+    TEST_ASSERT_TRUE(cache.preResolve("a.example", 0));
+    TEST_ASSERT_TRUE(cache.preResolve("a.example", 0)); // already in flight
+    TEST_ASSERT_EQUAL(1, resolver.calls);
+    resolver.answer(0, true, ip("10.0.0.1"));
+    TEST_ASSERT_TRUE(cache.preResolve("b.example", 10));
+    resolver.answer(0, true, ip("10.0.0.2"));
+
+    uint32_t address = 0;
+    Outcome outcome;
+    TEST_ASSERT_TRUE(cache.resolve("a.example", 20, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kResolved); // a is now more recently used than b
+    cache.preResolve("c.example", 30);
+    resolver.answer(0, true, ip("10.0.0.3"));
+    TEST_ASSERT_EQUAL(1, (int)cache.stats().evictions);
+    TEST_ASSERT_TRUE(cache.resolve("a.example", 40, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kResolved);
+    TEST_ASSERT_TRUE(cache.resolve("b.example", 40, &address, record(&outcome), nullptr) ==
+                     DnsCache::Result::kPending);
+}
+
+// 40 connections to 4 hosts, a few at a time, over two minutes: one lookup per host and TTL instead of one per
+// connection.
+static void test_lookups_per_connection_workload() {
+    DnsCache cache;
+    FakeResolver resolver;
+    cache.setResolver(&resolver);
+    AsyncHttpDnsConfig config;
+    config.ttlMs = 60000;
+    cache.configure(config);
+    const char* hosts[] = {"api.example.com", "tiles.example.com", "auth.example.com", "api.example.com"};
+    int connections = 0;
+    for (uint32_t now = 0; now < 120000; now += 12000) {
+        Outcome outcomes[4];
+        uint32_t address = 0;
+        for (int i = 0; i < 4; ++i, ++connections)
+            cache.resolve(hosts[i], now, &address, record(&outcomes[i]), nullptr);
+        while (!resolver.pending.empty())
+            resolver.answer(0, true, ip("10.0.0.1"));
+    }
+    char message[128];
+    snprintf(message, sizeof(message), "%d connections: %d DNS lookups with the cache, %d without", connections,
+             resolver.calls, connections);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(6, resolver.calls); // 3 hosts x 2 TTL periods
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_ipv4);
+    RUN_TEST(test_literals_and_bypass_need_no_resolver);
+    RUN_TEST(test_caches_answer_until_ttl);
+    RUN_TEST(test_negative_answers_are_cached_briefly);
+    RUN_TEST(test_concurrent_lookups_are_shared);
+    RUN_TEST(test_cancel_while_the_answer_is_delivered);
+    RUN_TEST(test_lookup_without_callback_fills_the_cache);
+    RUN_TEST(test_synchronous_resolver);
+    RUN_TEST(test_pins_override_dns);
+    RUN_TEST(test_pre_resolve_and_eviction);
+    RUN_TEST(test_lookups_per_connection_workload);
+    return UNITY_END();
+}
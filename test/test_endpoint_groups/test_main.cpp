@@ -0,0 +1,214 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static const char* kOkKeepAlive = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+static const char* kRegions = "http://eu.api.example, http://us.api.example:8080";
+
+static void test_request_to_group_goes_to_an_endpoint() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    FakeTransport::gRecordWrites = true;
+    TEST_ASSERT_TRUE(client.setEndpointGroup("api", kRegions));
+    TEST_ASSERT_FALSE(client.setEndpointGroup("broken", "http://ok.example,http://"));
+
+    client.get("http://api/v1/items?page=2", onOk, onErr);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    FakeTransport* t = gTransports[0];
+    TEST_ASSERT_EQUAL_STRING("eu.api.example", t->host.c_str());
+    TEST_ASSERT_EQUAL(80, t->port);
+    t->accept();
+    TEST_ASSERT_TRUE(t->written.find("GET /v1/items?page=2 HTTP/1.1\r\nHost: eu.api.example\r\n") == 0);
+    t->respond(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+
+    // Hosts that do not name a group are left alone.
+    client.get("http://other.example/", onOk, onErr);
+    TEST_ASSERT_EQUAL_STRING("other.example", gTransports[1]->host.c_str());
+}
+
+static void test_connect_failure_fails_over_without_error() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    FakeTransport::gRecordWrites = true;
+    client.setEndpointGroup("api", kRegions);
+    FakeTransport::gRefused.insert("eu.api.example");
+
+    client.get("http://api/v1/items", onOk, onErr);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    FakeTransport* t = gTransports[1];
+    TEST_ASSERT_EQUAL_STRING("us.api.example", t->host.c_str());
+    TEST_ASSERT_EQUAL(8080, t->port);
+    t->accept();
+    TEST_ASSERT_TRUE(t->written.find("Host: us.api.example\r\n") != std::string::npos);
+    t->respond(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(0, gErrors);
+    TEST_ASSERT_EQUAL(1, (int)client.getEndpointFailovers());
+
+    // eu failed its only attempt: new requests go straight to us.
+    std::vector<AsyncHttpEndpointStats> stats = client.getEndpointStats("api");
+    TEST_ASSERT_EQUAL(2, (int)stats.size());
+    TEST_ASSERT_FALSE(stats[0].healthy);
+    TEST_ASSERT_TRUE(stats[1].healthy);
+    client.get("http://api/v1/items", onOk, onErr);
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    TEST_ASSERT_EQUAL_STRING("us.api.example", gTransports[2]->host.c_str());
+    TEST_ASSERT_EQUAL(1, (int)client.getEndpointFailovers());
+}
+
+static void test_async_connect_error_fails_over() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setEndpointGroup("api", kRegions);
+
+    client.get("http://api/", onOk, onErr);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    gTransports[0]->fail(CONNECT_TIMEOUT);
+    TEST_ASSERT_EQUAL(0, gErrors);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL_STRING("us.api.example", gTransports[1]->host.c_str());
+    gTransports[1]->accept();
+    gTransports[1]->respond(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+}
+
+static void test_error_surfaces_once_every_endpoint_failed() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setEndpointGroup("api", kRegions);
+    FakeTransport::gRefused.insert("eu.api.example");
+    FakeTransport::gRefused.insert("us.api.example");
+
+    client.get("http://api/", onOk, onErr);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gLastError);
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+}
+
+static void test_post_is_not_failed_over_after_connection_closed() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setEndpointGroup("api", kRegions);
+
+    client.post("http://api/orders", "{}", onOk, onErr);
+    gTransports[0]->accept();
+    AsyncTransport::DisconnectHandler disconnectCb = gTransports[0]->onDisconnect;
+    disconnectCb(nullptr, gTransports[0]); // the server may have processed the order
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(CONNECTION_CLOSED, gLastError);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+}
+
+static void test_faster_endpoint_gets_the_traffic() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setEndpointGroup("api", kRegions);
+
+    // One sample each: eu answers in 120 ms, us in 30 ms.
+    client.get("http://api/", onOk, onErr);
+    delay(120);
+    gTransports[0]->accept();
+    gTransports[0]->respond(kOk);
+    client.get("http://api/", onOk, onErr);
+    TEST_ASSERT_EQUAL_STRING("us.api.example", gTransports[1]->host.c_str());
+    delay(30);
+    gTransports[1]->accept();
+    gTransports[1]->respond(kOk);
+
+    for (int i = 0; i < 4; ++i) {
+        client.get("http://api/", onOk, onErr);
+        FakeTransport* t = gTransports.back();
+        TEST_ASSERT_EQUAL_STRING("us.api.example", t->host.c_str());
+        delay(30);
+        t->accept();
+        t->respond(kOk);
+    }
+    TEST_ASSERT_EQUAL(6, gSuccess);
+    std::vector<AsyncHttpEndpointStats> stats = client.getEndpointStats("api");
+    TEST_ASSERT_EQUAL(120, (int)stats[0].latencyMs);
+    TEST_ASSERT_EQUAL(30, (int)stats[1].latencyMs);
+    TEST_ASSERT_EQUAL(5, (int)stats[1].selected);
+}
+
+static void test_warm_pooled_connection_is_preferred() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    FakeTransport::gRecordWrites = true;
+    client.setKeepAlive(true, 60000);
+    client.setEndpointGroup("api", kRegions);
+
+    // eu: 40 ms, connection closed; us: 60 ms, connection kept in the pool.
+    client.get("http://api/", onOk, onErr);
+    delay(40);
+    gTransports[0]->accept();
+    gTransports[0]->respond(kOk);
+    client.get("http://api/", onOk, onErr);
+    delay(60);
+    gTransports[1]->accept();
+    gTransports[1]->respond(kOkKeepAlive);
+    TEST_ASSERT_EQUAL(1, (int)client.getConnectionPoolStats().idle);
+
+    // 60 ms on a warm connection counts as 30 ms: us wins and no connection is opened.
+    client.get("http://api/", onOk, onErr);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(1, (int)client.getConnectionPoolStats().hits);
+    TEST_ASSERT_TRUE(gTransports[1]->written.rfind("Host: us.api.example\r\n") != std::string::npos);
+    gTransports[1]->respond(kOk);
+    TEST_ASSERT_EQUAL(3, gSuccess);
+
+    // The pooled connection is gone: eu is the fastest again.
+    client.get("http://api/", onOk, onErr);
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    TEST_ASSERT_EQUAL_STRING("eu.api.example", gTransports[2]->host.c_str());
+}
+
+static void test_removed_group_is_no_longer_routed() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setEndpointGroup("api", kRegions);
+    TEST_ASSERT_TRUE(client.removeEndpointGroup("api"));
+    TEST_ASSERT_FALSE(client.removeEndpointGroup("api"));
+    TEST_ASSERT_EQUAL(0, (int)client.getEndpointStats("api").size());
+    client.get("http://api/", onOk, onErr);
+    TEST_ASSERT_EQUAL_STRING("api", gTransports[0]->host.c_str());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_request_to_group_goes_to_an_endpoint);
+    RUN_TEST(test_connect_failure_fails_over_without_error);
+    RUN_TEST(test_async_connect_error_fails_over);
+    RUN_TEST(test_error_surfaces_once_every_endpoint_failed);
+    RUN_TEST(test_post_is_not_failed_over_after_connection_closed);
+    RUN_TEST(test_faster_endpoint_gets_the_traffic);
+    RUN_TEST(test_warm_pooled_connection_is_preferred);
+    RUN_TEST(test_removed_group_is_no_longer_routed);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
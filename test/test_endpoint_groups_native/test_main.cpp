@@ -0,0 +1,156 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "EndpointGroups.h"
+
+static const std::vector<std::string> kRegions = {"https://eu.api.example", "https://us.api.example",
+                                                  "http://10.0.0.3:8080/ignored"};
+
+static void test_parses_endpoints_and_rejects_bad_lists() {
+    EndpointGroups groups;
+    TEST_ASSERT_TRUE(groups.empty());
+    TEST_ASSERT_TRUE(groups.setGroup("API", kRegions));
+    TEST_ASSERT_TRUE(groups.hasGroup("api"));
+    TEST_ASSERT_EQUAL(3, (int)groups.size("Api"));
+    const EndpointGroups::Endpoint* third = groups.endpoint("api", 2);
+    TEST_ASSERT_NOT_NULL(third);
+    TEST_ASSERT_EQUAL_STRING("10.0.0.3", third->host.c_str());
+    TEST_ASSERT_EQUAL(8080, third->port);
+    TEST_ASSERT_FALSE(third->secure);
+    TEST_ASSERT_TRUE(groups.endpoint("api", 0)->secure);
+    TEST_ASSERT_EQUAL(443, groups.endpoint("api", 0)->port);
+    TEST_ASSERT_NULL(groups.endpoint("api", 3));
+
+    TEST_ASSERT_FALSE(groups.setGroup("empty", {}));
+    TEST_ASSERT_FALSE(groups.setGroup("bad", {"https://ok.example", "http://"}));
+    TEST_ASSERT_FALSE(groups.hasGroup("bad"));
+    TEST_ASSERT_TRUE(groups.removeGroup("API"));
+    TEST_ASSERT_FALSE(groups.removeGroup("api"));
+    TEST_ASSERT_TRUE(groups.empty());
+}
+
+static void test_unsampled_endpoints_are_tried_first_then_lowest_latency_wins() {
+    EndpointGroups groups;
+    groups.setGroup("api", kRegions);
+    // Each endpoint gets one request before the averages decide.
+    int first = groups.select("api", 0, 0, nullptr);
+    groups.recordSuccess("api", first, 120);
+    int second = groups.select("api", 0, 0, nullptr);
+    groups.recordSuccess("api", second, 40);
+    int third = groups.select("api", 0, 0, nullptr);
+    groups.recordSuccess("api", third, 80);
+    TEST_ASSERT_TRUE(first != second && second != third && first != third);
+
+    for (int i = 0; i < 5; ++i)
+        TEST_ASSERT_EQUAL(second, groups.select("api", 0, 0, nullptr));
+    // Excluded endpoints (already tried by the request) are skipped.
+    TEST_ASSERT_EQUAL(third, groups.select("api", 1u << second, 0, nullptr));
+    TEST_ASSERT_EQUAL(-1, groups.select("api", 0x7, 0, nullptr));
+    TEST_ASSERT_EQUAL(-1, groups.select("unknown", 0, 0, nullptr));
+}
+
+static void test_latency_average_follows_the_endpoint() {
+    EndpointGroups groups;
+    AsyncHttpEndpointPolicy policy;
+    policy.ewmaWeightPercent = 50;
+    groups.configure(policy);
+    groups.setGroup("api", {"http://a.example", "http://b.example"});
+    groups.recordSuccess("api", 0, 40);
+    groups.recordSuccess("api", 1, 60);
+    TEST_ASSERT_EQUAL(0, groups.select("api", 0, 0, nullptr));
+    // a.example slows down: after two samples its average (40 -> 120 -> 160) is above b's.
+    groups.recordSuccess("api", 0, 200);
+    TEST_ASSERT_EQUAL(120, groups.endpoint("api", 0)->latencyMs);
+    groups.recordSuccess("api", 0, 200);
+    TEST_ASSERT_EQUAL(1, groups.select("api", 0, 0, nullptr));
+}
+
+static void test_warm_endpoint_is_preferred_within_the_bonus() {
+    EndpointGroups groups;
+    groups.setGroup("api", {"https://near.example", "https://far.example"});
+    groups.recordSuccess("api", 0, 60);
+    groups.recordSuccess("api", 1, 100);
+    EndpointGroups::WarmProbe farIsWarm = [](const EndpointGroups::Endpoint& endpoint) {
+        return endpoint.host == "far.example";
+    };
+    // 100 ms with a pooled connection counts as 50 ms (default 50% bonus): cheaper than a new connection to near.
+    TEST_ASSERT_EQUAL(1, groups.select("api", 0, 0, farIsWarm));
+    groups.recordSuccess("api", 1, 400);
+    groups.recordSuccess("api", 1, 400); // now ~208 ms: the bonus no longer covers it
+    TEST_ASSERT_EQUAL(0, groups.select("api", 0, 0, farIsWarm));
+}
+
+static void test_failing_endpoint_is_skipped_until_retry_interval() {
+    EndpointGroups groups;
+    AsyncHttpEndpointPolicy policy;
+    policy.retryUnhealthyMs = 1000;
+    groups.configure(policy);
+    groups.setGroup("api", {"http://a.example", "http://b.example"});
+    groups.recordSuccess("api", 0, 10);
+    groups.recordSuccess("api", 1, 50);
+    uint32_t start = 0xFFFFFF00u; // millis() wraps while a.example is unhealthy
+    for (int i = 0; i < 4; ++i)
+        groups.recordFailure("api", 0, start);
+    std::vector<AsyncHttpEndpointStats> stats = groups.stats("api", start);
+    TEST_ASSERT_EQUAL(2, (int)stats.size());
+    TEST_ASSERT_FALSE(stats[0].healthy);
+    TEST_ASSERT_TRUE(stats[0].failurePercent >= 50);
+    TEST_ASSERT_EQUAL(4, (int)stats[0].failures);
+    TEST_ASSERT_TRUE(stats[1].healthy);
+
+    TEST_ASSERT_EQUAL(1, groups.select("api", 0, start + 999, nullptr));
+    // Retry interval elapsed: a.example is probed again and recovers with its successes.
+    TEST_ASSERT_EQUAL(0, groups.select("api", 0, start + 1000, nullptr));
+    for (int i = 0; i < 4; ++i)
+        groups.recordSuccess("api", 0, 10);
+    TEST_ASSERT_TRUE(groups.stats("api", start + 1000)[0].failurePercent < 50);
+    TEST_ASSERT_TRUE(groups.stats("api", start + 1000)[0].healthy);
+}
+
+static void test_first_connection_failure_marks_endpoint_unhealthy() {
+    EndpointGroups groups;
+    groups.setGroup("api", {"http://a.example", "http://b.example"});
+    TEST_ASSERT_EQUAL(0, groups.select("api", 0, 100, nullptr));
+    groups.recordFailure("api", 0, 100);
+    TEST_ASSERT_FALSE(groups.stats("api", 100)[0].healthy);
+    TEST_ASSERT_EQUAL(1, groups.select("api", 0, 100, nullptr));
+}
+
+static void test_all_unhealthy_uses_the_one_that_failed_longest_ago() {
+    EndpointGroups groups;
+    groups.setGroup("api", kRegions);
+    groups.recordFailure("api", 0, 300);
+    groups.recordFailure("api", 1, 100);
+    groups.recordFailure("api", 2, 200);
+    TEST_ASSERT_EQUAL(1, groups.select("api", 0, 400, nullptr));
+    TEST_ASSERT_EQUAL(2, groups.select("api", 1u << 1, 400, nullptr));
+}
+
+static void test_replacing_a_group_resets_its_statistics() {
+    EndpointGroups groups;
+    groups.setGroup("api", {"http://a.example"});
+    groups.recordFailure("api", 0, 0);
+    TEST_ASSERT_TRUE(groups.setGroup("api", {"http://a.example", "http://b.example"}));
+    std::vector<AsyncHttpEndpointStats> stats = groups.stats("api", 0);
+    TEST_ASSERT_EQUAL(2, (int)stats.size());
+    TEST_ASSERT_EQUAL(0, (int)stats[0].failures);
+    TEST_ASSERT_TRUE(stats[0].healthy);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_endpoints_and_rejects_bad_lists);
+    RUN_TEST(test_unsampled_endpoints_are_tried_first_then_lowest_latency_wins);
+    RUN_TEST(test_latency_average_follows_the_endpoint);
+    RUN_TEST(test_warm_endpoint_is_preferred_within_the_bonus);
+    RUN_TEST(test_failing_endpoint_is_skipped_until_retry_interval);
+    RUN_TEST(test_first_connection_failure_marks_endpoint_unhealthy);
+    RUN_TEST(test_all_unhealthy_uses_the_one_that_failed_longest_ago);
+    RUN_TEST(test_replacing_a_group_resets_its_statistics);
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+
+static const char* kLoginResponse = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: close\r\n\r\ntoken";
+static const char* kConfigResponse = "HTTP/1.1 201 Created\r\nContent-Length: 3\r\nConnection: close\r\n\r\ncfg";
+
+static void test_then_runs_on_completion() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    int calls = 0;
+    int status = 0;
+    AsyncHttpFuture future = client.getAsync("http://api.example/login");
+    TEST_ASSERT_TRUE(future.valid());
+    TEST_ASSERT_FALSE(future.isReady());
+    TEST_ASSERT_TRUE(future.requestId() != 0);
+    future.then([&](AsyncHttpResult& result) {
+        calls++;
+        if (result.success)
+            status = result.response->getStatusCode();
+    });
+    TEST_ASSERT_FALSE(future.valid()); // consumed by then()
+    client.loop();
+    TEST_ASSERT_EQUAL(0, calls);
+    gTransports[0]->serve(kLoginResponse);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(200, status);
+}
+
+static void test_errors_complete_the_future() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    HttpClientError error = ABORTED;
+    String message;
+    client.getAsync("http://api.example/login").then([&](AsyncHttpResult& result) {
+        TEST_ASSERT_FALSE(result.success);
+        error = result.error;
+        message = result.errorMessage;
+    });
+    client.loop();
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, error);
+    TEST_ASSERT_TRUE(message.length() > 0);
+}
+
+static void test_then_on_ready_future_runs_immediately() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpFuture future = client.getAsync(""); // rejected synchronously
+    TEST_ASSERT_TRUE(future.isReady());
+    TEST_ASSERT_EQUAL(0, (int)future.requestId());
+    TEST_ASSERT_FALSE(future.result().success);
+    int calls = 0;
+    future.then([&](AsyncHttpResult& result) {
+        calls++;
+        TEST_ASSERT_EQUAL(CONNECTION_FAILED, result.error);
+    });
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(0, (int)gTransports.size());
+}
+
+static void test_chained_requests_run_in_sequence() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    String body;
+    int finalStatus = 0;
+    client.getAsync("http://api.example/login")
+        .then([&](AsyncHttpResult& login) {
+            if (!login.success)
+                return AsyncHttpFuture::makeReady(std::move(login));
+            body = login.response->getBody();
+            return client.postAsync("http://api.example/config", "{}");
+        })
+        .then([&](AsyncHttpResult& config) {
+            if (config.success)
+                finalStatus = config.response->getStatusCode();
+        });
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size()); // the second call waits for the first
+    gTransports[0]->serve(kLoginResponse);
+    TEST_ASSERT_EQUAL_STRING("token", body.c_str());
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(0, finalStatus);
+    gTransports[1]->serve(kConfigResponse);
+    TEST_ASSERT_EQUAL(201, finalStatus);
+}
+
+static void test_chain_short_circuits_on_error() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    HttpClientError error = CONNECTION_FAILED;
+    client.getAsync("http://api.example/login")
+        .then([&](AsyncHttpResult& login) {
+            if (!login.success)
+                return AsyncHttpFuture::makeReady(std::move(login));
+            return client.getAsync("http://api.example/config");
+        })
+        .then([&](AsyncHttpResult& config) { error = config.error; });
+    client.loop();
+    TEST_ASSERT_TRUE(client.abort(client._activeRequests[0]->id));
+    TEST_ASSERT_EQUAL(ABORTED, error);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+}
+
+#if ASYNC_HTTP_HAS_COROUTINES
+static int gStep = 0;
+static int gCoroutineStatus = 0;
+static HttpClientError gCoroutineError = CONNECTION_FAILED;
+
+static AsyncHttpTask loginThenConfig(AsyncHttpClient& client) {
+    gStep = 1;
+    AsyncHttpResult login = co_await client.getAsync("http://api.example/login");
+    gStep = 2;
+    if (!login.success) {
+        gCoroutineError = login.error;
+        co_return;
+    }
+    AsyncHttpResult config = co_await client.postAsync("http://api.example/config", login.response->getBody().c_str());
+    gStep = 3;
+    gCoroutineStatus = config.success ? config.response->getStatusCode() : 0;
+}
+
+static void test_coroutine_resumes_on_each_completion() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    gStep = 0;
+    gCoroutineStatus = 0;
+    loginThenConfig(client);
+    TEST_ASSERT_EQUAL(1, gStep); // suspended, the caller is not blocked
+    client.loop();
+    gTransports[0]->serve(kLoginResponse);
+    TEST_ASSERT_EQUAL(2, gStep);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[1]->serve(kConfigResponse);
+    TEST_ASSERT_EQUAL(3, gStep);
+    TEST_ASSERT_EQUAL(201, gCoroutineStatus);
+}
+
+static void test_coroutine_sees_errors_and_ready_futures() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    gStep = 0;
+    gCoroutineError = ABORTED;
+    loginThenConfig(client);
+    client.loop();
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(2, gStep);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gCoroutineError);
+
+    // A synchronously rejected request does not suspend at all.
+    struct Local {
+        static AsyncHttpTask run(AsyncHttpClient& c, HttpClientError* out) {
+            AsyncHttpResult r = co_await c.getAsync("");
+            *out = r.error;
+        }
+    };
+    HttpClientError error = ABORTED;
+    Local::run(client, &error);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, error);
+}
+#endif
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_then_runs_on_completion);
+    RUN_TEST(test_errors_complete_the_future);
+    RUN_TEST(test_then_on_ready_future_runs_immediately);
+    RUN_TEST(test_chained_requests_run_in_sequence);
+    RUN_TEST(test_chain_short_circuits_on_error);
+#if ASYNC_HTTP_HAS_COROUTINES
+    RUN_TEST(test_coroutine_resumes_on_each_completion);
+    RUN_TEST(test_coroutine_sees_errors_and_ready_futures);
+#endif
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "GzipDecoder.h"
+#include "ObjectPool.h"
 
 static const uint8_t kGzipHello[] = {
     0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0xd7, 0x51,
@@ -159,6 +160,21 @@ static void test_gzip_isize_mismatch_fails() {
     TEST_ASSERT_TRUE(strlen(dec.lastError()) > 0);
 }
 
+static void test_inflate_window_comes_from_pool() {
+    AsyncHttpPoolConfig config;
+    config.gzipWindows = 1;
+    TEST_ASSERT_TRUE(HttpObjectPools::configure(config));
+    const std::vector<uint8_t> gz(kGzipHello, kGzipHello + sizeof(kGzipHello));
+    TEST_ASSERT_EQUAL_STRING("Hello, gzip!\n", decodeGzipInChunks(gz, gz.size()).c_str());
+    TEST_ASSERT_EQUAL_STRING("Hello, gzip!\n", decodeGzipInChunks(gz, 3).c_str());
+    BlockPool::Stats stats = HttpObjectPools::stats().gzipWindows;
+    TEST_ASSERT_EQUAL(0, (int)stats.inUse); // released by the decoder's destructor
+    TEST_ASSERT_EQUAL(1, (int)stats.highWater);
+    TEST_ASSERT_EQUAL(0, (int)stats.misses);
+    TEST_ASSERT_TRUE(stats.blockSize >= 32768);
+    TEST_ASSERT_TRUE(HttpObjectPools::configure(AsyncHttpPoolConfig()));
+}
+
 int main(int argc, char** argv) {
     (void)argc;
     (void)argv;
@@ -170,5 +186,6 @@ int main(int argc, char** argv) {
     RUN_TEST(test_truncated_gzip_fails);
     RUN_TEST(test_gzip_crc_mismatch_fails);
     RUN_TEST(test_gzip_isize_mismatch_fails);
+    RUN_TEST(test_inflate_window_comes_from_pool);
     return UNITY_END();
 }
@@ -0,0 +1,58 @@
+#include <unity.h>
+
+#include "HedgePolicy.h"
+
+static void test_percentile_nearest_rank() {
+    LatencyWindow window;
+    TEST_ASSERT_EQUAL(0, window.percentile(95));
+    for (uint32_t ms = 10; ms <= 100; ms += 10) // 10..100, shuffled order does not matter
+        window.record(ms);
+    TEST_ASSERT_EQUAL(10, (int)window.size());
+    TEST_ASSERT_EQUAL(50, window.percentile(50));
+    TEST_ASSERT_EQUAL(90, window.percentile(90));
+    TEST_ASSERT_EQUAL(100, window.percentile(95));
+    TEST_ASSERT_EQUAL(10, window.percentile(1));
+}
+
+static void test_window_keeps_most_recent_samples() {
+    LatencyWindow window;
+    for (size_t i = 0; i < LatencyWindow::kCapacity; ++i)
+        window.record(1000);
+    for (size_t i = 0; i < LatencyWindow::kCapacity; ++i)
+        window.record(20);
+    TEST_ASSERT_EQUAL((int)LatencyWindow::kCapacity, (int)window.size());
+    TEST_ASSERT_EQUAL(20, window.percentile(100)); // the slow samples were overwritten
+}
+
+static void test_effective_delay() {
+    AsyncHttpHedgePolicy policy;
+    TEST_ASSERT_FALSE(policy.enabled());
+    policy.delayMs = 300;
+    TEST_ASSERT_TRUE(policy.enabled());
+
+    LatencyWindow window;
+    TEST_ASSERT_EQUAL(300, policy.effectiveDelayMs(window)); // fixed delay
+
+    policy.latencyPercentile = 90;
+    policy.minSamples = 4;
+    window.record(5);
+    window.record(5);
+    window.record(8);
+    TEST_ASSERT_EQUAL(300, policy.effectiveDelayMs(window)); // not enough samples yet
+    window.record(9);
+    TEST_ASSERT_EQUAL(20, policy.effectiveDelayMs(window)); // p90 = 9, raised to minDelayMs
+    for (int i = 0; i < 4; ++i)
+        window.record(150);
+    TEST_ASSERT_EQUAL(150, policy.effectiveDelayMs(window));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_percentile_nearest_rank);
+    RUN_TEST(test_window_keeps_most_recent_samples);
+    RUN_TEST(test_effective_delay);
+    return UNITY_END();
+}
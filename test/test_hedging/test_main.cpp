@@ -0,0 +1,149 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static AsyncHttpHedgePolicy hedgeAfter(uint32_t delayMs) {
+    AsyncHttpHedgePolicy policy;
+    policy.delayMs = delayMs;
+    return policy;
+}
+
+static const char* kFromOriginal = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\nConnection: close\r\n\r\norig";
+static const char* kFromHedge = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhedge";
+
+// Sends a GET whose first connection stalls, then lets the hedge delay elapse.
+static uint32_t startStalledGet(AsyncHttpClient& client) {
+    size_t before = gTransports.size();
+    uint32_t fired = client.getHedgesFired();
+    uint32_t id = client.get("http://config.example/settings", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(before + 1, gTransports.size());
+    delay(60);
+    client.loop(); // 60 ms < 100 ms delay
+    TEST_ASSERT_EQUAL(before + 1, gTransports.size());
+    delay(40);
+    client.loop();
+    TEST_ASSERT_EQUAL(before + 2, gTransports.size());
+    TEST_ASSERT_EQUAL(fired + 1, client.getHedgesFired());
+    TEST_ASSERT_EQUAL(id, client._activeRequests[1]->id); // the copy shares the request id
+    return id;
+}
+
+static void test_hedge_copy_wins_and_original_is_cancelled() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setHedgePolicy(hedgeAfter(100));
+    startStalledGet(client);
+
+    gTransports[1]->serve(kFromHedge);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(0, gErrors);
+    TEST_ASSERT_EQUAL_STRING("hedge", gLastBody.c_str());
+    TEST_ASSERT_EQUAL(1, (int)client.getHedgesWon());
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(2, FakeTransport::gDestroyed); // the stalled connection was closed too
+
+    delay(200);
+    client.loop(); // nothing left to hedge
+    TEST_ASSERT_EQUAL(1, (int)client.getHedgesFired());
+}
+
+static void test_original_wins_and_copy_is_cancelled() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setHedgePolicy(hedgeAfter(100));
+    startStalledGet(client);
+
+    gTransports[0]->serve(kFromOriginal);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL_STRING("orig", gLastBody.c_str());
+    TEST_ASSERT_EQUAL(0, (int)client.getHedgesWon());
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(2, FakeTransport::gDestroyed);
+}
+
+static void test_failure_of_one_copy_hands_over_to_the_other() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setHedgePolicy(hedgeAfter(100));
+    startStalledGet(client);
+    gTransports[1]->fail(); // the copy fails: silent
+    TEST_ASSERT_EQUAL(0, gErrors);
+    gTransports[0]->serve(kFromOriginal);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+
+    resetCounters();
+    startStalledGet(client); // transports 2 and 3
+    gTransports[2]->fail();  // now the original fails: the copy inherits the callbacks
+    TEST_ASSERT_EQUAL(0, gErrors);
+    gTransports[3]->serve(kFromHedge);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL_STRING("hedge", gLastBody.c_str());
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+}
+
+static void test_both_copies_failing_reports_one_error() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setHedgePolicy(hedgeAfter(100));
+    startStalledGet(client);
+    gTransports[0]->fail();
+    gTransports[1]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gLastError);
+    TEST_ASSERT_EQUAL(0, gSuccess);
+}
+
+static void test_non_idempotent_requests_are_not_hedged() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setHedgePolicy(hedgeAfter(100));
+    client.post("http://config.example/settings", "{}", onOk, onErr);
+    delay(300);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(0, (int)client.getHedgesFired());
+}
+
+static void test_abort_cancels_both_copies() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setHedgePolicy(hedgeAfter(100));
+    uint32_t id = startStalledGet(client);
+    TEST_ASSERT_TRUE(client.abort(id));
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(ABORTED, gLastError);
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+    TEST_ASSERT_EQUAL(2, FakeTransport::gDestroyed);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hedge_copy_wins_and_original_is_cancelled);
+    RUN_TEST(test_original_wins_and_copy_is_cancelled);
+    RUN_TEST(test_failure_of_one_copy_hands_over_to_the_other);
+    RUN_TEST(test_both_copies_failing_reports_one_error);
+    RUN_TEST(test_non_idempotent_requests_are_not_hedged);
+    RUN_TEST(test_abort_cancels_both_copies);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
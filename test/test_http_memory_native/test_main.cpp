@@ -0,0 +1,142 @@
+#include <unity.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "HttpMemory.h"
+
+struct RegionCounts {
+    int internal = 0;
+    int external = 0;
+    int released = 0;
+};
+
+static void* countingAllocate(size_t size, AsyncHttpMemoryRegion region, void* user) {
+    RegionCounts* counts = static_cast<RegionCounts*>(user);
+    (region == AsyncHttpMemoryRegion::kExternal ? counts->external : counts->internal)++;
+    return malloc(size);
+}
+
+static void* countingReallocate(void* p, size_t size, AsyncHttpMemoryRegion region, void* user) {
+    RegionCounts* counts = static_cast<RegionCounts*>(user);
+    (region == AsyncHttpMemoryRegion::kExternal ? counts->external : counts->internal)++;
+    return realloc(p, size);
+}
+
+static void countingRelease(void* p, void* user) {
+    static_cast<RegionCounts*>(user)->released++;
+    free(p);
+}
+
+static RegionCounts gCounts;
+
+static void installCountingAllocator() {
+    gCounts = RegionCounts();
+    AsyncHttpAllocator allocator;
+    allocator.allocate = countingAllocate;
+    allocator.reallocate = countingReallocate;
+    allocator.release = countingRelease;
+    allocator.user = &gCounts;
+    HttpMemory::setAllocator(allocator);
+}
+
+static void restoreDefaults() {
+    HttpMemory::setAllocator(AsyncHttpAllocator());
+    HttpMemory::setPlacementPolicy(AsyncHttpPlacementPolicy());
+}
+
+static void test_policy_off_keeps_everything_internal() {
+    restoreDefaults();
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kResponseBody, 1 << 20) ==
+                     AsyncHttpMemoryRegion::kInternal);
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kGzipWindow, 1 << 20) ==
+                     AsyncHttpMemoryRegion::kInternal);
+}
+
+static void test_policy_places_large_cold_buffers_externally() {
+    restoreDefaults();
+    AsyncHttpPlacementPolicy policy;
+    policy.enabled = true;
+    policy.externalThreshold = 1024;
+    HttpMemory::setPlacementPolicy(policy);
+
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kResponseBody, 1023) ==
+                     AsyncHttpMemoryRegion::kInternal);
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kResponseBody, 1024) ==
+                     AsyncHttpMemoryRegion::kExternal);
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kGzipWindow, 32768) ==
+                     AsyncHttpMemoryRegion::kExternal);
+    // Hot buffers stay internal whatever their size unless the policy says otherwise.
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kReceiveBuffer, 32768) ==
+                     AsyncHttpMemoryRegion::kInternal);
+    TEST_ASSERT_TRUE(HttpMemory::regionFor(AsyncHttpBufferKind::kTlsRecord, 32768) ==
+                     AsyncHttpMemoryRegion::kInternal);
+    restoreDefaults();
+}
+
+static void test_buffer_moves_to_external_region_as_it_grows() {
+    installCountingAllocator();
+    AsyncHttpPlacementPolicy policy;
+    policy.enabled = true;
+    policy.externalThreshold = 1024;
+    HttpMemory::setPlacementPolicy(policy);
+    {
+        HttpBuffer body(AsyncHttpBufferKind::kResponseBody);
+        std::vector<char> packet(256, 'a');
+        body.concat(packet.data(), packet.size());
+        TEST_ASSERT_EQUAL(0, gCounts.external);
+        for (int i = 0; i < 8; ++i)
+            body.concat(packet.data(), packet.size());
+        TEST_ASSERT_TRUE(gCounts.external > 0);
+        TEST_ASSERT_EQUAL(9 * 256, (int)body.length());
+        TEST_ASSERT_EQUAL('\0', body.c_str()[body.length()]);
+    }
+    TEST_ASSERT_EQUAL(1, gCounts.released);
+    restoreDefaults();
+}
+
+static void test_buffer_is_binary_safe() {
+    HttpBuffer buffer(AsyncHttpBufferKind::kReceiveBuffer);
+    static const char kData[] = "ab\0cd\r\n\r\nbody";
+    buffer.concat(kData, sizeof(kData) - 1);
+    TEST_ASSERT_EQUAL(13, (int)buffer.length());
+    TEST_ASSERT_EQUAL(5, buffer.indexOf("\r\n\r\n"));
+    TEST_ASSERT_EQUAL(2, buffer.indexOf('\0'));
+    TEST_ASSERT_EQUAL(-1, buffer.indexOf("\r\n", 8));
+    TEST_ASSERT_EQUAL(7, buffer.indexOf("\r\n", 6));
+
+    buffer.remove(0, 9);
+    TEST_ASSERT_EQUAL_STRING("body", buffer.c_str());
+    buffer.remove(2, 100); // clamped
+    TEST_ASSERT_EQUAL_STRING("bo", buffer.c_str());
+
+    size_t capacity = buffer.capacity();
+    buffer.clear();
+    TEST_ASSERT_EQUAL(0, (int)buffer.length());
+    TEST_ASSERT_EQUAL(capacity, buffer.capacity());
+    TEST_ASSERT_EQUAL('\0', buffer.charAt(0));
+}
+
+static void test_buffer_copy_and_move() {
+    HttpBuffer a(AsyncHttpBufferKind::kResponseBody);
+    a.concat("hello", 5);
+    HttpBuffer b(a);
+    TEST_ASSERT_EQUAL_STRING("hello", b.c_str());
+    HttpBuffer c(std::move(a));
+    TEST_ASSERT_EQUAL_STRING("hello", c.c_str());
+    TEST_ASSERT_EQUAL(0, (int)a.length());
+    TEST_ASSERT_EQUAL_STRING("", a.c_str());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_policy_off_keeps_everything_internal);
+    RUN_TEST(test_policy_places_large_cold_buffers_externally);
+    RUN_TEST(test_buffer_moves_to_external_region_as_it_grows);
+    RUN_TEST(test_buffer_is_binary_safe);
+    RUN_TEST(test_buffer_copy_and_move);
+    return UNITY_END();
+}
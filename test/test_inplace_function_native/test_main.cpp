@@ -0,0 +1,143 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+
+#include "InplaceFunction.h"
+
+static size_t gAllocations = 0;
+
+void* operator new(size_t size) {
+    gAllocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        std::abort();
+    return p;
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+struct Tracked {
+    static int alive;
+    int value;
+    explicit Tracked(int v) : value(v) {
+        alive++;
+    }
+    Tracked(const Tracked& other) : value(other.value) {
+        alive++;
+    }
+    ~Tracked() {
+        alive--;
+    }
+};
+int Tracked::alive = 0;
+
+typedef InplaceFunction<int(int, int)> BinaryFn;
+
+static void test_invokes_and_reports_emptiness() {
+    BinaryFn empty;
+    TEST_ASSERT_FALSE(empty);
+    BinaryFn fromNull = nullptr;
+    TEST_ASSERT_FALSE(fromNull);
+
+    int bias = 10;
+    BinaryFn add = [bias](int a, int b) { return a + b + bias; };
+    TEST_ASSERT_TRUE(add);
+    TEST_ASSERT_EQUAL(13, add(1, 2));
+    add = nullptr;
+    TEST_ASSERT_FALSE(add);
+
+    BinaryFn plain = static_cast<int (*)(int, int)>([](int a, int b) { return a * b; });
+    TEST_ASSERT_EQUAL(6, plain(2, 3));
+}
+
+static void test_copy_move_and_destruction() {
+    {
+        Tracked tracked(7);
+        InplaceFunction<int()> fn = [tracked]() { return tracked.value; };
+        TEST_ASSERT_EQUAL(2, Tracked::alive);
+
+        InplaceFunction<int()> copy = fn;
+        TEST_ASSERT_EQUAL(3, Tracked::alive);
+        TEST_ASSERT_EQUAL(7, copy());
+        TEST_ASSERT_EQUAL(7, fn());
+
+        InplaceFunction<int()> moved = std::move(fn);
+        TEST_ASSERT_FALSE(fn);
+        TEST_ASSERT_EQUAL(3, Tracked::alive); // moved, not duplicated
+        TEST_ASSERT_EQUAL(7, moved());
+
+        copy = moved; // copy-assign over a live callable destroys the old one
+        TEST_ASSERT_EQUAL(3, Tracked::alive);
+        moved = nullptr;
+        TEST_ASSERT_EQUAL(2, Tracked::alive);
+    }
+    TEST_ASSERT_EQUAL(0, Tracked::alive);
+}
+
+static void test_mutable_state_and_reference_arguments() {
+    int calls = 0;
+    InplaceFunction<void(int&)> bump = [&calls](int& value) {
+        calls++;
+        value *= 2;
+    };
+    int value = 4;
+    bump(value);
+    bump(value);
+    TEST_ASSERT_EQUAL(16, value);
+    TEST_ASSERT_EQUAL(2, calls);
+
+    InplaceFunction<int()> counter = [n = 0]() mutable { return ++n; };
+    counter();
+    TEST_ASSERT_EQUAL(2, counter());
+}
+
+// The transport handler shape: a client pointer plus a smart pointer to the request context. std::function keeps
+// such a capture on the heap (not trivially copyable); InplaceFunction never allocates.
+static void test_handler_shaped_capture_does_not_allocate() {
+    std::shared_ptr<int> context = std::make_shared<int>(5);
+    std::weak_ptr<int> weak = context;
+    void* client = &context;
+
+    size_t before = gAllocations;
+    InplaceFunction<void(void*, size_t)> handler = [client, weak](void* data, size_t len) {
+        (void)client;
+        (void)data;
+        (void)len;
+    };
+    InplaceFunction<void(void*, size_t)> copy = handler;
+    InplaceFunction<void(void*, size_t)> moved = std::move(copy);
+    moved(nullptr, 0);
+    TEST_ASSERT_EQUAL(0, (int)(gAllocations - before));
+
+    before = gAllocations;
+    std::function<void(void*, size_t)> reference = [client, weak](void* data, size_t len) {
+        (void)client;
+        (void)data;
+        (void)len;
+    };
+    std::function<void(void*, size_t)> referenceCopy = reference;
+    char msg[96];
+    snprintf(msg, sizeof(msg), "std::function: %u allocations for construct + copy, InplaceFunction: 0",
+             (unsigned)(gAllocations - before));
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_invokes_and_reports_emptiness);
+    RUN_TEST(test_copy_move_and_destruction);
+    RUN_TEST(test_mutable_state_and_reference_arguments);
+    RUN_TEST(test_handler_shaped_capture_does_not_allocate);
+    return UNITY_END();
+}
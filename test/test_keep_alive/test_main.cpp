@@ -1,5 +1,9 @@
 #include <Arduino.h>
 #include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
 #define private public
 #include "AsyncHttpClient.h"
@@ -89,9 +93,8 @@ static void test_pools_connection_on_complete_body() {
     ctx->headersComplete = true;
     client.processResponse(ctx);
 
-    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->_idleConnections.size());
-    TEST_ASSERT_EQUAL_STRING("example.com", client._connectionPool->_idleConnections[0].host.c_str());
-    TEST_ASSERT_EQUAL(80, client._connectionPool->_idleConnections[0].port);
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount("http://example.com:80"));
 }
 
 static bool gErrorCalled = false;
@@ -123,7 +126,7 @@ static void test_does_not_pool_on_truncated_body() {
 
     TEST_ASSERT_TRUE(gErrorCalled);
     TEST_ASSERT_EQUAL(CONNECTION_CLOSED_MID_BODY, gLastError);
-    TEST_ASSERT_EQUAL(0, (int)client._connectionPool->_idleConnections.size());
+    TEST_ASSERT_EQUAL(0, (int)client._connectionPool->idleCount());
 }
 
 static void test_reuses_pooled_connection() {
@@ -142,8 +145,9 @@ static void test_reuses_pooled_connection() {
     poolCtx->response->setStatusCode(200);
     client.cleanup(poolCtx);
 
-    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->_idleConnections.size());
-    MockTransport* pooled = static_cast<MockTransport*>(client._connectionPool->_idleConnections[0].transport);
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
+    MockTransport* pooled =
+        static_cast<MockTransport*>(client._connectionPool->_idle["http://example.com:80"].connections[0].transport);
 
     auto ctx = new AsyncHttpClient::RequestContext();
     ctx->request.reset(new AsyncHttpRequest(HTTP_METHOD_GET, "http://example.com/"));
@@ -160,15 +164,271 @@ static void test_reuses_pooled_connection() {
     const char* frame = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\nConnection: keep-alive\r\n\r\nTEST";
     client.handleData(ctx, const_cast<char*>(frame), strlen(frame));
 
-    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->_idleConnections.size());
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
     TEST_ASSERT_FALSE(pooled->closed());
 }
 
+// Server side of a keep-alive connection that closes it after `kServerIdleMs` without a request. The client learns
+// about the close only when it next uses the socket (canSend() stays true), as with a FIN still in flight.
+static const uint32_t kServerIdleMs = 2000;
+
+class ServerSocket : public AsyncTransport {
+  public:
+    ServerSocket() {
+        gLive.push_back(this);
+    }
+    ~ServerSocket() override {
+        gLive.erase(std::find(gLive.begin(), gLive.end(), this));
+    }
+    void setConnectHandler(ConnectHandler handler, void* arg) override {
+        (void)arg;
+        onConnect = handler;
+    }
+    void setDataHandler(DataHandler handler, void* arg) override {
+        (void)arg;
+        onData = handler;
+    }
+    void setDisconnectHandler(DisconnectHandler handler, void* arg) override {
+        (void)arg;
+        onDisconnect = handler;
+    }
+    void setErrorHandler(ErrorHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    void setTimeout(uint32_t timeoutMs) override {
+        (void)timeoutMs;
+    }
+    void setTimeoutHandler(TimeoutHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    bool connect(const char* host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        return true;
+    }
+    size_t write(const char* data, size_t len) override {
+        (void)data;
+        pending = true;
+        return len;
+    }
+    bool canSend() const override {
+        return !closed;
+    }
+    void close(bool now = false) override {
+        (void)now;
+        closed = true;
+    }
+    bool isSecure() const override {
+        return false;
+    }
+    bool isHandshaking() const override {
+        return false;
+    }
+    uint32_t getHandshakeStartMs() const override {
+        return 0;
+    }
+    uint32_t getHandshakeTimeoutMs() const override {
+        return 0;
+    }
+
+    // Plays the server for every socket until nothing is left to do: completes new connections, then answers (or,
+    // when the server already timed the connection out, closes) each written request. The client may delete sockets
+    // and open new ones (replays) from the handlers.
+    static void serveAll(bool advertise) {
+        for (bool progress = true; progress;) {
+            progress = false;
+            std::vector<ServerSocket*> sockets = gLive;
+            for (ServerSocket* socket : sockets) {
+                if (std::find(gLive.begin(), gLive.end(), socket) == gLive.end())
+                    continue;
+                if (!socket->opened && socket->onConnect) {
+                    socket->opened = true;
+                    progress = true;
+                    ConnectHandler connectCb = socket->onConnect;
+                    connectCb(nullptr, socket);
+                } else if (socket->pending) {
+                    progress = true;
+                    socket->serve(advertise);
+                }
+            }
+        }
+    }
+
+    void serve(bool advertise) {
+        pending = false;
+        uint32_t now = millis();
+        bool timedOut = servedOnce && now - lastServedMs >= kServerIdleMs;
+        if (timedOut || (!servedOnce && gCloseFreshConnections)) {
+            closed = true;
+            DisconnectHandler disconnectCb = onDisconnect;
+            disconnectCb(nullptr, this);
+            return;
+        }
+        servedOnce = true;
+        lastServedMs = now;
+        const char* response = advertise ? "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n"
+                                           "Keep-Alive: timeout=2, max=100\r\n\r\nok"
+                                         : "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+        std::vector<char> buf(response, response + strlen(response));
+        DataHandler dataCb = onData;
+        dataCb(nullptr, this, buf.data(), buf.size());
+    }
+
+    static std::vector<ServerSocket*> gLive;
+    static int gOpened;
+    static bool gCloseFreshConnections; // the server also drops new connections without answering
+
+    ConnectHandler onConnect;
+    DataHandler onData;
+    DisconnectHandler onDisconnect;
+    bool opened = false;
+    bool pending = false;
+    bool closed = false;
+    bool servedOnce = false;
+    uint32_t lastServedMs = 0;
+};
+
+std::vector<ServerSocket*> ServerSocket::gLive;
+int ServerSocket::gOpened = 0;
+bool ServerSocket::gCloseFreshConnections = false;
+
+static int gStaleOk = 0;
+static int gStaleFailed = 0;
+
+static void installServerSockets(AsyncHttpClient& client) {
+    ServerSocket::gOpened = 0;
+    ServerSocket::gCloseFreshConnections = false;
+    client.setTransportFactory([](const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls) -> AsyncTransport* {
+        (void)request;
+        (void)tls;
+        ServerSocket::gOpened++;
+        return new ServerSocket();
+    });
+}
+
+static void sendRequest(AsyncHttpClient& client, HttpMethod method, bool advertise) {
+    std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(method, "http://api.example/ping"));
+    request->setHeader("Connection", "keep-alive"); // a bare AsyncHttpRequest asks for close
+    client.request(
+        std::move(request),
+        [](std::shared_ptr<AsyncHttpResponse> response) {
+            (void)response;
+            gStaleOk++;
+        },
+        [](HttpClientError error, const char* message) {
+            (void)message;
+            if (error == CONNECTION_CLOSED)
+                gStaleFailed++;
+        });
+    client.loop();
+    ServerSocket::serveAll(advertise);
+}
+
+// Runs requests with think times around the server's 2 s idle timeout against a client that keeps connections for
+// 10 s, and returns how many were sent on a connection the server had already closed (each one is replayed on a
+// fresh connection, so none fails).
+static int runStaleConnectionWorkload(bool advertise, int* opened) {
+    static const uint32_t kGapsMs[] = {300, 1200, 1900, 2100, 2600, 800, 1500, 3000, 1990, 2010, 400, 2500};
+    gStaleOk = 0;
+    gStaleFailed = 0;
+    int staleHits = 0;
+    {
+        AsyncHttpClient client;
+        client.setKeepAlive(true, 10000);
+        installServerSockets(client);
+        for (int round = 0; round < 4; ++round) {
+            for (uint32_t gap : kGapsMs) {
+                sendRequest(client, HTTP_METHOD_GET, advertise);
+                delay(gap);
+                client.loop();
+            }
+        }
+        staleHits = gStaleFailed + static_cast<int>(client.getStaleConnectionReplays());
+    }
+    *opened = ServerSocket::gOpened;
+    return staleHits;
+}
+
+static void test_server_keep_alive_timeout_prevents_stale_reuse() {
+    int requests = 4 * 12;
+    int openedBlind = 0;
+    int openedAdvertised = 0;
+    int staleBlind = runStaleConnectionWorkload(false, &openedBlind);
+    TEST_ASSERT_EQUAL(requests, gStaleOk);
+    int staleAdvertised = runStaleConnectionWorkload(true, &openedAdvertised);
+    TEST_ASSERT_EQUAL(requests, gStaleOk);
+
+    char message[200];
+    snprintf(message, sizeof(message),
+             "%d requests, server idle timeout 2 s: sent on a stale connection %d (%d%%) without Keep-Alive timeout, "
+             "%d with it (%d vs %d connections opened)",
+             requests, staleBlind, staleBlind * 100 / requests, staleAdvertised, openedBlind, openedAdvertised);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(staleBlind > 0);
+    TEST_ASSERT_EQUAL(0, staleAdvertised);
+}
+
+static void test_stale_pooled_connection_is_replayed_transparently() {
+    gStaleOk = 0;
+    gStaleFailed = 0;
+    AsyncHttpClient client;
+    client.setKeepAlive(true, 10000);
+    installServerSockets(client);
+    sendRequest(client, HTTP_METHOD_GET, false);
+    delay(kServerIdleMs + 500); // the server closes the idle connection; the client does not notice yet
+    sendRequest(client, HTTP_METHOD_GET, false);
+
+    TEST_ASSERT_EQUAL(2, gStaleOk);
+    TEST_ASSERT_EQUAL(0, gStaleFailed);
+    TEST_ASSERT_EQUAL(1, (int)client.getStaleConnectionReplays());
+    TEST_ASSERT_EQUAL(2, ServerSocket::gOpened);
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount()); // the replacement is pooled again
+}
+
+static void test_stale_replay_skips_non_idempotent_requests() {
+    gStaleOk = 0;
+    gStaleFailed = 0;
+    AsyncHttpClient client;
+    client.setKeepAlive(true, 10000);
+    installServerSockets(client);
+    sendRequest(client, HTTP_METHOD_GET, false);
+    delay(kServerIdleMs + 500);
+    sendRequest(client, HTTP_METHOD_POST, false); // the server may have processed it: surface the error
+
+    TEST_ASSERT_EQUAL(1, gStaleOk);
+    TEST_ASSERT_EQUAL(1, gStaleFailed);
+    TEST_ASSERT_EQUAL(0, (int)client.getStaleConnectionReplays());
+    TEST_ASSERT_EQUAL(1, ServerSocket::gOpened);
+}
+
+static void test_stale_replay_happens_once() {
+    gStaleOk = 0;
+    gStaleFailed = 0;
+    AsyncHttpClient client;
+    client.setKeepAlive(true, 10000);
+    installServerSockets(client);
+    sendRequest(client, HTTP_METHOD_GET, false);
+    delay(kServerIdleMs + 500);
+    ServerSocket::gCloseFreshConnections = true; // the replay fails as well: reported as an error
+    sendRequest(client, HTTP_METHOD_GET, false);
+
+    TEST_ASSERT_EQUAL(1, gStaleOk);
+    TEST_ASSERT_EQUAL(1, gStaleFailed);
+    TEST_ASSERT_EQUAL(1, (int)client.getStaleConnectionReplays());
+    TEST_ASSERT_EQUAL(2, ServerSocket::gOpened);
+}
+
 int runUnityTests() {
     UNITY_BEGIN();
     RUN_TEST(test_pools_connection_on_complete_body);
     RUN_TEST(test_does_not_pool_on_truncated_body);
     RUN_TEST(test_reuses_pooled_connection);
+    RUN_TEST(test_server_keep_alive_timeout_prevents_stale_reuse);
+    RUN_TEST(test_stale_pooled_connection_is_replayed_transparently);
+    RUN_TEST(test_stale_replay_skips_non_idempotent_requests);
+    RUN_TEST(test_stale_replay_happens_once);
     return UNITY_END();
 }
 
@@ -0,0 +1,126 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+// Admission estimate of a plain GET with the default limits: header buffer + request arena.
+static const size_t kGetCost = 2800 + ASYNC_HTTP_REQUEST_ARENA_SIZE;
+
+static void test_requests_wait_in_queue_until_memory_is_released() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpMemoryBudget budget;
+    budget.maxBytes = kGetCost + kGetCost / 2; // room for one request at a time
+    client.setMemoryBudget(budget);
+
+    client.get("http://api.example/a", onOk, onErr);
+    client.get("http://api.example/b", onOk, onErr);
+    client.get("http://api.example/c", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(2, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(kGetCost, client.getMemoryStats().used);
+
+    gTransports[0]->serve(kOk); // releases its charge and admits the next request
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[1]->serve(kOk);
+    gTransports[2]->serve(kOk);
+    TEST_ASSERT_EQUAL(3, gSuccess);
+
+    AsyncHttpMemoryStats stats = client.getMemoryStats();
+    TEST_ASSERT_EQUAL(0, (int)stats.used);
+    TEST_ASSERT_EQUAL(kGetCost + 2, stats.peak); // reservation + the buffered "ok"
+    TEST_ASSERT_EQUAL(2, (int)stats.deferred);
+    TEST_ASSERT_EQUAL(0, (int)stats.rejected);
+}
+
+static void test_fail_fast_rejects_requests_that_do_not_fit() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpMemoryBudget budget;
+    budget.maxBytes = kGetCost + kGetCost / 2;
+    budget.failFast = true;
+    client.setMemoryBudget(budget);
+
+    client.get("http://api.example/a", onOk, onErr);
+    client.get("http://api.example/b", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(MEMORY_BUDGET_EXCEEDED, gLastError);
+    TEST_ASSERT_EQUAL(1, (int)client.getMemoryStats().rejected);
+
+    gTransports[0]->serve(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(0, (int)client.getMemoryStats().used);
+}
+
+static void test_buffered_body_is_charged_to_the_budget() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpMemoryBudget budget;
+    budget.maxBytes = 2 * kGetCost + 50; // both requests fit, but not 100 buffered body bytes on top
+    budget.failFast = true;
+    client.setMemoryBudget(budget);
+
+    client.get("http://api.example/big", onOk, onErr);
+    client.get("http://api.example/small", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+
+    String big = "HTTP/1.1 200 OK\r\nContent-Length: 100\r\nConnection: close\r\n\r\n";
+    for (int i = 0; i < 100; ++i)
+        big += 'x';
+    gTransports[0]->serve(big.c_str());
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(MEMORY_BUDGET_EXCEEDED, gLastError);
+    TEST_ASSERT_EQUAL(kGetCost, client.getMemoryStats().used); // the failed request released everything
+
+    gTransports[1]->serve(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(0, (int)client.getMemoryStats().used);
+}
+
+static void test_request_larger_than_the_budget_runs_alone() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpMemoryBudget budget;
+    budget.maxBytes = 1024;
+    client.setMemoryBudget(budget);
+
+    client.get("http://api.example/a", onOk, onErr);
+    client.get("http://api.example/b", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    gTransports[0]->serve(kOk);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[1]->serve(kOk);
+    TEST_ASSERT_EQUAL(2, gSuccess);
+    TEST_ASSERT_EQUAL(0, (int)client.getMemoryStats().used);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_wait_in_queue_until_memory_is_released);
+    RUN_TEST(test_fail_fast_rejects_requests_that_do_not_fit);
+    RUN_TEST(test_buffered_body_is_charged_to_the_budget);
+    RUN_TEST(test_request_larger_than_the_budget_runs_alone);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,66 @@
+#include <unity.h>
+
+#include "MemoryBudget.h"
+
+static void test_charges_up_to_the_limit() {
+    MemoryBudget budget;
+    budget.configure(1000);
+    TEST_ASSERT_TRUE(budget.tryCharge(600));
+    TEST_ASSERT_TRUE(budget.fits(400));
+    TEST_ASSERT_FALSE(budget.fits(401));
+    TEST_ASSERT_FALSE(budget.tryCharge(401));
+    TEST_ASSERT_TRUE(budget.tryCharge(400));
+    TEST_ASSERT_EQUAL(1000, (int)budget.used());
+    budget.release(1000);
+    TEST_ASSERT_EQUAL(0, (int)budget.used());
+}
+
+static void test_empty_budget_accepts_an_oversized_charge() {
+    MemoryBudget budget;
+    budget.configure(100);
+    TEST_ASSERT_TRUE(budget.fits(500));
+    TEST_ASSERT_TRUE(budget.tryCharge(500));
+    TEST_ASSERT_FALSE(budget.tryCharge(1)); // over the limit until it is released
+    budget.charge(10);                      // forced charges still count
+    TEST_ASSERT_EQUAL(510, (int)budget.used());
+}
+
+static void test_peak_and_counters() {
+    MemoryBudget budget;
+    budget.configure(0); // unlimited: only tracks usage
+    budget.charge(300);
+    TEST_ASSERT_TRUE(budget.tryCharge(200));
+    budget.release(400);
+    budget.noteDeferred();
+    budget.noteRejected();
+    AsyncHttpMemoryStats stats = budget.stats();
+    TEST_ASSERT_EQUAL(100, (int)stats.used);
+    TEST_ASSERT_EQUAL(500, (int)stats.peak);
+    TEST_ASSERT_EQUAL(1, (int)stats.deferred);
+    TEST_ASSERT_EQUAL(1, (int)stats.rejected);
+
+    budget.configure(2000); // resets the peak to the current usage and clears the counters
+    stats = budget.stats();
+    TEST_ASSERT_EQUAL(100, (int)stats.peak);
+    TEST_ASSERT_EQUAL(2000, (int)stats.limit);
+    TEST_ASSERT_EQUAL(0, (int)stats.deferred);
+}
+
+static void test_release_never_underflows() {
+    MemoryBudget budget;
+    budget.charge(10);
+    budget.release(50);
+    TEST_ASSERT_EQUAL(0, (int)budget.used());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_charges_up_to_the_limit);
+    RUN_TEST(test_empty_budget_accepts_an_oversized_charge);
+    RUN_TEST(test_peak_and_counters);
+    RUN_TEST(test_release_never_underflows);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+struct RegionCounts {
+    int internal = 0;
+    int external = 0;
+    size_t externalBytes = 0;
+};
+
+static RegionCounts gCounts;
+
+static void countRegion(size_t size, AsyncHttpMemoryRegion region) {
+    if (region == AsyncHttpMemoryRegion::kExternal) {
+        gCounts.external++;
+        gCounts.externalBytes += size;
+    } else {
+        gCounts.internal++;
+    }
+}
+
+static void* countingAllocate(size_t size, AsyncHttpMemoryRegion region, void* user) {
+    (void)user;
+    countRegion(size, region);
+    return malloc(size);
+}
+
+static void* countingReallocate(void* p, size_t size, AsyncHttpMemoryRegion region, void* user) {
+    (void)user;
+    countRegion(size, region);
+    return realloc(p, size);
+}
+
+static void installCountingAllocator(bool placement) {
+    gCounts = RegionCounts();
+    AsyncHttpAllocator allocator;
+    allocator.allocate = countingAllocate;
+    allocator.reallocate = countingReallocate; // release: default free()
+    HttpMemory::setAllocator(allocator);
+    AsyncHttpPlacementPolicy policy;
+    policy.enabled = placement;
+    HttpMemory::setPlacementPolicy(policy);
+}
+
+static void restoreDefaults() {
+    HttpMemory::setAllocator(AsyncHttpAllocator());
+    HttpMemory::setPlacementPolicy(AsyncHttpPlacementPolicy());
+}
+
+static const size_t kBodySize = 16384;
+
+static void fetchLargeBody() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setMaxBodySize(64 * 1024);
+    size_t received = 0;
+    client.get(
+        "http://api.example/firmware.bin",
+        [&received](std::shared_ptr<AsyncHttpResponse> response) {
+            received = response->getBodyLength();
+            gSuccess++;
+        },
+        onErr);
+    client.loop();
+    String response = "HTTP/1.1 200 OK\r\nContent-Length: 16384\r\nConnection: close\r\n\r\n";
+    for (size_t i = 0; i < kBodySize; ++i)
+        response += 'x';
+    gTransports[0]->serve(response.c_str());
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(kBodySize, received);
+}
+
+static void test_large_body_is_placed_externally() {
+    resetCounters();
+    installCountingAllocator(true);
+    fetchLargeBody();
+    // Only the body goes external: the receive buffer holds the whole packet but is a hot buffer.
+    TEST_ASSERT_EQUAL(1, gCounts.external);
+    TEST_ASSERT_TRUE(gCounts.externalBytes > kBodySize);
+    restoreDefaults();
+}
+
+static void test_policy_off_keeps_every_buffer_internal() {
+    resetCounters();
+    installCountingAllocator(false);
+    fetchLargeBody();
+    TEST_ASSERT_EQUAL(0, gCounts.external);
+    TEST_ASSERT_TRUE(gCounts.internal > 0);
+    restoreDefaults();
+}
+
+static void test_small_body_stays_internal() {
+    resetCounters();
+    installCountingAllocator(true);
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.get("http://api.example/a", onOk, onErr);
+    client.loop();
+    gTransports[0]->serve("HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok");
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(0, gCounts.external);
+    restoreDefaults();
+}
+
+// Appends a 64 KiB body in TCP-sized segments, as the client does while a download streams in.
+static double appendMbPerSecond(bool placement) {
+    AsyncHttpPlacementPolicy policy;
+    policy.enabled = placement;
+    HttpMemory::setPlacementPolicy(policy);
+    std::vector<char> segment(1436, 'x');
+    const int kRounds = 50;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        HttpBuffer body(AsyncHttpBufferKind::kResponseBody);
+        while (body.length() < 64 * 1024)
+            body.concat(segment.data(), segment.size());
+        TEST_ASSERT_TRUE(body.length() >= 64 * 1024);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    restoreDefaults();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    return (kRounds * 64.0 / 1024.0) / seconds;
+}
+
+static void test_body_append_throughput_by_placement() {
+    double internalMbps = appendMbPerSecond(false);
+    double externalMbps = appendMbPerSecond(true);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "64 KiB body append: internal %.0f MB/s, placement policy %.0f MB/s", internalMbps,
+             externalMbps);
+    TEST_MESSAGE(msg);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_large_body_is_placed_externally);
+    RUN_TEST(test_policy_off_keeps_every_buffer_internal);
+    RUN_TEST(test_small_body_stays_internal);
+    RUN_TEST(test_body_append_throughput_by_placement);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,105 @@
+#include <unity.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ObjectPool.h"
+
+struct Widget {
+    uint64_t payload[4];
+    int value;
+    explicit Widget(int v) : value(v) {}
+};
+
+static void test_disabled_pool_defers_to_heap() {
+    BlockPool pool;
+    TEST_ASSERT_NULL(pool.tryAllocate(16));
+    BlockPool::Stats stats = pool.stats();
+    TEST_ASSERT_EQUAL(0, (int)stats.capacity);
+    TEST_ASSERT_EQUAL(0, (int)stats.misses); // disabled pools do not count misses
+}
+
+static void test_blocks_are_recycled_and_counted() {
+    BlockPool pool;
+    TEST_ASSERT_TRUE(pool.configure(3));
+    void* a = pool.tryAllocate(40);
+    void* b = pool.tryAllocate(40);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_TRUE(pool.owns(a));
+    TEST_ASSERT_EQUAL(0, (int)(reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t)));
+    BlockPool::Stats stats = pool.stats();
+    TEST_ASSERT_TRUE(stats.blockSize >= 40);
+    TEST_ASSERT_EQUAL(2, (int)stats.inUse);
+
+    TEST_ASSERT_FALSE(pool.configure(8)); // blocks in use: keeps its layout
+    TEST_ASSERT_TRUE(pool.release(b));
+    void* again = pool.tryAllocate(40);
+    TEST_ASSERT_TRUE(again == b); // LIFO reuse
+
+    int onHeap = 0;
+    TEST_ASSERT_FALSE(pool.release(&onHeap));
+    TEST_ASSERT_NULL(pool.tryAllocate(stats.blockSize + 1)); // too large for a block
+    void* c = pool.tryAllocate(8);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_NULL(pool.tryAllocate(8)); // exhausted
+    stats = pool.stats();
+    TEST_ASSERT_EQUAL(3, (int)stats.inUse);
+    TEST_ASSERT_EQUAL(3, (int)stats.highWater);
+    TEST_ASSERT_EQUAL(2, (int)stats.misses);
+
+    pool.release(a);
+    pool.release(again);
+    pool.release(c);
+    stats = pool.stats();
+    TEST_ASSERT_EQUAL(0, (int)stats.inUse);
+    TEST_ASSERT_EQUAL(3, (int)stats.highWater);
+    TEST_ASSERT_TRUE(pool.configure(1));
+    TEST_ASSERT_EQUAL(0, (int)pool.stats().highWater);
+}
+
+static void test_allocate_shared_uses_one_block_and_falls_back() {
+    BlockPool pool;
+    pool.configure(2);
+    std::vector<std::shared_ptr<Widget>> widgets;
+    for (int i = 0; i < 3; ++i)
+        widgets.push_back(std::allocate_shared<Widget>(PoolAllocator<Widget>(&pool), i));
+    TEST_ASSERT_TRUE(pool.owns(widgets[0].get()));
+    TEST_ASSERT_TRUE(pool.owns(widgets[1].get()));
+    TEST_ASSERT_FALSE(pool.owns(widgets[2].get())); // third one spilled to the heap
+    TEST_ASSERT_EQUAL(2, widgets[2]->value);
+    BlockPool::Stats stats = pool.stats();
+    TEST_ASSERT_EQUAL(2, (int)stats.inUse);
+    TEST_ASSERT_EQUAL(1, (int)stats.misses);
+
+    std::weak_ptr<Widget> weak = widgets[0];
+    widgets.clear();
+    TEST_ASSERT_EQUAL(1, (int)pool.stats().inUse); // control block lives on while a weak_ptr remains
+    weak.reset();
+    TEST_ASSERT_EQUAL(0, (int)pool.stats().inUse);
+}
+
+static void test_process_wide_pools_configure_together() {
+    AsyncHttpPoolConfig config;
+    config.contexts = 4;
+    config.responses = 2;
+    TEST_ASSERT_TRUE(HttpObjectPools::configure(config));
+    AsyncHttpPoolStats stats = HttpObjectPools::stats();
+    TEST_ASSERT_EQUAL(4, (int)stats.contexts.capacity);
+    TEST_ASSERT_EQUAL(0, (int)stats.requests.capacity);
+    TEST_ASSERT_EQUAL(2, (int)stats.responses.capacity);
+    TEST_ASSERT_TRUE(HttpObjectPools::configure(AsyncHttpPoolConfig()));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_pool_defers_to_heap);
+    RUN_TEST(test_blocks_are_recycled_and_counted);
+    RUN_TEST(test_allocate_shared_uses_one_block_and_falls_back);
+    RUN_TEST(test_process_wide_pools_configure_together);
+    return UNITY_END();
+}
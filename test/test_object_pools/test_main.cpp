@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+
+static const char* kOkResponse = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+static std::vector<std::shared_ptr<AsyncHttpResponse>> gKept;
+
+static void keepResponse(std::shared_ptr<AsyncHttpResponse> response) {
+    gKept.push_back(response);
+}
+
+static void configurePools(uint16_t slots) {
+    AsyncHttpPoolConfig config;
+    config.contexts = slots;
+    config.requests = slots;
+    config.responses = slots;
+    TEST_ASSERT_TRUE(AsyncHttpClient::configureObjectPools(config));
+}
+
+static void test_requests_run_from_pools_and_recycle() {
+    configurePools(2);
+    {
+        AsyncHttpClient client;
+        installFakeTransports(client);
+        client.get("http://api.example/a", keepResponse);
+        client.get("http://api.example/b", keepResponse);
+        client.loop();
+        AsyncHttpPoolStats stats = AsyncHttpClient::getObjectPoolStats();
+        TEST_ASSERT_EQUAL(2, (int)stats.contexts.inUse);
+        TEST_ASSERT_EQUAL(2, (int)stats.requests.inUse);
+        TEST_ASSERT_EQUAL(2, (int)stats.responses.inUse);
+        TEST_ASSERT_EQUAL(0, (int)stats.contexts.misses);
+
+        gTransports[0]->serve(kOkResponse);
+        gTransports[1]->serve(kOkResponse);
+        TEST_ASSERT_EQUAL(2, (int)gKept.size());
+        stats = AsyncHttpClient::getObjectPoolStats();
+        TEST_ASSERT_EQUAL(0, (int)stats.contexts.inUse);  // recycled by cleanup()
+        TEST_ASSERT_EQUAL(0, (int)stats.requests.inUse);
+        TEST_ASSERT_EQUAL(2, (int)stats.responses.inUse); // still held by the application
+
+        // The next requests reuse the recycled slots.
+        client.get("http://api.example/c", keepResponse);
+        client.loop();
+        gTransports[2]->serve(kOkResponse);
+        stats = AsyncHttpClient::getObjectPoolStats();
+        TEST_ASSERT_EQUAL(2, (int)stats.contexts.highWater);
+        TEST_ASSERT_EQUAL(0, (int)stats.contexts.misses);
+        TEST_ASSERT_EQUAL(1, (int)stats.responses.misses); // third response while two are still held
+    }
+    gKept.clear(); // responses outlive the client; dropping them returns their slots
+    AsyncHttpPoolStats stats = AsyncHttpClient::getObjectPoolStats();
+    TEST_ASSERT_EQUAL(0, (int)stats.responses.inUse);
+    TEST_ASSERT_TRUE(AsyncHttpClient::configureObjectPools(AsyncHttpPoolConfig()));
+}
+
+static void test_exhausted_pools_fall_back_to_heap() {
+    configurePools(1);
+    {
+        AsyncHttpClient client;
+        installFakeTransports(client);
+        for (int i = 0; i < 3; ++i)
+            client.get("http://api.example/x", keepResponse);
+        client.loop();
+        TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+        AsyncHttpPoolStats stats = AsyncHttpClient::getObjectPoolStats();
+        TEST_ASSERT_EQUAL(1, (int)stats.contexts.inUse);
+        TEST_ASSERT_EQUAL(2, (int)stats.contexts.misses);
+        TEST_ASSERT_EQUAL(2, (int)stats.requests.misses);
+        for (auto* t : std::vector<FakeTransport*>(gTransports))
+            t->serve(kOkResponse);
+        TEST_ASSERT_EQUAL(3, (int)gKept.size());
+    }
+    gKept.clear();
+    AsyncHttpPoolStats stats = AsyncHttpClient::getObjectPoolStats();
+    TEST_ASSERT_EQUAL(0, (int)stats.contexts.inUse);
+    TEST_ASSERT_EQUAL(0, (int)stats.requests.inUse);
+    TEST_ASSERT_EQUAL(0, (int)stats.responses.inUse);
+    TEST_ASSERT_EQUAL(1, (int)stats.contexts.highWater);
+    TEST_ASSERT_TRUE(AsyncHttpClient::configureObjectPools(AsyncHttpPoolConfig()));
+}
+
+static void test_reconfiguring_while_in_use_is_refused() {
+    configurePools(2);
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.get("http://api.example/a", keepResponse);
+    client.loop();
+    AsyncHttpPoolConfig bigger;
+    bigger.contexts = 8;
+    TEST_ASSERT_FALSE(AsyncHttpClient::configureObjectPools(bigger));
+    TEST_ASSERT_EQUAL(2, (int)AsyncHttpClient::getObjectPoolStats().contexts.capacity);
+    gTransports[0]->serve(kOkResponse);
+    gKept.clear();
+    TEST_ASSERT_TRUE(AsyncHttpClient::configureObjectPools(AsyncHttpPoolConfig()));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_run_from_pools_and_recycle);
+    RUN_TEST(test_exhausted_pools_fall_back_to_heap);
+    RUN_TEST(test_reconfiguring_while_in_use_is_refused);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,458 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#include "ConnectionPool.h"
+#undef private
+
+// Server end of a keep-alive connection: records what the client writes and lets tests push response bytes, in
+// packets of any size. Handlers are re-read for every packet because the client hands the connection from one
+// pipelined request to the next while it consumes them.
+class ServerSocket : public AsyncTransport {
+  public:
+    ServerSocket() : id(++gNextId) {
+        gLive.push_back(this);
+        gOpened++;
+    }
+    ~ServerSocket() override {
+        gLive.erase(std::find(gLive.begin(), gLive.end(), this));
+    }
+    void setConnectHandler(ConnectHandler handler, void* arg) override {
+        (void)arg;
+        onConnect = handler;
+    }
+    void setDataHandler(DataHandler handler, void* arg) override {
+        (void)arg;
+        onData = handler;
+    }
+    void setDisconnectHandler(DisconnectHandler handler, void* arg) override {
+        (void)arg;
+        onDisconnect = handler;
+    }
+    void setErrorHandler(ErrorHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    void setTimeout(uint32_t timeoutMs) override {
+        (void)timeoutMs;
+    }
+    void setTimeoutHandler(TimeoutHandler handler, void* arg) override {
+        (void)handler;
+        (void)arg;
+    }
+    bool connect(const char* host, uint16_t port) override {
+        (void)host;
+        (void)port;
+        return true;
+    }
+    size_t write(const char* data, size_t len) override {
+        received.append(data, len);
+        return len;
+    }
+    bool canSend() const override {
+        return !closed;
+    }
+    void close(bool now = false) override {
+        (void)now;
+        closed = true;
+    }
+    bool isSecure() const override {
+        return false;
+    }
+    bool isHandshaking() const override {
+        return false;
+    }
+    uint32_t getHandshakeStartMs() const override {
+        return 0;
+    }
+    uint32_t getHandshakeTimeoutMs() const override {
+        return 0;
+    }
+
+    // Sockets are looked up by id: a new one may be allocated where the client just deleted another.
+    static ServerSocket* find(int id) {
+        for (ServerSocket* socket : gLive)
+            if (socket->id == id)
+                return socket;
+        return nullptr;
+    }
+
+    // Requests received so far (GETs: each ends with the blank line).
+    int requests() const {
+        int count = 0;
+        for (size_t pos = received.find("\r\n\r\n"); pos != std::string::npos; pos = received.find("\r\n\r\n", pos + 4))
+            count++;
+        return count;
+    }
+
+    void connected() {
+        opened = true;
+        ConnectHandler connectCb = onConnect;
+        connectCb(nullptr, this);
+    }
+
+    // Sends `bytes` in packets of at most `packet` bytes (0 = one packet). Stops if the client deletes the socket.
+    static void send(ServerSocket* socket, const std::string& bytes, size_t packet = 0) {
+        int id = socket->id;
+        size_t offset = 0;
+        while (offset < bytes.size() && (socket = find(id)) != nullptr) {
+            size_t len = packet == 0 ? bytes.size() - offset : std::min(packet, bytes.size() - offset);
+            std::vector<char> buf(bytes.begin() + offset, bytes.begin() + offset + len);
+            DataHandler dataCb = socket->onData;
+            dataCb(nullptr, socket, buf.data(), buf.size());
+            offset += len;
+        }
+    }
+
+    static std::vector<ServerSocket*> gLive;
+    static int gOpened;
+    static int gNextId;
+
+    const int id;
+    ConnectHandler onConnect;
+    DataHandler onData;
+    DisconnectHandler onDisconnect;
+    std::string received;
+    int answered = 0;
+    bool opened = false;
+    bool closed = false;
+};
+
+std::vector<ServerSocket*> ServerSocket::gLive;
+int ServerSocket::gOpened = 0;
+int ServerSocket::gNextId = 0;
+
+static std::vector<String> gBodies;
+static std::vector<HttpClientError> gErrors;
+
+static void installServerSockets(AsyncHttpClient& client) {
+    ServerSocket::gOpened = 0;
+    gBodies.clear();
+    gErrors.clear();
+    client.setTransportFactory([](const AsyncHttpRequest& request, const AsyncHttpTLSConfig& tls) -> AsyncTransport* {
+        (void)request;
+        (void)tls;
+        return new ServerSocket();
+    });
+}
+
+static uint32_t get(AsyncHttpClient& client, const char* path) {
+    String url = String("http://tiles.example") + path;
+    return client.get(
+        url.c_str(), [](std::shared_ptr<AsyncHttpResponse> response) { gBodies.push_back(response->getBody()); },
+        [](HttpClientError error, const char* message) {
+            (void)message;
+            gErrors.push_back(error);
+        });
+}
+
+static std::string okResponse(const char* body, const char* extraHeaders = "") {
+    char head[160];
+    snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n%s\r\n", (unsigned)strlen(body),
+             extraHeaders);
+    return std::string(head) + body;
+}
+
+// One request on a fresh connection, answered, so the pool holds a connection the server kept alive.
+static ServerSocket* warmUp(AsyncHttpClient& client) {
+    get(client, "/warm");
+    client.loop();
+    ServerSocket* socket = ServerSocket::gLive.back();
+    socket->connected();
+    ServerSocket::send(socket, okResponse("w"));
+    socket->received.clear();
+    gBodies.clear();
+    return socket;
+}
+
+static void test_pipelines_requests_on_a_reused_connection() {
+    AsyncHttpClient client;
+    installServerSockets(client);
+    client.setKeepAlive(true, 10000);
+    client.setPipelining(true, 4);
+    ServerSocket* socket = warmUp(client);
+
+    get(client, "/1");
+    get(client, "/2");
+    get(client, "/3");
+    client.loop();
+    TEST_ASSERT_EQUAL(1, ServerSocket::gOpened); // all three went out on the warm connection
+    TEST_ASSERT_EQUAL(3, socket->requests());
+    TEST_ASSERT_EQUAL(2, (int)client.getPipelinedRequests());
+    TEST_ASSERT_TRUE(socket->received.find("GET /1 ") < socket->received.find("GET /2 "));
+
+    // All three responses in one packet: each request gets its own, in order.
+    ServerSocket::send(socket, okResponse("a") + okResponse("bb") + okResponse("ccc"));
+    TEST_ASSERT_EQUAL(3, (int)gBodies.size());
+    TEST_ASSERT_EQUAL_STRING("a", gBodies[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("bb", gBodies[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("ccc", gBodies[2].c_str());
+    TEST_ASSERT_EQUAL(0, (int)gErrors.size());
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount()); // back in the pool afterwards
+    TEST_ASSERT_EQUAL(0, (int)client._pipelines.size());
+}
+
+static void test_splits_mixed_framing_across_packets() {
+    AsyncHttpClient client;
+    installServerSockets(client);
+    client.setKeepAlive(true, 10000);
+    client.setPipelining(true, 4);
+    ServerSocket* socket = warmUp(client);
+
+    for (int i = 0; i < 4; ++i)
+        get(client, "/mixed");
+    client.loop();
+    TEST_ASSERT_EQUAL(4, socket->requests());
+    std::string wire = okResponse("first") +
+                       "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nchu\r\n4\r\nnked\r\n0\r\n\r\n" +
+                       "HTTP/1.1 204 No Content\r\n\r\n" + okResponse("", "X-Empty: 1\r\n");
+    ServerSocket::send(socket, wire, 7); // boundaries fall inside headers, chunk lines and bodies
+    TEST_ASSERT_EQUAL(0, (int)gErrors.size());
+    TEST_ASSERT_EQUAL(4, (int)gBodies.size());
+    TEST_ASSERT_EQUAL_STRING("first", gBodies[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("chunked", gBodies[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("", gBodies[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("", gBodies[3].c_str());
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
+}
+
+static void test_connection_close_requeues_the_rest_and_falls_back() {
+    AsyncHttpClient client;
+    installServerSockets(client);
+    client.setKeepAlive(true, 10000);
+    client.setPipelining(true, 4);
+    ServerSocket* socket = warmUp(client);
+
+    get(client, "/1");
+    get(client, "/2");
+    get(client, "/3");
+    client.loop();
+    TEST_ASSERT_EQUAL(3, socket->requests());
+    // The server answers the first request only and closes: the other two go out again on new connections.
+    int socketId = socket->id;
+    ServerSocket::send(socket, okResponse("a", "Connection: close\r\n"));
+    TEST_ASSERT_NULL(ServerSocket::find(socketId));
+    TEST_ASSERT_EQUAL(2, (int)client.getPipelineRequeues());
+    TEST_ASSERT_EQUAL(3, ServerSocket::gOpened);
+    std::vector<ServerSocket*> fresh = ServerSocket::gLive;
+    TEST_ASSERT_EQUAL(2, (int)fresh.size());
+    for (ServerSocket* s : fresh)
+        s->connected();
+    TEST_ASSERT_TRUE(fresh[0]->received.find("GET /2 ") != std::string::npos); // original order kept
+    ServerSocket::send(fresh[0], okResponse("b"));
+    ServerSocket::send(fresh[1], okResponse("c"));
+    TEST_ASSERT_EQUAL(3, (int)gBodies.size());
+    TEST_ASSERT_EQUAL(0, (int)gErrors.size());
+
+    // The origin no longer pipelines: two requests use the two pooled connections.
+    uint32_t pipelined = client.getPipelinedRequests();
+    get(client, "/4");
+    get(client, "/5");
+    client.loop();
+    TEST_ASSERT_EQUAL(pipelined, client.getPipelinedRequests());
+    TEST_ASSERT_EQUAL(1, fresh[0]->requests() - 1);
+    TEST_ASSERT_EQUAL(1, fresh[1]->requests() - 1);
+    ServerSocket::send(fresh[0], okResponse("d"));
+    ServerSocket::send(fresh[1], okResponse("e"));
+
+    // Once the refusal has expired, the origin pipelines again.
+    TEST_ASSERT_EQUAL(1, (int)client._pipelineRefused.size());
+    client._pipelineRefused[0].untilMs = millis();
+    get(client, "/6");
+    get(client, "/7");
+    get(client, "/8");
+    client.loop();
+    TEST_ASSERT_EQUAL(pipelined + 2, client.getPipelinedRequests());
+    TEST_ASSERT_EQUAL(0, (int)client._pipelineRefused.size());
+    ServerSocket* busy = fresh[0]->requests() > fresh[1]->requests() ? fresh[0] : fresh[1];
+    TEST_ASSERT_EQUAL(3, busy->requests() - 2);
+    ServerSocket::send(busy, okResponse("f") + okResponse("g") + okResponse("h"));
+    TEST_ASSERT_EQUAL(8, (int)gBodies.size());
+}
+
+static void test_aborting_the_front_request_keeps_pipelining() {
+    AsyncHttpClient client;
+    installServerSockets(client);
+    client.setKeepAlive(true, 10000);
+    client.setPipelining(true, 4);
+    ServerSocket* socket = warmUp(client);
+
+    uint32_t first = get(client, "/1");
+    get(client, "/2");
+    client.loop();
+    TEST_ASSERT_EQUAL(2, socket->requests());
+    TEST_ASSERT_TRUE(client.abort(first));
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gErrors.size());
+    TEST_ASSERT_EQUAL(ABORTED, gErrors[0]);
+    // The connection goes with the aborted request; the one behind it is sent again on a new connection.
+    TEST_ASSERT_EQUAL(1, (int)client.getPipelineRequeues());
+    TEST_ASSERT_EQUAL(0, (int)client._pipelineRefused.size());
+    ServerSocket* fresh = ServerSocket::gLive.back();
+    fresh->connected();
+    ServerSocket::send(fresh, okResponse("b"));
+    TEST_ASSERT_EQUAL(1, (int)gBodies.size());
+
+    // A local abort says nothing about the server: the next burst is pipelined again.
+    uint32_t pipelined = client.getPipelinedRequests();
+    get(client, "/3");
+    get(client, "/4");
+    client.loop();
+    TEST_ASSERT_EQUAL(pipelined + 1, client.getPipelinedRequests());
+    TEST_ASSERT_EQUAL(2, fresh->requests() - 1);
+    ServerSocket::send(fresh, okResponse("c") + okResponse("d"));
+    TEST_ASSERT_EQUAL(3, (int)gBodies.size());
+}
+
+static void test_aborting_a_queued_request_retires_the_connection() {
+    AsyncHttpClient client;
+    installServerSockets(client);
+    client.setKeepAlive(true, 10000);
+    client.setPipelining(true, 4);
+    ServerSocket* socket = warmUp(client);
+
+    get(client, "/1");
+    uint32_t second = get(client, "/2");
+    get(client, "/3");
+    client.loop();
+    TEST_ASSERT_EQUAL(3, socket->requests());
+    TEST_ASSERT_TRUE(client.abort(second));
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gErrors.size()); // ABORTED
+    TEST_ASSERT_EQUAL(ABORTED, gErrors[0]);
+    // The third request cannot be matched any more on this connection: it was re-queued on a new one.
+    TEST_ASSERT_EQUAL(1, (int)client.getPipelineRequeues());
+    TEST_ASSERT_EQUAL(2, ServerSocket::gOpened);
+    ServerSocket* fresh = ServerSocket::gLive.back();
+    fresh->connected();
+    ServerSocket::send(fresh, okResponse("c"));
+
+    // The front request still gets its answer; the connection is not reused after it.
+    int socketId = socket->id;
+    ServerSocket::send(socket, okResponse("a") + okResponse("b"));
+    TEST_ASSERT_EQUAL(2, (int)gBodies.size());
+    TEST_ASSERT_EQUAL_STRING("c", gBodies[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("a", gBodies[1].c_str());
+    TEST_ASSERT_NULL(ServerSocket::find(socketId));
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
+}
+
+static void test_non_idempotent_requests_are_not_pipelined() {
+    AsyncHttpClient client;
+    installServerSockets(client);
+    client.setKeepAlive(true, 10000);
+    client.setPipelining(true, 4);
+    ServerSocket* socket = warmUp(client);
+
+    get(client, "/1");
+    client.post(
+        "http://tiles.example/upload", "x", [](std::shared_ptr<AsyncHttpResponse> response) { (void)response; },
+        [](HttpClientError error, const char* message) {
+            (void)error;
+            (void)message;
+        });
+    client.loop();
+    TEST_ASSERT_EQUAL(1, socket->requests());
+    TEST_ASSERT_EQUAL(2, ServerSocket::gOpened); // the POST waits for nobody: it opens its own connection
+    TEST_ASSERT_EQUAL(0, (int)client.getPipelinedRequests());
+}
+
+// Simulated network: every step is one round trip. In a step the server completes the connections opened during
+// the previous one and answers, in a single packet per connection, every request that had reached it.
+static uint32_t runBurst(AsyncHttpClient& client, int requests, uint32_t rttMs, int* opened) {
+    int before = ServerSocket::gOpened;
+    size_t done = gBodies.size() + requests;
+    for (int i = 0; i < requests; ++i)
+        get(client, "/tile");
+    client.loop();
+    uint32_t start = millis();
+    while (gBodies.size() < done && gErrors.empty()) {
+        delay(rttMs);
+        std::vector<int> ids;
+        std::vector<int> due;
+        for (ServerSocket* s : ServerSocket::gLive) {
+            ids.push_back(s->id);
+            due.push_back(s->opened ? s->requests() - s->answered : -1);
+        }
+        for (size_t i = 0; i < ids.size(); ++i) {
+            ServerSocket* s = ServerSocket::find(ids[i]);
+            if (!s)
+                continue;
+            if (due[i] < 0) {
+                s->connected();
+                continue;
+            }
+            std::string wire;
+            for (int r = 0; r < due[i]; ++r)
+                wire += okResponse("0123456789abcdef0123456789abcdef");
+            s->answered += due[i];
+            if (!wire.empty())
+                ServerSocket::send(s, wire);
+        }
+        client.loop();
+    }
+    *opened = ServerSocket::gOpened - before;
+    return millis() - start;
+}
+
+static void test_benchmark_burst_of_small_gets() {
+    const int kRequests = 32;
+    const uint32_t kRttMs = 40;
+    struct Scenario {
+        const char* name;
+        uint16_t maxParallel;
+        uint8_t depth; // 0 = no pipelining
+    };
+    const Scenario scenarios[] = {
+        {"1 connection, no pipelining", 1, 0},
+        {"4 connections, no pipelining", 4, 0},
+        {"1 connection, pipelining depth 4", 4, 4},
+        {"1 connection, pipelining depth 8", 8, 8},
+    };
+    uint32_t elapsed[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        AsyncHttpClient client;
+        installServerSockets(client);
+        client.setKeepAlive(true, 60000);
+        client.setMaxParallel(scenarios[i].maxParallel);
+        client.setPipelining(scenarios[i].depth > 0, scenarios[i].depth);
+        ServerSocket* warm = warmUp(client);
+        warm->answered = 0;
+        int opened = 0;
+        elapsed[i] = runBurst(client, kRequests, kRttMs, &opened);
+        TEST_ASSERT_EQUAL(0, (int)gErrors.size());
+        TEST_ASSERT_EQUAL(kRequests, (int)gBodies.size());
+        char message[160];
+        snprintf(message, sizeof(message), "%d GETs, %u ms RTT, %s: %u ms, %u req/s, %d new connections", kRequests,
+                 (unsigned)kRttMs, scenarios[i].name, (unsigned)elapsed[i],
+                 (unsigned)(kRequests * 1000u / (elapsed[i] ? elapsed[i] : 1)), opened);
+        TEST_MESSAGE(message);
+    }
+    TEST_ASSERT_TRUE(elapsed[2] * 3 <= elapsed[0]); // depth 4 on one connection: at least 3x the throughput
+    TEST_ASSERT_TRUE(elapsed[2] <= elapsed[1]);     // and no slower than four connections
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pipelines_requests_on_a_reused_connection);
+    RUN_TEST(test_splits_mixed_framing_across_packets);
+    RUN_TEST(test_connection_close_requeues_the_rest_and_falls_back);
+    RUN_TEST(test_aborting_a_queued_request_retires_the_connection);
+    RUN_TEST(test_aborting_the_front_request_keeps_pipelining);
+    RUN_TEST(test_non_idempotent_requests_are_not_pipelined);
+    RUN_TEST(test_benchmark_burst_of_small_gets);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,106 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#include "ConnectionPool.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static const char* kKeepAliveResponse = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+static void test_preconnect_parks_connections_for_the_next_requests() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setKeepAlive(true, 30000);
+
+    TEST_ASSERT_EQUAL(2, client.preconnect("http://api.example:8080/any/path", 2));
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL_STRING("api.example", gTransports[0]->host.c_str());
+    TEST_ASSERT_EQUAL(8080, gTransports[0]->port);
+    TEST_ASSERT_EQUAL(0, (int)client._connectionPool->idleCount()); // not connected yet
+    gTransports[0]->accept();
+    gTransports[1]->accept();
+    TEST_ASSERT_EQUAL(2, (int)client._connectionPool->idleCount("http://api.example:8080"));
+
+    // The request goes out on the warm connection: no new transport, no connect.
+    client.get("http://api.example:8080/data", onOk, onErr);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
+    gTransports[1]->respond(kKeepAliveResponse); // LIFO: the most recently parked connection
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(2, (int)client._connectionPool->idleCount()); // back in the pool
+}
+
+static void test_preconnect_requires_keep_alive() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    TEST_ASSERT_EQUAL(0, client.preconnect("http://api.example/", 2));
+    client.setKeepAlive(true);
+    TEST_ASSERT_EQUAL(0, client.preconnect("not a url", 1));
+    TEST_ASSERT_EQUAL(0, (int)gTransports.size());
+}
+
+static void test_failed_or_slow_warmups_are_discarded() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setKeepAlive(true, 30000);
+    client.setDefaultConnectTimeout(1000);
+    TEST_ASSERT_EQUAL(2, client.preconnect("http://api.example/", 2));
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(1, FakeTransport::gDestroyed);
+    delay(1100); // the second never connects
+    client.loop();
+    TEST_ASSERT_EQUAL(2, FakeTransport::gDestroyed);
+    TEST_ASSERT_EQUAL(0, (int)client._connectionPool->idleCount());
+    TEST_ASSERT_EQUAL(0, (int)client._warmups.size());
+}
+
+static void test_keep_warm_replaces_closed_connections() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setKeepAlive(true, 30000);
+    client.keepWarm("http://api.example/", 2);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    client.loop(); // the two warm-ups in flight count towards the minimum
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[0]->accept();
+    gTransports[1]->accept();
+
+    gTransports[0]->disconnect(); // server closed an idle connection: the pool drops it
+    TEST_ASSERT_EQUAL(1, (int)client._connectionPool->idleCount());
+    delay(300);
+    client.loop();
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    gTransports[2]->accept();
+    TEST_ASSERT_EQUAL(2, (int)client._connectionPool->idleCount());
+
+    client.keepWarm("http://api.example/", 0);
+    gTransports[1]->disconnect();
+    delay(300);
+    client.loop();
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_preconnect_parks_connections_for_the_next_requests);
+    RUN_TEST(test_preconnect_requires_keep_alive);
+    RUN_TEST(test_failed_or_slow_warmups_are_discarded);
+    RUN_TEST(test_keep_warm_replaces_closed_connections);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
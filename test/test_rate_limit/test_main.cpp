@@ -0,0 +1,96 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+
+static void test_requests_over_limit_wait_in_pending_queue() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setPerOriginRateLimit(10.0f, 2); // 10/s, burst 2
+    for (int i = 0; i < 4; ++i)
+        client.get("http://api.example/x", nullptr, nullptr);
+
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(2, (int)client._pendingQueue.size());
+    TEST_ASSERT_TRUE(client._dispatchWaiting);
+
+    // loop() before the deadline does not dispatch anything.
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+
+    delay(110);
+    client.loop();
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    delay(110);
+    client.loop();
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+    TEST_ASSERT_FALSE(client._dispatchWaiting);
+}
+
+static void test_throttled_origin_does_not_block_others() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setPerOriginRateLimit(1.0f, 1);
+    client.get("http://slow.example/a", nullptr, nullptr);
+    client.get("http://slow.example/b", nullptr, nullptr);
+    client.get("http://fast.example/c", nullptr, nullptr);
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL_STRING("slow.example", gTransports[0]->host.c_str());
+    TEST_ASSERT_EQUAL_STRING("fast.example", gTransports[1]->host.c_str());
+    TEST_ASSERT_EQUAL(1, (int)client._pendingQueue.size());
+}
+
+static void test_global_limit_and_origin_override() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setRateLimit(20.0f, 1);
+    client.setOriginRateLimit("http://a.example", 0.0f); // no extra per-origin cap
+    client.get("http://a.example/1", nullptr, nullptr);
+    client.get("http://b.example/2", nullptr, nullptr);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    delay(60);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+
+    // Disabling the limits releases everything that is still pending.
+    client.get("http://a.example/3", nullptr, nullptr);
+    client.get("http://a.example/4", nullptr, nullptr);
+    client.setRateLimit(0.0f);
+    TEST_ASSERT_EQUAL(4, (int)gTransports.size());
+}
+
+static void test_abort_pending_rate_limited_request() {
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setPerOriginRateLimit(1.0f, 1);
+    client.get("http://api.example/1", nullptr, nullptr);
+    bool aborted = false;
+    uint32_t id = client.get("http://api.example/2", nullptr, [&](HttpClientError err, const char*) {
+        aborted = err == ABORTED;
+    });
+    TEST_ASSERT_TRUE(client.abort(id));
+    TEST_ASSERT_TRUE(aborted);
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_over_limit_wait_in_pending_queue);
+    RUN_TEST(test_throttled_origin_does_not_block_others);
+    RUN_TEST(test_global_limit_and_origin_override);
+    RUN_TEST(test_abort_pending_rate_limited_request);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
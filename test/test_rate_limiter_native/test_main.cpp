@@ -0,0 +1,105 @@
+#include <unity.h>
+
+#include <string>
+
+#include "RateLimiter.h"
+
+static void test_bucket_burst_then_refill() {
+    TokenBucket bucket;
+    bucket.configure(10.0f, 3, 1000); // 10/s, burst 3
+    TEST_ASSERT_TRUE(bucket.tryAcquire(1000));
+    TEST_ASSERT_TRUE(bucket.tryAcquire(1000));
+    TEST_ASSERT_TRUE(bucket.tryAcquire(1000));
+    TEST_ASSERT_FALSE(bucket.tryAcquire(1000));
+    TEST_ASSERT_EQUAL(100, bucket.msUntilAvailable(1000));
+    TEST_ASSERT_FALSE(bucket.tryAcquire(1099));
+    TEST_ASSERT_TRUE(bucket.tryAcquire(1100));
+    // Long idle period refills only up to the burst.
+    TEST_ASSERT_TRUE(bucket.isFull(60000));
+    for (int i = 0; i < 3; ++i)
+        TEST_ASSERT_TRUE(bucket.tryAcquire(60000));
+    TEST_ASSERT_FALSE(bucket.tryAcquire(60000));
+}
+
+static void test_bucket_fractional_rate_and_wraparound() {
+    TokenBucket bucket;
+    uint32_t start = 0xFFFFFF00u; // millis() wraps during the test
+    bucket.configure(0.5f, 1, start);
+    TEST_ASSERT_TRUE(bucket.tryAcquire(start));
+    TEST_ASSERT_EQUAL(2000, bucket.msUntilAvailable(start));
+    TEST_ASSERT_FALSE(bucket.tryAcquire(start + 1999));
+    TEST_ASSERT_TRUE(bucket.tryAcquire(start + 2000));
+}
+
+static void test_disabled_bucket_always_grants() {
+    TokenBucket bucket;
+    TEST_ASSERT_FALSE(bucket.enabled());
+    for (int i = 0; i < 100; ++i)
+        TEST_ASSERT_TRUE(bucket.tryAcquire(0));
+    bucket.configure(5.0f, 1, 0);
+    TEST_ASSERT_TRUE(bucket.enabled());
+    bucket.configure(0.0f, 1, 0);
+    TEST_ASSERT_FALSE(bucket.enabled());
+}
+
+static void test_limiter_per_origin_and_global() {
+    RateLimiter limiter;
+    TEST_ASSERT_FALSE(limiter.enabled());
+    limiter.setPerOriginDefault(1.0f, 1);
+    TEST_ASSERT_TRUE(limiter.enabled());
+
+    std::string a = RateLimiter::makeOriginKey("A.example", 443, true);
+    std::string b = RateLimiter::makeOriginKey("b.example", 80, false);
+    TEST_ASSERT_EQUAL_STRING("https://a.example:443", a.c_str());
+
+    uint32_t wait = 0;
+    TEST_ASSERT_TRUE(limiter.tryAcquire(a, 0, &wait) == RateLimiter::Result::kGranted);
+    TEST_ASSERT_TRUE(limiter.tryAcquire(a, 0, &wait) == RateLimiter::Result::kOriginLimited);
+    TEST_ASSERT_EQUAL(1000, wait);
+    // Another origin is independent.
+    TEST_ASSERT_TRUE(limiter.tryAcquire(b, 0, &wait) == RateLimiter::Result::kGranted);
+
+    // Global cap applies across origins; a refused request consumes nothing.
+    limiter.setGlobal(2.0f, 1, 0);
+    std::string c = RateLimiter::makeOriginKey("c.example", 80, false);
+    TEST_ASSERT_TRUE(limiter.tryAcquire(c, 0, &wait) == RateLimiter::Result::kGranted);
+    std::string d = RateLimiter::makeOriginKey("d.example", 80, false);
+    TEST_ASSERT_TRUE(limiter.tryAcquire(d, 0, &wait) == RateLimiter::Result::kGlobalLimited);
+    TEST_ASSERT_EQUAL(500, wait);
+    TEST_ASSERT_TRUE(limiter.tryAcquire(d, 500, &wait) == RateLimiter::Result::kGranted);
+}
+
+static void test_limiter_override_and_pruning() {
+    RateLimiter limiter;
+    limiter.setPerOriginDefault(1.0f, 1);
+    std::string vip = RateLimiter::makeOriginKey("vip.example", 443, true);
+    limiter.setOrigin(vip, 0.0f, 1, 0); // exempt
+    uint32_t wait = 0;
+    for (int i = 0; i < 10; ++i)
+        TEST_ASSERT_TRUE(limiter.tryAcquire(vip, 0, &wait) == RateLimiter::Result::kGranted);
+
+    // Many one-off origins do not grow the table without bound once their buckets refilled.
+    for (int i = 0; i < 100; ++i) {
+        std::string key = RateLimiter::makeOriginKey("h" + std::to_string(i) + ".example", 80, false);
+        TEST_ASSERT_TRUE(limiter.tryAcquire(key, static_cast<uint32_t>(i) * 2000, &wait) ==
+                         RateLimiter::Result::kGranted);
+    }
+    TEST_ASSERT_TRUE(limiter.trackedOrigins() <= 10);
+
+    // Changing the default keeps the override.
+    limiter.setPerOriginDefault(2.0f, 1);
+    TEST_ASSERT_EQUAL(1, (int)limiter.trackedOrigins());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_burst_then_refill);
+    RUN_TEST(test_bucket_fractional_rate_and_wraparound);
+    RUN_TEST(test_disabled_bucket_always_grants);
+    RUN_TEST(test_limiter_per_origin_and_global);
+    RUN_TEST(test_limiter_override_and_pruning);
+    return UNITY_END();
+}
@@ -124,6 +124,46 @@ static void test_redirect_cross_host_can_allowlist_header() {
     cleanupContext(ctx);
 }
 
+static void test_redirect_keeps_per_request_retry_policy() {
+    AsyncHttpClient client;
+    client.setFollowRedirects(true, 3);
+    auto ctx = makeRedirectContext(HTTP_METHOD_GET, "http://example.com/a");
+    AsyncHttpRetryPolicy retry;
+    retry.maxAttempts = 5;
+    ctx->request->setRetryPolicy(retry);
+    ctx->response->setStatusCode(302);
+    ctx->response->setHeader("Location", "http://other.example.com/b");
+
+    std::unique_ptr<AsyncHttpRequest> newReq;
+    TEST_ASSERT_TRUE(client._redirectHandler->buildRedirectRequest(ctx, &newReq, nullptr, nullptr));
+    TEST_ASSERT_NOT_NULL(newReq.get());
+    TEST_ASSERT_TRUE(newReq->hasRetryPolicy());
+    TEST_ASSERT_EQUAL(5, (int)newReq->getRetryPolicy()->maxAttempts);
+
+    cleanupContext(ctx);
+}
+
+static void test_redirect_keeps_per_request_socket_options() {
+    AsyncHttpClient client;
+    client.setFollowRedirects(true, 3);
+    auto ctx = makeRedirectContext(HTTP_METHOD_GET, "http://example.com/a");
+    AsyncHttpSocketOptions options;
+    options.noDelay = false;
+    options.keepAliveIntervalMs = 15000;
+    ctx->request->setSocketOptions(options);
+    ctx->response->setStatusCode(302);
+    ctx->response->setHeader("Location", "http://other.example.com/b");
+
+    std::unique_ptr<AsyncHttpRequest> newReq;
+    TEST_ASSERT_TRUE(client._redirectHandler->buildRedirectRequest(ctx, &newReq, nullptr, nullptr));
+    TEST_ASSERT_NOT_NULL(newReq.get());
+    TEST_ASSERT_TRUE(newReq->hasSocketOptions());
+    TEST_ASSERT_FALSE(newReq->getSocketOptions()->noDelay);
+    TEST_ASSERT_EQUAL_UINT32(15000, newReq->getSocketOptions()->keepAliveIntervalMs);
+
+    cleanupContext(ctx);
+}
+
 static void test_redirect_too_many_hops() {
     AsyncHttpClient client;
     client.setFollowRedirects(true, 2);
@@ -270,6 +310,8 @@ void setup() {
     RUN_TEST(test_redirect_cross_host_preserve_method_strip_auth);
     RUN_TEST(test_redirect_cross_host_drops_unknown_headers_by_default);
     RUN_TEST(test_redirect_cross_host_can_allowlist_header);
+    RUN_TEST(test_redirect_keeps_per_request_retry_policy);
+    RUN_TEST(test_redirect_keeps_per_request_socket_options);
     RUN_TEST(test_redirect_too_many_hops);
     RUN_TEST(test_redirect_to_https_supported);
     RUN_TEST(test_header_limit_triggers_error);
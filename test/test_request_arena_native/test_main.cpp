@@ -0,0 +1,97 @@
+#include <unity.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "RequestArena.h"
+
+static int gSlabAllocs = 0;
+static int gSlabFrees = 0;
+
+static void* countingAlloc(size_t size) {
+    gSlabAllocs++;
+    return malloc(size);
+}
+
+static void countingFree(void* p) {
+    gSlabFrees++;
+    free(p);
+}
+
+static void resetCounters() {
+    gSlabAllocs = 0;
+    gSlabFrees = 0;
+}
+
+static void test_allocations_are_bumped_from_one_slab() {
+    resetCounters();
+    {
+        RequestArena arena;
+        arena.configure(256, countingAlloc, countingFree);
+        TEST_ASSERT_EQUAL(0, gSlabAllocs); // reserved lazily
+        char* a = static_cast<char*>(arena.allocate(10));
+        char* b = static_cast<char*>(arena.allocate(20));
+        void* aligned = arena.allocate(8, alignof(uint64_t));
+        TEST_ASSERT_NOT_NULL(a);
+        TEST_ASSERT_EQUAL_PTR(a + 10, b);
+        TEST_ASSERT_EQUAL(0, (int)(reinterpret_cast<uintptr_t>(aligned) % alignof(uint64_t)));
+        TEST_ASSERT_EQUAL(1, gSlabAllocs);
+        TEST_ASSERT_EQUAL(0, (int)arena.stats().overflows);
+        TEST_ASSERT_TRUE(arena.stats().used >= 38);
+    }
+    TEST_ASSERT_EQUAL(1, gSlabFrees);
+}
+
+static void test_overflow_falls_back_to_heap_until_reset() {
+    resetCounters();
+    RequestArena arena;
+    arena.configure(32, countingAlloc, countingFree);
+    char* inSlab = arena.copy("0123456789", 10);
+    char* big = static_cast<char*>(arena.allocate(100));
+    TEST_ASSERT_NOT_NULL(big);
+    memset(big, 'x', 100);
+    TEST_ASSERT_EQUAL(1, (int)arena.stats().overflows);
+    TEST_ASSERT_EQUAL_STRING("0123456789", inSlab);
+
+    arena.reset(); // frees the overflow block, keeps the slab
+    TEST_ASSERT_EQUAL(0, (int)arena.stats().used);
+    TEST_ASSERT_EQUAL(11, (int)arena.stats().highWater);
+    TEST_ASSERT_EQUAL_PTR(inSlab, arena.copy("abc", 3));
+    TEST_ASSERT_EQUAL(1, gSlabAllocs);
+    TEST_ASSERT_EQUAL(0, gSlabFrees);
+}
+
+static void test_disabled_arena_uses_the_heap() {
+    resetCounters();
+    RequestArena arena;
+    arena.configure(0, countingAlloc, countingFree);
+    char* copy = arena.copy("header", 6);
+    TEST_ASSERT_EQUAL_STRING("header", copy);
+    TEST_ASSERT_EQUAL(0, gSlabAllocs);
+    TEST_ASSERT_EQUAL(1, (int)arena.stats().overflows);
+    arena.reset();
+}
+
+static void test_copy_is_nul_terminated_and_handles_empty_input() {
+    RequestArena arena;
+    arena.configure(64);
+    const char line[] = "Content-Length: 42\r\n";
+    char* copy = arena.copy(line, 18);
+    TEST_ASSERT_EQUAL_STRING("Content-Length: 42", copy);
+    char* empty = arena.copy("", 0);
+    TEST_ASSERT_NOT_NULL(empty);
+    TEST_ASSERT_EQUAL(0, (int)strlen(empty));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_are_bumped_from_one_slab);
+    RUN_TEST(test_overflow_falls_back_to_heap_until_reset);
+    RUN_TEST(test_disabled_arena_uses_the_heap);
+    RUN_TEST(test_copy_is_nul_terminated_and_handles_empty_input);
+    return UNITY_END();
+}
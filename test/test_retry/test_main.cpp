@@ -0,0 +1,187 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+static AsyncHttpRetryPolicy fastPolicy(uint8_t attempts) {
+    AsyncHttpRetryPolicy policy;
+    policy.maxAttempts = attempts;
+    policy.baseDelayMs = 50;
+    policy.maxDelayMs = 1000;
+    policy.jitterPercent = 0;
+    return policy;
+}
+
+static void test_connect_failure_is_retried_with_backoff() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setRetryPolicy(fastPolicy(3));
+    uint32_t id = client.get("http://api.example/x", onOk, onErr);
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    const AsyncHttpRequest* original = client._activeRequests[0]->request.get();
+
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(0, gErrors);
+    TEST_ASSERT_EQUAL(1, (int)client._pendingQueue.size());
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests.size());
+
+    client.loop(); // backoff not elapsed yet
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    delay(60);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    TEST_ASSERT_EQUAL(id, client._activeRequests[0]->id);
+    TEST_ASSERT_TRUE(original == client._activeRequests[0]->request.get()); // reused, not rebuilt
+    TEST_ASSERT_EQUAL(2, client._activeRequests[0]->retry.attempt);
+
+    gTransports[1]->fail(); // second retry waits 100 ms
+    delay(60);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    delay(50);
+    client.loop();
+    TEST_ASSERT_EQUAL(3, (int)gTransports.size());
+    gTransports[2]->serve(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(0, gErrors);
+}
+
+static void test_attempts_exhausted_surfaces_error() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setRetryPolicy(fastPolicy(2));
+    client.get("http://api.example/x", onOk, onErr);
+    gTransports[0]->fail();
+    delay(60);
+    client.loop();
+    gTransports[1]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(CONNECTION_FAILED, gLastError);
+    TEST_ASSERT_EQUAL(0, (int)client._pendingQueue.size());
+}
+
+static void test_503_honors_retry_after() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setRetryPolicy(fastPolicy(3));
+    client.get("http://api.example/x", onOk, onErr);
+    gTransports[0]->serve("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\n\r\n");
+    TEST_ASSERT_EQUAL(0, gSuccess);
+    delay(900);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, (int)gTransports.size());
+    delay(150);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, (int)gTransports.size());
+    gTransports[1]->serve(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+    TEST_ASSERT_EQUAL(200, gLastStatus);
+
+    // Retry-After beyond the cap: the 503 is delivered as-is.
+    AsyncHttpRetryPolicy policy = fastPolicy(3);
+    policy.maxRetryAfterMs = 500;
+    client.setRetryPolicy(policy);
+    client.get("http://api.example/y", onOk, onErr);
+    gTransports[2]->serve("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 4\r\nRetry-After: 60\r\n\r\nbusy");
+    TEST_ASSERT_EQUAL(2, gSuccess);
+    TEST_ASSERT_EQUAL(503, gLastStatus);
+}
+
+static void test_non_idempotent_requires_opt_in() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setRetryPolicy(fastPolicy(3));
+    client.post("http://api.example/x", "{}", onOk, onErr);
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+
+    std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(HTTP_METHOD_POST, "http://api.example/x"));
+    request->setBody("{}");
+    AsyncHttpRetryPolicy policy = fastPolicy(3);
+    policy.retryNonIdempotent = true;
+    request->setRetryPolicy(policy);
+    client.request(std::move(request), onOk, onErr);
+    gTransports[1]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(1, (int)client._pendingQueue.size());
+}
+
+static void test_stream_body_needs_rewind() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    client.setRetryPolicy(fastPolicy(3));
+    auto provider = [](uint8_t* buffer, size_t maxLen, bool* final) -> int {
+        (void)buffer;
+        (void)maxLen;
+        *final = true;
+        return 0;
+    };
+
+    std::unique_ptr<AsyncHttpRequest> plain(new AsyncHttpRequest(HTTP_METHOD_PUT, "http://api.example/blob"));
+    plain->setBodyStream(0, provider);
+    client.request(std::move(plain), onOk, onErr);
+    gTransports[0]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+
+    int rewinds = 0;
+    std::unique_ptr<AsyncHttpRequest> rewindable(new AsyncHttpRequest(HTTP_METHOD_PUT, "http://api.example/blob"));
+    rewindable->setBodyStream(0, provider, [&rewinds]() {
+        rewinds++;
+        return true;
+    });
+    client.request(std::move(rewindable), onOk, onErr);
+    gTransports[1]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_EQUAL(1, rewinds);
+}
+
+static void test_retry_respects_total_timeout_and_abort() {
+    resetCounters();
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    AsyncHttpRetryPolicy policy = fastPolicy(5);
+    policy.baseDelayMs = 200;
+    client.setRetryPolicy(policy);
+    client.setTimeout(150);
+    client.get("http://api.example/x", onOk, onErr);
+    gTransports[0]->fail(); // a 200 ms backoff cannot fit in a 150 ms budget
+    TEST_ASSERT_EQUAL(1, gErrors);
+
+    client.setTimeout(10000);
+    uint32_t id = client.get("http://api.example/x", onOk, onErr);
+    gTransports[1]->fail();
+    TEST_ASSERT_EQUAL(1, gErrors);
+    TEST_ASSERT_TRUE(client.abort(id));
+    TEST_ASSERT_EQUAL(2, gErrors);
+    TEST_ASSERT_EQUAL(ABORTED, gLastError);
+    TEST_ASSERT_EQUAL(0, (int)client._retryWaitingCount);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_connect_failure_is_retried_with_backoff);
+    RUN_TEST(test_attempts_exhausted_surfaces_error);
+    RUN_TEST(test_503_honors_retry_after);
+    RUN_TEST(test_non_idempotent_requires_opt_in);
+    RUN_TEST(test_stream_body_needs_rewind);
+    RUN_TEST(test_retry_respects_total_timeout_and_abort);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,96 @@
+#include <unity.h>
+
+#include <cstdint>
+
+#include "RetryPolicy.h"
+
+static void test_backoff_doubles_and_caps() {
+    AsyncHttpRetryPolicy policy;
+    policy.baseDelayMs = 100;
+    policy.maxDelayMs = 1000;
+    policy.jitterPercent = 0;
+    TEST_ASSERT_EQUAL(100, policy.backoffDelayMs(1, 12345));
+    TEST_ASSERT_EQUAL(200, policy.backoffDelayMs(2, 12345));
+    TEST_ASSERT_EQUAL(400, policy.backoffDelayMs(3, 12345));
+    TEST_ASSERT_EQUAL(800, policy.backoffDelayMs(4, 12345));
+    TEST_ASSERT_EQUAL(1000, policy.backoffDelayMs(5, 12345));
+    TEST_ASSERT_EQUAL(1000, policy.backoffDelayMs(200, 12345)); // no overflow
+}
+
+static void test_backoff_jitter_stays_in_range() {
+    AsyncHttpRetryPolicy policy;
+    policy.baseDelayMs = 1000;
+    policy.maxDelayMs = 8000;
+    policy.jitterPercent = 50;
+    uint32_t seed = 1;
+    uint32_t minSeen = UINT32_MAX;
+    uint32_t maxSeen = 0;
+    for (int i = 0; i < 2000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t d = policy.backoffDelayMs(2, seed);
+        TEST_ASSERT_TRUE(d >= 1000 && d <= 2000);
+        if (d < minSeen)
+            minSeen = d;
+        if (d > maxSeen)
+            maxSeen = d;
+    }
+    // Spread across the jitter window (clients desynchronize).
+    TEST_ASSERT_TRUE(minSeen < 1100);
+    TEST_ASSERT_TRUE(maxSeen > 1900);
+}
+
+static void test_defaults() {
+    AsyncHttpRetryPolicy policy;
+    TEST_ASSERT_FALSE(policy.enabled());
+    policy.maxAttempts = 3;
+    TEST_ASSERT_TRUE(policy.enabled());
+    TEST_ASSERT_TRUE(policy.retries(AsyncHttpRetryPolicy::kRetryOnConnectFailed));
+    TEST_ASSERT_TRUE(policy.retries(AsyncHttpRetryPolicy::kRetryOnStaleConnection));
+    TEST_ASSERT_TRUE(policy.retries(AsyncHttpRetryPolicy::kRetryOnStatus503));
+    TEST_ASSERT_FALSE(policy.retries(AsyncHttpRetryPolicy::kRetryOnConnectionClosed));
+    TEST_ASSERT_FALSE(policy.retries(AsyncHttpRetryPolicy::kRetryOnTlsHandshake));
+}
+
+static void test_retry_after_delta_seconds() {
+    uint32_t ms = 0;
+    TEST_ASSERT_TRUE(AsyncHttpRetryPolicy::parseRetryAfter("120", nullptr, &ms));
+    TEST_ASSERT_EQUAL(120000, ms);
+    TEST_ASSERT_TRUE(AsyncHttpRetryPolicy::parseRetryAfter("  0 ", nullptr, &ms));
+    TEST_ASSERT_EQUAL(0, ms);
+    TEST_ASSERT_TRUE(AsyncHttpRetryPolicy::parseRetryAfter("99999999999", nullptr, &ms));
+    TEST_ASSERT_EQUAL(UINT32_MAX / 1000 * 1000, ms);
+    TEST_ASSERT_FALSE(AsyncHttpRetryPolicy::parseRetryAfter("12abc", nullptr, &ms));
+    TEST_ASSERT_FALSE(AsyncHttpRetryPolicy::parseRetryAfter("", nullptr, &ms));
+}
+
+static void test_retry_after_http_date_uses_date_header() {
+    int64_t epoch = 0;
+    TEST_ASSERT_TRUE(AsyncHttpRetryPolicy::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", &epoch));
+    TEST_ASSERT_TRUE(epoch == 784111777);
+
+    uint32_t ms = 0;
+    TEST_ASSERT_TRUE(AsyncHttpRetryPolicy::parseRetryAfter("Wed, 21 Oct 2015 07:28:30 GMT",
+                                                           "Wed, 21 Oct 2015 07:28:00 GMT", &ms));
+    TEST_ASSERT_EQUAL(30000, ms);
+    // Date in the past => retry immediately.
+    TEST_ASSERT_TRUE(AsyncHttpRetryPolicy::parseRetryAfter("Wed, 21 Oct 2015 07:27:00 GMT",
+                                                           "Wed, 21 Oct 2015 07:28:00 GMT", &ms));
+    TEST_ASSERT_EQUAL(0, ms);
+    // Without a Date header there is no reference clock.
+    TEST_ASSERT_FALSE(AsyncHttpRetryPolicy::parseRetryAfter("Wed, 21 Oct 2015 07:28:30 GMT", nullptr, &ms));
+    TEST_ASSERT_FALSE(AsyncHttpRetryPolicy::parseHttpDate("Wed, 21 Foo 2015 07:28:30 GMT", &epoch));
+    TEST_ASSERT_FALSE(AsyncHttpRetryPolicy::parseHttpDate("21 Oct 2015", &epoch));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff_doubles_and_caps);
+    RUN_TEST(test_backoff_jitter_stays_in_range);
+    RUN_TEST(test_defaults);
+    RUN_TEST(test_retry_after_delta_seconds);
+    RUN_TEST(test_retry_after_http_date_uses_date_header);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <cstring>
+#include <vector>
+
+#define private public
+#include "AsyncHttpClient.h"
+#undef private
+#include "FakeTransport.h"
+#include "TestCallbacks.h"
+
+// 3000-byte body stream handing out as much as the client asks for.
+static std::unique_ptr<AsyncHttpRequest> makeUpload(size_t* sent) {
+    std::unique_ptr<AsyncHttpRequest> request(new AsyncHttpRequest(HTTP_METHOD_POST, "http://upload.example/data"));
+    *sent = 0;
+    request->setBodyStream(3000, [sent](uint8_t* buffer, size_t maxLen, bool* final) -> int {
+        size_t n = std::min(maxLen, static_cast<size_t>(3000) - *sent);
+        memset(buffer, 'x', n);
+        *sent += n;
+        *final = *sent == 3000;
+        return static_cast<int>(n);
+    });
+    return request;
+}
+
+static void test_defaults_and_per_request_override() {
+    AsyncHttpClient client;
+    AsyncHttpSocketOptions defaults = client.getSocketOptions();
+    TEST_ASSERT_TRUE(defaults.noDelay);
+    TEST_ASSERT_EQUAL(0, (int)defaults.keepAliveIntervalMs);
+    TEST_ASSERT_EQUAL(512, (int)defaults.txChunkBytes);
+
+    AsyncHttpSocketOptions options;
+    options.keepAliveIntervalMs = 15000;
+    options.keepAliveCount = 4;
+    client.setSocketOptions(options);
+    AsyncHttpRequest plain(HTTP_METHOD_GET, "http://a.example/");
+    TEST_ASSERT_EQUAL(15000, (int)client.resolveSocketOptions(&plain).keepAliveIntervalMs);
+
+    AsyncHttpSocketOptions bulk;
+    bulk.noDelay = false;
+    bulk.rxBufferHint = 16384;
+    AsyncHttpRequest tuned(HTTP_METHOD_GET, "http://a.example/");
+    tuned.setSocketOptions(bulk);
+    AsyncHttpSocketOptions resolved = client.resolveSocketOptions(&tuned);
+    TEST_ASSERT_FALSE(resolved.noDelay);
+    TEST_ASSERT_EQUAL(0, (int)resolved.keepAliveIntervalMs);
+    TEST_ASSERT_EQUAL(16384, (int)resolved.rxBufferHint);
+    // Hedge copies carry the override.
+    TEST_ASSERT_EQUAL(16384, (int)client.resolveSocketOptions(tuned.clone().get()).rxBufferHint);
+}
+
+static void test_body_stream_written_in_tx_chunks() {
+    gSuccess = 0;
+    AsyncHttpClient client;
+    installFakeTransports(client);
+    FakeTransport::gRecordWrites = true; // the size of every write shows how the body is chunked
+    size_t sent = 0;
+    client.request(makeUpload(&sent), onOk);
+    FakeTransport* t = gTransports[0];
+    t->accept();
+    TEST_ASSERT_EQUAL(2, (int)t->writes.size()); // head, then the first 512 bytes of the body
+    TEST_ASSERT_EQUAL(512, (int)t->writes[1]);
+    while (sent < 3000)
+        client.loop();
+    TEST_ASSERT_EQUAL(1 + 6, (int)t->writes.size()); // 5 x 512 + 440
+    t->respond(kOk);
+    TEST_ASSERT_EQUAL(1, gSuccess);
+
+    AsyncHttpSocketOptions options;
+    options.txChunkBytes = 2048;
+    client.setSocketOptions(options);
+    client.request(makeUpload(&sent), onOk);
+    t = gTransports[1];
+    t->accept();
+    client.loop();
+    TEST_ASSERT_EQUAL(3000, (int)sent);
+    TEST_ASSERT_EQUAL(3, (int)t->writes.size()); // head, 2048, 952
+    TEST_ASSERT_EQUAL(2048, (int)t->writes[1]);
+    TEST_ASSERT_EQUAL(952, (int)t->writes[2]);
+    TEST_ASSERT_EQUAL(0, (int)client._activeRequests[0]->streamChunk.capacity()); // released once the body is out
+    t->respond(kOk);
+    TEST_ASSERT_EQUAL(2, gSuccess);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_defaults_and_per_request_override);
+    RUN_TEST(test_body_stream_written_in_tx_chunks);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(200);
+    runUnityTests();
+}
+
+void loop() {}
@@ -0,0 +1,180 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SubmissionQueue.h"
+
+struct Item {
+    uint32_t producer = 0;
+    uint32_t seq = 0;
+};
+
+static void test_push_pop_fifo_and_capacity() {
+    MpscQueue<Item> q(5); // rounded up to 8
+    TEST_ASSERT_EQUAL(8, (int)q.capacity());
+    TEST_ASSERT_TRUE(q.empty());
+    for (uint32_t i = 0; i < 8; ++i) {
+        Item it;
+        it.seq = i;
+        TEST_ASSERT_TRUE(q.tryPush(std::move(it)));
+    }
+    Item overflow;
+    TEST_ASSERT_FALSE(q.tryPush(std::move(overflow)));
+    for (uint32_t i = 0; i < 8; ++i) {
+        Item out;
+        TEST_ASSERT_TRUE(q.tryPop(&out));
+        TEST_ASSERT_EQUAL(i, out.seq);
+    }
+    Item none;
+    TEST_ASSERT_FALSE(q.tryPop(&none));
+    TEST_ASSERT_TRUE(q.empty());
+}
+
+static void test_wraps_around_many_times() {
+    MpscQueue<Item> q(4);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        Item it;
+        it.seq = i;
+        TEST_ASSERT_TRUE(q.tryPush(std::move(it)));
+        Item out;
+        TEST_ASSERT_TRUE(q.tryPop(&out));
+        TEST_ASSERT_EQUAL(i, out.seq);
+    }
+}
+
+static void test_multi_producer_stress() {
+    const uint32_t kProducers = 4;
+    const uint32_t kPerProducer = 50000;
+    MpscQueue<Item> q(16);
+    std::atomic<bool> start{false};
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            while (!start.load())
+                std::this_thread::yield();
+            for (uint32_t i = 0; i < kPerProducer; ++i) {
+                Item it;
+                it.producer = p;
+                it.seq = i;
+                while (!q.tryPush(std::move(it)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<uint32_t> nextSeq(kProducers, 0);
+    uint32_t received = 0;
+    bool orderOk = true;
+    start.store(true);
+    while (received < kProducers * kPerProducer) {
+        Item out;
+        if (!q.tryPop(&out)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (out.producer >= kProducers || out.seq != nextSeq[out.producer])
+            orderOk = false;
+        else
+            nextSeq[out.producer]++;
+        received++;
+    }
+    for (auto& t : producers)
+        t.join();
+
+    TEST_ASSERT_TRUE_MESSAGE(orderOk, "per-producer order must be preserved");
+    for (uint32_t p = 0; p < kProducers; ++p)
+        TEST_ASSERT_EQUAL(kPerProducer, nextSeq[p]);
+    Item extra;
+    TEST_ASSERT_FALSE(q.tryPop(&extra));
+}
+
+// Contention benchmark: N producers hammering a mutex-protected deque (the previous design, where every submitter
+// takes the client mutex) versus the lock-free ring. Reports ns per submitted item; no hard threshold since CI
+// machines vary, but both paths must deliver every item.
+template <typename PushFn, typename PopFn>
+static double runContentionBench(uint32_t producersCount, uint32_t perProducer, PushFn push, PopFn pop) {
+    std::atomic<bool> start{false};
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < producersCount; ++p) {
+        producers.emplace_back([&, p]() {
+            while (!start.load())
+                std::this_thread::yield();
+            for (uint32_t i = 0; i < perProducer; ++i) {
+                Item it;
+                it.producer = p;
+                it.seq = i;
+                while (!push(it))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    uint32_t total = producersCount * perProducer;
+    uint32_t received = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    start.store(true);
+    while (received < total) {
+        if (pop())
+            received++;
+        else
+            std::this_thread::yield();
+    }
+    for (auto& t : producers)
+        t.join();
+    auto t1 = std::chrono::steady_clock::now();
+    TEST_ASSERT_EQUAL(total, received);
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / total;
+}
+
+static void test_contention_benchmark() {
+    const uint32_t kProducers = 4;
+    const uint32_t kPerProducer = 100000;
+
+    std::mutex mtx;
+    std::deque<Item> locked;
+    double lockedNs = runContentionBench(
+        kProducers, kPerProducer,
+        [&](Item& it) {
+            std::lock_guard<std::mutex> g(mtx);
+            locked.push_back(it);
+            return true;
+        },
+        [&]() {
+            std::lock_guard<std::mutex> g(mtx);
+            if (locked.empty())
+                return false;
+            locked.pop_front();
+            return true;
+        });
+
+    MpscQueue<Item> ring(64);
+    double ringNs = runContentionBench(
+        kProducers, kPerProducer, [&](Item& it) { return ring.tryPush(std::move(it)); },
+        [&]() {
+            Item out;
+            return ring.tryPop(&out);
+        });
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "mutex+deque: %.1f ns/item, lock-free ring: %.1f ns/item (%u producers)", lockedNs,
+             ringNs, (unsigned)kProducers);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_push_pop_fifo_and_capacity);
+    RUN_TEST(test_wraps_around_many_times);
+    RUN_TEST(test_multi_producer_stress);
+    RUN_TEST(test_contention_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "TlsSessionCache.h"
+
+static const std::string kApi = "https://api.example:443#00000000000000a1";
+static const std::string kCdn = "https://cdn.example:443#00000000000000a1";
+
+static std::vector<uint8_t> blob(uint8_t fill, size_t len = 16) {
+    return std::vector<uint8_t>(len, fill);
+}
+
+static void store(TlsSessionCache& cache, const std::string& key, const std::vector<uint8_t>& data, uint32_t nowMs,
+                  bool resumed = false) {
+    cache.store(key, data.data(), data.size(), resumed, nowMs);
+}
+
+static void test_stored_session_is_returned_for_its_key_only() {
+    TlsSessionCache cache;
+    std::vector<uint8_t> out;
+    TEST_ASSERT_FALSE(cache.lookup(kApi, 0, &out));
+    store(cache, kApi, blob(0xA1), 0);
+    TEST_ASSERT_TRUE(cache.lookup(kApi, 10, &out));
+    TEST_ASSERT_EQUAL(16, (int)out.size());
+    TEST_ASSERT_EQUAL(0xA1, (int)out[0]);
+    TEST_ASSERT_FALSE(cache.lookup(kCdn, 10, &out));
+    // Another TLS profile for the same origin (different digest) does not see the session.
+    TEST_ASSERT_FALSE(cache.lookup("https://api.example:443#00000000000000b2", 10, &out));
+
+    AsyncHttpTlsSessionStats stats = cache.stats();
+    TEST_ASSERT_EQUAL(1, (int)stats.entries);
+    TEST_ASSERT_EQUAL(16, (int)stats.bytes);
+    TEST_ASSERT_EQUAL(1, (int)stats.stored);
+}
+
+static void test_session_expires_from_its_full_handshake() {
+    TlsSessionCache cache;
+    AsyncHttpTlsSessionConfig config;
+    config.maxAgeMs = 1000;
+    cache.configure(config);
+    uint32_t start = 0xFFFFFE00u; // millis() wraps during the session's lifetime
+    store(cache, kApi, blob(1), start);
+    // Resumptions refresh the saved data (a renewed ticket) but not the age.
+    store(cache, kApi, blob(2), start + 600, true);
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(cache.lookup(kApi, start + 999, &out));
+    TEST_ASSERT_EQUAL(2, (int)out[0]);
+    TEST_ASSERT_FALSE(cache.lookup(kApi, start + 1000, &out));
+    TEST_ASSERT_EQUAL(1, (int)cache.stats().expired);
+    TEST_ASSERT_EQUAL(0, (int)cache.stats().entries);
+
+    // A new full handshake starts a new lifetime.
+    store(cache, kApi, blob(3), start + 1000);
+    store(cache, kApi, blob(4), start + 1500);
+    TEST_ASSERT_TRUE(cache.lookup(kApi, start + 2400, &out));
+    TEST_ASSERT_EQUAL(4, (int)out[0]);
+}
+
+static void test_least_recently_used_session_is_evicted() {
+    TlsSessionCache cache;
+    AsyncHttpTlsSessionConfig config;
+    config.maxEntries = 2;
+    cache.configure(config);
+    store(cache, kApi, blob(1), 0);
+    store(cache, kCdn, blob(2), 10);
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(cache.lookup(kApi, 20, &out)); // api is now more recent than cdn
+    store(cache, "https://img.example:443#00000000000000a1", blob(3), 30);
+    TEST_ASSERT_TRUE(cache.lookup(kApi, 40, &out));
+    TEST_ASSERT_FALSE(cache.lookup(kCdn, 40, &out));
+    TEST_ASSERT_EQUAL(1, (int)cache.stats().evictions);
+    TEST_ASSERT_EQUAL(2, (int)cache.stats().entries);
+}
+
+static void test_failed_offer_removes_the_session() {
+    TlsSessionCache cache;
+    store(cache, kApi, blob(1), 0);
+    TEST_ASSERT_TRUE(cache.remove(kApi));
+    TEST_ASSERT_FALSE(cache.remove(kApi));
+    std::vector<uint8_t> out;
+    TEST_ASSERT_FALSE(cache.lookup(kApi, 0, &out));
+}
+
+static void test_disabled_cache_keeps_nothing() {
+    TlsSessionCache cache;
+    store(cache, kApi, blob(1), 0);
+    AsyncHttpTlsSessionConfig config;
+    config.enabled = false;
+    cache.configure(config);
+    TEST_ASSERT_EQUAL(0, (int)cache.stats().entries);
+    store(cache, kApi, blob(1), 0);
+    std::vector<uint8_t> out;
+    TEST_ASSERT_FALSE(cache.lookup(kApi, 0, &out));
+
+    config.enabled = true;
+    config.maxEntries = 0;
+    cache.configure(config);
+    store(cache, kApi, blob(1), 0);
+    TEST_ASSERT_EQUAL(0, (int)cache.stats().entries);
+}
+
+static void test_handshake_counters_and_clear() {
+    TlsSessionCache cache;
+    cache.recordHandshake(false, false); // nothing cached: full
+    cache.recordHandshake(true, true);   // offered and resumed
+    cache.recordHandshake(true, false);  // offered, server chose a full handshake
+    store(cache, kApi, blob(1), 0);
+    AsyncHttpTlsSessionStats stats = cache.stats();
+    TEST_ASSERT_EQUAL(2, (int)stats.offered);
+    TEST_ASSERT_EQUAL(1, (int)stats.resumed);
+    TEST_ASSERT_EQUAL(2, (int)stats.full);
+
+    cache.clear();
+    stats = cache.stats();
+    TEST_ASSERT_EQUAL(0, (int)stats.entries);
+    TEST_ASSERT_EQUAL(0, (int)stats.offered);
+    TEST_ASSERT_EQUAL(0, (int)stats.stored);
+    std::vector<uint8_t> out;
+    TEST_ASSERT_FALSE(cache.lookup(kApi, 0, &out));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_stored_session_is_returned_for_its_key_only);
+    RUN_TEST(test_session_expires_from_its_full_handshake);
+    RUN_TEST(test_least_recently_used_session_is_evicted);
+    RUN_TEST(test_failed_offer_removes_the_session);
+    RUN_TEST(test_disabled_cache_keeps_nothing);
+    RUN_TEST(test_handshake_counters_and_clear);
+    return UNITY_END();
+}